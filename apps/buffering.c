@@ -29,6 +29,7 @@
 #include "debug.h"
 #include "file.h"
 #include "appevents.h"
+#include "trace.h"
 #include "metadata.h"
 #include "bmp.h"
 #ifdef HAVE_ALBUMART
@@ -650,6 +651,8 @@ static bool buffer_handle(int handle_id, size_t to_buffer)
         return true;
     }
 
+    TRACE_BEGIN(TP_BUFFER_HANDLE, handle_id);
+
     bool stop = false;
     while (h->end < h->filesize && !stop)
     {
@@ -675,7 +678,7 @@ static bool buffer_handle(int handle_id, size_t to_buffer)
         }
 
         if (copy_n <= 0)
-            return false; /* no space for read */
+            break; /* no space for read - stop is set */
 
         /* rc is the actual amount read */
         ssize_t rc = read(h->fd, ringbuf_ptr(widx), copy_n);
@@ -716,6 +719,8 @@ static bool buffer_handle(int handle_id, size_t to_buffer)
         send_event(BUFFER_EVENT_FINISHED, &handle_id);
     }
 
+    TRACE_END(TP_BUFFER_HANDLE, handle_id);
+
     return !stop;
 }
 
@@ -1088,6 +1093,12 @@ int bufalloc(const void *src, size_t size, enum data_type type)
             } else {
                 memcpy(ringbuf_ptr(data), src, size);
             }
+
+            if (type == TYPE_BITMAP) {
+                /* the bitmap data follows the struct in the copy as well */
+                ((struct bitmap *)ringbuf_ptr(data))->data =
+                    ringbuf_ptr(data + sizeof(struct bitmap));
+            }
         }
 
         h->type      = type;
@@ -1724,7 +1735,7 @@ void INIT_ATTR buffering_init(void)
     buffering_thread_id = create_thread( buffering_thread, buffering_stack,
             sizeof(buffering_stack), CREATE_THREAD_FROZEN,
             buffering_thread_name IF_PRIO(, PRIORITY_BUFFERING)
-            IF_COP(, CPU));
+            IF_COP(, BUFFERING_THREAD_CORE));
 
     queue_enable_queue_send(&buffering_queue, &buffering_queue_sender_list,
                             buffering_thread_id);
@@ -33,6 +33,7 @@
 #include "dsp_core.h"
 #include "metadata.h"
 #include "settings.h"
+#include "trace.h"
 
 /* Define LOGF_ENABLE to enable logf output in this file */
 /*#define LOGF_ENABLE*/
@@ -221,6 +222,9 @@ static void codec_pcmbuf_insert_callback(
     src.pin[1]    = ch2;
     src.proc_mask = 0;
 
+    /* The codec's own work is the time between the inserts */
+    TRACE_END(TP_CODEC_DECODE, 0);
+
     while (LIKELY(queue_empty(&codec_queue)) ||
            codec_check_queue__have_msg() >= 0)
     {
@@ -247,10 +251,12 @@ static void codec_pcmbuf_insert_callback(
             }
             else if (src.remcount <= 0)
             {
-                return; /* No input remains and DSP purged */
+                break; /* No input remains and DSP purged */
             }
         }
     }
+
+    TRACE_BEGIN(TP_CODEC_DECODE, 0);
 }
 
 /* helper function, not a callback */
@@ -651,7 +657,7 @@ void INIT_ATTR codec_thread_init(void)
     codec_thread_id = create_thread(
             codec_thread, codec_stack, sizeof(codec_stack), 0,
             codec_thread_name IF_PRIO(, PRIORITY_PLAYBACK)
-            IF_COP(, CPU));
+            IF_COP(, CODEC_THREAD_CORE));
     queue_enable_queue_send(&codec_queue, &codec_queue_sender_list,
                             codec_thread_id);
 }
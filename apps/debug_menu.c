@@ -133,6 +133,14 @@
 
 #include "talk.h"
 
+#ifdef ROCKBOX_HAS_TRACE
+#include "trace.h"
+#endif
+
+#ifdef HAVE_TEXT_CACHE
+#include "text_cache.h"
+#endif
+
 static const char* threads_getname(int selected_item, void *data,
                                    char *buffer, size_t buffer_len)
 {
@@ -191,6 +199,135 @@ static bool dbg_os(void)
     return simplelist_show_list(&info);
 }
 
+#ifdef HAVE_THREAD_CPU_TIME
+/* CPU usage over the last second, in tenths of a percent of the core */
+static struct
+{
+    long next_sample;
+    unsigned long idle_time[NUM_CORES];
+    unsigned long cpu_time[MAXTHREADS];
+    unsigned int idle_load[NUM_CORES];
+    unsigned int load[MAXTHREADS];
+} cpu_usage;
+
+static void cpu_usage_sample(void)
+{
+    unsigned long idle[NUM_CORES], delta[MAXTHREADS];
+    unsigned int core_of[MAXTHREADS];
+    unsigned long long total[NUM_CORES];
+    struct thread_debug_info info;
+
+    for (unsigned int core = 0; core < NUM_CORES; core++)
+    {
+        unsigned long time = core_idle_time(IF_COP(core));
+        total[core] = idle[core] = time - cpu_usage.idle_time[core];
+        cpu_usage.idle_time[core] = time;
+    }
+
+    for (int i = 0; i < MAXTHREADS; i++)
+    {
+        delta[i] = 0;
+        core_of[i] = 0;
+
+        if (thread_get_debug_info(i, &info) <= 0)
+            continue;
+
+#if NUM_CORES > 1
+        core_of[i] = info.core;
+#endif
+        delta[i] = info.cpu_time - cpu_usage.cpu_time[i];
+        cpu_usage.cpu_time[i] = info.cpu_time;
+        total[core_of[i]] += delta[i];
+    }
+
+    for (unsigned int core = 0; core < NUM_CORES; core++)
+    {
+        cpu_usage.idle_load[core] = total[core] ?
+            idle[core] * 1000ull / total[core] : 0;
+    }
+
+    for (int i = 0; i < MAXTHREADS; i++)
+    {
+        cpu_usage.load[i] = total[core_of[i]] ?
+            delta[i] * 1000ull / total[core_of[i]] : 0;
+    }
+}
+
+static const char* cpu_usage_getname(int selected_item, void *data,
+                                     char *buffer, size_t buffer_len)
+{
+    (void)data;
+
+    if (selected_item < (int)NUM_CORES)
+    {
+        unsigned int load = cpu_usage.idle_load[selected_item];
+        snprintf(buffer, buffer_len, "Idle" IF_COP(" (%d)") ": %3u.%u%%",
+                 IF_COP(selected_item,) load / 10, load % 10);
+        return buffer;
+    }
+
+    selected_item -= NUM_CORES;
+
+    struct thread_debug_info info;
+    if (thread_get_debug_info(selected_item, &info) <= 0)
+    {
+        snprintf(buffer, buffer_len, "%2d: ---", selected_item);
+        return buffer;
+    }
+
+    unsigned int load = cpu_usage.load[selected_item];
+    int len = snprintf(buffer, buffer_len, "%2d:%c%3u.%u%% %s",
+                       selected_item, info.stack_warn ? '!' : ' ',
+                       load / 10, load % 10, info.name);
+
+#ifdef HAVE_SCHEDULER_BOOSTCTRL
+    /* who keeps the CPU boosted */
+    if (info.boost_count > 0 && len < (int)buffer_len)
+    {
+        snprintf(buffer + len, buffer_len - len, " %cboost %lus x%u",
+                 info.statusstr[0] == '+' ? '+' : ' ',
+                 info.boost_ticks / HZ, info.boost_count);
+    }
+#else
+    (void)len;
+#endif
+
+    return buffer;
+}
+
+static int dbg_cpu_usage_action_callback(int action,
+                                         struct gui_synclist *lists)
+{
+    (void)lists;
+
+    if (TIME_AFTER(current_tick, cpu_usage.next_sample))
+    {
+        cpu_usage_sample();
+        cpu_usage.next_sample = current_tick + HZ;
+    }
+
+    if (action == ACTION_NONE)
+        action = ACTION_REDRAW;
+    return action;
+}
+
+static bool dbg_cpu_usage(void)
+{
+    struct simplelist_info info;
+
+    /* the first second starts now */
+    cpu_usage_sample();
+    cpu_usage.next_sample = current_tick + HZ;
+
+    simplelist_info_init(&info, "CPU usage:", NUM_CORES + MAXTHREADS, NULL);
+    info.hide_selection = true;
+    info.scroll_all = true;
+    info.action_callback = dbg_cpu_usage_action_callback;
+    info.get_name = cpu_usage_getname;
+    return simplelist_show_list(&info);
+}
+#endif /* HAVE_THREAD_CPU_TIME */
+
 #ifdef __linux__
 #include "cpuinfo-linux.h"
 
@@ -1573,6 +1710,54 @@ static bool dbg_dircache_info(void)
 
 #endif /* HAVE_DIRCACHE */
 
+#ifdef HAVE_TEXT_CACHE
+static int text_cache_callback(int btn, struct gui_synclist *lists)
+{
+    (void)lists;
+    struct text_cache_stats stats;
+    unsigned long lookups;
+
+    if (btn == ACTION_STD_OK)
+    {
+        text_cache_reset_stats();
+        btn = ACTION_REDRAW;
+    }
+
+    text_cache_get_stats(&stats);
+    lookups = stats.hits + stats.misses;
+
+    simplelist_set_line_count(0);
+    simplelist_addline("Cache size: %lu B", (unsigned long)stats.size);
+    simplelist_addline("Used: %lu B in %d runs",
+             (unsigned long)stats.used, stats.runs);
+    simplelist_addline("Hits: %lu (%lu%%)", stats.hits,
+             lookups ? stats.hits * 100 / lookups : 0);
+    simplelist_addline("Misses: %lu", stats.misses);
+    simplelist_addline("Uncached: %lu", stats.uncached);
+#ifdef TEXT_CACHE_CLOCK
+    simplelist_addline("Strings drawn: %lu", stats.draws);
+    simplelist_addline("Draw time: %lu us avg, %lu ms total",
+             stats.draws ? (unsigned long)(stats.draw_time / stats.draws) : 0,
+             (unsigned long)(stats.draw_time / 1000));
+#endif
+    simplelist_addline("SELECT resets the counts");
+
+    if (btn == ACTION_NONE)
+        btn = ACTION_REDRAW;
+    return btn;
+}
+
+static bool dbg_text_cache_info(void)
+{
+    struct simplelist_info info;
+    simplelist_info_init(&info, "Text cache", 0, NULL);
+    info.action_callback = text_cache_callback;
+    info.hide_selection = true;
+    info.scroll_all = true;
+    return simplelist_show_list(&info);
+}
+#endif /* HAVE_TEXT_CACHE */
+
 #ifdef HAVE_TAGCACHE
 static int database_callback(int btn, struct gui_synclist *lists)
 {
@@ -1943,6 +2128,35 @@ static bool dbg_metadatalog(void)
     return false;
 }
 
+#ifdef ROCKBOX_HAS_TRACE
+#define TRACE_FILE "/trace.out"
+
+static bool dbg_trace(void)
+{
+    MENUITEM_STRINGLIST(menu, "Event tracing", NULL,
+                        "Start", "Start, stop at audio dropout",
+                        "Stop and write " TRACE_FILE);
+
+    switch (do_menu(&menu, NULL, NULL, false))
+    {
+    case 0:
+        trace_start(false);
+        break;
+    case 1:
+        trace_start(true);
+        break;
+    case 2:
+        if (trace_dump(TRACE_FILE) < 0)
+            splash(HZ, "Failed to write " TRACE_FILE);
+        else
+            splash(HZ, "Trace written to " TRACE_FILE);
+        break;
+    }
+
+    return false;
+}
+#endif /* ROCKBOX_HAS_TRACE */
+
 #if CONFIG_CPU == SH7034 || defined(CPU_COLDFIRE)
 static bool dbg_set_memory_guard(void)
 {
@@ -2303,6 +2517,9 @@ static const struct {
         { "Catch mem accesses", dbg_set_memory_guard },
 #endif
         { "View OS stacks", dbg_os },
+#ifdef HAVE_THREAD_CPU_TIME
+        { "View CPU usage", dbg_cpu_usage },
+#endif
 #ifdef __linux__
         { "View CPU stats", dbg_cpuinfo },
 #endif
@@ -2328,12 +2545,18 @@ static const struct {
 #endif
 #endif
         { "Metadata log", dbg_metadatalog },
+#ifdef ROCKBOX_HAS_TRACE
+        { "Event tracing", dbg_trace },
+#endif
 #ifdef HAVE_DIRCACHE
         { "View dircache info", dbg_dircache_info },
 #endif
 #ifdef HAVE_TAGCACHE
         { "View database info", dbg_tagcache_info },
 #endif
+#ifdef HAVE_TEXT_CACHE
+        { "View text cache", dbg_text_cache_info },
+#endif
 #ifdef HAVE_LCD_BITMAP
 #if CONFIG_CODEC == SWCODEC
         { "View buffering thread", dbg_buffering_thread },
@@ -51,6 +51,9 @@
 #else
 #include "debug.h"
 #include "language.h"
+#include "crc32.h"
+#include "dir.h"
+#include "version.h"
 #endif /*__PCTOOL__*/
 
 #include <ctype.h>
@@ -79,6 +82,11 @@
 
 #define WPS_ERROR_INVALID_PARAM         -1
 
+#if defined(HAVE_LCD_BITMAP) && !defined(__PCTOOL__)
+/* keep parsed skins in SKIN_CACHE_DIR, see skin_cache_load() */
+#define SKIN_CACHE
+#endif
+
 static char* skin_buffer = NULL;
 #if (LCD_DEPTH > 1) || (defined(HAVE_REMOTE_LCD) && (LCD_REMOTE_DEPTH > 1))
 static char *backdrop_filename;
@@ -123,6 +131,11 @@ static struct line *curr_line;
 
 static int follow_lang_direction = 0;
 
+#ifdef SKIN_CACHE
+/* side effects of the parse that a cached skin has to repeat */
+static bool has_list_title;
+#endif
+
 typedef int (*parse_function)(struct skin_element *element,
                               struct wps_token *token,
                               struct wps_data *wps_data);
@@ -2280,6 +2293,9 @@ static int skin_element_callback(struct skin_element* element, void* data)
                 case SKIN_TOKEN_LIST_TITLE_TEXT:
 #ifndef __PCTOOL__
                     sb_skin_has_title(curr_screen);
+#endif
+#ifdef SKIN_CACHE
+                    has_list_title = true;
 #endif
                     break;
 #endif
@@ -2423,12 +2439,296 @@ static int skin_element_callback(struct skin_element* element, void* data)
     return CALLBACK_OK;
 }
 
+#ifdef SKIN_CACHE
+/* Parsed skins are kept on disk, so loading one again with the same source
+ * and in the same environment is a single read instead of a parse.
+ *
+ * The skin buffer is written just after parsing, before any images or fonts
+ * are loaded. Nearly everything in it is an offset from the start of the
+ * buffer, the exceptions being the tag_info pointers of the elements, the
+ * image filenames and the settings of touch regions. The header saves where
+ * those pointed to, and they're moved by the difference if needed. Anything
+ * the parser takes from outside the skin source goes into the key, and the
+ * build's version string makes sure the layout of the structs matches.
+ *
+ * The header is stored behind the buffer so both come in with one read. */
+
+#define SKIN_CACHE_MAGIC    0x534b4331 /* "SKC1" */
+
+enum skin_cache_backdrop {
+    CACHE_BACKDROP_NONE = 0,    /* NULL, i.e. %X(d) */
+    CACHE_BACKDROP_SETTING,     /* "-" */
+    CACHE_BACKDROP_BUFFER,      /* BACKDROP_BUFFERNAME */
+    CACHE_BACKDROP_FILE,        /* a filename in the skin buffer */
+};
+
+struct skin_cache_header {
+    uint32_t magic;
+    uint32_t key;
+    uint32_t size;  /* bytes of skin buffer in front of the header */
+    const struct tag_info *tag_base;
+    const struct settings_list *settings_base;
+    const char *buffer_base;
+    struct wps_data data;
+    struct {
+        OFFSETTYPE(char*) name;
+        int glyphs;
+    } fonts[MAXUSERFONTS];
+    OFFSETTYPE(char*) backdrop;
+    unsigned char backdrop_type;
+    bool has_list_title;
+};
+
+static uint32_t skin_cache_key(const char *source, size_t length)
+{
+    struct viewport vp;
+    int value;
+    uint32_t key = crc_32(source, length, 0xffffffff);
+
+    key = crc_32(rbversion, strlen(rbversion), key);
+    key = crc_32(&curr_screen, sizeof(curr_screen), key);
+    /* viewports start out as these, the font is set after loading */
+    viewport_set_defaults(&vp, curr_screen);
+    vp.font = 0;
+    key = crc_32(&vp, sizeof(vp), key);
+    viewport_set_fullscreen(&vp, curr_screen);
+    vp.font = 0;
+    key = crc_32(&vp, sizeof(vp), key);
+    value = lang_is_rtl();
+    key = crc_32(&value, sizeof(value), key);
+    key = crc_32(&global_settings.glyphs_to_cache,
+                 sizeof(global_settings.glyphs_to_cache), key);
+#ifdef HAVE_LCD_COLOR
+    key = crc_32(&global_settings.lss_color,
+                 sizeof(global_settings.lss_color), key);
+    key = crc_32(&global_settings.lse_color,
+                 sizeof(global_settings.lse_color), key);
+    key = crc_32(&global_settings.lst_color,
+                 sizeof(global_settings.lst_color), key);
+#endif
+    return key;
+}
+
+/* SKIN_CACHE_DIR/<name>.<ext> */
+static char *skin_cache_filename(char *buf, size_t buf_size,
+                                 const char *skinfile)
+{
+    const char *name = strrchr(skinfile, '/');
+    snprintf(buf, buf_size, SKIN_CACHE_DIR "/%s", name ? name + 1 : skinfile);
+    return buf;
+}
+
+static void skin_cache_save(const char *skinfile, uint32_t key,
+                            struct wps_data *wps_data)
+{
+    struct skin_cache_header header;
+    char path[MAX_PATH];
+    size_t size = skin_buffer_usage();
+    int fd, i;
+
+    memset(&header, 0, sizeof(header));
+    header.magic = SKIN_CACHE_MAGIC;
+    header.key = key;
+    header.size = size;
+    header.tag_base = find_tag("V");
+    header.settings_base = get_settings_list(&i);
+    header.buffer_base = skin_buffer;
+    header.data = *wps_data;
+    for (i = 0; i < MAXUSERFONTS; i++)
+    {
+        header.fonts[i].name = PTRTOSKINOFFSET(skin_buffer, skinfonts[i].name);
+        header.fonts[i].glyphs = skinfonts[i].glyphs;
+    }
+#ifdef HAVE_BACKDROP_IMAGE
+    header.backdrop = -1;
+    if (backdrop_filename == NULL)
+        header.backdrop_type = CACHE_BACKDROP_NONE;
+    else if (!strcmp(backdrop_filename, "-"))
+        header.backdrop_type = CACHE_BACKDROP_SETTING;
+    else if (!strcmp(backdrop_filename, BACKDROP_BUFFERNAME))
+        header.backdrop_type = CACHE_BACKDROP_BUFFER;
+    else
+    {
+        header.backdrop_type = CACHE_BACKDROP_FILE;
+        header.backdrop = PTRTOSKINOFFSET(skin_buffer, backdrop_filename);
+    }
+#endif
+    header.has_list_title = has_list_title;
+
+    skin_cache_filename(path, sizeof(path), skinfile);
+    fd = open(path, O_WRONLY|O_CREAT|O_TRUNC, 0666);
+    if (fd < 0)
+    {
+        mkdir(SKIN_CACHE_DIR);
+        fd = open(path, O_WRONLY|O_CREAT|O_TRUNC, 0666);
+        if (fd < 0)
+            return;
+    }
+
+    if (write(fd, skin_buffer, size) != (ssize_t)size ||
+        write(fd, &header, sizeof(header)) != sizeof(header))
+    {
+        close(fd);
+        remove(path);
+        return;
+    }
+    close(fd);
+}
+
+static void skin_cache_relocate_tags(struct skin_element *element,
+                                     ptrdiff_t delta)
+{
+    for (; element; element = SKINOFFSETTOPTR(skin_buffer, element->next))
+    {
+        struct skin_tag_parameter *params =
+                SKINOFFSETTOPTR(skin_buffer, element->params);
+        OFFSETTYPE(struct skin_element*) *children =
+                SKINOFFSETTOPTR(skin_buffer, element->children);
+        int i;
+
+        if (element->tag)
+            element->tag = (void *)((char *)element->tag + delta);
+        for (i = 0; i < element->params_count; i++)
+        {
+            if (params[i].type == CODE)
+                skin_cache_relocate_tags(
+                        SKINOFFSETTOPTR(skin_buffer, params[i].data.code),
+                        delta);
+        }
+        for (i = 0; i < element->children_count; i++)
+            skin_cache_relocate_tags(SKINOFFSETTOPTR(skin_buffer, children[i]),
+                                     delta);
+    }
+}
+
+/* Load the skin buffer saved for this source instead of parsing it.
+ * skin_buffer_init() must have been called already */
+static bool skin_cache_load(const char *skinfile, uint32_t key,
+                            struct wps_data *wps_data, size_t buffersize)
+{
+    struct skin_cache_header header;
+    struct skin_token_list *list;
+    char path[MAX_PATH];
+    ssize_t size;
+    ptrdiff_t delta;
+    int fd, i;
+
+    fd = open(skin_cache_filename(path, sizeof(path), skinfile), O_RDONLY);
+    if (fd < 0)
+        return false;
+    size = read(fd, skin_buffer, buffersize);
+    close(fd);
+
+    if (size < (ssize_t)sizeof(header))
+        return false;
+    memcpy(&header, skin_buffer + size - sizeof(header), sizeof(header));
+    if (header.magic != SKIN_CACHE_MAGIC || header.key != key ||
+        header.size != size - sizeof(header))
+        return false;
+
+    /* claim the space, no skin_buffer_alloc() has been made yet so this
+     * is exactly the cached part */
+    skin_buffer_alloc(header.size);
+
+    delta = (char *)find_tag("V") - (char *)header.tag_base;
+    if (delta)
+        skin_cache_relocate_tags(SKINOFFSETTOPTR(skin_buffer,
+                                                 header.data.tree), delta);
+
+    delta = skin_buffer - header.buffer_base;
+    for (list = SKINOFFSETTOPTR(skin_buffer, header.data.images); list;
+         list = SKINOFFSETTOPTR(skin_buffer, list->next))
+    {
+        struct wps_token *token = SKINOFFSETTOPTR(skin_buffer, list->token);
+        struct gui_img *img = SKINOFFSETTOPTR(skin_buffer, token->value.data);
+        if (img->bm.data)
+            img->bm.data += delta;
+    }
+
+#ifdef HAVE_TOUCHSCREEN
+    delta = (char *)get_settings_list(&i) - (char *)header.settings_base;
+    for (list = SKINOFFSETTOPTR(skin_buffer, header.data.touchregions); list;
+         list = SKINOFFSETTOPTR(skin_buffer, list->next))
+    {
+        struct wps_token *token = SKINOFFSETTOPTR(skin_buffer, list->token);
+        struct touchregion *region = SKINOFFSETTOPTR(skin_buffer,
+                                                     token->value.data);
+        if (region->action == ACTION_SETTINGS_INC ||
+            region->action == ACTION_SETTINGS_DEC ||
+            region->action == ACTION_SETTINGS_SET)
+        {
+            region->setting_data.setting = (void *)
+                    ((char *)region->setting_data.setting + delta);
+        }
+        else if (region->action == ACTION_TOUCH_MUTE)
+            region->value = global_settings.volume;
+    }
+#endif
+
+    /* the parse results, everything that refers to loaded resources stays
+     * as skin_data_reset() left it */
+    wps_data->tree = header.data.tree;
+    wps_data->images = header.data.images;
+#ifdef HAVE_BACKDROP_IMAGE
+    wps_data->use_extra_framebuffer = header.data.use_extra_framebuffer;
+    switch (header.backdrop_type)
+    {
+        case CACHE_BACKDROP_NONE:
+            backdrop_filename = NULL;
+            break;
+        case CACHE_BACKDROP_SETTING:
+            backdrop_filename = "-";
+            break;
+        case CACHE_BACKDROP_BUFFER:
+            backdrop_filename = BACKDROP_BUFFERNAME;
+            break;
+        default:
+            backdrop_filename = SKINOFFSETTOPTR(skin_buffer, header.backdrop);
+            break;
+    }
+#endif
+#ifdef HAVE_TOUCHSCREEN
+    wps_data->touchregions = header.data.touchregions;
+#endif
+#ifdef HAVE_SKIN_VARIABLES
+    wps_data->skinvars = header.data.skinvars;
+#endif
+    wps_data->wps_sb_tag = header.data.wps_sb_tag;
+    wps_data->show_sb_on_wps = header.data.show_sb_on_wps;
+#ifdef HAVE_ALBUMART
+    wps_data->albumart = header.data.albumart;
+    struct skin_albumart *aa = SKINOFFSETTOPTR(skin_buffer, wps_data->albumart);
+    if (aa)
+    {
+        struct dim dimensions = { .width = aa->width, .height = aa->height };
+        int albumart_slot = playback_claim_aa_slot(&dimensions);
+        if (0 <= albumart_slot)
+            wps_data->playback_aa_slot = albumart_slot;
+    }
+#endif
+
+    for (i = 0; i < MAXUSERFONTS; i++)
+    {
+        skinfonts[i].name = SKINOFFSETTOPTR(skin_buffer, header.fonts[i].name);
+        skinfonts[i].glyphs = header.fonts[i].glyphs;
+    }
+    if (header.has_list_title)
+        sb_skin_has_title(curr_screen);
+
+    return true;
+}
+#endif /* SKIN_CACHE */
+
 /* to setup up the wps-data from a format-buffer (isfile = false)
    from a (wps-)file (isfile = true)*/
 bool skin_data_load(enum screen_type screen, struct wps_data *wps_data,
                     const char *buf, bool isfile, struct skin_stats *stats)
 {
     char *wps_buffer = NULL;
+    struct skin_element *tree;
+#ifdef SKIN_CACHE
+    uint32_t cache_key = 0;
+#endif
     if (!wps_data || !buf)
         return false;
 #ifdef HAVE_LCD_BITMAP
@@ -2462,6 +2762,9 @@ bool skin_data_load(enum screen_type screen, struct wps_data *wps_data,
     curr_vp = NULL;
     curr_viewport_element = NULL;
     first_viewport = NULL;
+#ifdef SKIN_CACHE
+    has_list_title = false;
+#endif
 
     if (isfile)
     {
@@ -2484,6 +2787,9 @@ bool skin_data_load(enum screen_type screen, struct wps_data *wps_data,
         close(fd);
         if (start <= 0)
             return false;
+#ifdef SKIN_CACHE
+        cache_key = skin_cache_key(wps_buffer, start);
+#endif
         start++;
         skin_buffer = &wps_buffer[start];
         buffersize -= start;
@@ -2499,10 +2805,21 @@ bool skin_data_load(enum screen_type screen, struct wps_data *wps_data,
     backdrop_filename = "-";
     wps_data->backdrop_id = -1;
 #endif
-    /* parse the skin source */
     skin_buffer_init(skin_buffer, buffersize);
-    struct skin_element *tree = skin_parse(wps_buffer, skin_element_callback, wps_data);
-    wps_data->tree = PTRTOSKINOFFSET(skin_buffer, tree);
+#ifdef SKIN_CACHE
+    if (isfile && skin_cache_load(buf, cache_key, wps_data, buffersize))
+        tree = SKINOFFSETTOPTR(skin_buffer, wps_data->tree);
+    else
+#endif
+    {
+        /* parse the skin source */
+        tree = skin_parse(wps_buffer, skin_element_callback, wps_data);
+        wps_data->tree = PTRTOSKINOFFSET(skin_buffer, tree);
+#ifdef SKIN_CACHE
+        if (isfile && tree)
+            skin_cache_save(buf, cache_key, wps_data);
+#endif
+    }
     if (!SKINOFFSETTOPTR(skin_buffer, wps_data->tree)) {
 #ifdef DEBUG_SKIN_ENGINE
         if (isfile && debug_wps)
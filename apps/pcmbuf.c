@@ -40,6 +40,8 @@
 #include "settings.h"
 #include "audio.h"
 #include "voice_thread.h"
+#include "trace.h"
+#include "core_alloc.h"
 
 /* This is the target fill size of chunks on the pcm buffer
    Can be any number of samples but power of two sizes make for faster and
@@ -130,6 +132,15 @@ static bool fade_out_complete = false;
 /* Voice */
 static bool soft_mode = false;
 
+/* Analysis tap - a copy of the chunks handed to the mixer. Holds two full
+   chunks: the one playing and the one before it. Allocated while used. */
+#define PCMBUF_TAP_FRAMES   (2*PCMBUF_CHUNK_SIZE / 4)
+static int16_t * volatile pcmbuf_tap_buf SHAREDBSS_ATTR;
+static unsigned int volatile tap_widx SHAREDBSS_ATTR; /* Frames written */
+static unsigned int volatile tap_wend SHAREDBSS_ATTR; /* ...and being written */
+static int tap_handle = 0;
+static int tap_users = 0;
+
 #ifdef HAVE_CROSSFADE
 /* Crossfade buffer */
 static void *crossfade_buffer;
@@ -716,6 +727,22 @@ void pcmbuf_start_track_change(enum pcm_track_change_type type)
 
 /** Playback */
 
+/* Copy a chunk into the analysis tap */
+static void pcmbuf_tap_write(const void *start, size_t size)
+{
+    size_t frames = size / 4;
+    size_t index = tap_widx & (PCMBUF_TAP_FRAMES - 1);
+    size_t count = MIN(frames, PCMBUF_TAP_FRAMES - index);
+
+    /* Readers of the frames about to be overwritten must see it first */
+    tap_wend = tap_widx + frames;
+
+    memcpy(&pcmbuf_tap_buf[index*2], start, count*4);
+    memcpy(pcmbuf_tap_buf, start + count*4, (frames - count)*4);
+
+    tap_widx = tap_wend;
+}
+
 /* PCM driver callback */
 static void pcmbuf_pcm_callback(const void **start, size_t *size)
 {
@@ -723,6 +750,8 @@ static void pcmbuf_pcm_callback(const void **start, size_t *size)
     size_t index = chunk_ridx;
     struct chunkdesc *desc = current_desc;
 
+    TRACE_ISR_BEGIN(TP_PCMBUF_CALLBACK, 0);
+
     if (desc)
     {
         /* If last chunk in the track, notify of track change */
@@ -741,6 +770,9 @@ static void pcmbuf_pcm_callback(const void **start, size_t *size)
         *start = index_buffer(index);
         *size = desc->size;
 
+        if (pcmbuf_tap_buf)
+            pcmbuf_tap_write(*start, *size);
+
         if (desc->pos_key != 0)
         {
             /* Positioning chunk - notify playback */
@@ -748,6 +780,11 @@ static void pcmbuf_pcm_callback(const void **start, size_t *size)
                                            desc->pos_key);
         }
     }
+
+    /* nothing handed out means the buffer ran dry */
+    TRACE_ISR_END(TP_PCMBUF_CALLBACK, *size);
+    if (*size == 0)
+        TRACE_TRIGGER();
 }
 
 /* Force playback */
@@ -1315,6 +1352,95 @@ void pcmbuf_sync_position_update(void)
 }
 
 
+/** Analysis tap */
+
+/* Start or stop copying the audio played for pcmbuf_tap_read(); calls
+   nest. Returns false if there is no memory for the tap. */
+bool pcmbuf_tap_enable(bool enable)
+{
+    if (enable)
+    {
+        if (tap_users++ > 0)
+            return true;
+
+        /* Written from the PCM interrupt - must not move */
+        static struct buflib_callbacks ops = { NULL, NULL, NULL };
+        tap_handle = core_alloc_ex("pcm tap",
+                                   PCMBUF_TAP_FRAMES*4 + CACHEALIGN_SIZE, &ops);
+        if (tap_handle <= 0)
+        {
+            tap_users = 0;
+            return false;
+        }
+
+        int16_t *buf = CACHEALIGN_UP((int16_t *)core_get_data(tap_handle));
+#if NUM_CORES > 1 && (CONFIG_PLATFORM & PLATFORM_NATIVE)
+        /* Read on the other core - keep it out of the caches */
+        commit_discard_dcache();
+        buf = UNCACHED_ADDR(buf);
+#endif
+
+        pcm_play_lock();
+
+        pcmbuf_tap_buf = buf;
+
+        /* Catch up with the chunk playing now */
+        if (current_desc)
+            pcmbuf_tap_write(index_buffer(chunk_ridx), current_desc->size);
+
+        pcm_play_unlock();
+    }
+    else if (tap_users > 0 && --tap_users == 0)
+    {
+        pcm_play_lock();
+        pcmbuf_tap_buf = NULL;
+        pcm_play_unlock();
+
+        tap_handle = core_free(tap_handle);
+    }
+
+    return true;
+}
+
+/* Return the count of the frame playing now. Frames before it can be
+   read. */
+unsigned int pcmbuf_tap_position(void)
+{
+    unsigned int widx;
+    size_t waiting;
+
+    /* The mixer may give out the next chunk in between */
+    do
+    {
+        widx = tap_widx;
+        waiting = mixer_channel_get_bytes_waiting(PCM_MIXER_CHAN_PLAYBACK);
+    }
+    while (widx != tap_widx);
+
+    return widx - waiting / 4;
+}
+
+/* Copy count frames starting at frame pos as interleaved stereo samples.
+   Returns false if they aren't all in the tap, not yet or not anymore. */
+bool pcmbuf_tap_read(unsigned int pos, int16_t *dest, int count)
+{
+    const int16_t *buf = pcmbuf_tap_buf;
+
+    if (!buf || count <= 0 || tap_widx - pos < (unsigned int)count ||
+        tap_wend - pos > PCMBUF_TAP_FRAMES)
+        return false;
+
+    size_t index = pos & (PCMBUF_TAP_FRAMES - 1);
+    size_t n = MIN((size_t)count, PCMBUF_TAP_FRAMES - index);
+
+    memcpy(dest, &buf[index*2], n*4);
+    memcpy(dest + n*2, buf, (count - n)*4);
+
+    /* The callback may have started writing over them meanwhile */
+    return tap_wend - pos <= PCMBUF_TAP_FRAMES;
+}
+
+
 
 /** Misc */
 
@@ -78,6 +78,11 @@ void pcmbuf_soft_mode(bool shhh);
 unsigned int pcmbuf_get_position_key(void);
 void pcmbuf_sync_position_update(void);
 
+/* Analysis tap - audio as it plays, for visualizations */
+bool pcmbuf_tap_enable(bool enable);
+unsigned int pcmbuf_tap_position(void);
+bool pcmbuf_tap_read(unsigned int pos, int16_t *dest, int count);
+
 /* Misc */
 bool pcmbuf_is_lowdata(void);
 void pcmbuf_set_low_latency(bool state);
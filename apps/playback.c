@@ -27,6 +27,7 @@
 #include "core_alloc.h"
 #include "sound.h"
 #include "ata.h"
+#include "storage.h"
 #include "codecs.h"
 #include "codec_thread.h"
 #include "voice_thread.h"
@@ -49,6 +50,7 @@
 #ifdef HAVE_LCD_BITMAP
 #ifdef HAVE_ALBUMART
 #include "albumart.h"
+#include "albumart_cache.h"
 #endif
 #endif
 
@@ -740,7 +742,7 @@ static void audio_reset_buffer_noalloc(
 {
     /*
      * Layout audio buffer as follows:
-     * [|SCRATCH|BUFFERING|PCM]
+     * [|SCRATCH|AACACHE|BUFFERING|PCM]
      */
     logf("%s()", __func__);
 
@@ -769,6 +771,19 @@ static void audio_reset_buffer_noalloc(
     filebuf += allocsize;
     filebuflen -= allocsize;
 
+#ifdef HAVE_ALBUMART
+    /* Album art cache, only if it leaves a sensible amount for buffering */
+    allocsize = ALIGN_UP(ALBUMART_CACHE_SIZE, sizeof (intptr_t));
+    if (allocsize > 0 && filebuflen >= allocsize + 4*AUDIO_BUFFER_RESERVE)
+    {
+        albumart_cache_init(filebuf, allocsize);
+        filebuf += allocsize;
+        filebuflen -= allocsize;
+    }
+    else
+        albumart_cache_init(NULL, 0);
+#endif
+
     buffering_reset(filebuf, filebuflen);
 
     buffer_state = AUDIOBUF_STATE_INITIALIZED;
@@ -872,6 +887,9 @@ static int shrink_callback(int handle, unsigned hints, void* start, size_t old_s
     if (give_up)
     {
         buffer_state = AUDIOBUF_STATE_TRASHED;
+#ifdef HAVE_ALBUMART
+        albumart_cache_init(NULL, 0);
+#endif
         audiobuf_handle = core_free(audiobuf_handle);
         return BUFLIB_CB_OK;
     }
@@ -1632,22 +1650,37 @@ static bool audio_load_albumart(struct track_info *info,
 #endif
 
         /* We can only decode jpeg for embedded AA */
-        if (track_id3->has_embedded_albumart && track_id3->albumart.type == AA_TYPE_JPG)
+        if (track_id3->has_embedded_albumart && track_id3->albumart.type == AA_TYPE_JPG &&
+            !albumart_cache_lookup(track_id3, user_data.dim, true, &hid))
         {
             user_data.embedded_albumart = &track_id3->albumart;
             hid = bufopen(track_id3->path, 0, TYPE_BITMAP, &user_data);
+            albumart_cache_store(track_id3, user_data.dim, true, hid);
         }
 
         if (hid < 0 && hid != ERR_BUFFER_FULL)
         {
             /* No embedded AA or it couldn't be loaded - try other sources */
             char path[MAX_PATH];
+            /* Unless there's a bitmap for just this track, whatever gets
+               found is the same for the whole album */
+            bool shared = !find_track_albumart(track_id3, path, sizeof(path),
+                                               user_data.dim);
 
-            if (find_albumart(track_id3, path, sizeof(path),
-                              &albumart_slots[i].dim))
+            if (!shared || !albumart_cache_lookup(track_id3, user_data.dim,
+                                                  false, &hid))
             {
-                user_data.embedded_albumart = NULL;
-                hid = bufopen(path, 0, TYPE_BITMAP, &user_data);
+                if (find_albumart(track_id3, path, sizeof(path),
+                                  &albumart_slots[i].dim))
+                {
+                    user_data.embedded_albumart = NULL;
+                    hid = bufopen(path, 0, TYPE_BITMAP, &user_data);
+                }
+                else
+                    hid = ERR_FILE_ERROR;
+
+                if (shared)
+                    albumart_cache_store(track_id3, user_data.dim, false, hid);
             }
         }
 
@@ -1675,6 +1708,45 @@ static bool audio_load_albumart(struct track_info *info,
 
     return true;
 }
+
+/* Have the album art of the next tracks that aren't buffered yet decoded
+   into the album art cache, so it is there right away when skipping to them.
+   Runs while buffering is idle and hands over at most one track per call. */
+static void audio_prefetch_albumart(void)
+{
+    struct dim dims[MAX_MULTIPLE_AA];
+    char name_buf[MAX_PATH + 1];
+    int i, count = 0;
+
+    if (skip_pending != TRACK_SKIP_NONE)
+        return;
+
+#if defined(HAVE_DISK_STORAGE) && !defined(HAVE_HOSTFS)
+    /* not worth spinning up the disk for */
+    if (!storage_disk_is_active())
+        return;
+#endif
+
+    FOREACH_ALBUMART(i)
+    {
+        if (albumart_slots[i].used)
+            dims[count++] = albumart_slots[i].dim;
+    }
+
+    if (count == 0)
+        return;
+
+    for (i = 1; i <= ALBUMART_PREFETCH_TRACKS; i++)
+    {
+        const char *trackname = playlist_peek(playlist_peek_offset + i,
+                                              name_buf, sizeof (name_buf));
+        if (!trackname)
+            break;
+
+        if (albumart_cache_prefetch(trackname, dims, count))
+            break;
+    }
+}
 #endif /* HAVE_ALBUMART */
 
 #ifdef HAVE_CODEC_BUFFERING
@@ -3065,6 +3137,11 @@ void audio_playback_handler(struct queue_event *ev)
         case Q_AUDIO_INIT_RECORDING:
 #endif
         case SYS_USB_CONNECTED:
+#ifdef HAVE_ALBUMART
+            /* the files the cached art came from may change */
+            albumart_cache_flush();
+#endif
+            /* Fall-through */
         case Q_AUDIO_STOP:
             LOGFQUEUE("playback < Q_AUDIO_STOP");
             audio_stop_playback();
@@ -3149,6 +3226,10 @@ void audio_playback_handler(struct queue_event *ev)
 
         case SYS_TIMEOUT:
             LOGFQUEUE_SYS_TIMEOUT("playback < SYS_TIMEOUT");
+#ifdef HAVE_ALBUMART
+            if (filling == STATE_FULL)
+                audio_prefetch_albumart();
+#endif
             break;
 
         default:
@@ -3460,6 +3541,9 @@ void audio_hard_stop(void)
     audio_queue_send(Q_AUDIO_STOP, 1);
 #ifdef PLAYBACK_VOICE
     voice_stop();
+#endif
+#ifdef HAVE_ALBUMART
+    albumart_cache_init(NULL, 0);
 #endif
     if (audiobuf_handle > 0)
         audiobuf_handle = core_free(audiobuf_handle);
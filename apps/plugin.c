@@ -445,6 +445,8 @@ static const struct plugin_api rockbox_api = {
     queue_delete,
     queue_post,
     queue_wait_w_tmo,
+    queue_wait_many,
+    queue_enable_single_producer,
 #if CONFIG_CODEC == SWCODEC
     queue_enable_queue_send,
     queue_empty,
@@ -805,6 +807,14 @@ static const struct plugin_api rockbox_api = {
 
     /* new stuff at the end, sort into place next time
        the API gets incompatible */
+#ifdef HAVE_LCD_COLOR
+    lcd_alpha_bitmap_part,
+#endif
+#if CONFIG_CODEC == SWCODEC
+    pcmbuf_tap_enable,
+    pcmbuf_tap_position,
+    pcmbuf_tap_read,
+#endif
 };
 
 static int plugin_buffer_handle;
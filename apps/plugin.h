@@ -160,12 +160,12 @@ void* plugin_get_buffer(size_t *buffer_size);
 #define PLUGIN_MAGIC 0x526F634B /* RocK */
 
 /* increase this every time the api struct changes */
-#define PLUGIN_API_VERSION 231
+#define PLUGIN_API_VERSION 235
 
 /* update this to latest version if a change to the api struct breaks
    backwards compatibility (and please take the opportunity to sort in any
    new function which are "waiting" at the end of the function table) */
-#define PLUGIN_MIN_API_VERSION 231
+#define PLUGIN_MIN_API_VERSION 233
 
 /* plugin return codes */
 /* internal returns start at 0x100 to make exit(1..255) work */
@@ -547,6 +547,9 @@ struct plugin_api {
     void (*queue_post)(struct event_queue *q, long id, intptr_t data);
     void (*queue_wait_w_tmo)(struct event_queue *q, struct queue_event *ev,
             int ticks);
+    int (*queue_wait_many)(struct event_queue *q, struct queue_event *evs,
+            int count, int ticks);
+    void (*queue_enable_single_producer)(struct event_queue *q);
 #if CONFIG_CODEC == SWCODEC
     void (*queue_enable_queue_send)(struct event_queue *q,
                                     struct queue_sender_list *send,
@@ -977,6 +980,16 @@ struct plugin_api {
 
     /* new stuff at the end, sort into place next time
        the API gets incompatible */
+#ifdef HAVE_LCD_COLOR
+    void (*lcd_alpha_bitmap_part)(const unsigned char *src, int src_x,
+                                  int src_y, int stride, int x, int y,
+                                  int width, int height);
+#endif
+#if CONFIG_CODEC == SWCODEC
+    bool (*pcmbuf_tap_enable)(bool enable);
+    unsigned int (*pcmbuf_tap_position)(void);
+    bool (*pcmbuf_tap_read)(unsigned int pos, int16_t *dest, int count);
+#endif
 };
 
 /* plugin header */
@@ -0,0 +1,154 @@
+--[[
+             __________               __   ___.
+   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+                     \/            \/     \/    \/            \/
+ $Id$
+
+ Benchmark of the Lua interpreter: table, global and method access, strings,
+ calls into the plugin API and the pauses of the collector.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ KIND, either express or implied.
+
+]]--
+
+require("actions")
+
+-- Microseconds, from the tick where there's no finer timer
+local now = rb.usec_timer or function()
+    return rb.current_tick() * (1000000 / rb.HZ)
+end
+
+-- Each test runs long enough for the tick to be good enough
+local MIN_TIME = 250000
+
+local line = 0
+local function printf(...)
+    rb.lcd_puts(0, line, string.format(...))
+    rb.lcd_update()
+    line = line + 1
+end
+
+-- Runs f(n) with a doubling n until it takes MIN_TIME, prints operations/ms
+local function bench(name, f)
+    local n, t = 64
+    repeat
+        n = n * 2
+        local t0 = now()
+        f(n)
+        t = now() - t0
+        rb.yield()
+    until t >= MIN_TIME
+
+    printf("%-7s %6d kops/s", name, n / (t / 1000))
+end
+
+local function bench_array(n)
+    local a = {}
+    for i = 1, 64 do a[i] = i end
+    local s = 0
+    for i = 1, n do
+        local j = i % 64 + 1
+        a[j] = a[j] + s
+        s = a[j]
+    end
+end
+
+local function bench_field(n)
+    local p = { x = 1, y = 2 }
+    for i = 1, n do
+        p.x = p.x + p.y
+    end
+end
+
+local Counter = {}
+Counter.__index = Counter
+
+function Counter:add(v)
+    self.count = self.count + v
+end
+
+local function bench_method(n)
+    local c = setmetatable({ count = 0 }, Counter)
+    for i = 1, n do
+        c:add(i)
+    end
+end
+
+bench_global_value = 1
+
+local function bench_global(n)
+    local s = 0
+    for i = 1, n do
+        s = s + bench_global_value
+    end
+end
+
+local function bench_string(n)
+    local t = {}
+    for i = 1, n do
+        t[i % 32 + 1] = "key" .. i
+    end
+end
+
+local function bench_api(n)
+    for i = 1, n do
+        rb.current_tick()
+    end
+end
+
+local function bench_alloc(n)
+    local t = {}
+    for i = 1, n do
+        t[i % 256 + 1] = { i, i }
+    end
+end
+
+-- Makes garbage like a game does and collects kb KB of it between frames:
+-- prints for how long the collector holds up the next frame.
+local function bench_gc(kb)
+    local frames, total, max = 100, 0, 0
+    local live = {}
+
+    collectgarbage("collect")
+    for f = 1, frames do
+        for i = 1, 100 do
+            live[i % 50 + 1] = { f, i, "frame" .. i }
+        end
+        local t0 = now()
+        collectgarbage("frame", kb)
+        local t = now() - t0
+        total = total + t
+        if t > max then max = t end
+        rb.yield()
+    end
+
+    printf("gc %2dK  avg %5d max %6d us", kb, total / frames, max)
+end
+
+rb.lcd_clear_display()
+rb.splash(0, "Running...")
+rb.lcd_clear_display()
+
+bench("array", bench_array)
+bench("field", bench_field)
+bench("method", bench_method)
+bench("global", bench_global)
+bench("string", bench_string)
+bench("api", bench_api)
+bench("alloc", bench_alloc)
+bench_gc(1)
+bench_gc(4)
+bench_gc(16)
+
+repeat
+    local action = rb.get_action(rb.contexts.CONTEXT_STD, rb.HZ)
+until action == rb.actions.ACTION_STD_CANCEL
@@ -0,0 +1,296 @@
+/***************************************************************************
+ *             __________               __   ___.
+ *   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+ *   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+ *   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+ *   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+ *                     \/            \/     \/    \/            \/
+ * $Id$
+ *
+ * Event queue throughput benchmark
+ *
+ * A producer thread posts numbered events as fast as the queue takes them
+ * and a consumer thread takes them, first through a plain queue with
+ * queue_wait_w_tmo(), then through a single producer queue and finally
+ * through a single producer queue drained with queue_wait_many(). With more
+ * than one core this is repeated with the producer on the other core.
+ *
+ * Reported are the events per second and the context switches per event,
+ * the latter counted as the waits of the consumer that found the queue
+ * empty plus the yields of the producer that found it full. The results go
+ * to the screen and to bench_queue_log_*.txt.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ ****************************************************************************/
+
+#include "plugin.h"
+
+#ifdef USEC_TIMER
+#define NOW()       ((long)USEC_TIMER)
+#define PER_SECOND  1000000
+#else
+#define NOW()       (*rb->current_tick)
+#define PER_SECOND  HZ
+#endif
+
+#define EVENTS      50000
+#define STALL_TMO   (5*HZ)
+
+#define EV_DATA     1
+
+enum bench_mode
+{
+    MODE_PLAIN = 0,     /* queue_post() + queue_wait_w_tmo() */
+    MODE_SINGLE,        /* lock-free queue_post() + queue_wait_w_tmo() */
+    MODE_SINGLE_MANY,   /* lock-free queue_post() + queue_wait_many() */
+    NUM_MODES
+};
+
+static const char * const mode_names[NUM_MODES] =
+{
+    [MODE_PLAIN]       = "post/wait",
+    [MODE_SINGLE]      = "1-prod/wait",
+    [MODE_SINGLE_MANY] = "1-prod/many",
+};
+
+static struct event_queue bench_q SHAREDBSS_ATTR;
+static volatile long consumed SHAREDBSS_ATTR;
+static volatile bool stalled SHAREDBSS_ATTR;
+static long producer_yields SHAREDBSS_ATTR;
+static long consumer_blocks SHAREDBSS_ATTR;
+static long out_of_order SHAREDBSS_ATTR;
+static enum bench_mode mode SHAREDBSS_ATTR;
+
+static long producer_stack[DEFAULT_STACK_SIZE / sizeof(long)];
+static long consumer_stack[DEFAULT_STACK_SIZE / sizeof(long)];
+
+static int line = 0;
+static int max_line = 0;
+static int log_fd = -1;
+
+static void log_init(void)
+{
+    char logfilename[MAX_PATH];
+    int h;
+
+#ifdef HAVE_LCD_BITMAP
+    rb->lcd_setfont(FONT_SYSFIXED);
+#endif
+    rb->lcd_getstringsize("A", NULL, &h);
+    max_line = LCD_HEIGHT / h;
+    line = 0;
+    rb->lcd_clear_display();
+    rb->lcd_update();
+
+    rb->create_numbered_filename(logfilename, HOME_DIR, "bench_queue_log_",
+                                 ".txt", 2 IF_CNFN_NUM_(, NULL));
+    log_fd = rb->open(logfilename, O_RDWR|O_CREAT|O_TRUNC, 0666);
+}
+
+static void log_text(const char *fmt, ...)
+{
+    char buf[64];
+    va_list ap;
+
+    va_start(ap, fmt);
+    rb->vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+
+    rb->lcd_puts(0, line, buf);
+    rb->lcd_update();
+    if (++line >= max_line)
+        line = 0;
+
+    if (log_fd >= 0)
+        rb->fdprintf(log_fd, "%s\n", buf);
+}
+
+static void log_close(void)
+{
+    if (log_fd >= 0)
+        rb->close(log_fd);
+    log_fd = -1;
+}
+
+/* Posts as long as there is room - an overflowing queue would lose events */
+static void producer_thread(void)
+{
+    long yields = 0;
+
+    for (long i = 0; i < EVENTS && !stalled; i++)
+    {
+        while (i - consumed >= QUEUE_LENGTH && !stalled)
+        {
+            rb->yield();
+            yields++;
+        }
+
+        rb->queue_post(&bench_q, EV_DATA, i);
+    }
+
+    producer_yields = yields;
+    rb->thread_exit();
+}
+
+static void consumer_thread(void)
+{
+    struct queue_event evs[QUEUE_LENGTH];
+    long expect = 0, blocks = 0, bad = 0;
+
+    while (expect < EVENTS && !stalled)
+    {
+        int n;
+
+        if (rb->queue_empty(&bench_q))
+            blocks++;
+
+        if (mode == MODE_SINGLE_MANY)
+        {
+            n = rb->queue_wait_many(&bench_q, evs, QUEUE_LENGTH, STALL_TMO);
+        }
+        else
+        {
+            rb->queue_wait_w_tmo(&bench_q, &evs[0], STALL_TMO);
+            n = evs[0].id != SYS_TIMEOUT;
+        }
+
+        if (n == 0)
+        {
+            stalled = true;
+            break;
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            if (evs[i].data != expect)
+                bad++;
+            expect++;
+        }
+
+        consumed = expect;
+    }
+
+    consumer_blocks = blocks;
+    out_of_order = bad;
+    rb->thread_exit();
+}
+
+static bool run_bench(enum bench_mode m, unsigned int producer_core)
+{
+    unsigned int producer_id, consumer_id;
+
+    (void)producer_core;
+
+    mode = m;
+    consumed = 0;
+    stalled = false;
+    producer_yields = consumer_blocks = out_of_order = 0;
+
+    rb->queue_init(&bench_q, false);
+    if (m != MODE_PLAIN)
+        rb->queue_enable_single_producer(&bench_q);
+
+    consumer_id = rb->create_thread(consumer_thread, consumer_stack,
+                                    sizeof(consumer_stack), CREATE_THREAD_FROZEN,
+                                    "queue consumer"
+                                    IF_PRIO(, PRIORITY_PLAYBACK) IF_COP(, CPU));
+    producer_id = rb->create_thread(producer_thread, producer_stack,
+                                    sizeof(producer_stack), CREATE_THREAD_FROZEN,
+                                    "queue producer"
+                                    IF_PRIO(, PRIORITY_PLAYBACK)
+                                    IF_COP(, producer_core));
+
+    if (consumer_id == 0 || producer_id == 0)
+    {
+        /* let whichever thread got created quit right away */
+        stalled = true;
+        if (consumer_id != 0)
+        {
+            rb->thread_thaw(consumer_id);
+            rb->thread_wait(consumer_id);
+        }
+        if (producer_id != 0)
+        {
+            rb->thread_thaw(producer_id);
+            rb->thread_wait(producer_id);
+        }
+        rb->queue_delete(&bench_q);
+        log_text("out of thread slots");
+        return false;
+    }
+
+    long start = NOW();
+
+    rb->thread_thaw(consumer_id);
+    rb->thread_thaw(producer_id);
+    rb->thread_wait(consumer_id);
+    rb->thread_wait(producer_id);
+
+    long time = NOW() - start;
+
+    rb->queue_delete(&bench_q);
+
+    if (stalled)
+    {
+        log_text("%-12s stalled", mode_names[m]);
+        return false;
+    }
+
+    if (time <= 0)
+        time = 1;
+
+    long switches = producer_yields + consumer_blocks;
+
+    log_text("%-12s %7ld/s %ld.%02ld sw", mode_names[m],
+             (long)((long long)EVENTS * PER_SECOND / time),
+             switches / EVENTS, (switches % EVENTS) * 100 / EVENTS);
+
+    if (out_of_order)
+    {
+        log_text(" %ld events out of order", out_of_order);
+        return false;
+    }
+
+    return true;
+}
+
+enum plugin_status plugin_start(const void *parameter)
+{
+    bool ok = true;
+
+    (void)parameter;
+
+    log_init();
+    log_text("bench_queue, %d events", EVENTS);
+
+#ifdef HAVE_ADJUSTABLE_CPU_FREQ
+    rb->cpu_boost(true);
+#endif
+
+    for (unsigned int core = 0; core < NUM_CORES && ok; core++)
+    {
+        log_text(core == CPU ? "same core:" : "across cores:");
+
+        for (int m = 0; m < NUM_MODES && ok; m++)
+            ok = run_bench(m, core);
+    }
+
+#ifdef HAVE_ADJUSTABLE_CPU_FREQ
+    rb->cpu_boost(false);
+#endif
+
+    log_close();
+
+    log_text("done, press a button");
+    rb->button_clear_queue();
+    rb->button_get(true);
+
+    return ok ? PLUGIN_OK : PLUGIN_ERROR;
+}
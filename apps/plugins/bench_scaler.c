@@ -76,11 +76,38 @@ const struct custom_format format_null = {
 
 #define lcd_printf(...) \
 do { \
+    if (output_y + font_h > LCD_HEIGHT) \
+        clear_screen(); \
     rb->lcd_putsxyf(0, output_y, __VA_ARGS__); \
     rb->lcd_update_rect(0, output_y, LCD_WIDTH, font_h); \
     output_y += font_h; \
 } while (0)
 
+static void clear_screen(void)
+{
+    rb->lcd_set_drawmode(DRMODE_SOLID|DRMODE_INVERSEVID);
+    rb->lcd_fillrect(0, 0, LCD_WIDTH, LCD_HEIGHT);
+    rb->lcd_set_drawmode(DRMODE_SOLID);
+    rb->lcd_update();
+    output_y = 0;
+}
+
+/* the output stages timed for every scale, the null output gives the cost of
+   the scaler alone */
+static const struct {
+    const char *name;
+    const struct custom_format *format;
+    int format_index;
+} paths[] = {
+    { "scale", &format_null, 0 },
+#if LCD_DEPTH > 1
+    { "native", &format_native, 0 },
+#ifdef HAVE_LCD_COLOR
+    { "yuv", &format_native, 1 },
+#endif
+#endif
+};
+
 /* this is the plugin entry point */
 enum plugin_status plugin_start(const void* parameter)
 {
@@ -94,42 +121,52 @@ enum plugin_status plugin_start(const void* parameter)
     };
     (void)parameter;
 
-    rb->lcd_set_drawmode(DRMODE_SOLID|DRMODE_INVERSEVID);
-    rb->lcd_fillrect(0, 0, LCD_WIDTH, LCD_HEIGHT);
-    rb->lcd_set_drawmode(DRMODE_SOLID);
     rb->lcd_getstringsize("A", NULL, &font_h);
+    clear_screen();
+    /* the native outputs need somewhere to put the largest bitmap */
+    size_t bm_size = BM_SIZE(256, 256, FORMAT_NATIVE, false);
+    memset(&bm, 0, sizeof(bm));
     bm.data = plugin_buf;
+    plugin_buf += bm_size;
+    plugin_buf_len -= bm_size;
     int in, out;
+    unsigned i;
     for (in = 64; in < 1025; in <<= 2)
     {
         for (out = 64; out < 257; out <<= 1)
         {
             if (in == out)
                 continue;
-            lcd_printf("timing %dx%d->%dx>%d scale", in, in, out, out);
-            long t1, t2, t_end;
-            int count = 0;
-            t2 = *(rb->current_tick);
-            in_dim.width = in_dim.height = in;
-            bm.width = bm.height = rset.rowstop = out;
-            while (t2 != (t1 = *(rb->current_tick)));
-            t_end = t1 + 10 * HZ;
-            do {
-                resize_on_load(&bm, false, &in_dim, &rset, (unsigned char *)plugin_buf, plugin_buf_len, &format_null, IF_PIX_FMT(0,) store_part_null, NULL);
-                count++;
+            lcd_printf("%dx%d->%dx%d %s", in, in, out, out,
+                       in > out ? "area" : "linear");
+            for (i = 0; i < ARRAYLEN(paths); i++)
+            {
+                long t1, t2, t_end;
+                int count = 0;
                 t2 = *(rb->current_tick);
-            } while (TIME_BEFORE(t2, t_end) || count < 10);
-            t2 -= t1;
-            t2 *= 10;
-            t2 += count >> 1;
-            t2 /= count;
-            t1 = t2 / 1000;
-            t2 -= t1 * 1000;
-            lcd_printf("%01d.%03d secs/scale", (int)t1, (int)t2);
-            if (!(bm.width && bm.height))
-                break;
+                in_dim.width = in_dim.height = in;
+                bm.width = bm.height = rset.rowstop = out;
+                while (t2 != (t1 = *(rb->current_tick)));
+                t_end = t1 + 2 * HZ;
+                do {
+                    resize_on_load(&bm, true, &in_dim, &rset, plugin_buf,
+                                   plugin_buf_len, paths[i].format,
+                                   IF_PIX_FMT(paths[i].format_index,)
+                                   store_part_null, NULL);
+                    count++;
+                    t2 = *(rb->current_tick);
+                } while (TIME_BEFORE(t2, t_end) || count < 10);
+                t2 -= t1;
+                /* source pixels per second, in units of 1/100 Mpx */
+                unsigned long long px = (unsigned long long)count * in * in;
+                unsigned long mpx = px * HZ / ((unsigned long long)t2 * 10000);
+                lcd_printf("  %-6s %3lu.%02lu Mpx/s  %d ms/scale",
+                           paths[i].name, mpx / 100, mpx % 100,
+                           (int)((t2 * 1000 + count * HZ / 2) / (count * HZ)));
+            }
         }
     }
+    lcd_printf("done");
 
     while (rb->get_action(CONTEXT_STD,1) != ACTION_STD_OK) rb->yield();
     return PLUGIN_OK;
@@ -0,0 +1,328 @@
+/***************************************************************************
+ *             __________               __   ___.
+ *   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+ *   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+ *   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+ *   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+ *                     \/            \/     \/    \/            \/
+ * $Id$
+ *
+ * Scheduler latency benchmark
+ *
+ * Threads standing in for the codec, voice and buffering threads, at the
+ * same priorities, are woken every tick by a realtime thread and measure
+ * the time from the queue_post() until they run. This is repeated with an
+ * increasing number of CPU bound threads at UI, system and background
+ * priority competing for the processor, the way the tagcache, dircache and
+ * playlist threads do during a track change. The cost of a yield() with
+ * all of them runnable is measured too.
+ *
+ * Times are in microseconds on targets with a USEC_TIMER, in ticks
+ * elsewhere. The results go to the screen and to bench_sched_log_*.txt.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ ****************************************************************************/
+
+#include "plugin.h"
+
+#ifdef USEC_TIMER
+#define NOW()       ((long)USEC_TIMER)
+#define TIME_UNIT   "us"
+#else
+#define NOW()       (*rb->current_tick)
+#define TIME_UNIT   "ticks"
+#endif
+
+#define PHASE_TIME  (2*HZ)
+#define MAX_LOAD    6
+#define YIELDS      1000
+
+#define EV_WAKE     1
+#define EV_QUIT     2
+
+static struct audio_thread
+{
+    const char *name;
+    int priority;
+    unsigned int id;
+    struct event_queue queue;
+    long stack[DEFAULT_STACK_SIZE / sizeof(long)];
+    /* latency statistics of the current phase */
+    long count;
+    long sum;
+    long max;
+} audio_threads[] =
+{
+    { .name = "codec",     .priority = PRIORITY_PLAYBACK },
+    { .name = "voice",     .priority = PRIORITY_PLAYBACK - 4 },
+    { .name = "buffering", .priority = PRIORITY_BUFFERING },
+};
+
+#define NUM_AUDIO ARRAYLEN(audio_threads)
+
+static const int load_priorities[MAX_LOAD] =
+{
+    PRIORITY_USER_INTERFACE, PRIORITY_SYSTEM, PRIORITY_BACKGROUND,
+    PRIORITY_BACKGROUND, PRIORITY_SYSTEM, PRIORITY_BACKGROUND,
+};
+
+static unsigned int load_ids[MAX_LOAD];
+static long load_stacks[MAX_LOAD][DEFAULT_STACK_SIZE / sizeof(long)];
+static int num_load;
+static volatile int load_active;
+
+static unsigned int waker_id;
+static long waker_stack[DEFAULT_STACK_SIZE / sizeof(long)];
+
+static volatile bool quit;
+
+static int line = 0;
+static int max_line = 0;
+static int log_fd = -1;
+
+static void log_init(void)
+{
+    char logfilename[MAX_PATH];
+    int h;
+
+#ifdef HAVE_LCD_BITMAP
+    rb->lcd_setfont(FONT_SYSFIXED);
+#endif
+    rb->lcd_getstringsize("A", NULL, &h);
+    max_line = LCD_HEIGHT / h;
+    line = 0;
+    rb->lcd_clear_display();
+    rb->lcd_update();
+
+    rb->create_numbered_filename(logfilename, HOME_DIR, "bench_sched_log_",
+                                 ".txt", 2 IF_CNFN_NUM_(, NULL));
+    log_fd = rb->open(logfilename, O_RDWR|O_CREAT|O_TRUNC, 0666);
+}
+
+static void log_text(const char *fmt, ...)
+{
+    char buf[64];
+    va_list ap;
+
+    va_start(ap, fmt);
+    rb->vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+
+    rb->lcd_puts(0, line, buf);
+    rb->lcd_update();
+    if (++line >= max_line)
+        line = 0;
+
+    if (log_fd >= 0)
+        rb->fdprintf(log_fd, "%s\n", buf);
+}
+
+static void log_close(void)
+{
+    if (log_fd >= 0)
+        rb->close(log_fd);
+    log_fd = -1;
+}
+
+/* Stand-in for an audio thread: runs a little when told to, like a codec
+   decoding a chunk */
+static void audio_thread_func(void)
+{
+    /* create_thread() returns before the new thread gets to run, so the
+       id is stored by now */
+    unsigned int self = rb->thread_self();
+    struct audio_thread *t = audio_threads;
+    struct queue_event ev;
+
+    while (t->id != self)
+        t++;
+
+    while (1)
+    {
+        rb->queue_wait(&t->queue, &ev);
+        if (ev.id == EV_QUIT)
+            break;
+
+        long latency = NOW() - (long)ev.data;
+        t->count++;
+        t->sum += latency;
+        if (latency > t->max)
+            t->max = latency;
+
+        for (volatile int i = 0; i < 200; i++);
+    }
+
+    rb->thread_exit();
+}
+
+/* Wakes all of the audio threads every tick, as the pcm and the buffering
+   do during playback */
+static void waker_thread_func(void)
+{
+    while (!quit)
+    {
+        rb->sleep(0);
+
+        for (unsigned int i = 0; i < NUM_AUDIO; i++)
+            rb->queue_post(&audio_threads[i].queue, EV_WAKE, NOW());
+    }
+
+    rb->thread_exit();
+}
+
+/* CPU bound thread that gives up the processor every now and then */
+static void load_thread_func(void)
+{
+    unsigned int self = rb->thread_self();
+    int index = 0;
+
+    while (load_ids[index] != self)
+        index++;
+
+    while (!quit)
+    {
+        if (index >= load_active)
+        {
+            rb->sleep(HZ/20);
+            continue;
+        }
+
+        for (volatile int i = 0; i < 1000; i++);
+        rb->yield();
+    }
+
+    rb->thread_exit();
+}
+
+static void run_phase(int load)
+{
+    load_active = load;
+
+    for (unsigned int i = 0; i < NUM_AUDIO; i++)
+    {
+        audio_threads[i].count = 0;
+        audio_threads[i].sum = 0;
+        audio_threads[i].max = 0;
+    }
+
+    /* give the load threads time to wake up */
+    rb->sleep(HZ/10);
+
+    long start = NOW();
+    for (int i = 0; i < YIELDS; i++)
+        rb->yield();
+    long yield_time = NOW() - start;
+
+    long end = *rb->current_tick + PHASE_TIME;
+    while (TIME_BEFORE(*rb->current_tick, end))
+        rb->sleep(HZ/10);
+
+    log_text("%d threads busy", load);
+    for (unsigned int i = 0; i < NUM_AUDIO; i++)
+    {
+        struct audio_thread *t = &audio_threads[i];
+        log_text(" %-9s %5ld avg %6ld max", t->name,
+                 t->count ? t->sum / t->count : 0, t->max);
+    }
+    log_text(" yield %ld.%03ld " TIME_UNIT, yield_time / YIELDS,
+             (yield_time % YIELDS) * 1000 / YIELDS);
+}
+
+static void start_threads(void)
+{
+    for (unsigned int i = 0; i < NUM_AUDIO; i++)
+    {
+        struct audio_thread *t = &audio_threads[i];
+        rb->queue_init(&t->queue, false);
+        t->id = rb->create_thread(audio_thread_func, t->stack,
+                                  sizeof(t->stack), 0, t->name
+                                  IF_PRIO(, t->priority) IF_COP(, CPU));
+    }
+
+    waker_id = rb->create_thread(waker_thread_func, waker_stack,
+                                 sizeof(waker_stack), 0, "sched waker"
+                                 IF_PRIO(, PRIORITY_REALTIME) IF_COP(, CPU));
+
+    /* there are only so many thread slots, use what is left */
+    for (num_load = 0; num_load < MAX_LOAD; num_load++)
+    {
+        load_ids[num_load] =
+            rb->create_thread(load_thread_func, load_stacks[num_load],
+                              sizeof(load_stacks[num_load]), 0, "sched load"
+                              IF_PRIO(, load_priorities[num_load])
+                              IF_COP(, CPU));
+        if (load_ids[num_load] == 0)
+            break;
+    }
+}
+
+static void stop_threads(void)
+{
+    quit = true;
+
+    if (waker_id != 0)
+        rb->thread_wait(waker_id);
+
+    for (int i = 0; i < num_load; i++)
+        rb->thread_wait(load_ids[i]);
+
+    for (unsigned int i = 0; i < NUM_AUDIO; i++)
+    {
+        struct audio_thread *t = &audio_threads[i];
+        if (t->id != 0)
+        {
+            rb->queue_post(&t->queue, EV_QUIT, 0);
+            rb->thread_wait(t->id);
+        }
+        rb->queue_delete(&t->queue);
+    }
+}
+
+enum plugin_status plugin_start(const void *parameter)
+{
+    (void)parameter;
+
+    log_init();
+    log_text("bench_sched, times in " TIME_UNIT);
+
+    start_threads();
+
+    if (waker_id == 0 || audio_threads[NUM_AUDIO-1].id == 0)
+    {
+        stop_threads();
+        log_close();
+        rb->splash(HZ*2, "Out of thread slots");
+        return PLUGIN_ERROR;
+    }
+
+#ifdef HAVE_ADJUSTABLE_CPU_FREQ
+    rb->cpu_boost(true);
+#endif
+
+    for (int load = 0; ; load += 2)
+    {
+        run_phase(MIN(load, num_load));
+        if (load >= num_load)
+            break;
+    }
+
+#ifdef HAVE_ADJUSTABLE_CPU_FREQ
+    rb->cpu_boost(false);
+#endif
+
+    stop_threads();
+    log_close();
+
+    log_text("done, press a button");
+    rb->button_clear_queue();
+    rb->button_get(true);
+
+    return PLUGIN_OK;
+}
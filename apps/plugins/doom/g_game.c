@@ -59,6 +59,7 @@
 
 #include "w_wad.h"
 #include "r_main.h"
+#include "r_draw.h"
 #include "s_sound.h"
 
 // Data.
@@ -2778,14 +2779,15 @@ boolean G_CheckDemoStatus (void)
       int endtime = I_GetTime ();
       // killough -- added fps information and made it work for longer demos:
       unsigned realtics = endtime-starttime;
-      int fd=open(GAMEBASE "timedemo.txt",O_WRONLY | O_CREAT,0666);
-      fdprintf (fd,"Timed %d gametics in %d realtics = %d frames per second",
-               (unsigned) gametic, realtics,
-               (unsigned) gametic * TICRATE/ realtics);
+      // Every gametic is drawn with singletics, tenths of a frame per second
+      unsigned fps = realtics ? (unsigned) gametic * TICRATE * 10 / realtics : 0;
+      int fd=open(GAMEBASE "timedemo.txt",O_WRONLY | O_CREAT | O_TRUNC,0666);
+      fdprintf (fd,"Timed %d gametics in %d realtics = %d.%d frames per second%s\n",
+               (unsigned) gametic, realtics, fps / 10, fps % 10,
+               column_renderer ? " (column renderer)" : "");
       close(fd);
-      I_Error ("%d gametics in %d realtics",
-               (unsigned) gametic,realtics,
-               (unsigned) gametic * TICRATE / realtics);
+      I_Error ("%d gametics in %d realtics, %d.%d fps",
+               (unsigned) gametic, realtics, fps / 10, fps % 10);
       return false;
    }
 
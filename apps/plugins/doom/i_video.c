@@ -132,6 +132,12 @@ static unsigned char *gbuf;
 static char fastscreen[LCD_WIDTH*LCD_HEIGHT] IBSS_ATTR;
 #endif
 
+#ifdef HAVE_LCD_COLOR
+/* Lines converted per LCD update, a strip that stays in the data cache.
+ * A multiple of four, so that every strip starts word aligned. */
+#define UPDATE_LINES ((4096 / (LCD_WIDTH * (int)sizeof(fb_data)) + 4) & ~3)
+#endif
+
 static fb_data palette[256] IBSS_ATTR;
 static fb_data *paldata=NULL;
 
@@ -954,32 +960,69 @@ void I_FinishUpdate (void)
 #if(LCD_HEIGHT>LCD_WIDTH)
     if(rotate_screen)
     {
-        int y;
+        int y, x, n;
 
-        for (y = 1; y <= SCREENHEIGHT; y++)
+        /* Eight screen rows at a time: each goes down an LCD column, but
+         * the eight of them fill eight neighbouring pixels of a line. */
+        for (y = 0; y < SCREENHEIGHT; y += n)
         {
-            fb_data *dst = rb->lcd_framebuffer + LCD_WIDTH - y;
-            count = SCREENWIDTH;
+            fb_data *dst = rb->lcd_framebuffer + LCD_WIDTH - 1 - y;
+            n = MIN(SCREENHEIGHT - y, 8);
 
-            do
+            for (x = 0; x < SCREENWIDTH; x++)
             {
-                *dst = palette[*src++];
-                dst += LCD_WIDTH;
+                const byte *s = src + x;
+                count = n;
+
+                do
+                {
+                    *dst-- = palette[*s];
+                    s += SCREENWIDTH;
+                }
+                while (--count);
+
+                dst += LCD_WIDTH + n;
             }
-            while (--count);
+            src += n*SCREENWIDTH;
         }
+        rb->lcd_update();
     }
     else
 #endif
     {
         fb_data *dst = rb->lcd_framebuffer;
-        count = SCREENWIDTH*SCREENHEIGHT;
+        int y;
 
-        do
-            *dst++ = palette[*src++];
-        while (--count);
+        /* Convert a strip of lines and send it to the LCD while it is
+         * still in the cache, four pixels per read of the screen. */
+        for (y = 0; y < SCREENHEIGHT; y += UPDATE_LINES)
+        {
+            int lines = MIN(SCREENHEIGHT - y, UPDATE_LINES);
+            count = lines*SCREENWIDTH;
+
+            for (; count >= 4; count -= 4)
+            {
+                uint32_t p = *(const uint32_t *)src;
+#ifdef ROCKBOX_LITTLE_ENDIAN
+                dst[0] = palette[p & 0xff];
+                dst[1] = palette[(p >> 8) & 0xff];
+                dst[2] = palette[(p >> 16) & 0xff];
+                dst[3] = palette[p >> 24];
+#else
+                dst[0] = palette[p >> 24];
+                dst[1] = palette[(p >> 16) & 0xff];
+                dst[2] = palette[(p >> 8) & 0xff];
+                dst[3] = palette[p & 0xff];
+#endif
+                src += 4;
+                dst += 4;
+            }
+            while (count--)
+                *dst++ = palette[*src++];
+
+            rb->lcd_update_rect(0, y, SCREENWIDTH, lines);
+        }
     }
-    rb->lcd_update(); 
 #else /* !HAVE_LCD_COLOR */
 
     unsigned char *dst;
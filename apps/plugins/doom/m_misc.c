@@ -153,6 +153,7 @@ extern int mousebforward;
 extern int viewwidth;
 extern int viewheight;
 extern int fake_contrast;
+extern int column_renderer;
 extern int mouseSensitivity_horiz,mouseSensitivity_vert;  // killough
 
 extern int realtic_clock_rate;         // killough 4/13/98: adjustable timer
@@ -313,6 +314,8 @@ default_t defaults[] =
 #endif
       {"fake_contrast",{&fake_contrast, NULL},{1, NULL},0,1,
        def_bool,ss_none, 0, 0}, /* cph - allow crappy fake contrast to be disabled */
+      {"column_renderer",{&column_renderer, NULL},{0, NULL},0,1,
+       def_bool,ss_none, 0, 0}, /* draw the view column-major, then transpose it */
 //      {"use_fullscreen",{&use_fullscreen, NULL},{1, NULL},0,1, /* proff 21/05/2000 */
 //       def_bool,ss_none, 0, 0},
 //      {"use_doublebuffer",{&use_doublebuffer, NULL},{1, NULL},0,1,             // proff 2001-7-4
@@ -59,6 +59,16 @@ int  viewwindowy;
 
 byte *topleft IBSS_ATTR;
 
+// The step between two pixels of a column and two pixels of a span.
+// With the column renderer the view is drawn into a column-major buffer,
+// so that the wall and sprite columns, which are most of a frame, are
+// written to consecutive bytes, and transposed onto the screen at the end.
+int  dc_pitch IBSS_ATTR;
+int  ds_pitch IBSS_ATTR;
+
+int column_renderer;
+static byte *viewbuffer;
+
 // Color tables for different players,
 //  translate a limited part to another
 //  (color ramps used for  suit colors).
@@ -95,6 +105,7 @@ void R_DrawColumn (void)
    int              count;
    register byte    *dest;            // killough
    register fixed_t frac;            // killough
+   register int     pitch;
 
    // leban 1/17/99:
    // removed the + 1 here, adjusted the if test, and added an increment
@@ -117,7 +128,8 @@ void R_DrawColumn (void)
    count++;
 
    // Framebuffer destination address.
-   dest = topleft + dc_yl*SCREENWIDTH + dc_x;
+   dest = topleft + dc_yl*dc_pitch + dc_x*ds_pitch;
+   pitch = dc_pitch;
 
    // Determine scaling,
    // which is the only mapping to be done.
@@ -137,7 +149,7 @@ void R_DrawColumn (void)
       {
          *dest = dc_colormap[dc_source[(frac>>FRACBITS)&127]];
          frac += fracstep;
-         dest += SCREENWIDTH;
+         dest += pitch;
       }
    }
    else if (dc_texheight == 0)
@@ -147,7 +159,7 @@ void R_DrawColumn (void)
       {
          *dest = dc_colormap[dc_source[frac>>FRACBITS]];
          frac += fracstep;
-         dest += SCREENWIDTH;
+         dest += pitch;
       }
    }
    else
@@ -158,7 +170,7 @@ void R_DrawColumn (void)
          while (count>0)   // texture height is a power of 2 -- killough
          {
             *dest = dc_colormap[dc_source[(frac>>FRACBITS) & heightmask]];
-            dest += SCREENWIDTH;
+            dest += pitch;
             frac += fracstep;
             count--;
          }
@@ -183,7 +195,7 @@ void R_DrawColumn (void)
             // heightmask is the Tutti-Frutti fix -- killough
 
             *dest = dc_colormap[dc_source[frac>>FRACBITS]];
-            dest += SCREENWIDTH;
+            dest += pitch;
             if ((frac += fracstep) >= (int)heightmask)
                frac -= heightmask;
             count--;
@@ -210,6 +222,7 @@ void R_DrawTLColumn (void)
    int              count;
    register byte    *dest;           // killough
    register fixed_t frac;            // killough
+   register int     pitch;
 
    count = dc_yh - dc_yl + 1;
 
@@ -226,7 +239,8 @@ void R_DrawTLColumn (void)
 #endif
 
    // Framebuffer destination address.
-   dest = topleft + dc_yl*SCREENWIDTH + dc_x;
+   dest = topleft + dc_yl*dc_pitch + dc_x*ds_pitch;
+   pitch = dc_pitch;
 
    // Determine scaling,
    //  which is the only mapping to be done.
@@ -264,7 +278,7 @@ void R_DrawTLColumn (void)
             // heightmask is the Tutti-Frutti fix -- killough
 
             *dest = tranmap[(*dest<<8)+colormap[source[frac>>FRACBITS]]]; // phares
-            dest += SCREENWIDTH;
+            dest += pitch;
             if ((frac += fracstep) >= (int)heightmask)
                frac -= heightmask;
          }
@@ -275,10 +289,10 @@ void R_DrawTLColumn (void)
          while ((count-=2)>=0)   // texture height is a power of 2 -- killough
          {
             *dest = tranmap[(*dest<<8)+colormap[source[(frac>>FRACBITS) & heightmask]]]; // phares
-            dest += SCREENWIDTH;
+            dest += pitch;
             frac += fracstep;
             *dest = tranmap[(*dest<<8)+colormap[source[(frac>>FRACBITS) & heightmask]]]; // phares
-            dest += SCREENWIDTH;
+            dest += pitch;
             frac += fracstep;
          }
          if (count & 1)
@@ -326,6 +340,7 @@ void R_DrawFuzzColumn(void)
    byte     *dest;
    fixed_t  frac;
    fixed_t  fracstep;
+   int      pitch;
 
    // Adjust borders. Low...
    if (!dc_yl)
@@ -353,7 +368,8 @@ void R_DrawFuzzColumn(void)
    //  or blocky mode removed.
 
    // Does not work with blocky mode.
-   dest = topleft + dc_yl*SCREENWIDTH + dc_x;
+   dest = topleft + dc_yl*dc_pitch + dc_x*ds_pitch;
+   pitch = dc_pitch;
 
    // Looks familiar.
    fracstep = dc_iscale;
@@ -381,7 +397,7 @@ void R_DrawFuzzColumn(void)
       if (++fuzzpos == FUZZTABLE)
          fuzzpos = 0;
 
-      dest += SCREENWIDTH;
+      dest += pitch;
 
       frac += fracstep;
    }
@@ -406,6 +422,7 @@ void R_DrawTranslatedColumn (void)
    byte     *dest;
    fixed_t  frac;
    fixed_t  fracstep;
+   int      pitch;
 
    count = dc_yh - dc_yl;
    if (count < 0)
@@ -420,7 +437,8 @@ void R_DrawTranslatedColumn (void)
 #endif
 
    // FIXME. As above.
-   dest = topleft + dc_yl*SCREENWIDTH + dc_x;
+   dest = topleft + dc_yl*dc_pitch + dc_x*ds_pitch;
+   pitch = dc_pitch;
 
    // Looks familiar.
    fracstep = dc_iscale;
@@ -436,7 +454,7 @@ void R_DrawTranslatedColumn (void)
       //  is mapped to gray, red, black/indigo.
 
       *dest = dc_colormap[dc_translation[dc_source[frac>>FRACBITS]]];
-      dest += SCREENWIDTH;
+      dest += pitch;
 
       frac += fracstep;
    }
@@ -528,45 +546,50 @@ void R_DrawSpan (void)
 {
 #ifdef CPU_COLDFIRE
    // only slightly faster
-   asm volatile (
-      "tst %[count]                             \n"
-      "beq endspanloop                          \n"
-      "clr.l %%d4                               \n"
-      "spanloop:                                \n"
-      "move.l %[xfrac], %%d1                    \n"
-      "swap %%d1                                \n"
-      "and.l #63,%%d1                           \n"
-      "move.l %[yfrac], %%d2                    \n"
-      "lsr.l %[ten],%%d2                        \n"
-      "and.l #4032,%%d2                         \n"
-      "or.l %%d2, %%d1                          \n"
-      "move.b (%[source], %%d1), %%d4           \n"
-      "add.l %[ds_xstep], %[xfrac]              \n"
-      "add.l %[ds_ystep], %[yfrac]              \n"
-      "move.b (%[colormap],%%d4.l), (%[dest])+  \n"
-      "subq.l #1, %[count]                      \n"
-      "bne spanloop                             \n"
-      "endspanloop:                             \n"
-   : /* outputs */
-   : /* inputs */
-      [ten] "d"(10),
-      [count] "d" (ds_x2-ds_x1+1),
-      [xfrac] "a" (ds_xfrac),
-      [yfrac] "a" (ds_yfrac),
-      [source] "a" (ds_source),
-      [colormap] "a" (ds_colormap),
-      [dest] "a" (topleft+ds_y*SCREENWIDTH +ds_x1),
-      [ds_xstep] "d" (ds_xstep),
-      [ds_ystep] "d" (ds_ystep)
-   : /* clobbers */
-      "d1", "d2", "d4"
-   );
-#else
+   if (ds_pitch == 1)
+   {
+      asm volatile (
+         "tst %[count]                             \n"
+         "beq endspanloop                          \n"
+         "clr.l %%d4                               \n"
+         "spanloop:                                \n"
+         "move.l %[xfrac], %%d1                    \n"
+         "swap %%d1                                \n"
+         "and.l #63,%%d1                           \n"
+         "move.l %[yfrac], %%d2                    \n"
+         "lsr.l %[ten],%%d2                        \n"
+         "and.l #4032,%%d2                         \n"
+         "or.l %%d2, %%d1                          \n"
+         "move.b (%[source], %%d1), %%d4           \n"
+         "add.l %[ds_xstep], %[xfrac]              \n"
+         "add.l %[ds_ystep], %[yfrac]              \n"
+         "move.b (%[colormap],%%d4.l), (%[dest])+  \n"
+         "subq.l #1, %[count]                      \n"
+         "bne spanloop                             \n"
+         "endspanloop:                             \n"
+      : /* outputs */
+      : /* inputs */
+         [ten] "d"(10),
+         [count] "d" (ds_x2-ds_x1+1),
+         [xfrac] "a" (ds_xfrac),
+         [yfrac] "a" (ds_yfrac),
+         [source] "a" (ds_source),
+         [colormap] "a" (ds_colormap),
+         [dest] "a" (topleft+ds_y*dc_pitch +ds_x1),
+         [ds_xstep] "d" (ds_xstep),
+         [ds_ystep] "d" (ds_ystep)
+      : /* clobbers */
+         "d1", "d2", "d4"
+      );
+      return;
+   }
+#endif
    register unsigned count = ds_x2 - ds_x1 + 1,xfrac = ds_xfrac,yfrac = ds_yfrac;
 
    register byte *source = ds_source;
    register byte *colormap = ds_colormap;
-   register byte *dest = topleft + ds_y*SCREENWIDTH + ds_x1;
+   register byte *dest = topleft + ds_y*dc_pitch + ds_x1*ds_pitch;
+   register int pitch = ds_pitch;
 
    while (count)
    {
@@ -578,10 +601,10 @@ void R_DrawSpan (void)
       spot = xtemp | ytemp;
       xfrac += ds_xstep;
       yfrac += ds_ystep;
-      *dest++ = colormap[source[spot]];
+      *dest = colormap[source[spot]];
+      dest += pitch;
       count--;
    }
-#endif
 }
 
 //
@@ -605,12 +628,75 @@ void R_InitBuffer(int width, int height)
 
    viewwindowy = width==SCREENWIDTH ? 0 : (SCREENHEIGHT-(ST_SCALED_HEIGHT-1)-height)>>1;
 
-   topleft = d_screens[0] + viewwindowy*SCREENWIDTH + viewwindowx;
+   if (column_renderer)
+   {
+      // The view is drawn a column after the other into its own buffer,
+      // R_TransposeView puts it on the screen.
+      if (!viewbuffer)
+         viewbuffer = malloc(SCREENWIDTH*SCREENHEIGHT);
+
+      topleft = viewbuffer;
+      dc_pitch = 1;
+      ds_pitch = height;
+   }
+   else
+   {
+      topleft = d_screens[0] + viewwindowy*SCREENWIDTH + viewwindowx;
+      dc_pitch = SCREENWIDTH;
+      ds_pitch = 1;
+   }
 
    // Preclaculate all row offsets.
    // CPhipps - merge viewwindowx into here
    for (i=0; i<FUZZTABLE; i++)
-      fuzzoffset[i] = fuzzoffset_org[i]*SCREENWIDTH;
+      fuzzoffset[i] = fuzzoffset_org[i]*dc_pitch;
+}
+
+//
+// R_TransposeView
+// Copies the column-major view of the column renderer
+//  to its window on the screen, eight columns at a time
+//  so that both buffers are gone through in order.
+//
+
+void R_TransposeView(void)
+{
+   byte *screen = d_screens[0] + viewwindowy*SCREENWIDTH + viewwindowx;
+   int x, y;
+
+   for (x = 0; x < viewwidth; x += 8)
+   {
+      const byte *src = viewbuffer + x*viewheight;
+      byte *dest = screen + x;
+
+      if (viewwidth - x >= 8)
+      {
+         for (y = 0; y < viewheight; y++)
+         {
+            dest[0] = src[0];
+            dest[1] = src[viewheight];
+            dest[2] = src[viewheight*2];
+            dest[3] = src[viewheight*3];
+            dest[4] = src[viewheight*4];
+            dest[5] = src[viewheight*5];
+            dest[6] = src[viewheight*6];
+            dest[7] = src[viewheight*7];
+            src++;
+            dest += SCREENWIDTH;
+         }
+      }
+      else
+      {
+         for (y = 0; y < viewheight; y++)
+         {
+            int i;
+            for (i = 0; i < viewwidth - x; i++)
+               dest[i] = src[i*viewheight];
+            src++;
+            dest += SCREENWIDTH;
+         }
+      }
+   }
 }
 
 
@@ -84,6 +84,12 @@ void R_DrawSpan(void) ICODE_ATTR;
 
 void R_InitBuffer(int width, int height);
 
+// Draw the view column-major, and copy it to the screen when done.
+extern int column_renderer;
+extern int dc_pitch;
+extern int ds_pitch;
+void R_TransposeView(void);
+
 // Initialize color translation tables, for player rendering etc.
 void R_InitTranslationTables(void);
 
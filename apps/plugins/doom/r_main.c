@@ -543,6 +543,9 @@ void R_RenderPlayerView (player_t* player)
 
    R_DrawMasked ();
 
+   if (column_renderer)
+      R_TransposeView ();
+
    // Check for new console commands.
    //    NetUpdate ();
 }
@@ -432,11 +432,41 @@ static void R_DoDrawPlane(visplane_t *pl)
 // At the end of each frame.
 //
 
+// The visplanes are drawn sorted by flat and then light level, so that
+// the spans of one flat follow each other and its 4k stay in the cache.
+
+static int R_ComparePlanes(const void *a, const void *b)
+{
+   const visplane_t *p1 = *(const visplane_t *const *)a;
+   const visplane_t *p2 = *(const visplane_t *const *)b;
+
+   if (p1->picnum != p2->picnum)
+      return p1->picnum - p2->picnum;
+   if (p1->lightlevel != p2->lightlevel)
+      return p1->lightlevel - p2->lightlevel;
+   return p1->height < p2->height ? -1 : p1->height > p2->height;
+}
+
 void R_DrawPlanes (void)
 {
+   static visplane_t **sortedplanes;
+   static int num_sortedplanes;
    visplane_t *pl;
-   int i;
+   int i, n = 0;
+
    for (i=0;i<MAXVISPLANES;i++)
       for (pl=visplanes[i]; pl; pl=pl->next)
-         R_DoDrawPlane(pl);
+         if (pl->minx <= pl->maxx)
+         {
+            if (n == num_sortedplanes)
+               sortedplanes = realloc(sortedplanes,
+                  (num_sortedplanes = num_sortedplanes ? num_sortedplanes*2 : 128)
+                  * sizeof *sortedplanes);
+            sortedplanes[n++] = pl;
+         }
+
+   rb->qsort(sortedplanes, n, sizeof *sortedplanes, R_ComparePlanes);
+
+   for (i=0;i<n;i++)
+      R_DoDrawPlane(sortedplanes[i]);
 }
@@ -261,14 +261,6 @@ bool Dhandle_ver (int dver)
          return 0;
    }
    // Start adding to myargv
-   if(argvlist.timedemo && (gamemode == shareware))
-   {
-         singletics = true;
-         timingdemo = true;            // show stats after quit
-         G_DeferedPlayDemo("demo3");
-         singledemo = true;            // quit after one demo
-   }
-
    if(argvlist.addonnum)
    {
       snprintf(addon,sizeof(addon),"%s%s", GAMEBASE"addons/", addons[argvlist.addonnum]);
@@ -283,6 +275,17 @@ bool Dhandle_ver (int dver)
       G_DeferedPlayDemo(addon);
       singledemo = true;          // quit after one demo
    }
+   else if(argvlist.timedemo)
+   {
+      G_DeferedPlayDemo("demo3"); // every IWAD has one
+      singledemo = true;
+   }
+
+   if(argvlist.timedemo)
+   {
+      singletics = true;
+      timingdemo = true;          // show stats after quit
+   }
    return 1;
 }
 
@@ -499,6 +502,7 @@ int Oset_keys()
 }
 
 extern int fake_contrast;
+extern int column_renderer;
 
 static bool Doptions()
 {
@@ -511,9 +515,10 @@ static bool Doptions()
    int menuquit=0;
 
     MENUITEM_STRINGLIST(menu, "Options", NULL,
-                        "Set Keys", "Sound", "Timedemo", "Player Bobbing",
+                        "Set Keys", "Sound", "Player Bobbing",
                         "Weapon Recoil", "Translucency", "Fake Contrast",
                         "Always Run", "Headsup Display", "Statusbar Always Red",
+                        "Column Renderer",
 #if(LCD_HEIGHT>LCD_WIDTH)
                         "Rotate Screen 90 deg",
 #endif
@@ -521,7 +526,6 @@ static bool Doptions()
    
    void *options[]={
         &enable_sound,
-        &argvlist.timedemo,
         &default_player_bobbing,
         &default_weapon_recoil,
         &default_translucency,
@@ -529,6 +533,7 @@ static bool Doptions()
         &autorun,
         &hud_displayed,
         &sts_always_red,
+        &column_renderer,
 #if(LCD_HEIGHT>LCD_WIDTH)
         &rotate_screen,
 #endif
@@ -594,7 +599,7 @@ int doom_menu()
 
    MENUITEM_STRINGLIST(menu, "Doom Menu", NULL,
                        "Game", "Addons", "Demos",
-                       "Options", "Play Game", "Quit");
+                       "Options", "Play Game", "Timedemo", "Quit");
 
    if( (status=Dbuild_base(names)) == 0 ) // Build up the base wad files (select last added file)
    {
@@ -639,7 +644,12 @@ int doom_menu()
             menuquit=1;
             break;
 
-         case 5: /* Quit */
+         case 5: /* Timedemo, the selected demo or demo3 */
+            argvlist.timedemo=1;
+            menuquit=1;
+            break;
+
+         case 6: /* Quit */
             menuquit=1;
             gamever=-1;
             break;
@@ -56,6 +56,7 @@ GREY_INFO_STRUCT
 #   define FFT_AMP_SCALE    BUTTON_UP
 #   define FFT_FREQ_SCALE   BUTTON_DOWN
 #   define FFT_QUIT         BUTTON_OFF
+#   define FFT_HOP_SIZE     BUTTON_MODE
 
 #elif (CONFIG_KEYPAD == IPOD_4G_PAD) || \
       (CONFIG_KEYPAD == IPOD_3G_PAD) || \
@@ -68,6 +69,7 @@ GREY_INFO_STRUCT
 #   define FFT_AMP_SCALE    BUTTON_MENU
 #   define FFT_FREQ_SCALE   BUTTON_PLAY
 #   define FFT_QUIT         (BUTTON_SELECT | BUTTON_MENU)
+#   define FFT_HOP_SIZE     (BUTTON_SELECT | BUTTON_PLAY)
 
 #elif (CONFIG_KEYPAD == IAUDIO_X5M5_PAD)
 #   define FFT_PREV_GRAPH   BUTTON_LEFT
@@ -86,6 +88,7 @@ GREY_INFO_STRUCT
 #   define FFT_ORIENTATION  BUTTON_SELECT
 #   define FFT_WINDOW       BUTTON_A
 #   define FFT_QUIT         BUTTON_POWER
+#   define FFT_HOP_SIZE     BUTTON_MENU
 
 #elif (CONFIG_KEYPAD == SANSA_E200_PAD)
 #   define FFT_PREV_GRAPH   BUTTON_LEFT
@@ -104,6 +107,7 @@ GREY_INFO_STRUCT
 #   define FFT_AMP_SCALE    BUTTON_UP
 #   define FFT_FREQ_SCALE   BUTTON_DOWN
 #   define FFT_QUIT     (BUTTON_HOME|BUTTON_REPEAT)
+#   define FFT_HOP_SIZE     (BUTTON_SELECT | BUTTON_DOWN)
 
 #elif (CONFIG_KEYPAD == SANSA_C200_PAD)
 #   define FFT_PREV_GRAPH   BUTTON_LEFT
@@ -147,6 +151,7 @@ GREY_INFO_STRUCT
 #   define FFT_AMP_SCALE    BUTTON_UP
 #   define FFT_FREQ_SCALE   BUTTON_DOWN
 #   define FFT_QUIT         BUTTON_BACK
+#   define FFT_HOP_SIZE     BUTTON_NEXT
 
 #elif (CONFIG_KEYPAD == MROBE100_PAD)
 #   define FFT_PREV_GRAPH   BUTTON_LEFT
@@ -178,6 +183,7 @@ GREY_INFO_STRUCT
 #   define FFT_AMP_SCALE    BUTTON_UP
 #   define FFT_FREQ_SCALE   BUTTON_DOWN
 #   define FFT_QUIT         (BUTTON_PLAY|BUTTON_REPEAT)
+#   define FFT_HOP_SIZE     (BUTTON_PLAY | BUTTON_UP)
 
 #elif CONFIG_KEYPAD == CREATIVEZVM_PAD
 #   define FFT_PREV_GRAPH   BUTTON_LEFT
@@ -187,6 +193,7 @@ GREY_INFO_STRUCT
 #   define FFT_AMP_SCALE    BUTTON_UP
 #   define FFT_FREQ_SCALE   BUTTON_DOWN
 #   define FFT_QUIT         BUTTON_BACK
+#   define FFT_HOP_SIZE     BUTTON_PLAY
 
 #elif CONFIG_KEYPAD == PHILIPS_HDD1630_PAD
 #   define FFT_PREV_GRAPH   BUTTON_LEFT
@@ -205,6 +212,7 @@ GREY_INFO_STRUCT
 #   define FFT_AMP_SCALE    BUTTON_UP
 #   define FFT_FREQ_SCALE   BUTTON_DOWN
 #   define FFT_QUIT         BUTTON_POWER
+#   define FFT_HOP_SIZE     BUTTON_VIEW
 
 #elif CONFIG_KEYPAD == PHILIPS_SA9200_PAD
 #   define FFT_PREV_GRAPH   BUTTON_PREV
@@ -240,6 +248,7 @@ GREY_INFO_STRUCT
 #   define FFT_WINDOW       BUTTON_OK
 #   define FFT_AMP_SCALE    BUTTON_PLAY
 #   define FFT_QUIT         BUTTON_REC
+#   define FFT_HOP_SIZE     BUTTON_CANCEL
 /* Need FFT_FREQ_SCALE key */
 #elif CONFIG_KEYPAD == MPIO_HD200_PAD
 #   define FFT_PREV_GRAPH   BUTTON_REW
@@ -274,6 +283,7 @@ GREY_INFO_STRUCT
 #   define FFT_AMP_SCALE    BUTTON_UP
 #   define FFT_FREQ_SCALE   BUTTON_DOWN
 #   define FFT_QUIT         BUTTON_POWER
+#   define FFT_HOP_SIZE     BUTTON_VOL_UP
 
 #elif CONFIG_KEYPAD == SAMSUNG_YPR0_PAD
 #   define FFT_PREV_GRAPH   BUTTON_LEFT
@@ -301,6 +311,7 @@ GREY_INFO_STRUCT
 #   define FFT_ORIENTATION  BUTTON_SELECT
 #   define FFT_WINDOW       BUTTON_PLAY
 #   define FFT_QUIT         BUTTON_POWER
+#   define FFT_HOP_SIZE     BUTTON_NEXT
 
 #elif (CONFIG_KEYPAD == SONY_NWZ_PAD)
 #   define FFT_PREV_GRAPH   BUTTON_LEFT
@@ -350,8 +361,8 @@ GREY_INFO_STRUCT
 #include "pluginbitmaps/fft_colors.h"
 #endif
 
-#include "kiss_fftr.h"
-#include "_kiss_fft_guts.h" /* sizeof(struct kiss_fft_state) */
+#include "codecs/lib/fft.h"
+#include "codecs/lib/mdct_lookup.h" /* revtab */
 #include "const.h"
 
 
@@ -361,17 +372,24 @@ GREY_INFO_STRUCT
 
 #if (LCD_SIZE <= 511)
 #define FFT_SIZE 1024 /* 512*2 */
+#define FFT_BITS 10
 #elif (LCD_SIZE <= 1023)
 #define FFT_SIZE 2048 /* 1024*2 */
+#define FFT_BITS 11
 #else
 #define FFT_SIZE 4096 /* 2048*2 */
+#define FFT_BITS 12
 #endif
 
+/* The real input is transformed as a complex signal of half the length,
+ * so the codeclib FFT is one size smaller than FFT_SIZE */
 #define ARRAYLEN_IN (FFT_SIZE)
-#define ARRAYLEN_OUT (FFT_SIZE)
+#define ARRAYLEN_FFT (FFT_SIZE/2)
+#define ARRAYLEN_OUT (FFT_SIZE/2)
 #define ARRAYLEN_PLOT (FFT_SIZE/2-1) /* FFT is symmetric, ignore DC */
-#define BUFSIZE_FFT (sizeof(struct kiss_fft_state)+\
-                     sizeof(kiss_fft_cpx)*(FFT_SIZE-1))
+
+/* Most frames taken from the PCM tap in one go */
+#define TAP_READ_FRAMES 256
 
 #define __COEFF(type,size) type##_##size
 #define _COEFF(x, y) __COEFF(x,y) /* force CPP evaluation of FFT_SIZE */
@@ -384,30 +402,31 @@ GREY_INFO_STRUCT
 #define CACHEALIGN_UP_SIZE(type, len) \
     (CACHEALIGN_UP((len)*sizeof(type) + (sizeof(type)-1)) / sizeof(type))
 /* Shared */
-/* COP + CPU PCM */
-static kiss_fft_cpx input[CACHEALIGN_UP_SIZE(kiss_fft_scalar, ARRAYLEN_IN)]
-                            CACHEALIGN_AT_LEAST_ATTR(4);
 /* CPU+COP */
 #if NUM_CORES > 1
 /* Output queue indexes */
 static volatile int output_head SHAREDBSS_ATTR = 0;
 static volatile int output_tail SHAREDBSS_ATTR = 0;
 /* The result is nfft/2 complex frequency bins from DC to Nyquist. */
-static kiss_fft_cpx output[2][CACHEALIGN_UP_SIZE(kiss_fft_cpx, ARRAYLEN_OUT)]
-                                SHAREDBSS_ATTR;
+static FFTComplex output[2][CACHEALIGN_UP_SIZE(FFTComplex, ARRAYLEN_OUT)]
+                            SHAREDBSS_ATTR;
 #else
 /* Only one output buffer */
 #define output_head 0
 #define output_tail 0
 /* The result is nfft/2 complex frequency bins from DC to Nyquist. */
-static kiss_fft_cpx output[1][ARRAYLEN_OUT];
+static FFTComplex output[1][ARRAYLEN_OUT];
 #endif
 
 /* Unshared */
 /* COP */
-static kiss_fft_cfg fft_state SHAREDBSS_ATTR;
-static char fft_buffer[CACHEALIGN_UP_SIZE(char, BUFSIZE_FFT)]
-                CACHEALIGN_AT_LEAST_ATTR(4);
+static int16_t history[ARRAYLEN_IN]; /* last FFT_SIZE mono samples played */
+static int16_t tap_frames[TAP_READ_FRAMES*2];
+static unsigned int tap_pos;         /* next frame to take from the tap */
+static int tap_new;                  /* frames taken since the last FFT */
+static FFTComplex input[CACHEALIGN_UP_SIZE(FFTComplex, ARRAYLEN_FFT)]
+                         CACHEALIGN_AT_LEAST_ATTR(4);
+static FFTComplex twiddle[ARRAYLEN_OUT]; /* e^(i*2pi*k/FFT_SIZE), s.31 */
 /* CPU */
 static uint32_t linf_magnitudes[ARRAYLEN_PLOT]; /* ling freq bin plot */
 static uint32_t logf_magnitudes[ARRAYLEN_PLOT]; /* log freq plot output */
@@ -464,6 +483,15 @@ enum fft_window_func
     FFT_MAX_WF,
 };
 
+enum fft_hop_size
+{
+    FFT_MIN_HS = 0,
+    FFT_HS_FULL = 0, /* Each FFT waits for a whole new input frame */
+    FFT_HS_HALF,     /* Input frames overlap by half * */
+    FFT_HS_QUARTER,  /* Input frames overlap by three quarters */
+    FFT_MAX_HS,
+};
+
 static struct fft_config
 {
     int orientation;
@@ -471,6 +499,7 @@ static struct fft_config
     int amp_scale;
     int freq_scale;
     int window_func;
+    int hop_size;
 } fft_disk = 
 {
      /* Defaults */
@@ -479,6 +508,7 @@ static struct fft_config
     .amp_scale   = FFT_AS_LOG,
     .freq_scale  = FFT_FS_LOG,
     .window_func = FFT_WF_HAMMING,
+    .hop_size    = FFT_HS_HALF,
 };
 
 #define CFGFILE_VERSION    0
@@ -508,6 +538,11 @@ static struct configdata disk_config[] =
      { .int_p = &fft_disk.window_func }, "window function",
         (char * []){ [FFT_WF_HAMMING] = "hamming",
                      [FFT_WF_HANN]    = "hann" } },
+   { TYPE_ENUM, FFT_MIN_HS, FFT_MAX_HS,
+     { .int_p = &fft_disk.hop_size }, "hop size",
+        (char * []){ [FFT_HS_FULL]    = "full",
+                     [FFT_HS_HALF]    = "half",
+                     [FFT_HS_QUARTER] = "quarter" } },
 };
 
 /* Hint flags for setting changes */
@@ -518,7 +553,8 @@ enum fft_setting_flags
     FFT_SETF_AS = 1 << 2,
     FFT_SETF_FS = 1 << 3,
     FFT_SETF_WF = 1 << 4,
-    FFT_SETF_ALL = 0x1f
+    FFT_SETF_HS = 1 << 5,
+    FFT_SETF_ALL = 0x3f
 };
 
 /***************************** End of settings *****************************/
@@ -570,7 +606,9 @@ static long fft_next_frame_tick = 0; /* next tick to attempt drawing */
 
 /***************************** Math functions ******************************/
 
-/* Apply window function to input */
+/* Apply window function to the history and pack it into input: even
+ * samples go to the real parts, odd ones to the imaginary parts, in the
+ * split-radix order ff_fft_calc_c() wants */
 static void apply_window_func(enum fft_window_func mode)
 {
     static const int16_t * const coefs[] =
@@ -580,9 +618,38 @@ static void apply_window_func(enum fft_window_func mode)
     };
 
     const int16_t * const c = coefs[mode];
+    const int shift = 12 - (FFT_BITS - 1); /* revtab is for 4096 points */
 
-    for(int i = 0; i < ARRAYLEN_IN; ++i)
-        input[i].r = (input[i].r * c[i] + 16384) >> 15;
+    for(int i = 0; i < ARRAYLEN_FFT; ++i)
+    {
+        FFTComplex *z = &input[revtab[i] >> shift];
+        z->re = (history[2*i] * c[2*i] + 16384) >> 15;
+        z->im = (history[2*i+1] * c[2*i+1] + 16384) >> 15;
+    }
+}
+
+/* Turn the transform of the packed half length signal into the first half
+ * of the spectrum of the real one, scaled by 1/FFT_SIZE */
+static void real_fft_split(FFTComplex *out)
+{
+    for(int k = 0; k < ARRAYLEN_OUT; ++k)
+    {
+        const FFTComplex *a = &input[k];
+        const FFTComplex *b = &input[(ARRAYLEN_FFT - k) & (ARRAYLEN_FFT - 1)];
+
+        /* Spectra of the even and of the odd samples */
+        int32_t er = (a->re + b->re) >> 1;
+        int32_t ei = (a->im - b->im) >> 1;
+        int32_t or = (a->im + b->im) >> 1;
+        int32_t oi = (b->re - a->re) >> 1;
+
+        int32_t wr = twiddle[k].re, wi = twiddle[k].im;
+        int32_t xr = er + Q_MUL(or, wr, 31) - Q_MUL(oi, wi, 31);
+        int32_t xi = ei + Q_MUL(or, wi, 31) + Q_MUL(oi, wr, 31);
+
+        out[k].re = (xr + (1 << (FFT_BITS-1))) >> FFT_BITS;
+        out[k].im = (xi + (1 << (FFT_BITS-1))) >> FFT_BITS;
+    }
 }
 
 /* Calculates the magnitudes from complex numbers and returns the maximum */
@@ -591,13 +658,13 @@ static unsigned calc_magnitudes(enum fft_amp_scale scale)
     /* A major assumption made when calculating the Q*MAX constants 
      * is that the maximum magnitude is 29 bits long. */
     unsigned this_max = 0;
-    kiss_fft_cpx *this_output = output[output_head] + 1; /* skip DC */
+    FFTComplex *this_output = output[output_head] + 1; /* skip DC */
 
     /* Calculate the magnitude, discarding the phase. */
     for(int i = 0; i < ARRAYLEN_PLOT; ++i)
     {
-        int32_t re = this_output[i].r;
-        int32_t im = this_output[i].i;
+        int32_t re = this_output[i].re;
+        int32_t im = this_output[i].im;
 
         uint32_t d = re*re + im*im;
 
@@ -1028,53 +1095,84 @@ static bool is_playing(void)
 /** functions use in single/multi configuration **/
 static inline bool fft_init_fft_lib(void)
 {
-    size_t size = sizeof(fft_buffer);
-    fft_state = kiss_fft_alloc(FFT_SIZE, 0, fft_buffer, &size);
-
-    if(fft_state == NULL)
+    for(int k = 0; k < ARRAYLEN_OUT; ++k)
     {
-        DEBUGF("needed data: %i", (int) size);
-        return false;
+        long cos, sin = fp_sincos((unsigned long)k << (32 - FFT_BITS), &cos);
+        twiddle[k].re = cos;
+        twiddle[k].im = sin;
     }
 
+    tap_pos = rb->pcmbuf_tap_position();
+    tap_new = 0;
+
     return true;
 }
 
-static inline bool fft_get_fft(void)
+/* Slide the frames played since last time into the history, as mono */
+static bool fft_read_tap(void)
 {
-    int count;
-    const int16_t *value =
-        rb->mixer_channel_get_buffer(PCM_MIXER_CHAN_PLAYBACK, &count);
-    /* This block can introduce discontinuities in our data. Meaning, the
-     * FFT will not be done a continuous segment of the signal. Which can
-     * be bad. Or not.
-     * 
-     * Anyway, this is a demo, not a scientific tool. If you want accuracy,
-     * do a proper spectrum analysis.*/
-
-    /* there are cases when we don't have enough data to fill the buffer */
-    if(count != ARRAYLEN_IN)
+    unsigned int now = rb->pcmbuf_tap_position();
+    int count = now - tap_pos;
+
+    if(count <= 0)
+        return false;
+
+    if(count > ARRAYLEN_IN)
     {
-        if(count < ARRAYLEN_IN)
+        /* Only the last window's worth matters */
+        tap_pos = now - ARRAYLEN_IN;
+        count = ARRAYLEN_IN;
+    }
+
+    rb->memmove(history, history + count,
+                (ARRAYLEN_IN - count)*sizeof(int16_t));
+
+    int16_t *dst = &history[ARRAYLEN_IN - count];
+    tap_new += count;
+
+    while(count > 0)
+    {
+        int n = MIN(count, TAP_READ_FRAMES);
+
+        if(!rb->pcmbuf_tap_read(tap_pos, tap_frames, n))
+        {
+            /* Fell behind the tap - start over from what plays now, with
+               a silent window rather than a gap in it */
+            rb->memset(history, 0, sizeof(history));
+            tap_pos = now;
+            tap_new = 0;
             return false;
+        }
+
+        const int16_t *value = tap_frames;
+
+        for(int i = 0; i < n; i++, value += 2)
+            *dst++ = (value[0] + value[1]) >> 1; /* to mono */
 
-        count = ARRAYLEN_IN;  /* too much - limit */
+        tap_pos += n;
+        count -= n;
     }
 
-    int fft_idx = 0; /* offset in 'input' */
+    return true;
+}
 
-    do
-    {
-        kiss_fft_scalar left = *value++;
-        kiss_fft_scalar right = *value++;
-        input[fft_idx].r = (left + right) >> 1; /* to mono */
-    } while (fft_idx++, --count > 0);
+static inline bool fft_get_fft(void)
+{
+    /* Transform again once a hop of new frames has come in; the rest of
+     * the window is the same history as last time */
+    fft_read_tap();
+
+    if(tap_new < (ARRAYLEN_IN >> fft.hop_size))
+        return false;
+
+    tap_new = 0;
 
     apply_window_func(fft.window_func);
 
     rb->yield();
 
-    kiss_fft(fft_state, input, output[output_tail]);
+    ff_fft_calc_c(FFT_BITS - 1, input);
+    real_fft_split(output[output_tail]);
 
     rb->yield();
 
@@ -1231,6 +1329,14 @@ static void fft_osd_format_message(enum fft_setting_flags id)
             }[fft.window_func];
         break;
 
+    case FFT_SETF_HS:
+        msg = (const char * [FFT_MAX_HS]) {
+                [FFT_HS_FULL]    = "No overlap",
+                [FFT_HS_HALF]    = "Half overlap",
+                [FFT_HS_QUARTER] = "3/4 overlap",
+            }[fft.hop_size];
+        break;
+
     case FFT_SETF_AS:
         msg = (const char * [FFT_MAX_AS]) {
                 [FFT_AS_LOG] = "Logarithmic amplitude",
@@ -1475,6 +1581,7 @@ static void fft_cleanup(void)
     myosd_destroy();
 
     fft_close_fft();    
+    rb->pcmbuf_tap_enable(false);
 
 #ifdef HAVE_ADJUSTABLE_CPU_FREQ
     rb->cancel_cpu_boost();
@@ -1495,6 +1602,12 @@ static void fft_cleanup(void)
 
 static bool fft_setup(void)
 {
+    if(!rb->pcmbuf_tap_enable(true))
+    {
+        rb->splash(HZ, "No memory for the PCM tap");
+        return false;
+    }
+
     atexit(fft_cleanup);
 
     configfile_load(cfg_filename, disk_config, ARRAYLEN(disk_config),
@@ -1620,6 +1733,16 @@ enum plugin_status plugin_start(const void* parameter)
                 fft_popupmsg(FFT_SETF_WF);
                 break;
 
+#ifdef FFT_HOP_SIZE /* 'Till all keymaps are defined */
+            case FFT_HOP_SIZE:
+                if(++fft.hop_size >= FFT_MAX_HS)
+                    fft.hop_size = FFT_MIN_HS;
+
+                fft_setting_update(FFT_SETF_HS);
+                fft_popupmsg(FFT_SETF_HS);
+                break;
+#endif
+
             default:
                 exit_on_usb(button);
                 break;
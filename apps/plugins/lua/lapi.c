@@ -454,8 +454,13 @@ LUA_API void lua_pushlstring (lua_State *L, const char *s, size_t len) {
 LUA_API void lua_pushstring (lua_State *L, const char *s) {
   if (s == NULL)
     lua_pushnil(L);
-  else
-    lua_pushlstring(L, s, strlen(s));
+  else {
+    lua_lock(L);
+    luaC_checkGC(L);
+    setsvalue2s(L, L->top, luaS_new(L, s));
+    api_incr_top(L);
+    lua_unlock(L);
+  }
 }
 
 
@@ -923,7 +928,8 @@ LUA_API int lua_gc (lua_State *L, int what, int data) {
       res = cast_int(g->totalbytes & 0x3ff);
       break;
     }
-    case LUA_GCSTEP: {
+    case LUA_GCSTEP:
+    case LUA_GCFRAME: {
       lu_mem a = (cast(lu_mem, data) << 10);
       if (a <= g->totalbytes)
         g->GCthreshold = g->totalbytes - a;
@@ -936,6 +942,10 @@ LUA_API int lua_gc (lua_State *L, int what, int data) {
           break;
         }
       }
+      /* the next frame may allocate as much before the collector
+         interrupts it, so that most of the work is done in this step */
+      if (what == LUA_GCFRAME && g->gcstate != GCSpause)
+        g->GCthreshold = g->totalbytes + a;
       break;
     }
     case LUA_GCSETPAUSE: {
@@ -100,6 +100,12 @@ typedef lu_int32 Instruction;
 #endif
 
 
+/* size of the cache of strings made from C pointers (a prime) */
+#ifndef STRCACHE_SIZE
+#define STRCACHE_SIZE	53
+#endif
+
+
 /* minimum size for string buffer */
 #ifndef LUA_MINBUFFER
 #define LUA_MINBUFFER	32
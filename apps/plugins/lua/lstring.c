@@ -72,6 +72,29 @@ static TString *newlstr (lua_State *L, const char *str, size_t l,
 }
 
 
+/*
+** The C side asks for the same few names over and over (lua_getfield,
+** lua_pushstring of literals): remember the string made for a pointer and
+** check it with a strcmp instead of hashing and looking it up again.
+*/
+TString *luaS_new (lua_State *L, const char *str) {
+  global_State *g = G(L);
+  TString **p = &g->strcache[IntPoint(str) % STRCACHE_SIZE];
+  if (*p == NULL || strcmp(str, getstr(*p)) != 0)
+    *p = luaS_newlstr(L, str, strlen(str));
+  return *p;
+}
+
+
+/* drop the strings that the current collection is going to free */
+void luaS_clearcache (global_State *g) {
+  int i;
+  for (i = 0; i < STRCACHE_SIZE; i++)
+    if (g->strcache[i] != NULL && iswhite(obj2gco(g->strcache[i])))
+      g->strcache[i] = NULL;
+}
+
+
 TString *luaS_newlstr (lua_State *L, const char *str, size_t l) {
   GCObject *o;
   unsigned int h = cast(unsigned int, l);  /* seed */
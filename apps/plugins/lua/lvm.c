@@ -357,6 +357,40 @@ static void Arith (lua_State *L, StkId ra, const TValue *rb,
 #define Protect(x)	{ L->savedpc = pc; {x;}; base = L->base; }
 
 
+/*
+** Table reads that find a value, or miss in a table without an __index,
+** are done right here, with `pc' and `base' kept in registers. A miss in
+** an object goes on in its class, the __index table; only the rest goes
+** through luaV_gettable from the start.
+*/
+#define fastget(h,key,res) { \
+        if (ttisnumber(key) && \
+            cast(unsigned int, nvalue(key)-1) < cast(unsigned int, (h)->sizearray)) \
+          res = &(h)->array[nvalue(key)-1]; \
+        else if (ttisstring(key)) \
+          res = luaH_getstr(h, rawtsvalue(key)); \
+        else \
+          res = luaH_get(h, key); \
+      }
+
+#define gettable_op(t,key,val) { \
+        if (ttistable(t)) { \
+          Table *h = hvalue(t); \
+          const TValue *res, *tm; \
+          fastget(h, key, res); \
+          if (!ttisnil(res) || (tm = fasttm(L, h->metatable, TM_INDEX)) == NULL) { \
+            setobj2s(L, val, res); \
+            continue; \
+          } \
+          if (ttistable(tm)) { \
+            Protect(luaV_gettable(L, tm, key, val)); \
+            continue; \
+          } \
+        } \
+        Protect(luaV_gettable(L, t, key, val)); \
+      }
+
+
 #define arith_op(op,tm) { \
         TValue *rb = RKB(i); \
         TValue *rc = RKC(i); \
@@ -428,13 +462,21 @@ void luaV_execute (lua_State *L, int nexeccalls) {
       case OP_GETGLOBAL: {
         TValue g;
         TValue *rb = KBx(i);
-        sethvalue(L, &g, cl->env);
+        const TValue *res;
         lua_assert(ttisstring(rb));
+        res = luaH_getstr(cl->env, rawtsvalue(rb));
+        if (!ttisnil(res) || fasttm(L, cl->env->metatable, TM_INDEX) == NULL) {
+          setobj2s(L, ra, res);
+          continue;
+        }
+        sethvalue(L, &g, cl->env);
         Protect(luaV_gettable(L, &g, rb, ra));
         continue;
       }
       case OP_GETTABLE: {
-        Protect(luaV_gettable(L, RB(i), RKC(i), ra));
+        TValue *rb = RB(i);
+        TValue *rc = RKC(i);
+        gettable_op(rb, rc, ra);
         continue;
       }
       case OP_SETGLOBAL: {
@@ -451,7 +493,21 @@ void luaV_execute (lua_State *L, int nexeccalls) {
         continue;
       }
       case OP_SETTABLE: {
-        Protect(luaV_settable(L, ra, RKB(i), RKC(i)));
+        TValue *rb = RKB(i);
+        TValue *rc = RKC(i);
+        /* stores into the array part of a table need no new slot */
+        if (ttistable(ra) && ttisnumber(rb)) {
+          Table *h = hvalue(ra);
+          unsigned int n = cast(unsigned int, nvalue(rb)-1);
+          if (n < cast(unsigned int, h->sizearray) &&
+              (!ttisnil(&h->array[n]) ||
+               fasttm(L, h->metatable, TM_NEWINDEX) == NULL)) {
+            setobj2t(L, &h->array[n], rc);
+            luaC_barriert(L, h, rc);
+            continue;
+          }
+        }
+        Protect(luaV_settable(L, ra, rb, rc));
         continue;
       }
       case OP_NEWTABLE: {
@@ -463,8 +519,9 @@ void luaV_execute (lua_State *L, int nexeccalls) {
       }
       case OP_SELF: {
         StkId rb = RB(i);
+        TValue *rc = RKC(i);
         setobjs2s(L, ra+1, rb);
-        Protect(luaV_gettable(L, rb, RKC(i), ra));
+        gettable_op(rb, rc, ra);
         continue;
       }
       case OP_ADD: {
@@ -43,6 +43,10 @@
  * When porting new functions, don't forget to check rocklib_aux.pl whether it automatically creates
  * wrappers for the function and if so, add the function names to @forbidden_functions. This is to
  * prevent namespace collisions and adding duplicate wrappers.
+ *
+ * The functions of rocklib[] and of the image methods get the image metatable
+ * as their first upvalue: checking an argument is then a pointer compare,
+ * instead of a lookup of ROCKLUA_IMAGE in the registry on every call.
  */
 
 
@@ -67,7 +71,7 @@ static void rli_wrap(lua_State *L, fb_data *src, int width, int height)
 {
     struct rocklua_image *a = (struct rocklua_image *)lua_newuserdata(L, sizeof(struct rocklua_image));
 
-    luaL_getmetatable(L, ROCKLUA_IMAGE);
+    lua_pushvalue(L, lua_upvalueindex(1));
     lua_setmetatable(L, -2);
 
     a->width = width;
@@ -80,7 +84,7 @@ static fb_data* rli_alloc(lua_State *L, int width, int height)
     size_t nbytes = sizeof(struct rocklua_image) + ((width*height) - 1) * sizeof(fb_data);
     struct rocklua_image *a = (struct rocklua_image *)lua_newuserdata(L, nbytes);
 
-    luaL_getmetatable(L, ROCKLUA_IMAGE);
+    lua_pushvalue(L, lua_upvalueindex(1));
     lua_setmetatable(L, -2);
 
     a->width = width;
@@ -102,9 +106,16 @@ static int rli_new(lua_State *L)
 
 static struct rocklua_image* rli_checktype(lua_State *L, int arg)
 {
-    void *ud = luaL_checkudata(L, arg, ROCKLUA_IMAGE);
-    luaL_argcheck(L, ud != NULL, arg, "'" ROCKLUA_IMAGE "' expected");
-    return (struct rocklua_image*) ud;
+    void *ud = lua_touserdata(L, arg);
+    if(ud != NULL && lua_getmetatable(L, arg))
+    {
+        bool is_image = lua_rawequal(L, -1, lua_upvalueindex(1));
+        lua_pop(L, 1);
+        if(is_image)
+            return (struct rocklua_image*) ud;
+    }
+    luaL_typerror(L, arg, ROCKLUA_IMAGE);
+    return NULL;
 }
 
 static int rli_width(lua_State *L)
@@ -174,7 +185,8 @@ static inline void rli_init(lua_State *L)
     lua_pushvalue(L, -2);  /* pushes the metatable */
     lua_settable(L, -3);  /* metatable.__index = metatable */
 
-    luaL_register(L, NULL, rli_lib);
+    lua_pushvalue(L, -1);  /* the methods' upvalue */
+    luaI_openlib(L, NULL, rli_lib, 1);
 }
 
 /*
@@ -377,6 +389,49 @@ RB_WRAP(current_tick)
     return 1;
 }
 
+#ifdef USEC_TIMER
+RB_WRAP(usec_timer)
+{
+    lua_pushinteger(L, USEC_TIMER);
+    return 1;
+}
+#endif
+
+/* KB of garbage collection done by rb.lcd_update(), at the end of a frame
+ * rather than in the middle of the next one. 0 leaves the collector alone. */
+static int gc_frame_kb = 0;
+
+RB_WRAP(gc_frame)
+{
+    int previous = gc_frame_kb;
+    gc_frame_kb = luaL_optint(L, 1, 0);
+    lua_pushinteger(L, previous);
+    return 1;
+}
+
+RB_WRAP(lcd_update)
+{
+    rb->lcd_update();
+    if(gc_frame_kb > 0)
+        lua_gc(L, LUA_GCFRAME, gc_frame_kb);
+    return 0;
+}
+
+#ifdef HAVE_LCD_BITMAP
+RB_WRAP(lcd_update_rect)
+{
+    int x = luaL_checkint(L, 1);
+    int y = luaL_checkint(L, 2);
+    int width = luaL_checkint(L, 3);
+    int height = luaL_checkint(L, 4);
+
+    rb->lcd_update_rect(x, y, width, height);
+    if(gc_frame_kb > 0)
+        lua_gc(L, LUA_GCFRAME, gc_frame_kb);
+    return 0;
+}
+#endif
+
 #ifdef HAVE_TOUCHSCREEN
 RB_WRAP(action_get_touchscreen_press)
 {
@@ -684,7 +739,9 @@ RB_WRAP(get_plugin_action)
 static const luaL_Reg rocklib[] =
 {
     /* Graphics */
+    R(lcd_update),
 #ifdef HAVE_LCD_BITMAP
+    R(lcd_update_rect),
     R(lcd_framebuffer),
     R(lcd_mono_bitmap_part),
     R(lcd_mono_bitmap),
@@ -705,6 +762,10 @@ static const luaL_Reg rocklib[] =
 
     /* Kernel */
     R(current_tick),
+#ifdef USEC_TIMER
+    R(usec_timer),
+#endif
+    R(gc_frame),
 
     /* Buttons */
 #ifdef HAVE_TOUCHSCREEN
@@ -758,7 +819,8 @@ extern const luaL_Reg rocklib_aux[];
  */
 LUALIB_API int luaopen_rock(lua_State *L)
 {
-    luaL_register(L, LUA_ROCKLIBNAME, rocklib);
+    rli_init(L); /* leaves the image metatable for the upvalue */
+    luaI_openlib(L, LUA_ROCKLIBNAME, rocklib, 1);
     luaL_register(L, LUA_ROCKLIBNAME, rocklib_aux);
 
     RB_CONSTANT(HZ);
@@ -797,7 +859,5 @@ LUALIB_API int luaopen_rock(lua_State *L)
     RB_STRING_CONSTANT(PLUGIN_DATA_DIR);
     RB_STRING_CONSTANT(VIEWERS_DATA_DIR);
 
-    rli_init(L);
-
     return 1;
 }
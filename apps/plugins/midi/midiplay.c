@@ -374,6 +374,85 @@ static void get_more(const void** start, size_t* size)
 #endif
 }
 
+#ifdef USEC_TIMER
+#define NOW()       ((long)USEC_TIMER)
+#define PER_SECOND  1000000
+#else
+#define NOW()       (*rb->current_tick)
+#define PER_SECOND  HZ
+#endif
+
+/* Voices added per benchmark step and audio rendered for each */
+#define BENCH_STEP      4
+#define BENCH_SAMPLES   (SAMPLE_RATE/2)
+
+/* Renders held piano notes without playing them, more of them each step,
+   and reports how many voices the synth keeps up with in real time */
+static int benchmark(void)
+{
+    int voices_ok = 0, estimate = 0;
+    int n;
+
+    if (initSynth(NULL, ROCKBOX_DIR "/patchset/patchset.cfg",
+        ROCKBOX_DIR "/patchset/drums.cfg") == -1)
+        return -1;
+
+    rb->lcd_clear_display();
+    midi_debug("Synth benchmark, %d Hz", SAMPLE_RATE);
+
+    for (n = BENCH_STEP; n <= MAX_VOICES && !quit; n += BENCH_STEP)
+    {
+        int done, a, used, load;
+        long time;
+
+        resetControllers();
+
+        time = NOW();
+
+        for (done = 0; done < BENCH_SAMPLES; done += 512)
+        {
+            /* keep n voices going, the piano fades out */
+            for (a = 0, used = 0; a < MAX_VOICES; a++)
+                if (voices[a].isUsed && voices[a].state != STATE_RAMPDOWN)
+                    used++;
+
+            for (a = 0; used < n; a++, used++)
+                startNote(0, 36 + (a % 48), 100);
+
+            synthSamples(gmbuf, 512);
+            rb->yield();
+        }
+
+        time = NOW() - time;
+        if (time <= 0)
+            time = 1;
+
+        /* CPU needed for real time playback in percent */
+        load = (long long)time * 100 * SAMPLE_RATE / BENCH_SAMPLES /
+                   PER_SECOND;
+
+        midi_debug("%2d voices: %3d%% CPU", n, load);
+
+        if (load > 100)
+            break;
+
+        voices_ok = n;
+        estimate = n * 100 / MAX(load, 1);
+
+        if (rb->button_get(false) == BTN_QUIT)
+            quit = true;
+    }
+
+    if (voices_ok == 0)
+        midi_debug("Not real time with %d voices", BENCH_STEP);
+    else if (voices_ok == MAX_VOICES)
+        midi_debug("Real time: %d+ voices (est. %d)", MAX_VOICES, estimate);
+    else
+        midi_debug("Real time: %d voices", voices_ok);
+
+    return 0;
+}
+
 static int midimain(const void * filename)
 {
     int a, notes_used, vol;
@@ -523,17 +602,35 @@ enum plugin_status plugin_start(const void* parameter)
 {
     int retval;
 
-    if (parameter == NULL)
-    {
-        rb->splash(HZ*2, " Play .MID file ");
-        return PLUGIN_OK;
-    }
     rb->lcd_setfont(FONT_SYSFIXED);
 
 #if defined(HAVE_ADJUSTABLE_CPU_FREQ)
     rb->cpu_boost(true);
 #endif
 
+#ifdef SYNTH_DUAL_CORE
+    synthStartThread();
+#endif
+
+    if (parameter == NULL)
+    {
+        /* Started without a file - see what the synth can do */
+        retval = benchmark();
+
+#ifdef SYNTH_DUAL_CORE
+        synthStopThread();
+#endif
+#if defined(HAVE_ADJUSTABLE_CPU_FREQ)
+        rb->cpu_boost(false);
+#endif
+        if (retval == -1)
+            return PLUGIN_ERROR;
+
+        rb->button_clear_queue();
+        rb->button_get(true);
+        return PLUGIN_OK;
+    }
+
     midi_debug("%s", parameter);
     /*   rb->splash(HZ, true, parameter); */
 
@@ -550,6 +647,10 @@ enum plugin_status plugin_start(const void* parameter)
     rb->pcm_play_stop();
     rb->pcm_set_frequency(HW_SAMPR_DEFAULT);
 
+#ifdef SYNTH_DUAL_CORE
+    synthStopThread();
+#endif
+
 #if defined(HAVE_ADJUSTABLE_CPU_FREQ)
     rb->cpu_boost(false);
 #endif
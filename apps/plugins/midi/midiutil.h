@@ -52,6 +52,11 @@
 
 #endif
 
+/* Half of the voices are rendered on the other core */
+#if NUM_CORES > 1 && !defined(SIMULATOR)
+#define SYNTH_DUAL_CORE
+#endif
+
 #define BYTE unsigned char
 
 /* Data chunk ID types, returned by readID() */
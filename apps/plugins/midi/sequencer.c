@@ -279,6 +279,12 @@ static inline void pressNote(int ch, int note, int vol)
     }
 }
 
+/* Used by the benchmark */
+void startNote(int ch, int note, int vol)
+{
+    pressNote(ch, note, vol);
+}
+
 static void releaseNote(int ch, int note)
 {
     if (ch == 9)
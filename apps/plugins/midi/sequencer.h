@@ -24,6 +24,8 @@ int tick(void);
 /* used by beatbox */
 void rewindFile(void);
 
+void startNote(int ch, int note, int vol);
+
 void seekForward(int nSec);
 void seekBackward(int nSec);
 
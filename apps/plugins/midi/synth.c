@@ -258,6 +258,101 @@ void setPoint(struct SynthObject * so, int pt)
         so->curOffset = 0;
 }
 
+/* Samples rendered between two updates of the envelope. In between, the
+   voice is rendered without any per sample checks until it gets to a loop
+   point or the end of its waveform. */
+#define SYNTH_BLOCK 32
+
+/* Adds one sample to the output, left in the high and right in the low half */
+static inline int32_t panSample(int s1, unsigned int pan)
+{
+    int s2 = s1 * pan;
+    s1 = (s1 << 7) - s2;
+    return ((s1 << 9) & 0xFFFF0000) | ((s2 >> 7) & 0xFFFF);
+}
+
+/* Fades out a stopped voice from the last sample it played */
+static void rampVoice(struct SynthObject * so, int32_t * out,
+                      unsigned int samples)
+{
+    const unsigned int pan = chPan[so->ch];
+
+    while (samples-- > 0 && so->isUsed)
+    {
+        so->decay = so->decay / 2;
+
+        if (so->decay < 10 && so->decay > -10)
+            so->isUsed = false;
+
+        *(out++) += panSample(so->decay, pan);
+    }
+}
+
+/* Starts the fade out of a voice, 's' is the last sample it played */
+static inline void stopVoice(struct SynthObject * so, int s)
+{
+    so->state = STATE_RAMPDOWN;
+    so->decay = s != 0 ? s : 1;
+}
+
+/* Advances the envelope by 'samples'. Returns false if the voice is done. */
+static bool stepEnvelope(struct SynthObject * so, unsigned int samples)
+{
+    if (so->curRate == 0)
+        return false;
+
+    if (so->ch == 9) /* No ADSR for drums */
+        return true;
+
+    int step = so->curRate * (int)samples;
+    bool passed;
+
+    if (so->curOffset < so->targetOffset)
+    {
+        so->curOffset += step;
+        passed = so->curOffset > so->targetOffset;
+    }
+    else
+    {
+        so->curOffset -= step;
+        passed = so->curOffset < so->targetOffset;
+    }
+
+    if (passed)
+    {
+        if (so->curPoint == 2)          /* Sustain */
+            so->curOffset = so->targetOffset;
+        else if (so->curPoint != 5)
+            setPoint(so, so->curPoint+1);
+        else
+            return false;
+    }
+
+    if (so->curOffset < 0)
+    {
+        so->curOffset = so->targetOffset;
+        return false;
+    }
+
+    return true;
+}
+
+/* Number of steps the voice can take before it has to check for a loop
+   point or the end of the waveform */
+static inline unsigned int freeSteps(const struct SynthObject * so,
+                                     unsigned int cp, unsigned int lo,
+                                     unsigned int hi)
+{
+    if (cp >= hi || cp < lo)
+        return 0;
+    else if (so->delta > 0)
+        return (hi - 1 - cp) / so->delta;
+    else if (so->delta < 0)
+        return (cp - lo) / -so->delta;
+    else
+        return UINT_MAX;
+}
+
 static inline void synthVoice(struct SynthObject * so, int32_t * out, unsigned int samples)
 {
     struct GWaveform * wf;
@@ -270,7 +365,6 @@ static inline void synthVoice(struct SynthObject * so, int32_t * out, unsigned i
     const int16_t *sample_data = wf->data;
 
     const unsigned int pan = chPan[so->ch];
-    const int volscale = so->volscale;
 
     const int mode_mask24 = wf->mode&24;
     const int mode_mask28 = wf->mode&28;
@@ -282,163 +376,120 @@ static inline void synthVoice(struct SynthObject * so, int32_t * out, unsigned i
     const unsigned int start_loop = wf->startLoop << FRACTSIZE;
     const int diff_loop = end_loop-start_loop;
 
-    bool rampdown = (so->state == STATE_RAMPDOWN);
-    const bool ch_9 = (so->ch == 9);
+    /* Going forward the checks start at the loop end or the waveform end,
+       going backward at the loop start */
+    const unsigned int hi = mode_mask28 ? MIN(end_loop, num_samples)
+                                        : num_samples;
 
-    while(LIKELY(samples-- > 0))
+    s1 = 0;
+
+    while (samples > 0)
     {
-        /* Is voice being ramped? */
-        if(UNLIKELY(rampdown))
+        if (so->state == STATE_RAMPDOWN)
         {
-            if(so->decay != 0)  /* Ramp has been started */
-            {
-                so->decay = so->decay / 2;
+            rampVoice(so, out, samples);
+            break;
+        }
 
-                if(so->decay < 10 && so->decay > -10)
-                    so->isUsed = false;
+        const unsigned int len = MIN(samples, SYNTH_BLOCK);
+        unsigned int block = len;
+        bool stop = false;
 
-                s1 = so->decay;
-                s2 = s1 * pan;
-                s1 = (s1 << 7) -s2;
-                *(out++) += ((s1 << 9) & 0xFFFF0000) | ((s2 >> 7) &0xFFFF);
-                continue;
-            }
-        } else  /* OK to advance voice */
-        {
-            cp_temp += so->delta;
-        }
+        samples -= len;
 
-        s2 = sample_data[(cp_temp >> FRACTSIZE)+1];
+        /* Scaling by channel volume and note volume is done in sequencer.c */
+        /* That saves us some multiplication and pointer operations         */
+        const int gain = (so->curOffset >> 22) * so->volscale >> 8;
 
-        if(LIKELY(mode_mask28))
+        while (block > 0)
         {
-            /* LOOP_REVERSE|LOOP_PINGPONG  = 24  */
-            if(UNLIKELY(mode_mask24 && so->loopState == STATE_LOOPING && (cp_temp < start_loop)))
-            {
-                if(UNLIKELY(mode_mask_looprev))
-                {
-                    cp_temp += diff_loop;
-                    s2 = sample_data[cp_temp >> FRACTSIZE];
-                }
-                else
-                {
-                    so->delta = -so->delta; /* At this point cp_temp is wrong. We need to take a step */
-                }
-            }
+            unsigned int lo = (mode_mask24 && so->loopState == STATE_LOOPING)
+                              ? start_loop : 0;
+            unsigned int n = MIN(block, freeSteps(so, cp_temp, lo, hi));
+            const int delta = so->delta;
 
-            if(UNLIKELY(cp_temp >= end_loop))
+            block -= n;
+
+            while (n-- > 0)
             {
-                so->loopState = STATE_LOOPING;
-                if(UNLIKELY(!mode_mask24))
-                {
-                    cp_temp -= diff_loop;
-                    s2 = sample_data[cp_temp >> FRACTSIZE];
-                }
-                else
-                {
-                    so->delta = -so->delta;
-                }
-            }
-        }
+                cp_temp += delta;
 
-        /* Have we overrun? */
-        if(UNLIKELY(cp_temp >= num_samples))
-        {
-            cp_temp -= so->delta;
-            s2 = sample_data[(cp_temp >> FRACTSIZE)+1];
+                const int16_t *p = &sample_data[cp_temp >> FRACTSIZE];
+                s1 = p[0];
+                s1 += (signed)((p[1] - s1) * (cp_temp & ((1<<FRACTSIZE)-1))) >> FRACTSIZE;
+                s1 = s1 * gain >> 14;
 
-            if (!rampdown) /* stop voice */
-            {
-                rampdown = true;
-                so->decay = 0;
+                *(out++) += panSample(s1, pan);
             }
-        }
 
-        /* Better, working, linear interpolation    */
-        s1 = sample_data[cp_temp >> FRACTSIZE];
+            if (block == 0)
+                break;
 
-        s1 +=((signed)((s2 - s1) * (cp_temp & ((1<<FRACTSIZE)-1)))>>FRACTSIZE);
+            /* One step that gets to a loop point or the end */
+            block--;
+            cp_temp += so->delta;
 
-        if(UNLIKELY(so->curRate == 0))
-        {
-            if (!rampdown) /* stop voice */
-            {
-                rampdown = true;
-                so->decay = 0;
-            }
-//          so->isUsed = false;
-        }
+            s2 = sample_data[(cp_temp >> FRACTSIZE)+1];
 
-        if(LIKELY(!ch_9 && !rampdown)) /* Stupid ADSR code... and don't do ADSR for drums */
-        {
-            if(UNLIKELY(so->curOffset < so->targetOffset))
+            if(LIKELY(mode_mask28))
             {
-                so->curOffset += (so->curRate);
-                if(UNLIKELY(so -> curOffset > so->targetOffset && so->curPoint != 2))
+                /* LOOP_REVERSE|LOOP_PINGPONG  = 24  */
+                if(mode_mask24 && so->loopState == STATE_LOOPING && (cp_temp < start_loop))
                 {
-                    if(UNLIKELY(so->curPoint != 5))
+                    if(mode_mask_looprev)
                     {
-                        setPoint(so, so->curPoint+1);
+                        cp_temp += diff_loop;
+                        s2 = sample_data[cp_temp >> FRACTSIZE];
                     }
-                    else if (!rampdown) /* stop voice */
+                    else
                     {
-                        rampdown = true;
-                        so->decay = 0;
+                        so->delta = -so->delta; /* At this point cp_temp is wrong. We need to take a step */
                     }
                 }
-            } else
-            {
-                so->curOffset -= (so->curRate);
-                if(UNLIKELY(so -> curOffset < so->targetOffset && so->curPoint != 2))
+
+                if(cp_temp >= end_loop)
                 {
-                    if(UNLIKELY(so->curPoint != 5))
+                    so->loopState = STATE_LOOPING;
+                    if(!mode_mask24)
                     {
-                        setPoint(so, so->curPoint+1);
+                        cp_temp -= diff_loop;
+                        s2 = sample_data[cp_temp >> FRACTSIZE];
                     }
-                    else if (!rampdown) /* stop voice */
+                    else
                     {
-                        rampdown = true;
-                        so->decay = 0;
+                        so->delta = -so->delta;
                     }
-
                 }
             }
-        }
 
-        if(UNLIKELY(so->curOffset < 0))
-        {
-            so->curOffset = so->targetOffset;
-            if (!rampdown)
+            /* Have we overrun? */
+            if(cp_temp >= num_samples)
             {
-                rampdown = true;
-                so->decay = 0;
+                cp_temp -= so->delta;
+                s2 = sample_data[(cp_temp >> FRACTSIZE)+1];
+                stop = true;
             }
-        }
 
-        s1 = s1 * (so->curOffset >> 22) >> 8;
+            /* Better, working, linear interpolation    */
+            s1 = sample_data[cp_temp >> FRACTSIZE];
+            s1 +=((signed)((s2 - s1) * (cp_temp & ((1<<FRACTSIZE)-1)))>>FRACTSIZE);
+            s1 = s1 * gain >> 14;
 
-        /* Scaling by channel volume and note volume is done in sequencer.c */
-        /* That saves us some multiplication and pointer operations         */
-        s1 = s1 * volscale >> 14;
+            *(out++) += panSample(s1, pan);
 
-        /* need to set ramp beginning */
-        if(UNLIKELY(rampdown && so->decay == 0))
-        {
-            so->decay = s1;
-            if(so->decay == 0)
-                so->decay = 1;  /* stupid junk.. */
+            if (stop)
+                break;
         }
 
-        s2 = s1 * pan;
-        s1 = (s1 << 7) - s2;
-        *(out++) += ((s1 << 9) & 0xFFFF0000) | ((s2 >> 7) &0xFFFF);
+        if (stop || !stepEnvelope(so, len))
+        {
+            stopVoice(so, s1);
+            /* The rest of this block fades out */
+            samples += block;
+        }
     }
 
-    /* store these again */
-    if (rampdown)
-        so->state = STATE_RAMPDOWN;
     so->cp = cp_temp;
-    return;
 }
 
 /* buffer to hold all the samples for the current tick, this is a hack
@@ -446,6 +497,80 @@ static inline void synthVoice(struct SynthObject * so, int32_t * out, unsigned i
    access iram */
 int32_t samp_buf[512] IBSS_ATTR;
 
+/* Adds every 'step'th voice starting at 'first' to buf */
+static void synthVoices(int32_t *buf, unsigned int num_samples,
+                        int first, int step)
+{
+    int i;
+
+    for(i=first; i < MAX_VOICES; i+=step)
+    {
+        struct SynthObject *voicept=&voices[i];
+        if(voicept->isUsed)
+        {
+            synthVoice(voicept, buf, num_samples);
+        }
+    }
+}
+
+#ifdef SYNTH_DUAL_CORE
+/* The other core renders every second voice into its own buffer while this
+   one does the rest. On PP the voices are in IRAM, which isn't cached. */
+enum
+{
+    SYNTH_RUN = 1,
+    SYNTH_QUIT,
+};
+
+static struct event_queue synth_q SHAREDBSS_ATTR;
+static volatile bool synth_done SHAREDBSS_ATTR;
+static unsigned int synth_thread_id = 0;
+static long synth_stack[DEFAULT_STACK_SIZE / sizeof(long)];
+/* written by the other core only */
+static int32_t synth_cop_buf[512] CACHEALIGN_ATTR;
+
+static void synthThread(void)
+{
+    struct queue_event ev;
+
+    while (1)
+    {
+        rb->queue_wait(&synth_q, &ev);
+
+        if (ev.id == SYNTH_QUIT)
+            break;
+
+        IF_COP(rb->commit_discard_dcache());
+
+        rb->memset(synth_cop_buf, 0, ev.data*4);
+        synthVoices(synth_cop_buf, ev.data, 1, 2);
+
+        IF_COP(rb->commit_dcache());
+        synth_done = true;
+    }
+}
+
+void synthStartThread(void)
+{
+    rb->queue_init(&synth_q, false);
+    synth_thread_id = rb->create_thread(synthThread, synth_stack,
+                                        sizeof(synth_stack), 0, "midi synth"
+                                        IF_PRIO(, PRIORITY_PLAYBACK)
+                                        IF_COP(, COP));
+}
+
+void synthStopThread(void)
+{
+    if (synth_thread_id != 0)
+    {
+        rb->queue_post(&synth_q, SYNTH_QUIT, 0);
+        rb->thread_wait(synth_thread_id);
+        rb->queue_delete(&synth_q);
+        synth_thread_id = 0;
+    }
+}
+#endif /* SYNTH_DUAL_CORE */
+
 /* synth num_samples samples and write them to the */
 /* buffer pointed to by buf_ptr                    */
 void synthSamples(int32_t *buf_ptr, unsigned int num_samples) ICODE_ATTR;
@@ -455,18 +580,32 @@ void synthSamples(int32_t *buf_ptr, unsigned int num_samples)
         DEBUGF("num_samples is too big!\n");
     else
     {
-        int i;
-        struct SynthObject *voicept;
-
         rb->memset(samp_buf, 0, num_samples*4);
 
-        for(i=0; i < MAX_VOICES; i++)
+#ifdef SYNTH_DUAL_CORE
+        if (synth_thread_id != 0)
         {
-            voicept=&voices[i];
-            if(voicept->isUsed)
-            {
-                synthVoice(voicept, samp_buf, num_samples);
-            }
+            unsigned int i;
+
+            IF_COP(rb->commit_dcache());
+            synth_done = false;
+            rb->queue_post(&synth_q, SYNTH_RUN, num_samples);
+
+            synthVoices(samp_buf, num_samples, 0, 2);
+
+            while (!synth_done)
+                rb->yield();
+
+            IF_COP(rb->commit_discard_dcache());
+
+            /* the same as adding all voices to one buffer */
+            for (i = 0; i < num_samples; i++)
+                samp_buf[i] += synth_cop_buf[i];
+        }
+        else
+#endif
+        {
+            synthVoices(samp_buf, num_samples, 0, 1);
         }
 
         rb->memcpy(buf_ptr, samp_buf, num_samples*4);
@@ -477,4 +616,3 @@ void synthSamples(int32_t *buf_ptr, unsigned int num_samples)
 
     return;  /* No more ghetto lowpass filter. Linear interpolation works well. */
 }
-
@@ -22,6 +22,11 @@ int initSynth(struct MIDIfile * mf, char * filename, char * drumConfig);
 void setPoint(struct SynthObject * so, int pt);
 void synthSamples(int32_t *buf_ptr, unsigned int num_samples);
 
+#ifdef SYNTH_DUAL_CORE
+void synthStartThread(void);
+void synthStopThread(void);
+#endif
+
 void resetControllers(void);
 
 static inline struct Event * getEvent(struct Track * tr, int evNum)
@@ -578,6 +578,98 @@ static int settings_menu(void)
     return 0;
 }
 
+#ifdef USETHREADS
+/* double buffering thread */
+static void thread(void)
+{
+    struct queue_event ev;
+
+    while (1)
+    {
+        synthbuf();
+        rb->queue_wait_w_tmo(&thread_q, &ev, HZ/20);
+        switch (ev.id) {
+            case EV_EXIT:
+                return;
+        }
+    }
+}
+
+static bool start_thread(void)
+{
+    rb->queue_init(&thread_q, true);
+    thread_id = rb->create_thread(thread, thread_stack,
+        sizeof(thread_stack), 0, "render buffering thread"
+        IF_PRIO(, PRIORITY_PLAYBACK)
+        IF_COP(, CPU));
+    return thread_id != 0;
+}
+
+static void stop_thread(void)
+{
+    rb->queue_post(&thread_q, EV_EXIT, 0);
+    rb->thread_wait(thread_id);
+    rb->queue_delete(&thread_q);
+}
+#endif
+
+#ifdef USEC_TIMER
+#define NOW()       ((long)USEC_TIMER)
+#define PER_SECOND  1000000
+#else
+#define NOW()       (*rb->current_tick)
+#define PER_SECOND  HZ
+#endif
+
+#define BENCH_SECONDS 10
+
+/**
+  Mixes the next seconds of the module as fast as it goes and shows how many
+  times real time that was. Playback goes on from where it was.
+ */
+static void benchmark(void)
+{
+    long time, factor;
+    long samples = 0;
+    int pos = module->sngpos;
+
+    if (Player_Paused())
+    {
+        rb->splash(HZ, "Resume playback first");
+        return;
+    }
+
+    rb->pcm_play_stop();
+#ifdef USETHREADS
+    stop_thread();
+#endif
+
+    rb->splash(0, "Benchmarking...");
+
+    time = NOW();
+    while (samples < BENCH_SECONDS * SAMPLE_RATE && Player_Active())
+    {
+        /* 16 bit stereo */
+        samples += VC_WriteBytes(gmbuf, BUF_SIZE) / 4;
+        rb->yield();
+    }
+    time = NOW() - time;
+
+    if (time <= 0)
+        time = 1;
+    factor = (long long)samples * PER_SECOND * 100 / SAMPLE_RATE / time;
+
+    Player_SetPosition(pos);
+    memset(gmbuf, 0, sizeof(gmbuf));
+#ifdef USETHREADS
+    start_thread();
+#endif
+    rb->pcm_play_data(&get_more, NULL, NULL, 0);
+
+    rb->splashf(HZ*4, "%d channels: %ld.%02ldx real time",
+                module->numchn, factor / 100, factor % 100);
+}
+
 /**
   Show the main menu
  */
@@ -587,7 +679,7 @@ static int main_menu(void)
     int result;
 
     MENUITEM_STRINGLIST(main_menu,"Mikmod Main Menu",NULL,
-                        "Settings", "Return", "Quit");
+                        "Settings", "Benchmark", "Return", "Quit");
     while (1)
     {
         switch (rb->do_menu(&main_menu,&selection, NULL, false))
@@ -598,9 +690,13 @@ static int main_menu(void)
             break;
 
         case 1:
+            benchmark();
             return 0;
 
         case 2:
+            return 0;
+
+        case 3:
             return -1;
 
         case MENU_ATTACHED_USB:
@@ -612,24 +708,6 @@ static int main_menu(void)
     }
 }
 
-#ifdef USETHREADS
-/* double buffering thread */
-static void thread(void)
-{
-    struct queue_event ev;
-
-    while (1)
-    {
-        synthbuf();
-        rb->queue_wait_w_tmo(&thread_q, &ev, HZ/20);
-        switch (ev.id) {
-            case EV_EXIT:
-                return;
-        }
-    }
-}
-#endif
-
 static void mm_errorhandler(void)
 {
     rb->splashf(HZ, "%s", MikMod_strerror(MikMod_errno));
@@ -668,11 +746,7 @@ static int playfile(char* filename)
         rb->cpu_boost(true);
 #endif
 #ifdef USETHREADS
-    rb->queue_init(&thread_q, true);
-    if ((thread_id = rb->create_thread(thread, thread_stack,
-        sizeof(thread_stack), 0, "render buffering thread" 
-        IF_PRIO(, PRIORITY_PLAYBACK)
-        IF_COP(, CPU))) == 0)
+    if (!start_thread())
     {
         rb->splash(HZ, "Cannot create thread!");
         return PLUGIN_ERROR;
@@ -841,9 +915,7 @@ static int playfile(char* filename)
     }
 
 #ifdef USETHREADS
-    rb->queue_post(&thread_q, EV_EXIT, 0);
-    rb->thread_wait(thread_id);
-    rb->queue_delete(&thread_q);
+    stop_thread();
 #endif
 #ifdef HAVE_ADJUSTABLE_CPU_FREQ
     if ( settings.boost )
@@ -72,7 +72,8 @@
 #define FRACBITS 11
 #define FRACMASK ((1L<<FRACBITS)-1L)
 
-#define TICKLSIZE 8192
+/* one block of mixed samples, see the block mixers below */
+#define TICKLSIZE 512
 #define TICKWSIZE (TICKLSIZE<<1)
 #define TICKBSIZE (TICKWSIZE<<1)
 
@@ -109,7 +110,7 @@ static	VINFO *vinf=NULL,*vnf;
 static	long tickleft,samplesthatfit,vc_memory=0;
 static	int vc_softchn;
 static	SLONGLONG idxsize,idxlpos,idxlend;
-static	SLONG *vc_tickbuf=NULL;
+static	SLONG vc_tickbuf[TICKLSIZE] IBSS_ATTR;
 static	UWORD vc_mode;
 
 /* Reverb control variables */
@@ -130,335 +131,190 @@ static	SLONG *RVbufR1=NULL,*RVbufR2=NULL,*RVbufR3=NULL,*RVbufR4=NULL,
 #else
 #define NATIVE SLONG
 #endif
-#if defined HAVE_SSE2 || defined HAVE_ALTIVEC
-
-static size_t MixSIMDMonoNormal(const SWORD* srce,SLONG* dest,size_t index, size_t increment,size_t todo)
-{
-	// TODO:
-	SWORD sample;
-	SLONG lvolsel = vnf->lvolsel;
-
-	while(todo--) {
-		sample = srce[index >> FRACBITS];
-		index += increment;
-
-		*dest++ += lvolsel * sample;
-	}
-	return index;
-}
-
-static size_t MixSIMDStereoNormal(const SWORD* srce, SLONG* dest, size_t index, size_t increment,size_t todo)
-{	
-	SWORD vol[8] = {vnf->lvolsel, vnf->rvolsel};
-	SWORD sample;
-	SLONG remain = todo;
-
-	// Dest can be misaligned ...
-	while(!IS_ALIGNED_16(dest)) {
-		sample=srce[(index += increment) >> FRACBITS];
-		*dest++ += vol[0] * sample;
-		*dest++ += vol[1] * sample;
-		todo--;
-	}
-
-	// Srce is always aligned ...
-
-#if defined HAVE_SSE2
-	remain = todo&3;	
-	{
-		__m128i v0 = _mm_set_epi16(0, vol[1], 
-								   0, vol[0], 
-								   0, vol[1], 
-								   0, vol[0]);
-		for(todo>>=2;todo; todo--)
-		{
-			SWORD s0 = srce[(index += increment) >> FRACBITS];
-			SWORD s1 = srce[(index += increment) >> FRACBITS];
-			SWORD s2 = srce[(index += increment) >> FRACBITS];
-			SWORD s3 = srce[(index += increment) >> FRACBITS];
-			__m128i v1 = _mm_set_epi16(0, s1, 0, s1, 0, s0, 0, s0);
-			__m128i v2 = _mm_set_epi16(0, s3, 0, s3, 0, s2, 0, s2);
-			__m128i v3 = _mm_load_si128((__m128i*)(dest+0));
-			__m128i v4 = _mm_load_si128((__m128i*)(dest+4));
-			_mm_store_si128((__m128i*)(dest+0), _mm_add_epi32(v3, _mm_madd_epi16(v0, v1)));
-			_mm_store_si128((__m128i*)(dest+4), _mm_add_epi32(v4, _mm_madd_epi16(v0, v2)));
-			dest+=8;				
-		}
-	}
-
-#elif defined HAVE_ALTIVEC
-	remain = todo&3;
-	{
-		vector signed short r0 = vec_ld(0, vol);
-		vector signed short v0 = vec_perm(r0, r0, (vector unsigned char)(0, 1, // l
-																		 0, 1, // l
-																		 2, 3, // r
-																		 2, 1, // r
-																		 0, 1, // l
-																		 0, 1, // l
-																		 2, 3, // r 
-																		 2, 3 // r
-																		 ));
-		SWORD s[8];
-			
-		for(todo>>=2;todo; todo--)
-		{
-			// Load constants
-			s[0] = srce[(index += increment) >> FRACBITS];
-			s[1] = srce[(index += increment) >> FRACBITS];
-			s[2] = srce[(index += increment) >> FRACBITS];
-			s[3] = srce[(index += increment) >> FRACBITS];
-			s[4] = 0;
-	
-			vector short int r1 = vec_ld(0, s);
-			vector signed short v1 = vec_perm(r1, r1, (vector unsigned char)(0*2, 0*2+1, // s0
-																			 4*2, 4*2+1, // 0
-																			 0*2, 0*2+1, // s0
-																			 4*2, 4*2+1, // 0
-																			 1*2, 1*2+1, // s1
-																			 4*2, 4*2+1, // 0
-																			 1*2, 1*2+1, // s1
-																			 4*2, 4*2+1  // 0
-																			 ));
-																			 
-			vector signed short v2 = vec_perm(r1, r1, (vector unsigned char)(2*2, 2*2+1, // s2
-																			 4*2, 4*2+1, // 0
-																			 2*2, 2*2+1, // s2
-																			 4*2, 4*2+1, // 0
-																			 3*2, 3*2+1, // s3
-																			 4*2, 4*2+1, // 0
-																			 3*2, 3*2+1, // s3
-																			 4*2, 4*2+1  // 0
-																			 ));
-			vector signed int v3 = vec_ld(0, dest);
-			vector signed int v4 = vec_ld(0, dest + 4);
-			vector signed int v5 = vec_mule(v0, v1);
-			vector signed int v6 = vec_mule(v0, v2);
-
-			vec_st(vec_add(v3, v5), 0, dest);				
-			vec_st(vec_add(v4, v6), 0x10, dest);
-
-			dest+=8;
-		}
-	}
-#endif // HAVE_ALTIVEC
+/*========== Block mixers
+
+  The channels are mixed into vc_tickbuf, which holds one block of samples
+  and stays in IRAM where there is some. Every combination of interpolation
+  and output mode gets its own inner loop, MixBlock() with the mode fixed,
+  and the volume ramp has a loop of its own which only mixes the samples the
+  ramp lasts. The mixers never have to look for the loop points or the end
+  of the sample, AddChannel() splits the block there. Hosted builds with
+  SSE2 mix four samples at once.
+*/
 
-	// Remaining bits ...
-	while(remain--) {
-		sample=srce[(index += increment) >> FRACBITS];
+#define MIX_MONO		0
+#define MIX_STEREO		1
+#define MIX_SURROUND	2
 
-		*dest++ += vol[0] * sample;
-		*dest++ += vol[1] * sample;
-	}
-	return index;
-}
-#endif
+#if (CONFIG_PLATFORM & PLATFORM_HOSTED) && defined(__SSE2__)
+/* mix four samples at once, multiplying 16 bit words with pmaddwd */
+#define SSE2_MIXER
+#include <emmintrin.h>
 
-/*========== 32 bit sample mixers - only for 32 bit platforms */
-#ifndef NATIVE_64BIT_INT
+typedef SLONG SLONG_U __attribute__((aligned(2), may_alias));
 
-static SLONG Mix32MonoNormal(const SWORD* srce,SLONG* dest,SLONG index,SLONG increment,SLONG todo)
+/* The words of a sample and the next one in the order of memory */
+static inline SLONG LoadPair(const SWORD* p)
 {
-#if defined HAVE_ALTIVEC || defined HAVE_SSE2
-    if (md_mode & DMODE_SIMDMIXER)
-    {
-		return MixSIMDMonoNormal(srce, dest, index, increment, todo);
-	}
-	else
-#endif
-	{
-		SWORD sample;
-		SLONG lvolsel = vnf->lvolsel;
-	
-		while(todo--) {
-			sample = srce[index >> FRACBITS];
-			index += increment;
-	
-			*dest++ += lvolsel * sample;
-		}
-	}
-	return index;
+	return *(const SLONG_U*)p;
 }
-
-// FIXME: This mixer should works also on 64-bit platform
-// Hint : changes SLONG / SLONGLONG mess with size_t 
-static SLONG Mix32StereoNormal(const SWORD* srce,SLONG* dest,SLONG index,SLONG increment,SLONG todo)
-{
-#if defined HAVE_ALTIVEC || defined HAVE_SSE2
-    if (md_mode & DMODE_SIMDMIXER)
-    {
-		return MixSIMDStereoNormal(srce, dest, index, increment, todo);
-	}
-	else
 #endif
-	{
-		SWORD sample;
-		SLONG lvolsel = vnf->lvolsel;
-		SLONG rvolsel = vnf->rvolsel;
-
-		while(todo--) {
-			sample=srce[(index += increment) >> FRACBITS];
-
-			*dest++ += lvolsel * sample;
-			*dest++ += rvolsel * sample;
-		}
-	}
-	return index;
-}
 
+typedef NATIVE (*BLOCKMIXER)(const SWORD*,SLONG*,NATIVE,NATIVE,NATIVE);
 
-static SLONG Mix32SurroundNormal(const SWORD* srce,SLONG* dest,SLONG index,SLONG increment,SLONG todo)
+static inline SLONG FetchSample(const SWORD* srce,NATIVE index,int interp)
 {
-	SWORD sample;
-	SLONG lvolsel = vnf->lvolsel;
-	SLONG rvolsel = vnf->rvolsel;
+	const SWORD *p=&srce[index>>FRACBITS];
 
-	if (lvolsel>=rvolsel) {
-		while(todo--) {
-			sample = srce[index >> FRACBITS];
-			index += increment;
+	if(!interp)
+		return p[0];
 
-			*dest++ += lvolsel*sample;
-			*dest++ -= lvolsel*sample;
-		}
-	} else {
-		while(todo--) {
-			sample = srce[index >> FRACBITS];
-			index += increment;
-
-			*dest++ -= rvolsel*sample;
-			*dest++ += rvolsel*sample;
-		}
-	}
-	return index;
+	return p[0]+((SLONG)(p[1]-p[0])*(SLONG)(index&FRACMASK)>>FRACBITS);
 }
 
-static SLONG Mix32MonoInterp(const SWORD* srce,SLONG* dest,SLONG index,SLONG increment,SLONG todo)
+static inline __attribute__((always_inline))
+NATIVE MixBlock(const SWORD* srce,SLONG* dest,NATIVE index,NATIVE increment,
+                NATIVE todo,int interp,int mode)
 {
-	SLONG sample;
-	SLONG lvolsel = vnf->lvolsel;
-	SLONG rampvol = vnf->rampvol;
-
-	if (rampvol) {
-		SLONG oldlvol = vnf->oldlvol - lvolsel;
-		while(todo--) {
-			sample=(SLONG)srce[index>>FRACBITS]+
-			       ((SLONG)(srce[(index>>FRACBITS)+1]-srce[index>>FRACBITS])
-			        *(index&FRACMASK)>>FRACBITS);
-			index += increment;
-
-			*dest++ += ((lvolsel << CLICK_SHIFT) + oldlvol * rampvol)
-			           * sample >> CLICK_SHIFT;
-			if (!--rampvol)
-				break;
+	SLONG lvolsel=vnf->lvolsel;
+	SLONG rvolsel=(mode==MIX_SURROUND)?-lvolsel:vnf->rvolsel;
+
+#ifdef SSE2_MIXER
+	/* the volumes are 16 bit words paired with a zero, to take the sample
+	   from the low word of a 32 bit lane */
+	const __m128i vol=_mm_set_epi32(rvolsel&0xffff,lvolsel&0xffff,
+	                                rvolsel&0xffff,lvolsel&0xffff);
+	const __m128i mvol=_mm_set1_epi32(lvolsel&0xffff);
+
+	for(;todo>=4;todo-=4) {
+		NATIVE i0=index,i1=i0+increment,i2=i1+increment,i3=i2+increment;
+		const SWORD *p0=&srce[i0>>FRACBITS],*p1=&srce[i1>>FRACBITS],
+		            *p2=&srce[i2>>FRACBITS],*p3=&srce[i3>>FRACBITS];
+		__m128i s;
+
+		if(interp) {
+			/* a sample and the next one as the two words of a lane, times
+			   -f and f in the same words is (b-a)*f */
+			__m128i ab=_mm_set_epi32(LoadPair(p3),LoadPair(p2),
+			                         LoadPair(p1),LoadPair(p0));
+			__m128i f=_mm_and_si128(_mm_set_epi32(i3,i2,i1,i0),
+			                        _mm_set1_epi32(FRACMASK));
+			f=_mm_or_si128(_mm_slli_epi32(f,16),
+			               _mm_and_si128(_mm_sub_epi32(_mm_setzero_si128(),f),
+			                             _mm_set1_epi32(0xffff)));
+
+			s=_mm_srai_epi32(_mm_slli_epi32(ab,16),16);
+			s=_mm_add_epi32(s,_mm_srai_epi32(_mm_madd_epi16(ab,f),FRACBITS));
+		} else
+			s=_mm_set_epi32(p3[0],p2[0],p1[0],p0[0]);
+		index=i3+increment;
+
+		if(mode==MIX_MONO) {
+			__m128i d=_mm_loadu_si128((__m128i*)dest);
+			_mm_storeu_si128((__m128i*)dest,
+			                 _mm_add_epi32(d,_mm_madd_epi16(s,mvol)));
+			dest+=4;
+		} else {
+			__m128i d0=_mm_loadu_si128((__m128i*)dest);
+			__m128i d1=_mm_loadu_si128((__m128i*)(dest+4));
+			__m128i s0=_mm_unpacklo_epi32(s,s),s1=_mm_unpackhi_epi32(s,s);
+
+			_mm_storeu_si128((__m128i*)dest,
+			                 _mm_add_epi32(d0,_mm_madd_epi16(s0,vol)));
+			_mm_storeu_si128((__m128i*)(dest+4),
+			                 _mm_add_epi32(d1,_mm_madd_epi16(s1,vol)));
+			dest+=8;
 		}
-		vnf->rampvol = rampvol;
-		if (todo < 0)
-			return index;
 	}
+#endif
 
 	while(todo--) {
-		sample=(SLONG)srce[index>>FRACBITS]+
-		       ((SLONG)(srce[(index>>FRACBITS)+1]-srce[index>>FRACBITS])
-		        *(index&FRACMASK)>>FRACBITS);
-		index += increment;
+		SLONG sample=FetchSample(srce,index,interp);
+		index+=increment;
 
-		*dest++ += lvolsel * sample;
+		*dest++ += lvolsel*sample;
+		if(mode!=MIX_MONO)
+			*dest++ += rvolsel*sample;
 	}
 	return index;
 }
 
-static SLONG Mix32StereoInterp(const SWORD* srce,SLONG* dest,SLONG index,SLONG increment,SLONG todo)
+/* Mixes the first 'todo' samples of a volume ramp, 'todo' may not be more
+   than vnf->rampvol */
+static inline __attribute__((always_inline))
+NATIVE MixRamp(const SWORD* srce,SLONG* dest,NATIVE index,NATIVE increment,
+               NATIVE todo,int mode)
 {
-	SLONG sample;
-	SLONG lvolsel = vnf->lvolsel;
-	SLONG rvolsel = vnf->rvolsel;
-	SLONG rampvol = vnf->rampvol;
-
-	if (rampvol) {
-		SLONG oldlvol = vnf->oldlvol - lvolsel;
-		SLONG oldrvol = vnf->oldrvol - rvolsel;
-		while(todo--) {
-			sample=(SLONG)srce[index>>FRACBITS]+
-			       ((SLONG)(srce[(index>>FRACBITS)+1]-srce[index>>FRACBITS])
-			        *(index&FRACMASK)>>FRACBITS);
-			index += increment;
+	SLONG lvolsel=vnf->lvolsel,rvolsel=vnf->rvolsel;
+	SLONG oldlvol=vnf->oldlvol,oldrvol=vnf->oldrvol;
+	SLONG rampvol=vnf->rampvol;
 
-			*dest++ += ((lvolsel << CLICK_SHIFT) + oldlvol * rampvol)
-			           * sample >> CLICK_SHIFT;
-			*dest++ += ((rvolsel << CLICK_SHIFT) + oldrvol * rampvol)
-					   * sample >> CLICK_SHIFT;
-			if (!--rampvol)
-				break;
-		}
-		vnf->rampvol = rampvol;
-		if (todo < 0)
-			return index;
+	if(mode==MIX_SURROUND&&lvolsel<rvolsel) {
+		lvolsel=rvolsel;
+		oldlvol=oldrvol;
 	}
+	oldlvol-=lvolsel;
+	oldrvol-=rvolsel;
 
 	while(todo--) {
-		sample=(SLONG)srce[index>>FRACBITS]+
-		       ((SLONG)(srce[(index>>FRACBITS)+1]-srce[index>>FRACBITS])
-		        *(index&FRACMASK)>>FRACBITS);
-		index += increment;
-
-		*dest++ += lvolsel * sample;
-		*dest++ += rvolsel * sample;
+		SLONG sample=FetchSample(srce,index,1);
+		SLONG left=((lvolsel<<CLICK_SHIFT)+oldlvol*rampvol)*sample>>CLICK_SHIFT;
+		index+=increment;
+
+		*dest++ += left;
+		if(mode==MIX_SURROUND)
+			*dest++ -= left;
+		else if(mode==MIX_STEREO)
+			*dest++ += ((rvolsel<<CLICK_SHIFT)+oldrvol*rampvol)
+			           *sample>>CLICK_SHIFT;
+		rampvol--;
 	}
+	vnf->rampvol=rampvol;
 	return index;
 }
 
-static SLONG Mix32SurroundInterp(const SWORD* srce,SLONG* dest,SLONG index,SLONG increment,SLONG todo)
-{
-	SLONG sample;
-	SLONG lvolsel = vnf->lvolsel;
-	SLONG rvolsel = vnf->rvolsel;
-	SLONG rampvol = vnf->rampvol;
-	SLONG oldvol, vol;
-
-	if (lvolsel >= rvolsel) {
-		vol = lvolsel;
-		oldvol = vnf->oldlvol;
-	} else {
-		vol = rvolsel;
-		oldvol = vnf->oldrvol;
+#define BLOCK_MIXER(name,interp,mode)                                        \
+	static NATIVE name(const SWORD* srce,SLONG* dest,NATIVE index,           \
+	                   NATIVE increment,NATIVE todo) ICODE_ATTR;             \
+	static NATIVE name(const SWORD* srce,SLONG* dest,NATIVE index,           \
+	                   NATIVE increment,NATIVE todo)                         \
+	{                                                                        \
+		return MixBlock(srce,dest,index,increment,todo,interp,mode);         \
 	}
 
-	if (rampvol) {
-		oldvol -= vol;
-		while(todo--) {
-			sample=(SLONG)srce[index>>FRACBITS]+
-			       ((SLONG)(srce[(index>>FRACBITS)+1]-srce[index>>FRACBITS])
-			        *(index&FRACMASK)>>FRACBITS);
-			index += increment;
-
-			sample=((vol << CLICK_SHIFT) + oldvol * rampvol)
-				   * sample >> CLICK_SHIFT;
-			*dest++ += sample;
-			*dest++ -= sample;
-
-			if (!--rampvol)
-				break;
-		}
-		vnf->rampvol = rampvol;
-		if (todo < 0)
-			return index;
+#define RAMP_MIXER(name,mode)                                                \
+	static NATIVE name(const SWORD* srce,SLONG* dest,NATIVE index,           \
+	                   NATIVE increment,NATIVE todo) ICODE_ATTR;             \
+	static NATIVE name(const SWORD* srce,SLONG* dest,NATIVE index,           \
+	                   NATIVE increment,NATIVE todo)                         \
+	{                                                                        \
+		return MixRamp(srce,dest,index,increment,todo,mode);                 \
 	}
 
-	while(todo--) {
-		sample=(SLONG)srce[index>>FRACBITS]+
-		       ((SLONG)(srce[(index>>FRACBITS)+1]-srce[index>>FRACBITS])
-		        *(index&FRACMASK)>>FRACBITS);
-		index += increment;
-
-		*dest++ += vol*sample;
-		*dest++ -= vol*sample;
-	}
-	return index;
-}
-#endif
-
-/*========== 64 bit sample mixers - all platforms */
+BLOCK_MIXER(MixBlockMonoNormal,0,MIX_MONO)
+BLOCK_MIXER(MixBlockStereoNormal,0,MIX_STEREO)
+BLOCK_MIXER(MixBlockSurroundNormal,0,MIX_SURROUND)
+BLOCK_MIXER(MixBlockMonoInterp,1,MIX_MONO)
+BLOCK_MIXER(MixBlockStereoInterp,1,MIX_STEREO)
+BLOCK_MIXER(MixBlockSurroundInterp,1,MIX_SURROUND)
+RAMP_MIXER(MixRampMono,MIX_MONO)
+RAMP_MIXER(MixRampStereo,MIX_STEREO)
+RAMP_MIXER(MixRampSurround,MIX_SURROUND)
+
+/* [interpolation][output mode] */
+static const BLOCKMIXER BlockMixers[2][3]={
+	{MixBlockMonoNormal,MixBlockStereoNormal,MixBlockSurroundNormal},
+	{MixBlockMonoInterp,MixBlockStereoInterp,MixBlockSurroundInterp},
+};
+
+/* the volume is only ramped when interpolating */
+static const BLOCKMIXER RampMixers[3]={
+	MixRampMono,MixRampStereo,MixRampSurround,
+};
+
+/*========== 64 bit sample mixers - for samples longer than the 32 bit
+             mixing index allows on 32 bit platforms */
+#ifndef NATIVE_64BIT_INT
 
 static SLONGLONG MixMonoNormal(const SWORD* srce,SLONG* dest,SLONGLONG index,SLONGLONG increment,SLONG todo)
 {
@@ -638,6 +494,7 @@ static SLONGLONG MixSurroundInterp(const SWORD* srce,SLONG* dest,SLONGLONG index
 	}
 	return index;
 }
+#endif
 
 static void (*MixReverb)(SLONG* srce,NATIVE count);
 
@@ -1044,41 +901,31 @@ static void AddChannel(SLONG* ptr,NATIVE todo)
 
 		if(vnf->vol) {
 #ifndef NATIVE_64BIT_INT
-			/* use the 32 bit mixers as often as we can (they're much faster) */
+			/* the block mixers need the index to fit in 32 bits */
 			if((vnf->current<0x7fffffff)&&(endpos<0x7fffffff)) {
-				if((md_mode & DMODE_INTERP)) {
-					if(vc_mode & DMODE_STEREO) {
-						if((vnf->pan==PAN_SURROUND)&&(md_mode&DMODE_SURROUND))
-							vnf->current=Mix32SurroundInterp
-							           (s,ptr,vnf->current,vnf->increment,done);
-						else
-							vnf->current=Mix32StereoInterp
-							           (s,ptr,vnf->current,vnf->increment,done);
-					} else
-						vnf->current=Mix32MonoInterp
-						               (s,ptr,vnf->current,vnf->increment,done);
-				} else if(vc_mode & DMODE_STEREO) {
-					if((vnf->pan==PAN_SURROUND)&&(md_mode&DMODE_SURROUND))
-						vnf->current=Mix32SurroundNormal
-						               (s,ptr,vnf->current,vnf->increment,done);
-					else
-					{
-#if defined HAVE_ALTIVEC || defined HAVE_SSE2
-					if (md_mode & DMODE_SIMDMIXER)
-						vnf->current=MixSIMDStereoNormal
-						               (s,ptr,vnf->current,vnf->increment,done);
-    
-					else
-#endif
-						vnf->current=Mix32StereoNormal
-						               (s,ptr,vnf->current,vnf->increment,done);
-					}
-				} else
-					vnf->current=Mix32MonoNormal
-					                   (s,ptr,vnf->current,vnf->increment,done);
-			} else
 #endif
-			       {
+				int interp=(md_mode&DMODE_INTERP)?1:0;
+				int mode=MIX_MONO;
+				NATIVE index=vnf->current,count=done;
+				SLONG *dest=ptr;
+
+				if(vc_mode&DMODE_STEREO)
+					mode=((vnf->pan==PAN_SURROUND)&&(md_mode&DMODE_SURROUND))?
+					     MIX_SURROUND:MIX_STEREO;
+
+				if(interp&&vnf->rampvol) {
+					NATIVE ramp=MIN(count,vnf->rampvol);
+
+					index=RampMixers[mode](s,dest,index,vnf->increment,ramp);
+					dest +=(mode==MIX_MONO)?ramp:(ramp<<1);
+					count-=ramp;
+				}
+				if(count)
+					index=BlockMixers[interp][mode]
+					                 (s,dest,index,vnf->increment,count);
+				vnf->current=index;
+#ifndef NATIVE_64BIT_INT
+			} else {
 				if((md_mode & DMODE_INTERP)) {
 					if(vc_mode & DMODE_STEREO) {
 						if((vnf->pan==PAN_SURROUND)&&(md_mode&DMODE_SURROUND))
@@ -1095,21 +942,13 @@ static void AddChannel(SLONG* ptr,NATIVE todo)
 						vnf->current=MixSurroundNormal
 						               (s,ptr,vnf->current,vnf->increment,done);
 					else
-					{
-#if defined HAVE_ALTIVEC || defined HAVE_SSE2
-					if (md_mode & DMODE_SIMDMIXER)
-						vnf->current=MixSIMDStereoNormal
-						               (s,ptr,vnf->current,vnf->increment,done);
-    
-					else
-#endif
 						vnf->current=MixStereoNormal
 						               (s,ptr,vnf->current,vnf->increment,done);
-					}
 				} else
 					vnf->current=MixMonoNormal
 					                   (s,ptr,vnf->current,vnf->increment,done);
 			}
+#endif
 		} else
 			/* update sample position */
 			vnf->current=endpos;
@@ -1156,7 +995,8 @@ void VC1_WriteSamples(SBYTE* buf,ULONG todo)
 				if(!vnf->frq) vnf->active = 0;
 
 				if(vnf->active) {
-					vnf->increment=((SLONGLONG)(vnf->frq<<FRACBITS))/md_mixfreq;
+					/* the dividend has 32 bits, don't divide with 64 */
+					vnf->increment=(SLONGLONG)((vnf->frq<<FRACBITS)/md_mixfreq);
 					if(vnf->flags&SF_REVERSE) vnf->increment=-vnf->increment;
 					vol = vnf->vol;  pan = vnf->pan;
 
@@ -1228,11 +1068,6 @@ int VC1_Init(void)
 		_mm_errno = MMERR_INITIALIZING_MIXER;
 		return 1;
 	}
-	if(!vc_tickbuf)
-		if(!(vc_tickbuf=(SLONG*)MikMod_malloc((TICKLSIZE+32)*sizeof(SLONG)))) {
-			_mm_errno = MMERR_INITIALIZING_MIXER;
-			return 1;
-		}
 
 	MixReverb=(md_mode&DMODE_STEREO)?MixReverb_Stereo:MixReverb_Normal;
 	MixLowPass=(md_mode&DMODE_STEREO)?MixLowPass_Stereo:MixLowPass_Normal;
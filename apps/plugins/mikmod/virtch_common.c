@@ -276,11 +276,9 @@ ULONG VC1_WriteBytes(SBYTE* buf,ULONG todo)
 
 void VC1_Exit(void)
 {
-	if(vc_tickbuf) MikMod_free(vc_tickbuf);
 	if(vinf) MikMod_free(vinf);
 	if(Samples) MikMod_free(Samples);
 
-	vc_tickbuf = NULL;
 	vinf = NULL;
 	Samples = NULL;
 	
@@ -156,7 +156,16 @@ bool mpeg_alloc_init(unsigned char *buf, size_t mallocsize)
 /* allocate non-dedicated buffer space which mpeg2_mem_reset will free */
 void * mpeg2_malloc(unsigned size, mpeg2_alloc_t reason)
 {
-    void *ptr = mpeg_malloc_internal(mpeg2_mallocbuf, &mpeg2_mem_ptr,
+    void *ptr;
+
+#if MPEG2_SLICE_THREAD
+    /* Frames start on a cache line so that the cores can share them by
+     * rows */
+    if (reason == MPEG2_ALLOC_YUV)
+        mpeg2_mem_ptr = ALIGN_UP(mpeg2_mem_ptr, CACHEALIGN_SIZE);
+#endif
+
+    ptr = mpeg_malloc_internal(mpeg2_mallocbuf, &mpeg2_mem_ptr,
                                      mpeg2_bufsize, size, reason);
     /* libmpeg2 expects zero-initialized allocations */
     if (ptr)
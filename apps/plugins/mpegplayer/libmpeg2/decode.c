@@ -230,14 +230,29 @@ mpeg2_state_t mpeg2_parse (mpeg2dec_t * mpeg2dec)
 
     	    mpeg2dec->bytes_since_tag += copied;
 
+#if MPEG2_SLICE_THREAD
+            /* A queued slice stays in the chunk buffer, the next one goes
+               behind it */
+    	    if (mpeg2_slice_queue (mpeg2dec, mpeg2dec->code,
+                                   mpeg2dec->chunk_start))
+                mpeg2dec->chunk_start = mpeg2dec->chunk_ptr;
+            else
+                mpeg2dec->chunk_start = mpeg2dec->chunk_buffer;
+#else
     	    mpeg2_slice (&mpeg2dec->decoder, mpeg2dec->code,
 			             mpeg2dec->chunk_start);
+#endif
 	        mpeg2dec->code = mpeg2dec->buf_start[-1];
 	        mpeg2dec->chunk_ptr = mpeg2dec->chunk_start;
 	    }
 
     	if ((unsigned) (mpeg2dec->code - 1) >= 0xb0 - 1)
+        {
+#if MPEG2_SLICE_THREAD
+            mpeg2_slice_finish (mpeg2dec);
+#endif
 	        break;
+        }
 
     	if (seek_chunk (mpeg2dec) == STATE_BUFFER)
     	    return STATE_BUFFER;
@@ -470,6 +485,10 @@ void mpeg2_tag_picture (mpeg2dec_t * mpeg2dec, uint32_t tag, uint32_t tag2)
 
 void mpeg2_reset (mpeg2dec_t * mpeg2dec, int full_reset)
 {
+#if MPEG2_SLICE_THREAD
+    mpeg2_slice_finish (mpeg2dec);
+#endif
+
     mpeg2dec->buf_start = mpeg2dec->buf_end = NULL;
     mpeg2dec->num_tags = 0;
     mpeg2dec->shift = 0xffffff00;
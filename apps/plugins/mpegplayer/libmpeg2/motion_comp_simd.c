@@ -0,0 +1,100 @@
+/*
+ * motion_comp_simd.c
+ *
+ * This file is part of mpeg2dec, a free MPEG-2 video stream decoder.
+ * See http://libmpeg2.sourceforge.net/ for updates.
+ *
+ * mpeg2dec is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * mpeg2dec is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * $Id$
+ *
+ * Motion compensation with the generic vectors of gcc, one row of a block
+ * per operation. Gives the same results as motion_comp_c.c.
+ */
+#include <inttypes.h>
+#include "mpeg2.h"
+#include "attributes.h"
+#include "mpeg2_internal.h"
+
+/* 16 and 8 pixel rows and the same as 16 bit lanes, for averaging four */
+typedef uint8_t v16u8 __attribute__((vector_size(16)));
+typedef uint16_t v8u16 __attribute__((vector_size(16)));
+typedef uint8_t v8u8 __attribute__((vector_size(8)));
+typedef uint16_t v4u16 __attribute__((vector_size(8)));
+
+/* the rows of the reference pictures have any alignment */
+typedef uint8_t v16u8_u __attribute__((vector_size(16), aligned(1), may_alias));
+typedef uint8_t v8u8_u __attribute__((vector_size(8), aligned(1), may_alias));
+
+#define ROW_16(p) (*(v16u8_u *)(p))
+#define ROW_8(p)  (*(v8u8_u *)(p))
+
+/* avg2() and avg4() of motion_comp.h. The pairs of bytes are added up in
+ * 16 bit lanes, the high and the low bytes separately, so it doesn't
+ * matter which is which. */
+#define AVG_FUNCS(w, vec, wide)                                             \
+    static inline vec avg2_##w (vec a, vec b)                               \
+    {                                                                       \
+        return (a | b) - ((a ^ b) >> 1);                                    \
+    }                                                                       \
+                                                                            \
+    static inline vec avg4_##w (vec a, vec b, vec c, vec d)                 \
+    {                                                                       \
+        wide lo = ((wide)a & 0xff) + ((wide)b & 0xff) +                     \
+                  ((wide)c & 0xff) + ((wide)d & 0xff) + 2;                  \
+        wide hi = ((wide)a >> 8) + ((wide)b >> 8) +                         \
+                  ((wide)c >> 8) + ((wide)d >> 8) + 2;                      \
+        return (vec)((lo >> 2) | ((hi >> 2) << 8));                         \
+    }
+
+AVG_FUNCS (16, v16u8, v8u16)
+AVG_FUNCS (8, v8u8, v4u16)
+
+#define predict_o(w)  (ROW_##w (ref))
+#define predict_x(w)  (avg2_##w (ROW_##w (ref), ROW_##w (ref + 1)))
+#define predict_y(w)  (avg2_##w (ROW_##w (ref), ROW_##w (ref + stride)))
+#define predict_xy(w) (avg4_##w (ROW_##w (ref), ROW_##w (ref + 1),         \
+                                 ROW_##w (ref + stride),                    \
+                                 ROW_##w (ref + stride + 1)))
+
+#define put(w, predictor) ROW_##w (dest) = predictor (w)
+#define avg(w, predictor) ROW_##w (dest) = avg2_##w (predictor (w),         \
+                                                     ROW_##w (dest))
+
+#define MC_FUNC_W(op, xy, w)                                                \
+    void MC_##op##_##xy##_##w (uint8_t * dest, const uint8_t * ref,         \
+                               const int stride, int height)                \
+    {                                                                       \
+        do {                                                                \
+            op (w, predict_##xy);                                           \
+            ref += stride;                                                  \
+            dest += stride;                                                 \
+        } while (--height);                                                 \
+    }
+
+#define MC_FUNC(op, xy) \
+    MC_FUNC_W(op, xy, 16) \
+    MC_FUNC_W(op, xy, 8)
+
+/* definitions of the actual mc functions */
+
+MC_FUNC (put, o)
+MC_FUNC (avg, o)
+MC_FUNC (put, x)
+MC_FUNC (avg, x)
+MC_FUNC (put, y)
+MC_FUNC (avg, y)
+MC_FUNC (put, xy)
+MC_FUNC (avg, xy)
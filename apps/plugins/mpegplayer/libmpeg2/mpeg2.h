@@ -190,6 +190,17 @@ void mpeg2_init_fbuf (mpeg2_decoder_t * decoder,
                       uint8_t * backward_fbuf[MPEG2_COMPONENTS]);
 void mpeg2_slice (mpeg2_decoder_t * decoder, int code, const uint8_t * buffer);
 
+#if MPEG2_SLICE_THREAD
+/* slice_thread.c */
+int mpeg2_slice_thread_init (void);
+void mpeg2_slice_thread_exit (void);
+/* Runs fn(buf) on the slice thread while the next picture is decoded -
+ * waits when the picture goes into buf */
+void mpeg2_slice_thread_call (void (* fn) (uint8_t * const *),
+                              uint8_t * const * buf);
+void mpeg2_slice_thread_call_wait (void);
+#endif
+
 int mpeg2_guess_aspect (const mpeg2_sequence_t * sequence,
                         unsigned int * pixel_width,
                         unsigned int * pixel_height);
@@ -247,6 +247,13 @@ mpeg2_state_t mpeg2_header_slice_start (mpeg2dec_t * mpeg2dec);
 mpeg2_state_t mpeg2_header_end (mpeg2dec_t * mpeg2dec);
 void mpeg2_set_fbuf (mpeg2dec_t * mpeg2dec, int b_type);
 
+#if MPEG2_SLICE_THREAD
+/* slice_thread.c */
+int mpeg2_slice_queue (mpeg2dec_t * mpeg2dec, int code,
+                       const uint8_t * buffer);
+void mpeg2_slice_finish (mpeg2dec_t * mpeg2dec);
+#endif
+
 /* idct.c */
 void mpeg2_idct_init (void);
 void mpeg2_idct_copy(int16_t * block, uint8_t * dest,
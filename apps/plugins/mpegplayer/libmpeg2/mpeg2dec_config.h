@@ -12,4 +12,12 @@
 #define MPEG2_COMPONENTS 1
 #endif
 
+/* Decode the slices of a picture on both cores and draw on the one not
+ * running the video thread */
+#if NUM_CORES > 1
+#define MPEG2_SLICE_THREAD 1
+#else
+#define MPEG2_SLICE_THREAD 0
+#endif
+
 #endif /* MPEG2DEC_CONFIG_H */
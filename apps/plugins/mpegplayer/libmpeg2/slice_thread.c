@@ -0,0 +1,394 @@
+/*
+ * slice_thread.c
+ *
+ * This file is part of mpeg2dec, a free MPEG-2 video stream decoder.
+ * See http://libmpeg2.sourceforge.net/ for updates.
+ *
+ * mpeg2dec is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * mpeg2dec is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * $Id$
+ *
+ * Slices of a picture decoded on the core not running the video thread.
+ *
+ * MPEG-2 slices start from fresh predictors and only read the reference
+ * pictures, so the rows of macroblocks of a picture can be decoded in any
+ * order. The video thread queues the slices of a row as it finds them and
+ * hands finished rows to the slice thread, which decodes with its own copy
+ * of the decoder state. Whenever more than one row is waiting the video
+ * thread decodes the oldest itself, so both cores keep busy however fast
+ * the data arrives. Everything is decoded before the next header is parsed.
+ *
+ * Whole rows are handed out because a slice may end anywhere in a row, and
+ * with caches that are not coherent two cores must never write to the same
+ * cache line of a frame.
+ *
+ * When no slices are waiting, the slice thread also draws the last picture
+ * while the video thread goes on with the next.
+ */
+
+#include "plugin.h"
+
+#include "mpeg2dec_config.h"
+
+#include "mpeg2.h"
+#include "attributes.h"
+#include "mpeg2_internal.h"
+
+#if MPEG2_SLICE_THREAD
+
+#define SLICE_STACKSIZE (4*1024)
+#define SLICES_MAX      256            /* queued before a sync */
+#define SLICE_ROWS_MAX  128            /* queued before a sync */
+#define SLICE_DATA_MAX  (256*1024)     /* queued in the chunk buffer */
+
+enum
+{
+    SLICE_RUN = 1,
+    SLICE_QUIT,
+};
+
+struct slice_row
+{
+    short first;                /* index of the first slice */
+    short count;
+};
+
+static struct
+{
+    struct mutex mtx;
+    struct event_queue q;
+    unsigned int thread;
+    bool idle;                  /* slice thread waits for the queue */
+    bool new_picture;           /* the next slice starts a picture */
+    bool parallel;              /* the rows of this picture are shared */
+    /* slices of the current picture */
+    int nslices;
+    int row_start;              /* first slice of the row being queued */
+    int code[SLICES_MAX];
+    const uint8_t * data[SLICES_MAX];
+    /* rows of the current picture ready to decode */
+    int nrows;
+    int taken;                  /* by either thread */
+    int busy;                   /* taken by the slice thread, not done */
+    struct slice_row rows[SLICE_ROWS_MAX];
+    /* function to run on the slice thread - NULL when done */
+    void (* call) (uint8_t * const *);
+    uint8_t * const * call_buf;
+} slices SHAREDBSS_ATTR;
+
+/* The decoder state of the slice thread */
+static uint8_t slice_decoder_buf[CACHEALIGN_UP(sizeof (mpeg2_decoder_t))]
+    CACHEALIGN_ATTR;
+#define slice_decoder ((mpeg2_decoder_t *)slice_decoder_buf)
+
+#if defined(CPU_COLDFIRE) || (defined(CPU_ARM) && ARM_ARCH >= 6)
+/* as static_dct_block in decode.c */
+static int16_t slice_dct_block[128] IBSS_ATTR ATTR_ALIGN(16);
+#else
+static int16_t slice_dct_block[64] IBSS_ATTR ATTR_ALIGN(16);
+#endif
+
+static uint32_t slice_stack[SLICE_STACKSIZE / sizeof(uint32_t)];
+
+static void decode_row (mpeg2_decoder_t * decoder, int row)
+{
+    const struct slice_row * r = &slices.rows[row];
+    int i;
+
+    for (i = r->first; i < r->first + r->count; i++)
+        mpeg2_slice (decoder, slices.code[i], slices.data[i]);
+}
+
+/* Call with the mutex held */
+static void wake_slice_thread (void)
+{
+    if (slices.idle)
+    {
+        slices.idle = false;
+        rb->queue_post (&slices.q, SLICE_RUN, 0);
+    }
+}
+
+static void slice_thread (void)
+{
+    struct queue_event ev;
+
+    while (1)
+    {
+        rb->queue_wait (&slices.q, &ev);
+
+        if (ev.id == SLICE_QUIT)
+            break;
+
+        while (1)
+        {
+            void (* call) (uint8_t * const *);
+            int row = -1;
+
+            rb->mutex_lock (&slices.mtx);
+
+            call = slices.call;
+            if (call == NULL)
+            {
+                if (slices.taken < slices.nrows)
+                {
+                    row = slices.taken++;
+                    slices.busy++;
+                }
+                else
+                {
+                    slices.idle = true;
+                }
+            }
+
+            rb->mutex_unlock (&slices.mtx);
+
+            if (call == NULL && row < 0)
+                break;
+
+            /* Whatever the other core wrote is in memory by now */
+            IF_COP(rb->commit_discard_dcache());
+
+            if (call != NULL)
+                call (slices.call_buf);
+            else
+                decode_row (slice_decoder, row);
+
+            IF_COP(rb->commit_dcache());
+
+            rb->mutex_lock (&slices.mtx);
+
+            if (call != NULL)
+                slices.call = NULL;
+            else
+                slices.busy--;
+
+            rb->mutex_unlock (&slices.mtx);
+
+            /* Scheduling is cooperative */
+            rb->yield ();
+        }
+    }
+}
+
+/* Rows may only go to different cores if no two of them share a cache
+ * line */
+static bool rows_apart (mpeg2dec_t * mpeg2dec)
+{
+    uint8_t * const * buf = mpeg2dec->fbuf[0]->buf;
+    int i;
+
+    if ((mpeg2dec->decoder.stride_frame >> 1) % CACHEALIGN_SIZE)
+        return false;
+
+    for (i = 0; i < MPEG2_COMPONENTS; i++)
+    {
+        if ((uintptr_t)buf[i] % CACHEALIGN_SIZE)
+            return false;
+    }
+
+    return true;
+}
+
+/* Hands the slices queued since the last row to the slice thread */
+static void post_row (void)
+{
+    struct slice_row * r;
+
+    if (slices.row_start == slices.nslices)
+        return;
+
+    /* The slice data and the decoder state must be in memory */
+    IF_COP(rb->commit_dcache());
+
+    rb->mutex_lock (&slices.mtx);
+
+    r = &slices.rows[slices.nrows++];
+    r->first = slices.row_start;
+    r->count = slices.nslices - slices.row_start;
+    wake_slice_thread ();
+
+    rb->mutex_unlock (&slices.mtx);
+
+    slices.row_start = slices.nslices;
+}
+
+/* Decodes waiting rows until no more than 'keep' are left for the slice
+ * thread */
+static void take_rows (mpeg2_decoder_t * decoder, int keep)
+{
+    while (1)
+    {
+        int row = -1;
+
+        rb->mutex_lock (&slices.mtx);
+
+        if (slices.nrows - slices.taken > keep)
+            row = slices.taken++;
+
+        rb->mutex_unlock (&slices.mtx);
+
+        if (row < 0)
+            break;
+
+        decode_row (decoder, row);
+    }
+}
+
+/* Decodes everything queued and empties the queue */
+static void sync_rows (mpeg2dec_t * mpeg2dec)
+{
+    post_row ();
+    take_rows (&mpeg2dec->decoder, 0);
+
+    while (slices.busy > 0)
+        rb->yield ();
+
+    slices.nslices = 0;
+    slices.row_start = 0;
+    slices.nrows = 0;
+    slices.taken = 0;
+}
+
+/* Decodes or queues a slice. Returns nonzero if it was queued, then its
+ * data has to stay where it is until mpeg2_slice_finish(). Returns zero if
+ * nothing is queued anymore. */
+int mpeg2_slice_queue (mpeg2dec_t * mpeg2dec, int code,
+                       const uint8_t * buffer)
+{
+    if (slices.new_picture)
+    {
+        slices.new_picture = false;
+
+        /* Don't decode into the picture being drawn */
+        if (slices.call != NULL &&
+            slices.call_buf[0] == mpeg2dec->fbuf[0]->buf[0])
+            mpeg2_slice_thread_call_wait ();
+
+        /* MPEG-1 slices may go on into the next row */
+        slices.parallel = slices.thread != 0 &&
+                          !mpeg2dec->decoder.mpeg1 &&
+                          mpeg2dec->decoder.convert == NULL &&
+                          rows_apart (mpeg2dec);
+
+        if (slices.parallel)
+        {
+            rb->memcpy (slice_decoder, &mpeg2dec->decoder,
+                        sizeof (mpeg2_decoder_t));
+            slice_decoder->DCTblock = slice_dct_block;
+        }
+    }
+
+    if (!slices.parallel)
+    {
+        mpeg2_slice (&mpeg2dec->decoder, code, buffer);
+        return 0;
+    }
+
+    if (slices.nslices > slices.row_start &&
+        code != slices.code[slices.nslices - 1])
+    {
+        /* A new row - the last one is complete */
+        post_row ();
+        take_rows (&mpeg2dec->decoder, 1);
+    }
+
+    slices.code[slices.nslices] = code;
+    slices.data[slices.nslices] = buffer;
+    slices.nslices++;
+
+    if (slices.nslices < SLICES_MAX &&
+        slices.nrows < SLICE_ROWS_MAX - 1 &&
+        buffer - mpeg2dec->chunk_buffer < SLICE_DATA_MAX)
+        return 1;
+
+    /* Out of room - decode what there is and start over */
+    sync_rows (mpeg2dec);
+    return 0;
+}
+
+/* Finishes the picture - called before anything else happens to the
+ * decoder */
+void mpeg2_slice_finish (mpeg2dec_t * mpeg2dec)
+{
+    if (slices.parallel)
+    {
+        sync_rows (mpeg2dec);
+        /* See the rows the slice thread decoded */
+        IF_COP(rb->commit_discard_dcache());
+        slices.parallel = false;
+    }
+
+    slices.new_picture = true;
+}
+
+void mpeg2_slice_thread_call (void (* fn) (uint8_t * const *),
+                              uint8_t * const * buf)
+{
+    mpeg2_slice_thread_call_wait ();
+
+    if (slices.thread == 0)
+    {
+        fn (buf);
+        return;
+    }
+
+    IF_COP(rb->commit_dcache());
+
+    rb->mutex_lock (&slices.mtx);
+
+    slices.call_buf = buf;
+    slices.call = fn;
+    wake_slice_thread ();
+
+    rb->mutex_unlock (&slices.mtx);
+}
+
+void mpeg2_slice_thread_call_wait (void)
+{
+    while (slices.call != NULL)
+        rb->yield ();
+}
+
+int mpeg2_slice_thread_init (void)
+{
+    rb->memset (&slices, 0, sizeof (slices));
+    rb->memset (slice_dct_block, 0, sizeof (slice_dct_block));
+
+    rb->mutex_init (&slices.mtx);
+    rb->queue_init (&slices.q, false);
+    slices.idle = true;
+    slices.new_picture = true;
+
+    slices.thread = rb->create_thread (slice_thread, slice_stack,
+                                       sizeof (slice_stack), 0, "mpgslice"
+                                       IF_PRIO(, PRIORITY_PLAYBACK)
+                                       IF_COP(, CPU));
+
+    return slices.thread != 0;
+}
+
+void mpeg2_slice_thread_exit (void)
+{
+    if (slices.thread != 0)
+    {
+        rb->queue_post (&slices.q, SLICE_QUIT, 0);
+        rb->thread_wait (slices.thread);
+        rb->queue_delete (&slices.q);
+        slices.thread = 0;
+    }
+}
+
+#endif /* MPEG2_SLICE_THREAD */
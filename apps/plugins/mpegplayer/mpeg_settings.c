@@ -924,6 +924,39 @@ static int get_start_time(uint32_t duration)
     return button;
 }
 
+/* Decode and draw the whole file as fast as possible, without audio */
+static void decode_benchmark(void)
+{
+    struct video_benchmark_data vbd;
+    bool ok;
+    long fps;
+
+    rb->lcd_clear_display();
+    rb->lcd_update();
+    rb->button_clear_queue();
+
+    trigger_cpu_boost();
+    ok = stream_video_benchmark(&vbd);
+    cancel_cpu_boost();
+
+    rb->button_clear_queue();
+
+    if (!ok)
+    {
+        rb->splash(HZ*2, "Unavailable");
+        return;
+    }
+
+    /* In 100ths of a frame per second */
+    fps = vbd.num_decoded * (HZ*100LL) / MAX(vbd.ticks, 1);
+
+    rb->splashf(0, "%s%d frames in %ld.%02lds: %ld.%02ld fps",
+                vbd.aborted ? "Stopped - " : "", vbd.num_decoded,
+                vbd.ticks / HZ, vbd.ticks % HZ * 100 / HZ,
+                fps / 100, fps % 100);
+    rb->button_get(true);
+}
+
 static int show_start_menu(uint32_t duration)
 {
     int selected = 0;
@@ -937,7 +970,7 @@ static int show_start_menu(uint32_t duration)
 
     MENUITEM_STRINGLIST(menu, "Mpegplayer Menu", mpeg_sysevent_callback,
                         "Play from beginning", resume_str, "Set start time",
-                        "Settings", "Quit mpegplayer");
+                        "Decode benchmark", "Settings", "Quit mpegplayer");
 
     ts_to_hms(settings.resume_time, &hms);
     hms_format(hms_str, sizeof(hms_str), &hms);
@@ -975,6 +1008,10 @@ static int show_start_menu(uint32_t duration)
                 menu_quit = true;
             break;
 
+        case MPEG_START_BENCHMARK:
+            decode_benchmark();
+            break;
+
         case MPEG_START_SETTINGS:
             mpeg_settings();
             break;
@@ -52,6 +52,7 @@ enum mpeg_start_id
     MPEG_START_RESTART,
     MPEG_START_RESUME,
     MPEG_START_SEEK,
+    MPEG_START_BENCHMARK,
     MPEG_START_SETTINGS,
     MPEG_START_QUIT,
     MPEG_START_EXIT,
@@ -543,9 +543,10 @@ struct fps
     int pf_width;
     int pf_height;
     long update_tick;       /* When to next update FPS reading */
-    #define FPS_FORMAT  "%d.%02d"
-    #define FPS_DIMSTR  "999.99" /* For establishing rect size */
-    #define FPS_BUFSIZE sizeof("999.99")
+    /* drawn/decoded */
+    #define FPS_FORMAT  "%d.%02d/%d.%02d"
+    #define FPS_DIMSTR  "999.99/999.99" /* For establishing rect size */
+    #define FPS_BUFSIZE sizeof("999.99/999.99")
 };
 
 static struct osd osd;
@@ -1048,7 +1049,8 @@ static void fps_refresh(void)
     stream_video_stats(&stats);
 
     rb->snprintf(str, FPS_BUFSIZE, FPS_FORMAT,
-                 stats.fps / 100, stats.fps % 100);
+                 stats.fps / 100, stats.fps % 100,
+                 stats.decode_fps / 100, stats.decode_fps % 100);
 
     w = fps.rect.r - fps.rect.l;
     h = fps.rect.b - fps.rect.t;
@@ -751,6 +751,32 @@ bool stream_vo_get_size(struct vo_ext *sz)
     return retval;
 }
 
+bool stream_video_benchmark(struct video_benchmark_data *vbd)
+{
+    bool retval = false;
+
+    stream_mgr_lock();
+
+    if (disk_buf_status() == STREAM_STOPPED)
+    {
+        struct video_benchmark_data *p = &stream_mgr.parms.vbd;
+
+        p->sk.pos = 0;
+        p->sk.len = disk_buf.filesize;
+        p->sk.dir = SSCAN_FORWARD;
+
+        /* Video thread has to be in its initial state */
+        str_send_msg(&video_str, STREAM_RESET, 0);
+        retval = send_video_msg(VIDEO_BENCHMARK, (intptr_t)p);
+
+        *vbd = *p;
+    }
+
+    stream_mgr_unlock();
+
+    return retval;
+}
+
 void stream_vo_set_clip(const struct vo_rect *rc)
 {
     stream_mgr_lock();
@@ -43,6 +43,7 @@ struct stream_mgr
     {
         struct vo_rect rc;
         struct stream_seek_data skd;
+        struct video_benchmark_data vbd;
     } parms;
 };
 
@@ -122,6 +123,9 @@ bool stream_draw_frame(bool no_prepare);
 /* Return video dimensions */
 bool stream_vo_get_size(struct vo_ext *sz);
 
+/* Decode the whole video as fast as possible, drawing every picture */
+bool stream_video_benchmark(struct video_benchmark_data *vbd);
+
 /* Returns the resume time in timestamp ticks */
 uint32_t stream_get_resume_time(void);
 
@@ -109,6 +109,7 @@ enum stream_message
     VIDEO_SET_CLIP_RECT,      /* Set the visible video area */
     VIDEO_GET_CLIP_RECT,      /* Return the visible video area */
     VIDEO_SET_POST_FRAME_CALLBACK, /* Set a callback after frame is drawn */
+    VIDEO_BENCHMARK,          /* Decode and draw as fast as possible */
     STREAM_MESSAGE_LAST,
 };
 
@@ -126,6 +127,15 @@ struct str_sync_data
     struct stream_scan sk; /* Specification of start/limits/direction */
 };
 
+/* Data parameter for VIDEO_BENCHMARK */
+struct video_benchmark_data
+{
+    struct stream_scan sk; /* Part of the file to decode */
+    int  num_decoded;      /* Pictures decoded and drawn */
+    long ticks;            /* Time it took */
+    bool aborted;          /* Stopped by a button press */
+};
+
 /* Stream status codes - not eqivalent to thread states */
 enum stream_status
 {
@@ -166,7 +176,9 @@ struct video_output_stats
 {
     int    num_drawn;       /* Number of frames drawn since reset */
     int    num_skipped;     /* Number of frames skipped since reset */
+    int    num_decoded;     /* Number of pictures decoded since reset */
     int    fps;             /* fps rate in 100ths of a frame per second */
+    int    decode_fps;      /* Same for the pictures decoded */
 };
 
 void video_thread_get_stats(struct video_output_stats *s);
@@ -25,6 +25,17 @@
 
 #define VO_NON_NULL_RECT 0x1
 #define VO_VISIBLE       0x2
+#define VO_SCALE         0x4
+
+/* Where the frame buffer is plain memory, videos larger than the screen are
+ * converted and scaled to fit it in one pass, instead of being cropped by
+ * lcd_blit_yuv. The scaler is plain C, so lcd_blit_yuv stays in use for
+ * everything that fits. */
+#if (CONFIG_PLATFORM & PLATFORM_HOSTED) && defined(HAVE_LCD_COLOR) && \
+    (LCD_DEPTH == 16 || LCD_DEPTH >= 24) && LCD_WIDTH >= LCD_HEIGHT && \
+    !(defined(LCD_STRIDEFORMAT) && LCD_STRIDEFORMAT == VERTICAL_STRIDE)
+#define VO_HAVE_SCALER
+#endif
 
 struct vo_data
 {
@@ -136,6 +147,62 @@ static inline void yuv_blit(uint8_t * const * buf, int src_x, int src_y,
     video_unlock();
 }
 
+#ifdef VO_HAVE_SCALER
+/* As lcd_blit_yuv for the output rectangle, scaling rc_vid to the display
+ * size - 16.16 fixed point, nearest pixel */
+static void yuv_scale_blit(uint8_t * const * buf)
+{
+    int vid_w = vo.rc_vid.r - vo.rc_vid.l;
+    int vid_h = vo.rc_vid.b - vo.rc_vid.t;
+    unsigned xstep = (vo.display_width << 16) / vid_w;
+    unsigned ystep = (vo.display_height << 16) / vid_h;
+    unsigned sx0 = (vo.output_x - vo.rc_vid.l) * xstep + xstep / 2;
+    unsigned sy = (vo.output_y - vo.rc_vid.t) * ystep + ystep / 2;
+    int stride = vo.image_width;
+    fb_data *dst = rb->lcd_framebuffer + vo.output_y*LCD_FBWIDTH +
+                   vo.output_x;
+    int row;
+
+    video_lock();
+
+    for (row = 0; row < vo.output_height; row++, sy += ystep)
+    {
+        const uint8_t *ysrc = buf[0] + (sy >> 16)*stride;
+        const uint8_t *usrc = buf[1] + (sy >> 17)*(stride >> 1);
+        const uint8_t *vsrc = buf[2] + (sy >> 17)*(stride >> 1);
+        unsigned sx = sx0;
+        int col;
+
+        for (col = 0; col < vo.output_width; col++, sx += xstep)
+        {
+            int x = sx >> 16;
+            int y = 74*(ysrc[x] - 16);
+            int cb = usrc[x >> 1] - 128;
+            int cr = vsrc[x >> 1] - 128;
+            int r = y + 101*cr;
+            int g = y - 24*cb - 51*cr;
+            int b = y + 128*cb;
+
+            if ((unsigned)(r | g | b) > 64*256-1)
+            {
+                r = MIN(MAX(r, 0), 64*256-1);
+                g = MIN(MAX(g, 0), 64*256-1);
+                b = MIN(MAX(b, 0), 64*256-1);
+            }
+
+            dst[col] = FB_RGBPACK(r >> 6, g >> 6, b >> 6);
+        }
+
+        dst += LCD_FBWIDTH;
+    }
+
+    rb->lcd_update_rect(vo.output_x, vo.output_y, vo.output_width,
+                        vo.output_height);
+
+    video_unlock();
+}
+#endif /* VO_HAVE_SCALER */
+
 void vo_draw_frame(uint8_t * const * buf)
 {
     if ((vo.flags & (VO_NON_NULL_RECT | VO_VISIBLE)) !=
@@ -151,6 +218,12 @@ void vo_draw_frame(uint8_t * const * buf)
         vo_draw_black(NULL);
         DEBUGF("vo no frame\n");
     }
+#ifdef VO_HAVE_SCALER
+    else if (vo.flags & VO_SCALE)
+    {
+        yuv_scale_blit(buf);
+    }
+#endif
     else
     {
         yuv_blit(buf, 0, 0, vo.image_width,
@@ -454,6 +527,36 @@ void vo_setup(const mpeg2_sequence_t * sequence)
     vo.image_chroma_x = vo.image_width / sequence->chroma_width;
     vo.image_chroma_y = vo.image_height / sequence->chroma_height;
 
+#ifdef VO_HAVE_SCALER
+    vo.flags &= ~VO_SCALE;
+
+    if (rb->lcd_framebuffer != NULL &&
+        (sequence->display_width > SCREEN_WIDTH ||
+         sequence->display_height > SCREEN_HEIGHT))
+    {
+        /* Shrink to fit, keeping the aspect ratio */
+        int w = SCREEN_WIDTH;
+        int h = sequence->display_height * SCREEN_WIDTH /
+                sequence->display_width;
+
+        if (h > SCREEN_HEIGHT)
+        {
+            h = SCREEN_HEIGHT;
+            w = sequence->display_width * SCREEN_HEIGHT /
+                sequence->display_height;
+        }
+
+        vo.rc_vid.l = ((SCREEN_WIDTH - w) / 2) & ~1;
+        vo.rc_vid.t = ((SCREEN_HEIGHT - h) / 2) & ~1;
+        vo.rc_vid.r = vo.rc_vid.l + w;
+        vo.rc_vid.b = vo.rc_vid.t + h;
+
+        vo.flags |= VO_SCALE;
+        vo_set_clip_rect(&vo.rc_clip);
+        return;
+    }
+#endif /* VO_HAVE_SCALER */
+
     if (sequence->display_width >= SCREEN_WIDTH)
     {
         vo.rc_vid.l = 0;
@@ -59,6 +59,8 @@ struct video_thread_data
 static int video_num_drawn SHAREDBSS_ATTR;
 /* Number skipped since reset */
 static int video_num_skipped SHAREDBSS_ATTR;
+/* Number of pictures decoded since reset */
+static int video_num_decoded SHAREDBSS_ATTR;
 
 /* TODO: Check if 4KB is appropriate - it works for my test streams,
    so maybe we can reduce it. */
@@ -197,6 +199,90 @@ scan_finished:
     return retval;
 }
 
+/* Decodes and draws every picture in the range as fast as it goes */
+static bool video_str_benchmark(struct video_thread_data *td,
+                                struct video_benchmark_data *vbd)
+{
+    struct stream tmp_str;
+    bool vis = vo_show(true);
+    long start;
+
+    tmp_str.id = video_str.id;
+    tmp_str.hdr.pos = vbd->sk.pos;
+    tmp_str.hdr.limit = vbd->sk.pos + vbd->sk.len;
+
+    vbd->num_decoded = 0;
+    vbd->aborted = false;
+
+    mpeg2_reset(td->mpeg2dec, false);
+
+    start = *rb->current_tick;
+
+    while (!vbd->aborted)
+    {
+        mpeg2_state_t mp2state = mpeg2_parse(td->mpeg2dec);
+        rb->yield();
+
+        switch (mp2state)
+        {
+        case STATE_BUFFER:
+            switch (parser_get_next_data(&tmp_str, STREAM_PM_RANDOM_ACCESS))
+            {
+            case STREAM_DATA_END:
+                goto benchmark_finished;
+
+            case STREAM_OK:
+                mpeg2_buffer(td->mpeg2dec, tmp_str.curr_packet,
+                             tmp_str.curr_packet_end);
+                td->info = mpeg2_info(td->mpeg2dec);
+                break;
+            }
+            break;
+
+        case STATE_SEQUENCE:
+            vo_setup(td->info->sequence);
+            break;
+
+        case STATE_SLICE:
+        case STATE_END:
+        case STATE_INVALID_END:
+        {
+            long button;
+
+            if (td->info->display_fbuf == NULL)
+                break;
+
+#if MPEG2_SLICE_THREAD
+            mpeg2_slice_thread_call(vo_draw_frame,
+                                    td->info->display_fbuf->buf);
+#else
+            vo_draw_frame(td->info->display_fbuf->buf);
+#endif
+            vbd->num_decoded++;
+
+            /* The caller waits for the reply - any press stops it */
+            button = rb->button_get(false);
+            if (button != BUTTON_NONE &&
+                !(button & (BUTTON_REL | BUTTON_REPEAT | SYS_EVENT)))
+                vbd->aborted = true;
+            break;
+            }
+
+        default:
+            break;
+        }
+    }
+
+benchmark_finished:
+#if MPEG2_SLICE_THREAD
+    mpeg2_slice_thread_call_wait();
+#endif
+    vbd->ticks = *rb->current_tick - start;
+    vo_show(vis);
+
+    return vbd->num_decoded > 0;
+}
+
 static bool init_sequence(struct video_thread_data *td)
 {
     struct str_sync_data sd;
@@ -474,6 +560,11 @@ static bool frame_print_handler(struct video_thread_data *td)
 /* This only returns to play or quit */
 static void video_thread_msg(struct video_thread_data *td)
 {
+#if MPEG2_SLICE_THREAD
+    /* Anything done here may draw or change the picture being drawn */
+    mpeg2_slice_thread_call_wait();
+#endif
+
     while (1)
     {
         intptr_t reply = 0;
@@ -577,6 +668,7 @@ static void video_thread_msg(struct video_thread_data *td)
             td->last_render = *rb->current_tick - HZ;
             video_num_drawn = 0;
             video_num_skipped = 0;
+            video_num_decoded = 0;
 
             reply = true;
             break;
@@ -641,6 +733,14 @@ static void video_thread_msg(struct video_thread_data *td)
             reply = true;
             break;
 
+        case VIDEO_BENCHMARK:
+            if (td->state != TSTATE_INIT)
+                break; /* Can only use after a reset was issued */
+
+            reply = video_str_benchmark(td,
+                        (struct video_benchmark_data *)td->ev.data);
+            break;
+
         case STREAM_QUIT:
             /* Time to go - make thread exit */
             td->state = TSTATE_EOS;
@@ -752,6 +852,9 @@ static void video_thread(void)
 
         case STATE_SEQUENCE:
             /* New video sequence, inform output of any changes */
+#if MPEG2_SLICE_THREAD
+            mpeg2_slice_thread_call_wait();
+#endif
             vo_setup(td.info->sequence);
             break;
 
@@ -823,6 +926,9 @@ static void video_thread(void)
 
             td.group_est--;
 
+            if (skip == 0)
+                video_num_decoded++;
+
             mpeg2_skip(td.mpeg2dec, skip);
             break;  
             }
@@ -974,7 +1080,13 @@ static void video_thread(void)
             /* Record last frame time */
             td.last_render = *rb->current_tick;
 
+#if MPEG2_SLICE_THREAD
+            /* Drawn on the other core while the next picture is decoded */
+            mpeg2_slice_thread_call(vo_draw_frame,
+                                    td.info->display_fbuf->buf);
+#else
             vo_draw_frame(td.info->display_fbuf->buf);
+#endif
             video_num_drawn++;
             break;
 
@@ -1012,6 +1124,11 @@ bool video_thread_init(void)
     video_str.hdr.q = &video_str_queue;
     rb->queue_init(video_str.hdr.q, false);
 
+#if MPEG2_SLICE_THREAD
+    /* Works without it, just slower */
+    mpeg2_slice_thread_init();
+#endif
+
     /* We put the video thread on another processor for multi-core targets. */
     video_str.thread = rb->create_thread(
         video_thread, video_stack, VIDEO_STACKSIZE, 0,
@@ -1040,6 +1157,10 @@ void video_thread_exit(void)
         IF_COP(rb->commit_discard_dcache());
         video_str.thread = 0;
     }
+
+#if MPEG2_SLICE_THREAD
+    mpeg2_slice_thread_exit();
+#endif
 }
 
 
@@ -1050,10 +1171,16 @@ void video_thread_get_stats(struct video_output_stats *s)
     uint32_t now = stream_get_ticks(&start);
     s->num_drawn = video_num_drawn;
     s->num_skipped = video_num_skipped;
+    s->num_decoded = video_num_decoded;
 
     s->fps = 0;
+    s->decode_fps = 0;
 
     if (now > start)
+    {
         s->fps = muldiv_uint32(CLOCK_RATE*100, s->num_drawn, now - start);
+        s->decode_fps = muldiv_uint32(CLOCK_RATE*100, s->num_decoded,
+                                      now - start);
+    }
 }
 
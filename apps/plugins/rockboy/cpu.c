@@ -186,16 +186,42 @@ case 0xF0|(n): SET(6, r); break; \
 case 0xF8|(n): SET(7, r); break;
 
 
+/* With gcc the opcodes are dispatched through a table of the addresses of
+ * their labels, which saves the range check and the jump through the
+ * switch table. The labels are op_0x00 to op_0xFF, the alu opcodes use the
+ * labels of ALU_CASES. */
+#if defined(__GNUC__) && !defined(DYNAREC)
+#define THREADED_DISPATCH
+#endif
+
+#ifdef THREADED_DISPATCH
+#define OP(n) case n: op_##n
+#define LABEL(l) l:
+
+#define OPS16(h) \
+&&op_0x##h##0, &&op_0x##h##1, &&op_0x##h##2, &&op_0x##h##3, \
+&&op_0x##h##4, &&op_0x##h##5, &&op_0x##h##6, &&op_0x##h##7, \
+&&op_0x##h##8, &&op_0x##h##9, &&op_0x##h##A, &&op_0x##h##B, \
+&&op_0x##h##C, &&op_0x##h##D, &&op_0x##h##E, &&op_0x##h##F
+
+#define ALU8(label) \
+&&label##_B, &&label##_C, &&label##_D, &&label##_E, \
+&&label##_H, &&label##_L, &&label##_M, &&label##_A
+#else
+#define OP(n) case n
+#define LABEL(l)
+#endif
+
 #define ALU_CASES(base, imm, op, label) \
-case (imm): b = FETCH; goto label; \
-case (base): b = B; goto label; \
-case (base)+1: b = C; goto label; \
-case (base)+2: b = D; goto label; \
-case (base)+3: b = E; goto label; \
-case (base)+4: b = H; goto label; \
-case (base)+5: b = L; goto label; \
-case (base)+6: b = readb(HL); goto label; \
-case (base)+7: b = A; \
+OP(imm): b = FETCH; goto label; \
+case (base): LABEL(label##_B) b = B; goto label; \
+case (base)+1: LABEL(label##_C) b = C; goto label; \
+case (base)+2: LABEL(label##_D) b = D; goto label; \
+case (base)+3: LABEL(label##_E) b = E; goto label; \
+case (base)+4: LABEL(label##_H) b = H; goto label; \
+case (base)+5: LABEL(label##_L) b = L; goto label; \
+case (base)+6: LABEL(label##_M) b = readb(HL); goto label; \
+case (base)+7: LABEL(label##_A) b = A; \
 label: op(b); break;
 
 
@@ -205,6 +231,7 @@ label: op(b); break;
 
 
 
+
 #define JR ( PC += 1+(n8)readb(PC) )
 #define JP ( PC = readw(PC) )
 
@@ -378,6 +405,16 @@ int cpu_emulate(int cycles)
     static union reg acc IBSS_ATTR;
     static byte b IBSS_ATTR;
     static word w IBSS_ATTR;
+#ifdef THREADED_DISPATCH
+    static const void *const op_table[256] ICONST_ATTR =
+    {
+        OPS16(0), OPS16(1), OPS16(2), OPS16(3),
+        OPS16(4), OPS16(5), OPS16(6), OPS16(7),
+        ALU8(__ADD), ALU8(__ADC), ALU8(__SUB), ALU8(__SBC),
+        ALU8(__AND), ALU8(__XOR), ALU8(__OR), ALU8(__CP),
+        OPS16(C), OPS16(D), OPS16(E), OPS16(F)
+    };
+#endif
 
     i = cycles;
 next:
@@ -385,7 +422,7 @@ next:
     if(shut)
         return cycles-i;
 #endif
-    if ((clen = cpu_idle(i)))
+    if (cpu.halt && (clen = cpu_idle(i)))
     {
         i -= clen;
         if (i > 0) goto next;
@@ -422,142 +459,145 @@ next:
     op = FETCH;
     clen = cycles_table[op];
 
+#ifdef THREADED_DISPATCH
+    goto *op_table[op];
+#endif
     switch(op)
     {
-    case 0x00: /* NOP */
-    case 0x40: /* LD B,B */
-    case 0x49: /* LD C,C */
-    case 0x52: /* LD D,D */
-    case 0x5B: /* LD E,E */
-    case 0x64: /* LD H,H */
-    case 0x6D: /* LD L,L */
-    case 0x7F: /* LD A,A */
+    OP(0x00): /* NOP */
+    OP(0x40): /* LD B,B */
+    OP(0x49): /* LD C,C */
+    OP(0x52): /* LD D,D */
+    OP(0x5B): /* LD E,E */
+    OP(0x64): /* LD H,H */
+    OP(0x6D): /* LD L,L */
+    OP(0x7F): /* LD A,A */
         break;
             
-    case 0x41: /* LD B,C */
+    OP(0x41): /* LD B,C */
         B = C; break;
-    case 0x42: /* LD B,D */
+    OP(0x42): /* LD B,D */
         B = D; break;
-    case 0x43: /* LD B,E */
+    OP(0x43): /* LD B,E */
         B = E; break;
-    case 0x44: /* LD B,H */
+    OP(0x44): /* LD B,H */
         B = H; break;
-    case 0x45: /* LD B,L */
+    OP(0x45): /* LD B,L */
         B = L; break;
-    case 0x46: /* LD B,(HL) */
+    OP(0x46): /* LD B,(HL) */
         B = readb(xHL); break;
-    case 0x47: /* LD B,A */
+    OP(0x47): /* LD B,A */
         B = A; break;
 
-    case 0x48: /* LD C,B */
+    OP(0x48): /* LD C,B */
         C = B; break;
-    case 0x4A: /* LD C,D */
+    OP(0x4A): /* LD C,D */
         C = D; break;
-    case 0x4B: /* LD C,E */
+    OP(0x4B): /* LD C,E */
         C = E; break;
-    case 0x4C: /* LD C,H */
+    OP(0x4C): /* LD C,H */
         C = H; break;
-    case 0x4D: /* LD C,L */
+    OP(0x4D): /* LD C,L */
         C = L; break;
-    case 0x4E: /* LD C,(HL) */
+    OP(0x4E): /* LD C,(HL) */
         C = readb(xHL); break;
-    case 0x4F: /* LD C,A */
+    OP(0x4F): /* LD C,A */
         C = A; break;
 
-    case 0x50: /* LD D,B */
+    OP(0x50): /* LD D,B */
         D = B; break;
-    case 0x51: /* LD D,C */
+    OP(0x51): /* LD D,C */
         D = C; break;
-    case 0x53: /* LD D,E */
+    OP(0x53): /* LD D,E */
         D = E; break;
-    case 0x54: /* LD D,H */
+    OP(0x54): /* LD D,H */
         D = H; break;
-    case 0x55: /* LD D,L */
+    OP(0x55): /* LD D,L */
         D = L; break;
-    case 0x56: /* LD D,(HL) */
+    OP(0x56): /* LD D,(HL) */
         D = readb(xHL); break;
-    case 0x57: /* LD D,A */
+    OP(0x57): /* LD D,A */
         D = A; break;
 
-    case 0x58: /* LD E,B */
+    OP(0x58): /* LD E,B */
         E = B; break;
-    case 0x59: /* LD E,C */
+    OP(0x59): /* LD E,C */
         E = C; break;
-    case 0x5A: /* LD E,D */
+    OP(0x5A): /* LD E,D */
         E = D; break;
-    case 0x5C: /* LD E,H */
+    OP(0x5C): /* LD E,H */
         E = H; break;
-    case 0x5D: /* LD E,L */
+    OP(0x5D): /* LD E,L */
         E = L; break;
-    case 0x5E: /* LD E,(HL) */
+    OP(0x5E): /* LD E,(HL) */
         E = readb(xHL); break;
-    case 0x5F: /* LD E,A */
+    OP(0x5F): /* LD E,A */
         E = A; break;
 
-    case 0x60: /* LD H,B */
+    OP(0x60): /* LD H,B */
         H = B; break;
-    case 0x61: /* LD H,C */
+    OP(0x61): /* LD H,C */
         H = C; break;
-    case 0x62: /* LD H,D */
+    OP(0x62): /* LD H,D */
         H = D; break;
-    case 0x63: /* LD H,E */
+    OP(0x63): /* LD H,E */
         H = E; break;
-    case 0x65: /* LD H,L */
+    OP(0x65): /* LD H,L */
         H = L; break;
-    case 0x66: /* LD H,(HL) */
+    OP(0x66): /* LD H,(HL) */
         H = readb(xHL); break;
-    case 0x67: /* LD H,A */
+    OP(0x67): /* LD H,A */
         H = A; break;
             
-    case 0x68: /* LD L,B */
+    OP(0x68): /* LD L,B */
         L = B; break;
-    case 0x69: /* LD L,C */
+    OP(0x69): /* LD L,C */
         L = C; break;
-    case 0x6A: /* LD L,D */
+    OP(0x6A): /* LD L,D */
         L = D; break;
-    case 0x6B: /* LD L,E */
+    OP(0x6B): /* LD L,E */
         L = E; break;
-    case 0x6C: /* LD L,H */
+    OP(0x6C): /* LD L,H */
         L = H; break;
-    case 0x6E: /* LD L,(HL) */
+    OP(0x6E): /* LD L,(HL) */
         L = readb(xHL); break;
-    case 0x6F: /* LD L,A */
+    OP(0x6F): /* LD L,A */
         L = A; break;
             
-    case 0x70: /* LD (HL),B */
+    OP(0x70): /* LD (HL),B */
         b = B; goto __LD_HL;
-    case 0x71: /* LD (HL),C */
+    OP(0x71): /* LD (HL),C */
         b = C; goto __LD_HL;
-    case 0x72: /* LD (HL),D */
+    OP(0x72): /* LD (HL),D */
         b = D; goto __LD_HL;
-    case 0x73: /* LD (HL),E */
+    OP(0x73): /* LD (HL),E */
         b = E; goto __LD_HL;
-    case 0x74: /* LD (HL),H */
+    OP(0x74): /* LD (HL),H */
         b = H; goto __LD_HL;
-    case 0x75: /* LD (HL),L */
+    OP(0x75): /* LD (HL),L */
         b = L; goto __LD_HL;
-    case 0x77: /* LD (HL),A */
+    OP(0x77): /* LD (HL),A */
         b = A;
     __LD_HL:
         writeb(xHL,b);
         break;
             
-    case 0x78: /* LD A,B */
+    OP(0x78): /* LD A,B */
         A = B; break;
-    case 0x79: /* LD A,C */
+    OP(0x79): /* LD A,C */
         A = C; break;
-    case 0x7A: /* LD A,D */
+    OP(0x7A): /* LD A,D */
         A = D; break;
-    case 0x7B: /* LD A,E */
+    OP(0x7B): /* LD A,E */
         A = E; break;
-    case 0x7C: /* LD A,H */
+    OP(0x7C): /* LD A,H */
         A = H; break;
-    case 0x7D: /* LD A,L */
+    OP(0x7D): /* LD A,L */
         A = L; break;
-    case 0x7E: /* LD A,(HL) */
+    OP(0x7E): /* LD A,(HL) */
         A = readb(xHL); break;
 
-    case 0x01: /* LD BC,imm */
+    OP(0x01): /* LD BC,imm */
 #ifdef DYNAREC
         W(acc) = readw(xPC);
         B=HB(acc);
@@ -567,7 +607,7 @@ next:
 #endif
         PC += 2;
         break;
-    case 0x11: /* LD DE,imm */
+    OP(0x11): /* LD DE,imm */
 #ifdef DYNAREC
         W(acc) = readw(xPC);
         D=HB(acc);
@@ -577,66 +617,66 @@ next:
 #endif
         PC += 2; 
         break;
-    case 0x21: /* LD HL,imm */
+    OP(0x21): /* LD HL,imm */
         HL = readw(xPC); PC += 2; break;
-    case 0x31: /* LD SP,imm */
+    OP(0x31): /* LD SP,imm */
         SP = readw(xPC); PC += 2; break;
 
-    case 0x02: /* LD (BC),A */
+    OP(0x02): /* LD (BC),A */
         writeb(xBC, A); break;
-    case 0x0A: /* LD A,(BC) */
+    OP(0x0A): /* LD A,(BC) */
         A = readb(xBC); break;
-    case 0x12: /* LD (DE),A */
+    OP(0x12): /* LD (DE),A */
         writeb(xDE, A); break;
-    case 0x1A: /* LD A,(DE) */
+    OP(0x1A): /* LD A,(DE) */
         A = readb(xDE); break;
 
-    case 0x22: /* LDI (HL),A */
+    OP(0x22): /* LDI (HL),A */
         writeb(xHL, A); HL++; break;
-    case 0x2A: /* LDI A,(HL) */
+    OP(0x2A): /* LDI A,(HL) */
         A = readb(xHL); HL++; break;
-    case 0x32: /* LDD (HL),A */
+    OP(0x32): /* LDD (HL),A */
         writeb(xHL, A); HL--; break;
-    case 0x3A: /* LDD A,(HL) */
+    OP(0x3A): /* LDD A,(HL) */
         A = readb(xHL); HL--; break;
 
-    case 0x06: /* LD B,imm */
+    OP(0x06): /* LD B,imm */
         B = FETCH; break;
-    case 0x0E: /* LD C,imm */
+    OP(0x0E): /* LD C,imm */
         C = FETCH; break;
-    case 0x16: /* LD D,imm */
+    OP(0x16): /* LD D,imm */
         D = FETCH; break;
-    case 0x1E: /* LD E,imm */
+    OP(0x1E): /* LD E,imm */
         E = FETCH; break;
-    case 0x26: /* LD H,imm */
+    OP(0x26): /* LD H,imm */
         H = FETCH; break;
-    case 0x2E: /* LD L,imm */
+    OP(0x2E): /* LD L,imm */
         L = FETCH; break;
-    case 0x36: /* LD (HL),imm */
+    OP(0x36): /* LD (HL),imm */
         b = FETCH; writeb(xHL, b); break;
-    case 0x3E: /* LD A,imm */
+    OP(0x3E): /* LD A,imm */
         A = FETCH; break;
 
-    case 0x08: /* LD (imm),SP */
+    OP(0x08): /* LD (imm),SP */
         writew(readw(xPC), SP); PC += 2; break;
-    case 0xEA: /* LD (imm),A */
+    OP(0xEA): /* LD (imm),A */
         writeb(readw(xPC), A); PC += 2; break;
 
-    case 0xE0: /* LDH (imm),A */
+    OP(0xE0): /* LDH (imm),A */
         writehi(FETCH, A); break;
-    case 0xE2: /* LDH (C),A */
+    OP(0xE2): /* LDH (C),A */
         writehi(C, A); break;
-    case 0xF0: /* LDH A,(imm) */
+    OP(0xF0): /* LDH A,(imm) */
         A = readhi(FETCH); break;
-    case 0xF2: /* LDH A,(C) (undocumented) */
+    OP(0xF2): /* LDH A,(C) (undocumented) */
         A = readhi(C); break;
             
 
-    case 0xF8: /* LD HL,SP+imm */
+    OP(0xF8): /* LD HL,SP+imm */
         b = FETCH; LDHLSP(b); break;
-    case 0xF9: /* LD SP,HL */
+    OP(0xF9): /* LD SP,HL */
         SP = HL; break;
-    case 0xFA: /* LD A,(imm) */
+    OP(0xFA): /* LD A,(imm) */
         A = readb(readw(xPC)); PC += 2; break;
 
         ALU_CASES(0x80, 0xC6, ADD, __ADD)
@@ -648,39 +688,39 @@ next:
         ALU_CASES(0xB0, 0xF6, OR, __OR)
         ALU_CASES(0xB8, 0xFE, CP, __CP)
 
-    case 0x09: /* ADD HL,BC */
+    OP(0x09): /* ADD HL,BC */
         w = BC; goto __ADDW;
-    case 0x19: /* ADD HL,DE */
+    OP(0x19): /* ADD HL,DE */
         w = DE; goto __ADDW;
-    case 0x39: /* ADD HL,SP */
+    OP(0x39): /* ADD HL,SP */
         w = SP; goto __ADDW;
-    case 0x29: /* ADD HL,HL */
+    OP(0x29): /* ADD HL,HL */
         w = HL;
     __ADDW:
         ADDW(w);
         break;
 
-    case 0x04: /* INC B */
+    OP(0x04): /* INC B */
         INC(B); break;
-    case 0x0C: /* INC C */
+    OP(0x0C): /* INC C */
         INC(C); break;
-    case 0x14: /* INC D */
+    OP(0x14): /* INC D */
         INC(D); break;
-    case 0x1C: /* INC E */
+    OP(0x1C): /* INC E */
         INC(E); break;
-    case 0x24: /* INC H */
+    OP(0x24): /* INC H */
         INC(H); break;
-    case 0x2C: /* INC L */
+    OP(0x2C): /* INC L */
         INC(L); break;
-    case 0x34: /* INC (HL) */
+    OP(0x34): /* INC (HL) */
         b = readb(xHL);
         INC(b);
         writeb(xHL, b);
         break;
-    case 0x3C: /* INC A */
+    OP(0x3C): /* INC A */
         INC(A); break;
             
-    case 0x03: /* INC BC */
+    OP(0x03): /* INC BC */
 #ifdef DYNAREC
         W(acc)=((B<<8)|C)+1;
         B=HB(acc);
@@ -689,7 +729,7 @@ next:
         INCW(BC); 
 #endif
         break;
-    case 0x13: /* INC DE */
+    OP(0x13): /* INC DE */
 #ifdef DYNAREC
         W(acc)=((D<<8)|E)+1;
         D=HB(acc);
@@ -698,32 +738,32 @@ next:
         INCW(DE); 
 #endif
         break;
-    case 0x23: /* INC HL */
+    OP(0x23): /* INC HL */
         INCW(HL); break;
-    case 0x33: /* INC SP */
+    OP(0x33): /* INC SP */
         INCW(SP); break;
             
-    case 0x05: /* DEC B */
+    OP(0x05): /* DEC B */
         DEC(B); break;
-    case 0x0D: /* DEC C */
+    OP(0x0D): /* DEC C */
         DEC(C); break;
-    case 0x15: /* DEC D */
+    OP(0x15): /* DEC D */
         DEC(D); break;
-    case 0x1D: /* DEC E */
+    OP(0x1D): /* DEC E */
         DEC(E); break;
-    case 0x25: /* DEC H */
+    OP(0x25): /* DEC H */
         DEC(H); break;
-    case 0x2D: /* DEC L */
+    OP(0x2D): /* DEC L */
         DEC(L); break;
-    case 0x35: /* DEC (HL) */
+    OP(0x35): /* DEC (HL) */
         b = readb(xHL);
         DEC(b);
         writeb(xHL, b);
         break;
-    case 0x3D: /* DEC A */
+    OP(0x3D): /* DEC A */
         DEC(A); break;
 
-    case 0x0B: /* DEC BC */
+    OP(0x0B): /* DEC BC */
 #ifdef DYNAREC
         W(acc)=((B<<8)|C)-1;
         B=HB(acc);
@@ -732,7 +772,7 @@ next:
         DECW(BC); 
 #endif
         break;
-    case 0x1B: /* DEC DE */
+    OP(0x1B): /* DEC DE */
 #ifdef DYNAREC
         W(acc)=((D<<8)|E)-1;
         D=HB(acc);
@@ -741,97 +781,97 @@ next:
         DECW(DE); 
 #endif
         break;
-    case 0x2B: /* DEC HL */
+    OP(0x2B): /* DEC HL */
         DECW(HL); break;
-    case 0x3B: /* DEC SP */
+    OP(0x3B): /* DEC SP */
         DECW(SP); break;
 
-    case 0x07: /* RLCA */
+    OP(0x07): /* RLCA */
         RLCA(A); break;
-    case 0x0F: /* RRCA */
+    OP(0x0F): /* RRCA */
         RRCA(A); break;
-    case 0x17: /* RLA */
+    OP(0x17): /* RLA */
         RLA(A); break;
-    case 0x1F: /* RRA */
+    OP(0x1F): /* RRA */
         RRA(A); break;
 
-    case 0x27: /* DAA */
+    OP(0x27): /* DAA */
         DAA; break;
-    case 0x2F: /* CPL */
+    OP(0x2F): /* CPL */
         CPL(A); break;
 
-    case 0x18: /* JR */
+    OP(0x18): /* JR */
     __JR:
         JR; break;
-    case 0x20: /* JR NZ */
+    OP(0x20): /* JR NZ */
         if (!(F&FZ)) goto __JR; NOJR; break;
-    case 0x28: /* JR Z */
+    OP(0x28): /* JR Z */
         if (F&FZ) goto __JR; NOJR; break;
-    case 0x30: /* JR NC */
+    OP(0x30): /* JR NC */
         if (!(F&FC)) goto __JR; NOJR; break;
-    case 0x38: /* JR C */
+    OP(0x38): /* JR C */
         if (F&FC) goto __JR; NOJR; break;
 
-    case 0xC3: /* JP */
+    OP(0xC3): /* JP */
     __JP:
         JP; break;
-    case 0xC2: /* JP NZ */
+    OP(0xC2): /* JP NZ */
         if (!(F&FZ)) goto __JP; NOJP; break;
-    case 0xCA: /* JP Z */
+    OP(0xCA): /* JP Z */
         if (F&FZ) goto __JP; NOJP; break;
-    case 0xD2: /* JP NC */
+    OP(0xD2): /* JP NC */
         if (!(F&FC)) goto __JP; NOJP; break;
-    case 0xDA: /* JP C */
+    OP(0xDA): /* JP C */
         if (F&FC) goto __JP; NOJP; break;
-    case 0xE9: /* JP HL */
+    OP(0xE9): /* JP HL */
         PC = HL; break;
 
-    case 0xC9: /* RET */
+    OP(0xC9): /* RET */
     __RET:
         RET; break;
-    case 0xC0: /* RET NZ */
+    OP(0xC0): /* RET NZ */
         if (!(F&FZ)) goto __RET; NORET; break;
-    case 0xC8: /* RET Z */
+    OP(0xC8): /* RET Z */
         if (F&FZ) goto __RET; NORET; break;
-    case 0xD0: /* RET NC */
+    OP(0xD0): /* RET NC */
         if (!(F&FC)) goto __RET; NORET; break;
-    case 0xD8: /* RET C */
+    OP(0xD8): /* RET C */
         if (F&FC) goto __RET; NORET; break;
-    case 0xD9: /* RETI */
+    OP(0xD9): /* RETI */
         IME = IMA = 1; goto __RET;
 
-    case 0xCD: /* CALL */
+    OP(0xCD): /* CALL */
     __CALL:
         CALL; break;
-    case 0xC4: /* CALL NZ */
+    OP(0xC4): /* CALL NZ */
         if (!(F&FZ)) goto __CALL; NOCALL; break;
-    case 0xCC: /* CALL Z */
+    OP(0xCC): /* CALL Z */
         if (F&FZ) goto __CALL; NOCALL; break;
-    case 0xD4: /* CALL NC */
+    OP(0xD4): /* CALL NC */
         if (!(F&FC)) goto __CALL; NOCALL; break;
-    case 0xDC: /* CALL C */
+    OP(0xDC): /* CALL C */
         if (F&FC) goto __CALL; NOCALL; break;
 
-    case 0xC7: /* RST 0 */
+    OP(0xC7): /* RST 0 */
         b = 0x00; goto __RST;
-    case 0xCF: /* RST 8 */
+    OP(0xCF): /* RST 8 */
         b = 0x08; goto __RST;
-    case 0xD7: /* RST 10 */
+    OP(0xD7): /* RST 10 */
         b = 0x10; goto __RST;
-    case 0xDF: /* RST 18 */
+    OP(0xDF): /* RST 18 */
         b = 0x18; goto __RST;
-    case 0xE7: /* RST 20 */
+    OP(0xE7): /* RST 20 */
         b = 0x20; goto __RST;
-    case 0xEF: /* RST 28 */
+    OP(0xEF): /* RST 28 */
         b = 0x28; goto __RST;
-    case 0xF7: /* RST 30 */
+    OP(0xF7): /* RST 30 */
         b = 0x30; goto __RST;
-    case 0xFF: /* RST 38 */
+    OP(0xFF): /* RST 38 */
         b = 0x38;
     __RST:
         RST(b); break;
             
-    case 0xC1: /* POP BC */
+    OP(0xC1): /* POP BC */
 #ifdef DYNAREC
         POP(W(acc));
         B=HB(acc);
@@ -840,9 +880,9 @@ next:
         POP(BC); 
 #endif
         break;
-    case 0xC5: /* PUSH BC */
+    OP(0xC5): /* PUSH BC */
         PUSH(BC); break;
-    case 0xD1: /* POP DE */
+    OP(0xD1): /* POP DE */
 #ifdef DYNAREC
         POP(W(acc));
         D=HB(acc);
@@ -851,13 +891,13 @@ next:
         POP(DE); 
 #endif
         break;
-    case 0xD5: /* PUSH DE */
+    OP(0xD5): /* PUSH DE */
         PUSH(DE); break;
-    case 0xE1: /* POP HL */
+    OP(0xE1): /* POP HL */
         POP(HL); break;
-    case 0xE5: /* PUSH HL */
+    OP(0xE5): /* PUSH HL */
         PUSH(HL); break;
-    case 0xF1: /* POP AF */
+    OP(0xF1): /* POP AF */
 #ifdef DYNAREC
         POP(W(acc));
         A=HB(acc);
@@ -866,23 +906,23 @@ next:
         POP(AF); 
         break;
 #endif
-    case 0xF5: /* PUSH AF */
+    OP(0xF5): /* PUSH AF */
         PUSH(AF); break;
 
-    case 0xE8: /* ADD SP,imm */
+    OP(0xE8): /* ADD SP,imm */
         b = FETCH; ADDSP(b); break;
 
-    case 0xF3: /* DI */
+    OP(0xF3): /* DI */
         DI; break;
-    case 0xFB: /* EI */
+    OP(0xFB): /* EI */
         EI; break;
 
-    case 0x37: /* SCF */
+    OP(0x37): /* SCF */
         SCF; break;
-    case 0x3F: /* CCF */
+    OP(0x3F): /* CCF */
         CCF; break;
 
-    case 0x10: /* STOP */
+    OP(0x10): /* STOP */
         PC++;
         if (R_KEY1 & 1)
         {
@@ -893,11 +933,11 @@ next:
         /* NOTE - we do not implement dmg STOP whatsoever */
         break;
             
-    case 0x76: /* HALT */
+    OP(0x76): /* HALT */
         cpu.halt = 1;
         break;
 
-    case 0xCB: /* CB prefix */
+    OP(0xCB): /* CB prefix */
         cbop = FETCH;
         clen = cb_cycles_table[cbop];
         switch (cbop)
@@ -921,6 +961,8 @@ next:
         }
         break;
             
+    OP(0xD3): OP(0xDB): OP(0xDD): OP(0xE3): OP(0xE4): OP(0xEB):
+    OP(0xEC): OP(0xED): OP(0xF4): OP(0xFC): OP(0xFD):
     default:
         die(
             "invalid opcode 0x%02X at address 0x%04X, rombank = %d\n",
@@ -5,6 +5,7 @@
 #include "cpu-gb.h"
 #include "mem.h"
 #include "lcd-gb.h"
+#include "fb.h"
 #include "sound.h"
 #include "rtc-gb.h"
 #include "pcm.h"
@@ -30,6 +31,37 @@ static void emu_step(void)
     cpu_emulate(cpu.lcdc);
 }
 
+/* Runs frames as fast as they go, without sound or input. They are drawn
+ * as usual but not shown. */
+void emu_benchmark(int frames)
+{
+    int enabled = fb.enabled;
+    int sound = options.sound;
+
+    fb.enabled = 1;
+    fb.headless = 1;
+    options.sound = 0;
+
+    while (frames-- > 0 && !shut)
+    {
+        cpu_emulate(2280);
+        while (R_LY > 0 && R_LY < 144)
+            emu_step();
+
+        if (!(R_LCDC & 0x80))
+            cpu_emulate(32832);
+
+        while (R_LY > 0)
+            emu_step();
+
+        rb->yield();
+    }
+
+    fb.enabled = enabled;
+    fb.headless = 0;
+    options.sound = sound;
+}
+
 /* This mess needs to be moved to another module; it's just here to
  * make things work in the mean time. */
 void emu_run(void)
@@ -19,6 +19,7 @@ struct fb
     int mode;
 #endif
     int enabled;
+    int headless; /* draw the frames, but don't show them */
 };
 
 
@@ -47,6 +47,8 @@ struct scan scan IBSS_ATTR;
 byte patpix[4096][8][8]
 #if defined(CPU_COLDFIRE)
      __attribute__ ((aligned(16))) /* to profit from burst mode */
+#else
+     __attribute__ ((aligned(4))) /* rows are copied by the word */
 #endif
      ;
 byte patdirty[1024];
@@ -59,18 +61,45 @@ static int scanline_ind=0;
 static int dmg_pal[4][4];
 
 #if defined(HAVE_LCD_MODES) && (HAVE_LCD_MODES & LCD_MODE_PAL256)
-unsigned char *vdest;
+typedef unsigned char vpixel;
+#define VPIXEL(c) (c) /* the lcd looks up the palette */
 #else
-fb_data *vdest;
+typedef fb_data vpixel;
+#define VPIXEL(c) (PAL[c])
 #endif
 
+vpixel *vdest;
+
 #ifndef ASM_UPDATEPATPIX
+#if ((CONFIG_CPU != SH7034) && !defined(CPU_COLDFIRE))
+/* The pixels of a row of a pattern are looked up for each of its two bytes,
+ * as they are and mirrored. A pixel is 0 or 1 here, so the high byte shifted
+ * left by one never carries into the next pixel. */
+#define PB(b, n)    (((b) >> (n)) & 1)
+#define PB_ROW(b)   { PB(b,7), PB(b,6), PB(b,5), PB(b,4), \
+                      PB(b,3), PB(b,2), PB(b,1), PB(b,0) }
+#define PB_FLIP(b)  { PB(b,0), PB(b,1), PB(b,2), PB(b,3), \
+                      PB(b,4), PB(b,5), PB(b,6), PB(b,7) }
+#define PB4(m, b)   m(b), m((b)+1), m((b)+2), m((b)+3)
+#define PB16(m, b)  PB4(m, b), PB4(m, (b)+4), PB4(m, (b)+8), PB4(m, (b)+12)
+#define PB64(m, b)  PB16(m, b), PB16(m, (b)+16), PB16(m, (b)+32), \
+                    PB16(m, (b)+48)
+#define PB256(m)    PB64(m, 0), PB64(m, 64), PB64(m, 128), PB64(m, 192)
+
+static const byte patbits[2][256][8] __attribute__ ((aligned(4))) =
+{
+    { PB256(PB_ROW) },
+    { PB256(PB_FLIP) },
+};
+#endif
+
 static void updatepatpix(void) ICODE_ATTR;
 static void updatepatpix(void)
 {
     int i, j;
 #if ((CONFIG_CPU != SH7034) && !defined(CPU_COLDFIRE))
-    int k, a, c;
+    un32 *d, *s;
+    const un32 *lo, *hi;
 #endif
     byte *vram = lcd.vbank[0];
 
@@ -217,16 +246,17 @@ static void updatepatpix(void)
                 "d0", "d1", "d2"
             );
 #else
-            a = ((i<<4) | (j<<1));
-            for (k = 0; k < 8; k++)
-            {
-                c = vram[a] & BIT_N(k) ? 1 : 0;
-                c |= vram[a+1] & BIT_N(k) ? 2 : 0;
-                patpix[i+1024][j][k] = c;
-            }
-            for (k = 0; k < 8; k++)
-                patpix[i][j][k] =
-                    patpix[i+1024][j][7-k];
+            lo = (const un32 *)patbits[0][vram[(i<<4)|(j<<1)]];
+            hi = (const un32 *)patbits[0][vram[(i<<4)|(j<<1)|1]];
+            d = (un32 *)patpix[i][j];
+            d[0] = lo[0] | (hi[0] << 1);
+            d[1] = lo[1] | (hi[1] << 1);
+
+            lo = (const un32 *)patbits[1][vram[(i<<4)|(j<<1)]];
+            hi = (const un32 *)patbits[1][vram[(i<<4)|(j<<1)|1]];
+            d = (un32 *)patpix[i+1024][j];
+            d[0] = lo[0] | (hi[0] << 1);
+            d[1] = lo[1] | (hi[1] << 1);
 #endif
         }
 #if CONFIG_CPU == SH7034
@@ -357,13 +387,14 @@ static void updatepatpix(void)
 #else
         for (j = 0; j < 8; j++)
         {
-            for (k = 0; k < 8; k++)
-            {
-                patpix[i+2048][j][k] =
-                    patpix[i][7-j][k];
-                patpix[i+3072][j][k] =
-                    patpix[i+1024][7-j][k];
-            }
+            d = (un32 *)patpix[i+2048][j];
+            s = (un32 *)patpix[i][7-j];
+            d[0] = s[0];
+            d[1] = s[1];
+            d = (un32 *)patpix[i+3072][j];
+            s = (un32 *)patpix[i+1024][7-j];
+            d[0] = s[0];
+            d[1] = s[1];
         }
 #endif
     }
@@ -931,6 +962,45 @@ int swidth  IDATA_ATTR=160;
 int sremain IDATA_ATTR=LCD_WIDTH-160;
 #endif
 
+#ifdef HAVE_LCD_COLOR
+/* Looks up the palette and scales the line in one pass, step is the
+ * distance between pixels in the frame buffer */
+static void scale_line(vpixel *dst, int step) ICODE_ATTR;
+static void scale_line(vpixel *dst, int step)
+{
+    byte *src = BUF;
+    int cnt;
+
+    if (swidth == 160 && SCALEWS == 1<<16)
+    {
+        for (cnt = 160/8; cnt > 0; cnt--)
+        {
+            dst[0]      = VPIXEL(src[0]);
+            dst[step]   = VPIXEL(src[1]);
+            dst[2*step] = VPIXEL(src[2]);
+            dst[3*step] = VPIXEL(src[3]);
+            dst[4*step] = VPIXEL(src[4]);
+            dst[5*step] = VPIXEL(src[5]);
+            dst[6*step] = VPIXEL(src[6]);
+            dst[7*step] = VPIXEL(src[7]);
+            dst += 8*step;
+            src += 8;
+        }
+    }
+    else
+    {
+        unsigned int srcpt = 0x8000;
+
+        for (cnt = swidth; cnt > 0; cnt--)
+        {
+            *dst = VPIXEL(src[srcpt>>16]);
+            dst += step;
+            srcpt += SCALEWS;
+        }
+    }
+}
+#endif
+
 void setvidmode(void)
 {
 
@@ -1078,33 +1148,32 @@ void lcd_refreshline(void)
     /*  Universal Scaling pulled from PrBoom and modified for rockboy  */
 
     static int hpt IDATA_ATTR=0x8000;
+    vpixel *prev = NULL;
+    int step;
+
+    if (options.rotate == 1)
+        step = LCD_WIDTH;
+    else if (options.rotate == 2)
+        step = -LCD_WIDTH;
+    else
+        step = 1;
 
     while((hpt>>16)<L+1)
     {
         hpt+=SCALEHS;
-        register unsigned int srcpt=0x8000;
-        register unsigned int wcount=swidth;
-        while(wcount--)
-        {
-#if defined(HAVE_LCD_MODES) && (HAVE_LCD_MODES & LCD_MODE_PAL256)
-            *vdest = BUF[srcpt>>16];
-#else
-            *vdest = PAL[BUF[srcpt>>16]];
-#endif
-            if (options.rotate == 1) {
-                vdest+=LCD_WIDTH;
-            } else if (options.rotate == 2) {
-                vdest-=LCD_WIDTH;
-            } else {
-                vdest++;
-            }
-
-            srcpt+=SCALEWS;
-        }
-        vdest+=sremain;
+        /* a line shown twice is copied from the row above */
+        if (prev && step == 1)
+            memcpy(vdest, prev, swidth*sizeof(vpixel));
+        else
+            scale_line(vdest, step);
+        prev = vdest;
+        vdest+=swidth*step+sremain;
     }
 
     if(L==143)
+        hpt=0x8000;
+
+    if(L==143 && !fb.headless)
     {
         if(options.showstats)
         {
@@ -1118,8 +1187,6 @@ void lcd_refreshline(void)
             rb->lcd_update_rect(0,LCD_HEIGHT-10, LCD_WIDTH, 10);
         }
 
-        hpt=0x8000;
-
 #if defined(HAVE_LCD_MODES) && (HAVE_LCD_MODES & LCD_MODE_PAL256)
         if(options.scaling==3) {
             rb->lcd_blit_pal256((unsigned char*)rb->lcd_framebuffer,(LCD_WIDTH-160)/2, (LCD_HEIGHT-144)/2, (LCD_WIDTH-160)/2, (LCD_HEIGHT-144)/2, 160, 144);
@@ -1221,7 +1288,6 @@ void vram_write(addr a, byte b)
     if (a >= 0x1800) return;
     patdirty[((R_VBK&1)<<9)+(a>>4)] = 1;
     anydirty = 1;
-    pal_dirty();
 }
 
 void vram_dirty(void)
@@ -17,9 +17,21 @@
 #define SLOT_COUNT  50
 #define DESC_SIZE   20
 
+/* ten seconds of game boy time */
+#define BENCH_FRAMES 600
+
+#ifdef USEC_TIMER
+#define NOW()       ((long)USEC_TIMER)
+#define PER_SECOND  1000000
+#else
+#define NOW()       (*rb->current_tick)
+#define PER_SECOND  HZ
+#endif
+
 /* load/save state function declarations */
 static void do_opt_menu(void);
 static void do_slot_menu(bool is_load);
+static void do_benchmark(void);
 static void munge_name(char *buf, size_t bufsiz);
 
 /* directory ROM save slots belong in */
@@ -91,7 +103,7 @@ int do_user_menu(void) {
 
     MENUITEM_STRINGLIST(menu, "Rockboy Menu", NULL,
                         "Load Game", "Save Game",
-                        "Options", "Reset", "Quit");
+                        "Options", "Reset", "Benchmark", "Quit");
 
     rockboy_pcm_init();
 
@@ -114,7 +126,10 @@ int do_user_menu(void) {
                 emu_reset();
                 done=true;
                 break;
-            case 4: /* Quit */
+            case 4: /* Benchmark */
+                do_benchmark();
+                break;
+            case 5: /* Quit */
                 ret = USER_MENU_QUIT;
                 if(options.autosave) sn_save();
                 done=true;
@@ -340,6 +355,47 @@ static void do_slot_menu(bool is_load) {
     }
 }
 
+/*
+ * do_benchmark - run the game as fast as it goes for a while and show the
+ * frame rate. The game is put back where it was afterwards.
+ */
+static void do_benchmark(void) {
+    char path[256];
+    long time, fps;
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/benchmark.rbs", STATE_DIR);
+
+    if ((fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666)) < 0)
+    {
+        rb->splash(HZ, "Can't save the game state");
+        return;
+    }
+    savestate(fd);
+    close(fd);
+
+    rb->splash(0, "Benchmarking...");
+
+    time = NOW();
+    emu_benchmark(BENCH_FRAMES);
+    time = NOW() - time;
+
+    if (time <= 0)
+        time = 1;
+    /* in tenths, the game boy does 59.7 frames per second */
+    fps = (long long)BENCH_FRAMES * PER_SECOND * 10 / time;
+
+    if ((fd = open(path, O_RDONLY)) >= 0)
+    {
+        loadstate(fd);
+        close(fd);
+    }
+    rb->remove(path);
+
+    rb->splashf(HZ*4, "%ld.%ld fps, %ld%% of full speed",
+                fps / 10, fps % 10, fps * 1000 / 5973);
+}
+
 static void do_opt_menu(void)
 {
     bool done=false;
@@ -259,6 +259,7 @@ void vid_begin(void)
 void vid_init(void)
 {
     fb.enabled=1;
+    fb.headless=0;
 
 #if defined(HAVE_LCD_COLOR)
 #if LCD_DEPTH == 24
@@ -363,7 +364,8 @@ void vid_update(int scanline)
         }
         cnt ++;
     }
-    rb->lcd_update_rect(0, (scanline/2) & ~7, LCD_WIDTH, 8);
+    if (!fb.headless)
+        rb->lcd_update_rect(0, (scanline/2) & ~7, LCD_WIDTH, 8);
 #elif (LCD_HEIGHT == 128) && (LCD_DEPTH == 2) /* iriver H1x0, Samsung YH920 */
     if (fb.mode==1)
         scanline-=16;
@@ -378,7 +380,8 @@ void vid_update(int scanline)
                       ((scan.buf[3][cnt]&0x3)<<6);
         cnt++;
     }
-    rb->lcd_update_rect(0, scanline & ~3, LCD_WIDTH, 4);
+    if (!fb.headless)
+        rb->lcd_update_rect(0, scanline & ~3, LCD_WIDTH, 4);
 #elif defined(HAVE_LCD_COLOR)
     /* handled in lcd.c now */
 #endif /* LCD_HEIGHT */
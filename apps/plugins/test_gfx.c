@@ -453,6 +453,143 @@ static void time_put_line(void) /* tests put_line performance */
                  count1, count2, count3, count4);
 }
 
+#if defined(HAVE_LCD_COLOR) && !defined(TEST_GREYLIB)
+/* An anti-aliased ring standing in for a glyph of a 16 pixel font, and an
+ * icon with an alpha channel. The glyph width is odd so that rows start in
+ * the middle of a byte, as they do in font files. */
+#define GLYPH_W 9
+#define GLYPH_H 16
+#define ICON_W  16
+#define ICON_H  16
+
+static unsigned char glyph[(GLYPH_W * GLYPH_H + 1) / 2];
+static struct
+{
+    fb_data image[ICON_W * ICON_H];
+    unsigned char alpha[ICON_W * ICON_H / 2];
+} icon_data;
+static struct bitmap icon;
+
+/* 4 bit alpha of a ring between radius r and r + 2 around the center of a
+ * w x h box, 0 being opaque and 15 transparent. Each pixel is sampled 4x4
+ * times. */
+static void make_ring(unsigned char *dst, int stride, int w, int h, int r)
+{
+    int r_in = (r * 8) * (r * 8), r_out = ((r + 2) * 8) * ((r + 2) * 8);
+
+    for (int y = 0; y < h; y++)
+    {
+        for (int x = 0; x < w; x++)
+        {
+            int covered = 0, i = y * stride + x;
+
+            for (int sy = 0; sy < 4; sy++)
+            {
+                for (int sx = 0; sx < 4; sx++)
+                {
+                    /* in 1/8 pixels from the center */
+                    int dx = (8 * x + 2 * sx + 1) - 4 * w;
+                    int dy = (8 * y + 2 * sy + 1) - 4 * h;
+                    int d = dx * dx + dy * dy;
+
+                    if (d >= r_in && d < r_out)
+                        covered++;
+                }
+            }
+
+            dst[i / 2] |= (15 - covered * 15 / 16) << ((i & 1) * 4);
+        }
+    }
+}
+
+static void init_alpha_bitmaps(void)
+{
+    make_ring(glyph, GLYPH_W, GLYPH_W, GLYPH_H, GLYPH_W / 2 - 1);
+    make_ring(icon_data.alpha, ICON_W, ICON_W, ICON_H, ICON_W / 2 - 2);
+
+    for (int i = 0; i < ICON_W * ICON_H; i++)
+        icon_data.image[i] = LCD_RGBPACK(i, 255 - i, 128);
+
+    icon.width = ICON_W;
+    icon.height = ICON_H;
+    icon.format = FORMAT_NATIVE;
+    icon.maskdata = NULL;
+    icon.alpha_offset = offsetof(typeof(icon_data), alpha);
+    icon.data = (unsigned char *)&icon_data;
+}
+
+/* returns the number of glyphs or icons drawn in DURATION */
+static int time_alpha_draw(int drawmode, bool draw_icon)
+{
+    long time_start, time_end;
+    int count = 0;
+
+    rb->lcd_set_drawmode(drawmode);
+    rb->sleep(0); /* sync to tick */
+    time_start = *rb->current_tick;
+    while((time_end = *rb->current_tick) - time_start < DURATION)
+    {
+        unsigned rnd = rand_table[count++ & 0x3ff];
+        if (draw_icon)
+            rb->lcd_bmp_part(&icon, 0, 0, (rnd >> 8) & 0x3f, rnd & 0x3f,
+                             ICON_W, ICON_H);
+        else
+            rb->lcd_alpha_bitmap_part(glyph, 0, 0, GLYPH_W,
+                                      (rnd >> 8) & 0x3f, rnd & 0x3f,
+                                      GLYPH_W, GLYPH_H);
+    }
+    return count;
+}
+
+/* tests the blending of anti-aliased glyphs and alpha icons */
+static void time_alpha(void)
+{
+    size_t bufsize;
+    fb_data *backdrop = rb->plugin_get_buffer(&bufsize);
+    int solid, fg, bd, icon_fg, icon_bd;
+
+    init_alpha_bitmaps();
+    rb->lcd_set_foreground(LCD_RGBPACK(255, 255, 0));
+    rb->lcd_set_background(LCD_RGBPACK(0, 0, 96));
+
+    solid = time_alpha_draw(DRMODE_SOLID, false);
+    fg = time_alpha_draw(DRMODE_FG, false);
+    icon_fg = time_alpha_draw(DRMODE_FG, true);
+
+    bd = icon_bd = 0;
+    if (bufsize >= LCD_FBWIDTH * LCD_FBHEIGHT * sizeof(fb_data))
+    {
+        for (int i = 0; i < LCD_FBWIDTH * LCD_FBHEIGHT; i++)
+            backdrop[i] = LCD_RGBPACK(0, i & 0xff, (i >> 8) & 0xff);
+        rb->lcd_set_backdrop(backdrop);
+
+        bd = time_alpha_draw(DRMODE_SOLID, false);
+        icon_bd = time_alpha_draw(DRMODE_SOLID, true);
+
+        rb->lcd_set_backdrop(NULL);
+    }
+
+    rb->lcd_set_drawmode(DRMODE_SOLID);
+    rb->lcd_set_foreground(LCD_DEFAULT_FG);
+    rb->lcd_set_background(LCD_DEFAULT_BG);
+
+    rb->fdprintf(log_fd, "\nalpha blending  (glyphs/s, pixels/s):\n"
+                         "    glyph solid:      %d  %d\n"
+                         "    glyph foreground: %d  %d\n"
+                         "    glyph backdrop:   %d  %d\n"
+                         "    icon foreground:  %d  %d\n"
+                         "    icon backdrop:    %d  %d\n",
+                 solid, solid * GLYPH_W * GLYPH_H,
+                 fg, fg * GLYPH_W * GLYPH_H,
+                 bd, bd * GLYPH_W * GLYPH_H,
+                 icon_fg, icon_fg * ICON_W * ICON_H,
+                 icon_bd, icon_bd * ICON_W * ICON_H);
+}
+#define NUM_ALPHA_TESTS 5
+#else
+#define NUM_ALPHA_TESTS 0
+#endif /* HAVE_LCD_COLOR && !TEST_GREYLIB */
+
 /* plugin entry point */
 enum plugin_status plugin_start(const void* parameter)
 {
@@ -498,7 +635,7 @@ enum plugin_status plugin_start(const void* parameter)
     backlight_ignore_timeout();
 
     rb->splashf(0, "LCD driver performance test, please wait %d sec",
-                7*4*DURATION/HZ);
+                (7*4 + NUM_ALPHA_TESTS)*DURATION/HZ);
     init_rand_table();
 
 #ifdef HAVE_ADJUSTABLE_CPU_FREQ
@@ -512,6 +649,9 @@ enum plugin_status plugin_start(const void* parameter)
     time_fillrect();
     time_text();
     time_put_line();
+#if defined(HAVE_LCD_COLOR) && !defined(TEST_GREYLIB)
+    time_alpha();
+#endif
 
 #ifdef HAVE_ADJUSTABLE_CPU_FREQ
     if (*rb->cpu_frequency != cpu_freq)
@@ -0,0 +1,544 @@
+/***************************************************************************
+ *             __________               __   ___.
+ *   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+ *   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+ *   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+ *   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+ *                     \/            \/     \/    \/            \/
+ * $Id$
+ *
+ * Kernel object stress test
+ *
+ * Worker threads, spread over the cores where there is more than one,
+ * hammer a mutex, pass numbered items through a ring buffer guarded by
+ * semaphores and exchange posted and sent events through queues. The
+ * results are checked for lost updates, lost or reordered items and wrong
+ * replies, and every wait has a timeout so a lost wakeup shows up as a
+ * stall instead of a hang. With priority scheduling, workers of different
+ * priorities check that they are run highest first and that a low priority
+ * one still gets turns next to a busy higher priority one. Finally sleep()
+ * is timed.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ ****************************************************************************/
+
+#include "plugin.h"
+
+#define WORKERS     4
+#define ROUNDS      20000
+#define STALL_TMO   (5*HZ)
+
+#define RING_SIZE   16
+#define POST_BURST  8   /* less than a queue holds */
+
+#define EV_POST     1
+#define EV_SEND     2
+#define EV_QUIT     3
+
+#define AGING_TIME  (HZ/2)
+
+#define SLEEPS      HZ
+
+static long stacks[WORKERS][DEFAULT_STACK_SIZE / sizeof(long)];
+static unsigned int thread_ids[WORKERS] SHAREDBSS_ATTR;
+static void (*worker_func)(int index) SHAREDBSS_ATTR;
+
+static int line;
+static int errors;
+
+static void result(const char *fmt, ...)
+{
+    char buf[64];
+    va_list ap;
+
+    va_start(ap, fmt);
+    rb->vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+
+    rb->lcd_puts(0, line++, buf);
+    rb->lcd_update();
+    DEBUGF("%s\n", buf);
+}
+
+static void worker_thread(void)
+{
+    unsigned int self = rb->thread_self();
+    int index = 0;
+
+    /* the threads are started once all the ids are stored */
+    while (thread_ids[index] != self)
+        index++;
+
+    worker_func(index);
+
+    rb->thread_exit();
+}
+
+/* Runs func(0 .. WORKERS-1) in threads and waits for all of them. Without
+   priorities they alternate between the cores, with them they all run on
+   the CPU at priorities[index]. Returns the time it took in ticks. */
+static long run_workers_at(void (*func)(int index), const int *priorities)
+{
+    long start = *rb->current_tick;
+#if !defined(HAVE_PRIORITY_SCHEDULING) && NUM_CORES == 1
+    (void)priorities;
+#endif
+
+    worker_func = func;
+
+    for (int i = 0; i < WORKERS; i++)
+    {
+        thread_ids[i] =
+            rb->create_thread(worker_thread, stacks[i], sizeof(stacks[i]),
+                              CREATE_THREAD_FROZEN, "kernel test"
+                              IF_PRIO(, priorities ? priorities[i] :
+                                        PRIORITY_USER_INTERFACE)
+                              IF_COP(, (!priorities && (i & 1)) ? COP : CPU));
+        if (thread_ids[i] == 0)
+        {
+            result("out of thread slots");
+            errors++;
+            break;
+        }
+    }
+
+    for (int i = 0; i < WORKERS && thread_ids[i] != 0; i++)
+        rb->thread_thaw(thread_ids[i]);
+
+    for (int i = 0; i < WORKERS && thread_ids[i] != 0; i++)
+        rb->thread_wait(thread_ids[i]);
+
+    rb->memset(thread_ids, 0, sizeof(thread_ids));
+
+    return *rb->current_tick - start;
+}
+
+static long run_workers(void (*func)(int index))
+{
+    return run_workers_at(func, NULL);
+}
+
+/** Mutex: unprotected read-modify-write of a shared counter **/
+
+static struct mutex counter_mtx SHAREDBSS_ATTR;
+static volatile long counter SHAREDBSS_ATTR;
+
+static void mutex_worker(int index)
+{
+    for (int i = 0; i < ROUNDS; i++)
+    {
+        rb->mutex_lock(&counter_mtx);
+
+        long value = counter;
+        /* let others run into the locked mutex now and then */
+        if ((i + index) % 64 == 0)
+            rb->yield();
+        counter = value + 1;
+
+        rb->mutex_unlock(&counter_mtx);
+    }
+}
+
+static void test_mutex(void)
+{
+    counter = 0;
+    rb->mutex_init(&counter_mtx);
+
+    long ticks = run_workers(mutex_worker);
+
+    if (counter == (long)WORKERS * ROUNDS)
+        result("mutex: ok, %ld ms", ticks * 1000 / HZ);
+    else
+    {
+        result("mutex: %ld of %ld", counter, (long)WORKERS * ROUNDS);
+        errors++;
+    }
+}
+
+#ifdef HAVE_SEMAPHORE_OBJECTS
+/** Semaphores: producers and consumers on a ring buffer **/
+
+static struct semaphore ring_free SHAREDBSS_ATTR;
+static struct semaphore ring_full SHAREDBSS_ATTR;
+static struct mutex ring_mtx SHAREDBSS_ATTR;
+static unsigned long ring[RING_SIZE] SHAREDBSS_ATTR;
+static unsigned int ring_read SHAREDBSS_ATTR;
+static unsigned int ring_write SHAREDBSS_ATTR;
+static volatile unsigned long ring_sum SHAREDBSS_ATTR;
+static volatile int ring_bad SHAREDBSS_ATTR;
+
+/* item: producer in the top bits, sequence number below */
+#define ITEM(producer, seq) (((unsigned long)(producer) << 24) | (seq))
+
+static void sem_worker(int index)
+{
+    /* workers 0 and 1 produce, 2 and 3 consume - each on a different
+       core from its counterpart */
+    if (index < WORKERS / 2)
+    {
+        for (int seq = 0; seq < ROUNDS; seq++)
+        {
+            if (rb->semaphore_wait(&ring_free, STALL_TMO) != OBJ_WAIT_SUCCEEDED)
+            {
+                ring_bad |= 1;
+                return;
+            }
+
+            rb->mutex_lock(&ring_mtx);
+            ring[ring_write++ % RING_SIZE] = ITEM(index, seq);
+            rb->mutex_unlock(&ring_mtx);
+
+            rb->semaphore_release(&ring_full);
+        }
+    }
+    else
+    {
+        int last[WORKERS / 2];
+        unsigned long sum = 0;
+
+        for (int i = 0; i < WORKERS / 2; i++)
+            last[i] = -1;
+
+        for (int n = 0; n < ROUNDS; n++)
+        {
+            if (rb->semaphore_wait(&ring_full, STALL_TMO) != OBJ_WAIT_SUCCEEDED)
+            {
+                ring_bad |= 1;
+                return;
+            }
+
+            rb->mutex_lock(&ring_mtx);
+            unsigned long item = ring[ring_read++ % RING_SIZE];
+            rb->mutex_unlock(&ring_mtx);
+
+            rb->semaphore_release(&ring_free);
+
+            /* each consumer sees the items of a producer in order */
+            int producer = item >> 24, seq = item & 0xffffff;
+            if (producer >= WORKERS / 2 || seq <= last[producer])
+                ring_bad |= 2;
+            else
+                last[producer] = seq;
+
+            sum += seq;
+        }
+
+        rb->mutex_lock(&ring_mtx);
+        ring_sum += sum;
+        rb->mutex_unlock(&ring_mtx);
+    }
+}
+
+static void test_semaphore(void)
+{
+    /* every item is taken once by one of the consumers */
+    unsigned long expected = (unsigned long)(WORKERS / 2) *
+                             ROUNDS * (ROUNDS - 1) / 2;
+
+    rb->semaphore_init(&ring_free, RING_SIZE, RING_SIZE);
+    rb->semaphore_init(&ring_full, RING_SIZE, 0);
+    rb->mutex_init(&ring_mtx);
+    ring_read = ring_write = 0;
+    ring_sum = 0;
+    ring_bad = 0;
+
+    long ticks = run_workers(sem_worker);
+
+    if (ring_bad & 1)
+        result("semaphore: stalled");
+    else if (ring_bad & 2)
+        result("semaphore: items out of order");
+    else if (ring_sum != expected)
+        result("semaphore: items lost");
+    else
+    {
+        result("semaphore: ok, %ld ms", ticks * 1000 / HZ);
+        return;
+    }
+
+    errors++;
+}
+#endif /* HAVE_SEMAPHORE_OBJECTS */
+
+#if CONFIG_CODEC == SWCODEC /* queue_send() */
+/** Queues: posts and sends to a server on the other core **/
+
+static struct event_queue queues[WORKERS / 2] SHAREDBSS_ATTR;
+static struct queue_sender_list senders[WORKERS / 2] SHAREDBSS_ATTR;
+static volatile long posts_seen[WORKERS / 2] SHAREDBSS_ATTR;
+static volatile int queue_bad SHAREDBSS_ATTR;
+
+static void queue_worker(int index)
+{
+    /* workers 0 and 1 serve, 2 talks to 1 and 3 to 0 - so always across
+       the cores */
+    if (index < WORKERS / 2)
+    {
+        struct event_queue *q = &queues[index];
+        struct queue_event ev;
+        long expect = 0;
+
+        while (1)
+        {
+            rb->queue_wait_w_tmo(q, &ev, STALL_TMO);
+
+            switch (ev.id)
+            {
+            case EV_POST:
+                if (ev.data != expect)
+                    queue_bad |= 2;
+                expect = ev.data + 1;
+                posts_seen[index]++;
+                break;
+
+            case EV_SEND:
+                rb->queue_reply(q, ev.data + 1);
+                break;
+
+            case EV_QUIT:
+                rb->queue_reply(q, 0);
+                return;
+
+            case SYS_TIMEOUT:
+                queue_bad |= 1;
+                return;
+            }
+        }
+    }
+    else
+    {
+        struct event_queue *q = &queues[WORKERS - 1 - index];
+
+        for (int i = 0; i < ROUNDS; i++)
+        {
+            rb->queue_post(q, EV_POST, i);
+
+            /* a send is only answered once everything posted before it has
+               been taken, so the queue can't overflow */
+            if (i % POST_BURST == POST_BURST - 1 &&
+                rb->queue_send(q, EV_SEND, i) != i + 1)
+            {
+                queue_bad |= 4;
+            }
+
+            if (queue_bad)
+                break;
+        }
+
+        rb->queue_send(q, EV_QUIT, 0);
+    }
+}
+
+static void test_queue(void)
+{
+    for (int i = 0; i < WORKERS / 2; i++)
+    {
+        rb->queue_init(&queues[i], false);
+        rb->queue_enable_queue_send(&queues[i], &senders[i], 0);
+        posts_seen[i] = 0;
+    }
+    queue_bad = 0;
+
+    long ticks = run_workers(queue_worker);
+
+    for (int i = 0; i < WORKERS / 2; i++)
+    {
+        if (posts_seen[i] != ROUNDS)
+            queue_bad |= 8;
+        rb->queue_delete(&queues[i]);
+    }
+
+    if (queue_bad & 1)
+        result("queue: stalled");
+    else if (queue_bad & 2)
+        result("queue: posts out of order");
+    else if (queue_bad & 4)
+        result("queue: wrong reply");
+    else if (queue_bad & 8)
+        result("queue: posts lost");
+    else
+    {
+        result("queue: ok, %ld ms", ticks * 1000 / HZ);
+        return;
+    }
+
+    errors++;
+}
+#endif /* CONFIG_CODEC == SWCODEC */
+
+#ifdef HAVE_PRIORITY_SCHEDULING
+/** Priorities: the order threads get to run in and aging **/
+
+/* All below the plugin's own priority, so none of them runs before it
+   waits for them. A woken thread starts out aged by its priority, so the
+   levels are far enough apart for that not to let one jump ahead. The last
+   two share a level and take turns in the order they were woken. */
+static const int order_priorities[WORKERS] =
+{
+    PRIORITY_USER_INTERFACE + 13,
+    PRIORITY_USER_INTERFACE + 7,
+    PRIORITY_USER_INTERFACE + 1,
+    PRIORITY_USER_INTERFACE + 1,
+};
+static const int expected_order[WORKERS] = { 2, 3, 1, 0 };
+
+static int run_order[WORKERS] SHAREDBSS_ATTR;
+static int run_count SHAREDBSS_ATTR;
+
+static void order_worker(int index)
+{
+    run_order[run_count++] = index;
+}
+
+/* a busy worker and one four levels below it that has to age to run */
+static const int aging_priorities[WORKERS] =
+{
+    PRIORITY_USER_INTERFACE + 1,
+    PRIORITY_USER_INTERFACE + 5,
+    PRIORITY_USER_INTERFACE + 1,
+    PRIORITY_USER_INTERFACE + 1,
+};
+
+static volatile long busy_turns SHAREDBSS_ATTR;
+static volatile long aged_turns SHAREDBSS_ATTR;
+static volatile bool busy SHAREDBSS_ATTR;
+static volatile bool busy_done SHAREDBSS_ATTR;
+
+static void aging_worker(int index)
+{
+    if (index == 0)
+    {
+        long end = *rb->current_tick + AGING_TIME;
+
+        busy = true;
+        while (TIME_BEFORE(*rb->current_tick, end))
+        {
+            busy_turns++;
+            rb->yield();
+        }
+        busy = false;
+        busy_done = true;
+    }
+    else if (index == 1)
+    {
+        while (!busy_done)
+        {
+            if (busy)
+                aged_turns++;
+            rb->yield();
+        }
+    }
+}
+
+static void test_priority(void)
+{
+    run_count = 0;
+    run_workers_at(order_worker, order_priorities);
+
+    for (int i = 0; i < WORKERS; i++)
+    {
+        if (run_order[i] != expected_order[i])
+        {
+            result("priority: run as %d %d %d %d", run_order[0],
+                   run_order[1], run_order[2], run_order[3]);
+            errors++;
+            return;
+        }
+    }
+
+    busy_turns = aged_turns = 0;
+    busy = busy_done = false;
+    run_workers_at(aging_worker, aging_priorities);
+
+    /* it is picked once in 4*4+1 turns of the busy one, give or take
+       other threads */
+    if (aged_turns == 0)
+        result("priority: starved");
+    else if (aged_turns * 4 > busy_turns)
+        result("priority: %ld turns vs %ld", aged_turns, busy_turns);
+    else
+    {
+        result("priority: ok, aged %ld of %ld", aged_turns, busy_turns);
+        return;
+    }
+
+    errors++;
+}
+#endif /* HAVE_PRIORITY_SCHEDULING */
+
+/** Sleep: sleep(1) over and over **/
+
+static void test_sleep(void)
+{
+    /* start right after a tick */
+    rb->sleep(0);
+
+    long start = *rb->current_tick;
+    for (int i = 0; i < SLEEPS; i++)
+        rb->sleep(1);
+    long ticks = *rb->current_tick - start;
+
+#ifdef HAVE_HRTIMER
+    /* each one lasts a tick period, whatever the phase of the tick */
+    long min = SLEEPS - 1, max = SLEEPS + SLEEPS / 4;
+#else
+    /* each one ends on the second tick after the call */
+    long min = SLEEPS, max = 2 * SLEEPS + SLEEPS / 4;
+#endif
+
+    if (ticks >= min && ticks <= max)
+        result("sleep: ok, %ld ms", ticks * 1000 / HZ);
+    else
+    {
+        result("sleep: %d took %ld ms", SLEEPS, ticks * 1000 / HZ);
+        errors++;
+    }
+}
+
+enum plugin_status plugin_start(const void *parameter)
+{
+    (void)parameter;
+
+#ifdef HAVE_LCD_BITMAP
+    rb->lcd_setfont(FONT_SYSFIXED);
+#endif
+    rb->lcd_clear_display();
+    line = 0;
+    errors = 0;
+
+    result("%d threads on %d cores", WORKERS, NUM_CORES);
+
+#ifdef HAVE_ADJUSTABLE_CPU_FREQ
+    rb->cpu_boost(true);
+#endif
+
+    test_mutex();
+#ifdef HAVE_SEMAPHORE_OBJECTS
+    test_semaphore();
+#endif
+#if CONFIG_CODEC == SWCODEC
+    test_queue();
+#endif
+#ifdef HAVE_PRIORITY_SCHEDULING
+    test_priority();
+#endif
+    test_sleep();
+
+#ifdef HAVE_ADJUSTABLE_CPU_FREQ
+    rb->cpu_boost(false);
+#endif
+
+    result(errors ? "FAILED" : "passed");
+    result("press a button");
+    rb->button_clear_queue();
+    rb->button_get(true);
+
+    return errors ? PLUGIN_ERROR : PLUGIN_OK;
+}
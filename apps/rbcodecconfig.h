@@ -21,6 +21,9 @@
 /* HZ, TIME_AFTER, current_tick */
 #include "kernel.h"
 
+/* TRACE_BEGIN, TRACE_END */
+#include "trace.h"
+
 /* Structure to record some info during processing call */
 struct dsp_loop_context
 {
@@ -35,6 +38,7 @@ static inline void dsp_process_start(struct dsp_loop_context *ctx)
     /* At least perform one yield before starting */
     ctx->last_yield = current_tick;
     yield();
+    TRACE_BEGIN(TP_DSP_PROCESS, 0);
 #if defined(CPU_COLDFIRE)
     /* set emac unit for dsp processing, and save old macsr, we're running in
        codec thread context at this point, so can't clobber it */
@@ -60,6 +64,7 @@ static inline void dsp_process_end(struct dsp_loop_context *ctx)
     /* set old macsr again */
     coldfire_set_macsr(ctx->old_macsr);
 #endif
+    TRACE_END(TP_DSP_PROCESS, 0);
     (void)ctx;
 }
 
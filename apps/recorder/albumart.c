@@ -122,6 +122,16 @@ static bool try_exts(char *path, int len)
 #define try_exts(path, len) file_exists(path)
 #endif
 
+/* Try ./<trackname><size>.{jpeg,jpg,bmp}, leaving the name in path */
+static bool try_track_file(const char *trackname, const char *size_string,
+                           char *path)
+{
+    strip_extension(path, MAX_PATH + 1 - strlen(size_string) - 4, trackname);
+    strcat(path, size_string);
+    strcat(path, "." EXT);
+    return try_exts(path, strlen(path));
+}
+
 /* Look for the first matching album art bitmap in the following list:
  *  ./<trackname><size>.{jpeg,jpg,bmp}
  *  ./<albumname><size>.{jpeg,jpg,bmp}
@@ -176,14 +186,7 @@ bool search_albumart_files(const struct mp3entry *id3, const char *size_string,
         {
             /* the first file we look for is one specific to the
                current track */
-            strip_extension(path, sizeof(path) - strlen(size_string) - 4,
-                            trackname);
-            strcat(path, size_string);
-            strcat(path, "." EXT);
-#ifdef USE_JPEG_COVER
-            pathlen = strlen(path);
-#endif
-            found = try_exts(path, pathlen);
+            found = try_track_file(trackname, size_string, path);
         }
         if (pass)
             break;
@@ -297,6 +300,31 @@ bool find_albumart(const struct mp3entry *id3, char *buf, int buflen,
     return search_albumart_files(id3, size_string, buf, buflen);
 }
 
+/* Look only for bitmaps specific to the track, i.e. the ones that can't be
+ * shared with the other tracks of the album.
+ * Stores the found filename in the buf parameter.
+ * Returns true if a bitmap was found, false otherwise */
+bool find_track_albumart(const struct mp3entry *id3, char *buf, int buflen,
+                         const struct dim *dim)
+{
+    char path[MAX_PATH + 1];
+    char size_string[9];
+
+    if (!id3 || !buf || strcmp(id3->path, "No file!") == 0)
+        return false;
+
+    snprintf(size_string, sizeof(size_string), ".%dx%d",
+              dim->width, dim->height);
+
+    if (!try_track_file(id3->path, size_string, path) &&
+        !try_track_file(id3->path, "", path))
+        return false;
+
+    strlcpy(buf, path, buflen);
+    logf("Track album art found: %s", path);
+    return true;
+}
+
 /* Draw the album art bitmap from the given handle ID onto the given WPS.
    Call with clear = true to clear the bitmap instead of drawing it. */
 void draw_album_art(struct gui_wps *gwps, int handle_id, bool clear)
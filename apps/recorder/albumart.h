@@ -36,6 +36,11 @@ bool find_albumart(const struct mp3entry *id3, char *buf, int buflen,
                     const struct dim *dim);
 
 #ifndef PLUGIN
+/* Like find_albumart() but only looks for bitmaps named after the track
+ * itself (./<trackname><size>.bmp and ./<trackname>.bmp) */
+bool find_track_albumart(const struct mp3entry *id3, char *buf, int buflen,
+                         const struct dim *dim);
+
 /* Draw the album art bitmap from the given handle ID onto the given Skin.
    Call with clear = true to clear the bitmap instead of drawing it. */
 void draw_album_art(struct gui_wps *gwps, int handle_id, bool clear);
@@ -0,0 +1,613 @@
+/***************************************************************************
+ *             __________               __   ___.
+ *   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+ *   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+ *   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+ *   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+ *                     \/            \/     \/    \/            \/
+ * $Id$
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ ****************************************************************************/
+
+#include <string.h>
+#include "config.h"
+#include "system.h"
+#include "kernel.h"
+#include "thread.h"
+#include "usb.h"
+#include "crc32.h"
+#include "file.h"
+#include "buffering.h"
+#include "albumart.h"
+#ifdef HAVE_JPEG
+#include "jpeg_load.h"
+#endif
+#include "skin_engine/skin_engine.h"
+#include "albumart_cache.h"
+
+/* Define LOGF_ENABLE to enable logf output in this file */
+/*#define LOGF_ENABLE*/
+#include "logf.h"
+
+struct albumart_cache_entry
+{
+    uint32_t hash;      /* crc of the key, to skip most compares */
+    struct dim dim;
+    size_t offset;      /* position of the key in cache_buf */
+    size_t key_size;    /* size of the key, the bitmap follows it */
+    size_t size;        /* size of struct bitmap + data, 0: album has no art */
+};
+
+/* What decides which picture a track gets: the directory (for the cover
+   files found there), album and artist, plus the size of the picture for
+   embedded art. Stored in cache_buf in front of the bitmap as the strings
+   with their terminators, followed by the picture size */
+struct albumart_cache_key
+{
+    const char *dir;
+    size_t dir_len;
+    const char *album;
+    const char *artist;
+    bool embedded;
+    off_t aa_size;
+};
+
+/* oldest entry first; the keys and bitmaps are stored in cache_buf in the
+   same order so evicting from the front keeps the data contiguous */
+static struct albumart_cache_entry entries[ALBUMART_CACHE_ENTRIES];
+static int num_entries;
+
+static char *cache_buf;
+static size_t cache_bufsize;
+static size_t cache_used;
+/* space at the end of cache_buf the prefetch thread is decoding into */
+static size_t cache_reserved;
+/* changes whenever the entries are dropped */
+static unsigned int cache_generation;
+
+static struct mutex cache_mutex SHAREDBSS_ATTR;
+/* held while decoding into the reserved space, so the memory isn't handed
+   to somebody else meanwhile */
+static struct mutex decode_mutex SHAREDBSS_ATTR;
+static bool cache_mutex_initialized = false;
+
+/* Prefetching reads the track's metadata and decodes its pictures, which
+   takes a while, so it's done by a thread of its own */
+#define PREFETCH_TRACK  1
+
+static struct event_queue prefetch_queue SHAREDBSS_ATTR;
+static long prefetch_stack[(DEFAULT_STACK_SIZE + 0x2000)/sizeof(long)];
+static const char prefetch_thread_name[] = "albumart prefetch";
+/* created with the first cache there is, none without one */
+static unsigned int prefetch_thread_id = 0;
+
+/* the track handed to the thread; only written while it's idle */
+static char prefetch_trackname[MAX_PATH];
+static struct dim prefetch_dims[SKINNABLE_SCREENS_COUNT];
+static int prefetch_count;
+static volatile bool prefetch_busy = false;
+
+/* crc of the last tracks handed to albumart_cache_prefetch(), so they aren't
+   read again every time playback is idle */
+static uint32_t prefetched[2*ALBUMART_PREFETCH_TRACKS];
+static unsigned int prefetched_next;
+
+static void make_key(struct albumart_cache_key *key,
+                     const struct mp3entry *id3, bool embedded)
+{
+    const char *sep = strrchr(id3->path, '/');
+
+    key->dir = id3->path;
+    key->dir_len = sep ? (size_t)(sep - id3->path) : 0;
+    key->album = id3->album ? id3->album : "";
+    key->artist = id3->albumartist ? id3->albumartist :
+                  id3->artist ? id3->artist : "";
+    /* the same picture embedded in every track has the same size; tracks
+       with differing pictures then just don't share the entry */
+    key->embedded = embedded;
+    key->aa_size = embedded ? id3->albumart.size : 0;
+}
+
+static size_t key_size(const struct albumart_cache_key *key)
+{
+    size_t size = key->dir_len + strlen(key->album) + strlen(key->artist) + 3;
+    if (key->embedded)
+        size += sizeof(key->aa_size);
+    return size;
+}
+
+static void key_write(const struct albumart_cache_key *key, char *p)
+{
+    memcpy(p, key->dir, key->dir_len);
+    p += key->dir_len;
+    *p++ = '\0';
+    size_t len = strlen(key->album) + 1;
+    memcpy(p, key->album, len);
+    p += len;
+    len = strlen(key->artist) + 1;
+    memcpy(p, key->artist, len);
+    p += len;
+    if (key->embedded)
+        memcpy(p, &key->aa_size, sizeof(key->aa_size));
+}
+
+static uint32_t key_hash(const struct albumart_cache_key *key)
+{
+    uint32_t hash = crc_32(key->dir, key->dir_len, 0xffffffff);
+    hash = crc_32(key->album, strlen(key->album), hash);
+    hash = crc_32(key->artist, strlen(key->artist), hash);
+    if (key->embedded)
+        hash = crc_32(&key->aa_size, sizeof(key->aa_size), hash);
+    return hash;
+}
+
+static bool key_matches(const struct albumart_cache_key *key,
+                        const struct albumart_cache_entry *e)
+{
+    const char *p = cache_buf + e->offset;
+    size_t len;
+
+    if (e->key_size != ALIGN_UP(key_size(key), sizeof (intptr_t)))
+        return false;
+
+    if (memcmp(p, key->dir, key->dir_len) || p[key->dir_len] != '\0')
+        return false;
+    p += key->dir_len + 1;
+
+    len = strlen(key->album) + 1;
+    if (memcmp(p, key->album, len))
+        return false;
+    p += len;
+
+    len = strlen(key->artist) + 1;
+    if (memcmp(p, key->artist, len))
+        return false;
+    p += len;
+
+    return !key->embedded ||
+           !memcmp(p, &key->aa_size, sizeof(key->aa_size));
+}
+
+static struct albumart_cache_entry * find_entry(
+        const struct albumart_cache_key *key, const struct dim *dim)
+{
+    uint32_t hash = key_hash(key);
+
+    for (int i = 0; i < num_entries; i++)
+    {
+        struct albumart_cache_entry *e = &entries[i];
+        if (e->hash == hash && e->dim.width == dim->width &&
+            e->dim.height == dim->height && key_matches(key, e))
+            return e;
+    }
+
+    return NULL;
+}
+
+/* Add an entry for the key at the end of the cache, with room for a bitmap
+   of the given size following the key. The caller has made room */
+static struct albumart_cache_entry * add_entry(
+        const struct albumart_cache_key *key, const struct dim *dim,
+        size_t size)
+{
+    struct albumart_cache_entry *e = &entries[num_entries++];
+    e->hash = key_hash(key);
+    e->dim = *dim;
+    e->offset = cache_used;
+    e->key_size = ALIGN_UP(key_size(key), sizeof (intptr_t));
+    e->size = size;
+    key_write(key, cache_buf + e->offset);
+    cache_used += e->key_size + size;
+    return e;
+}
+
+static void remove_entry(int index)
+{
+    size_t size = entries[index].key_size + entries[index].size;
+    size_t offset = entries[index].offset;
+
+    memmove(cache_buf + offset, cache_buf + offset + size,
+            cache_used - offset - size);
+    cache_used -= size;
+
+    for (int i = index + 1; i < num_entries; i++)
+        entries[i].offset -= size;
+
+    num_entries--;
+    memmove(&entries[index], &entries[index + 1],
+            (num_entries - index) * sizeof (entries[0]));
+}
+
+static void prefetch_thread(void);
+
+void albumart_cache_init(void *buf, size_t size)
+{
+    if (!cache_mutex_initialized)
+    {
+        mutex_init(&cache_mutex);
+        mutex_init(&decode_mutex);
+        cache_mutex_initialized = true;
+    }
+
+    if (buf && size > 0 && prefetch_thread_id == 0)
+    {
+        queue_init(&prefetch_queue, true);
+        prefetch_thread_id = create_thread(prefetch_thread, prefetch_stack,
+                                 sizeof(prefetch_stack), 0,
+                                 prefetch_thread_name
+                                 IF_PRIO(, PRIORITY_BACKGROUND) IF_COP(, CPU));
+    }
+
+    /* waits for a decode into the old memory to finish */
+    mutex_lock(&decode_mutex);
+    mutex_lock(&cache_mutex);
+
+    cache_buf = size > 0 ? buf : NULL;
+    cache_bufsize = cache_buf ? size : 0;
+    cache_used = 0;
+    cache_reserved = 0;
+    cache_generation++;
+    num_entries = 0;
+    memset(prefetched, 0, sizeof(prefetched));
+
+    mutex_unlock(&cache_mutex);
+    mutex_unlock(&decode_mutex);
+
+    logf("aacache: %lu bytes", (unsigned long)cache_bufsize);
+}
+
+void albumart_cache_flush(void)
+{
+    if (!cache_mutex_initialized)
+        return;
+
+    mutex_lock(&cache_mutex);
+    cache_used = 0;
+    cache_generation++;
+    num_entries = 0;
+    memset(prefetched, 0, sizeof(prefetched));
+    mutex_unlock(&cache_mutex);
+}
+
+bool albumart_cache_lookup(const struct mp3entry *id3, const struct dim *dim,
+                           bool embedded, int *hid)
+{
+    bool found = false;
+
+    if (!cache_buf)
+        return false;
+
+    mutex_lock(&cache_mutex);
+
+    struct albumart_cache_key key;
+    make_key(&key, id3, embedded);
+    struct albumart_cache_entry *e = find_entry(&key, dim);
+    if (e)
+    {
+        found = true;
+
+        if (e->size == 0)
+        {
+            logf("aacache: no art for %s", id3->path);
+            *hid = ERR_FILE_ERROR;
+        }
+        else
+        {
+            /* bufalloc points the copy's bitmap data to its new home */
+            *hid = bufalloc(cache_buf + e->offset + e->key_size, e->size,
+                            TYPE_BITMAP);
+            logf("aacache: hit %s (%d)", id3->path, *hid);
+        }
+    }
+
+    mutex_unlock(&cache_mutex);
+
+    return found;
+}
+
+void albumart_cache_store(const struct mp3entry *id3, const struct dim *dim,
+                          bool embedded, int hid)
+{
+    void *data = NULL;
+    ssize_t size = 0;
+
+    /* a full buffer says nothing about the album */
+    if (!cache_buf || hid == ERR_BUFFER_FULL)
+        return;
+
+    if (hid >= 0)
+    {
+        size = bufgetdata(hid, 0, &data);
+        if (size <= 0 || ALIGN_UP((size_t)size, sizeof (intptr_t)) > cache_bufsize)
+            return;
+    }
+
+    mutex_lock(&cache_mutex);
+
+    struct albumart_cache_key key;
+    make_key(&key, id3, embedded);
+    struct albumart_cache_entry *e = find_entry(&key, dim);
+    if (e)
+        remove_entry(e - entries);
+
+    size_t alloc_size = ALIGN_UP(size, sizeof (intptr_t)) +
+                        ALIGN_UP(key_size(&key), sizeof (intptr_t));
+
+    size_t limit = cache_bufsize - cache_reserved;
+
+    while (num_entries > 0 &&
+           (num_entries >= ALBUMART_CACHE_ENTRIES ||
+            cache_used + alloc_size > limit))
+    {
+        remove_entry(0);
+    }
+
+    if (cache_used + alloc_size <= limit)
+    {
+        e = add_entry(&key, dim, ALIGN_UP(size, sizeof (intptr_t)));
+        if (size > 0)
+            memcpy(cache_buf + e->offset + e->key_size, data, size);
+    }
+
+    mutex_unlock(&cache_mutex);
+
+    logf("aacache: stored %s (%ld bytes)", id3->path, (long)size);
+}
+
+/* Decode a bitmap into the end of the cache, then move it to its place.
+   Only the prefetch thread does this, and the cache stays usable meanwhile.
+   Failures aren't remembered, as they may just be down to the memory left,
+   so the regular load tries again.
+   Returns true if an entry for the album was added */
+static bool prefetch_decode(const struct albumart_cache_key *key,
+                            const struct dim *dim, const char *path,
+                            const struct mp3_albumart *aa)
+{
+    struct bitmap *bmp = NULL;
+    unsigned int generation;
+    size_t reserve;
+    bool added = false;
+    int fd, rc = -1;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    mutex_lock(&decode_mutex);
+    mutex_lock(&cache_mutex);
+
+    /* leave the decoder half of the cache to work in */
+    reserve = ALIGN_DOWN(cache_bufsize / 2, sizeof (intptr_t));
+    while (num_entries > 0 && cache_used > cache_bufsize - reserve)
+        remove_entry(0);
+
+    cache_reserved = reserve;
+    generation = cache_generation;
+
+    mutex_unlock(&cache_mutex);
+
+    int free = reserve - sizeof(struct bitmap);
+
+    if (free > 0)
+    {
+        bmp = (struct bitmap *)(cache_buf + cache_bufsize - reserve);
+        bmp->width = dim->width;
+        bmp->height = dim->height;
+        bmp->data = (unsigned char *)(bmp + 1);
+#if (LCD_DEPTH > 1) || defined(HAVE_REMOTE_LCD) && (LCD_REMOTE_DEPTH > 1)
+        bmp->maskdata = NULL;
+#endif
+
+#ifdef HAVE_JPEG
+        if (aa != NULL) {
+            lseek(fd, aa->pos, SEEK_SET);
+            rc = clip_jpeg_fd(fd, aa->size, bmp, free, FORMAT_NATIVE|
+                     FORMAT_DITHER|FORMAT_RESIZE|FORMAT_KEEP_ASPECT, NULL);
+        }
+        else if (strcmp(path + strlen(path) - 4, ".bmp"))
+            rc = read_jpeg_fd(fd, bmp, free, FORMAT_NATIVE|FORMAT_DITHER|
+                              FORMAT_RESIZE|FORMAT_KEEP_ASPECT, NULL);
+        else
+#endif
+            rc = read_bmp_fd(fd, bmp, free, FORMAT_NATIVE|FORMAT_DITHER|
+                             FORMAT_RESIZE|FORMAT_KEEP_ASPECT, NULL);
+    }
+    close(fd);
+    (void)aa;
+
+    mutex_lock(&cache_mutex);
+
+    cache_reserved = 0;
+
+    /* not if the entries were flushed meanwhile, the files may be new */
+    if (rc > 0 && generation == cache_generation &&
+        find_entry(key, dim) == NULL)
+    {
+        size_t ksize = ALIGN_UP(key_size(key), sizeof (intptr_t));
+        size_t size = ALIGN_UP(sizeof(struct bitmap) + rc, sizeof (intptr_t));
+
+        /* evicting only moves data that's below the bitmap */
+        while (num_entries > 0 &&
+               (num_entries >= ALBUMART_CACHE_ENTRIES ||
+                cache_used + ksize + size > cache_bufsize))
+        {
+            remove_entry(0);
+        }
+
+        if (cache_used + ksize + size <= cache_bufsize)
+        {
+            memmove(cache_buf + cache_used + ksize, bmp,
+                    sizeof(struct bitmap) + rc);
+            add_entry(key, dim, size);
+            added = true;
+        }
+    }
+
+    mutex_unlock(&cache_mutex);
+    mutex_unlock(&decode_mutex);
+
+    logf("aacache: prefetch %s: %d", path, rc);
+    return added;
+}
+
+/* Remember that the album has no art, like albumart_cache_store() does */
+static void prefetch_no_art(const struct albumart_cache_key *key,
+                            const struct dim *dim)
+{
+    size_t ksize = ALIGN_UP(key_size(key), sizeof (intptr_t));
+
+    mutex_lock(&cache_mutex);
+
+    if (find_entry(key, dim) == NULL)
+    {
+        size_t limit = cache_bufsize - cache_reserved;
+
+        while (num_entries > 0 &&
+               (num_entries >= ALBUMART_CACHE_ENTRIES ||
+                cache_used + ksize > limit))
+        {
+            remove_entry(0);
+        }
+
+        if (cache_used + ksize <= limit)
+            add_entry(key, dim, 0);
+    }
+
+    mutex_unlock(&cache_mutex);
+}
+
+static bool entry_cached(const struct albumart_cache_key *key,
+                         const struct dim *dim, bool *has_art)
+{
+    mutex_lock(&cache_mutex);
+    struct albumart_cache_entry *e = find_entry(key, dim);
+    if (e && has_art)
+        *has_art = e->size > 0;
+    mutex_unlock(&cache_mutex);
+    return e != NULL;
+}
+
+/* Runs in the prefetch thread */
+static void prefetch_track(const char *trackname, const struct dim *dims,
+                           int count)
+{
+    static struct mp3entry id3;
+    struct albumart_cache_key key;
+    char path[MAX_PATH];
+    int i, fd;
+
+    fd = open(trackname, O_RDONLY);
+    if (fd < 0)
+        return;
+
+    bool ok = get_metadata(&id3, fd, trackname);
+    close(fd);
+    if (!ok)
+        return;
+
+    /* the same lookups as audio_load_albumart() makes once the track gets
+       buffered */
+    for (i = 0; i < count; i++)
+    {
+        const struct dim *dim = &dims[i];
+        bool has_art = false;
+
+        if (id3.has_embedded_albumart && id3.albumart.type == AA_TYPE_JPG)
+        {
+            make_key(&key, &id3, true);
+            if (!entry_cached(&key, dim, &has_art))
+                has_art = prefetch_decode(&key, dim, id3.path, &id3.albumart);
+            if (has_art)
+                continue;
+        }
+
+        /* bitmaps for just this track are never cached */
+        if (find_track_albumart(&id3, path, sizeof(path), dim))
+            continue;
+
+        make_key(&key, &id3, false);
+        if (entry_cached(&key, dim, NULL))
+            continue;
+
+        if (find_albumart(&id3, path, sizeof(path), dim))
+            prefetch_decode(&key, dim, path, NULL);
+        else
+            prefetch_no_art(&key, dim);
+    }
+}
+
+static void prefetch_thread(void)
+{
+    struct queue_event ev;
+
+#ifdef HAVE_IO_PRIORITY
+    thread_set_io_priority(thread_self(), IO_PRIORITY_BACKGROUND);
+#endif
+
+    while (1)
+    {
+        queue_wait(&prefetch_queue, &ev);
+
+        switch (ev.id)
+        {
+            case PREFETCH_TRACK:
+                prefetch_track(prefetch_trackname, prefetch_dims,
+                               prefetch_count);
+                prefetch_busy = false;
+                break;
+
+            case SYS_USB_CONNECTED:
+                usb_acknowledge(SYS_USB_CONNECTED_ACK);
+                usb_wait_for_disconnect(&prefetch_queue);
+                break;
+        }
+    }
+}
+
+bool albumart_cache_prefetch(const char *trackname, const struct dim *dims,
+                             int count)
+{
+    bool found = false;
+    unsigned int i;
+
+    if (!cache_buf || prefetch_thread_id == 0)
+        return false;
+
+    if (prefetch_busy)
+        return true;
+
+    uint32_t name_key = crc_32(trackname, strlen(trackname), 0xffffffff);
+
+    mutex_lock(&cache_mutex);
+
+    for (i = 0; i < ARRAYLEN(prefetched); i++)
+    {
+        if (prefetched[i] == name_key)
+            found = true;
+    }
+
+    if (!found)
+        prefetched[prefetched_next++ % ARRAYLEN(prefetched)] = name_key;
+
+    mutex_unlock(&cache_mutex);
+
+    if (found)
+        return false;
+
+    strlcpy(prefetch_trackname, trackname, sizeof(prefetch_trackname));
+    prefetch_count = MIN(count, (int)ARRAYLEN(prefetch_dims));
+    memcpy(prefetch_dims, dims, prefetch_count * sizeof(prefetch_dims[0]));
+
+    prefetch_busy = true;
+    queue_post(&prefetch_queue, PREFETCH_TRACK, 0);
+
+    return true;
+}
@@ -0,0 +1,78 @@
+/***************************************************************************
+ *             __________               __   ___.
+ *   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+ *   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+ *   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+ *   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+ *                     \/            \/     \/    \/            \/
+ * $Id$
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ ****************************************************************************/
+
+#ifndef _ALBUMART_CACHE_H_
+#define _ALBUMART_CACHE_H_
+
+#include <stdbool.h>
+#include <sys/types.h>
+#include "config.h"
+#include "metadata.h"
+#include "bmp.h"
+
+/* Cache of decoded, already scaled album art, shared by all tracks of an
+ * album. Entries are keyed by the track's directory, album and artist (plus
+ * the size of the picture for embedded art) and by the requested size, so
+ * every %Cl size of every loaded skin gets its own entry. Lookups that found
+ * no art at all are remembered too, so the file probing is skipped for the
+ * next track of such an album.
+ *
+ * The memory is carved out of the audio buffer, so it goes away together
+ * with it when the buffer is shrunk or reset. */
+
+#if MEMORYSIZE > 2
+/* room for a couple of full screen covers, or many smaller ones */
+#define ALBUMART_CACHE_SIZE     (2*LCD_WIDTH*LCD_HEIGHT*FB_DATA_SZ)
+#else
+#define ALBUMART_CACHE_SIZE     0
+#endif
+#define ALBUMART_CACHE_ENTRIES  16
+/* how many of the tracks after the buffered ones get their art prefetched */
+#define ALBUMART_PREFETCH_TRACKS 4
+
+/* (Re)initialise the cache to use the given memory, dropping all entries.
+ * buf may be NULL to disable the cache */
+void albumart_cache_init(void *buf, size_t size);
+
+/* Drop all entries, e.g. because files may have changed */
+void albumart_cache_flush(void);
+
+/* Look up the album art for the track at the given size. embedded selects
+ * the track's embedded picture instead of the files next to it.
+ * Returns false if nothing is cached, otherwise *hid is set to a new
+ * buffering handle holding a copy of the bitmap, ERR_FILE_ERROR if it is
+ * known that there's no art or ERR_BUFFER_FULL if the copy didn't fit */
+bool albumart_cache_lookup(const struct mp3entry *id3, const struct dim *dim,
+                           bool embedded, int *hid);
+
+/* Remember the result of loading album art for the track. hid is the
+ * bitmap handle returned by bufopen(), or an error if no art could be
+ * found or decoded */
+void albumart_cache_store(const struct mp3entry *id3, const struct dim *dim,
+                          bool embedded, int hid);
+
+/* Have the album art of a track that isn't buffered yet decoded into the
+ * cache in the background, in all the given sizes, so it's there once the
+ * track is loaded. Each track is only read once until the cache is flushed.
+ * Returns true if the track was handed to the prefetch thread or that is
+ * still busy with the previous one, false if there was nothing to do */
+bool albumart_cache_prefetch(const char *trackname, const struct dim *dims,
+                             int count);
+
+#endif /* _ALBUMART_CACHE_H_ */
@@ -144,5 +144,7 @@ struct bitstream
 #define DHT       0x0020 /* with Definition of huffman tables */
 #define SOS       0x0040 /* with Start-of-Scan segment */
 #define DQT       0x0080 /* with definition of quantization table */
+#define SOF2      0x0100 /* with SOF2-Segment (progressive DCT) */
+#define EOI       0x0200 /* reached End-of-Image */
 
 #endif /* _JPEG_COMMON_H */
@@ -68,6 +68,22 @@ typedef uint8_t jpeg_pix_t;
 #endif
 #define IDCT_WS_SIZE (64 + TRANSPOSE_EXTRA_IDCT_WS + COLOR_EXTRA_IDCT_WS)
 
+/* Progressive mode: all scans have to be seen before the first block can be
+ * transformed, so the coefficients of the whole image are kept here. Only as
+ * many per block as the chosen IDCT size uses are stored, plus a mask of the
+ * ones that have become nonzero so far, which is all that the refinement
+ * scans need to know about the rest.
+ */
+struct coef_plane
+{
+    int16_t *coef; /* ncoef quantized coefficients per block, zig-zag order */
+    uint64_t *nonzero; /* per block mask of nonzero coefficients */
+    int ncoef; /* stored coefficients per block, 0 if unused */
+    int stride; /* blocks per row of the plane */
+    int w, h; /* blocks covering the component, for non-interleaved scans */
+    int hs, vs; /* sampling factors */
+};
+
 /* This can't be in jpeg_load.h because plugin.h includes it, and it conflicts
  * with the definition in jpeg_decoder.h
  */
@@ -85,7 +101,7 @@ struct jpeg
     int bitbuf_bits;
     int marker_ind;
     int marker_val;
-    unsigned char marker;
+    unsigned char marker; /* marker ending the entropy coded data, if seen */
     int x_size, y_size; /* size of image (can be less than block boundary) */
     int x_phys, y_phys; /* physical size, block aligned */
     int x_mbl; /* x dimension of MBL */
@@ -94,6 +110,7 @@ struct jpeg
     int restart_interval; /* number of MCUs between RSTm markers */
     int restart; /* blocks until next restart marker */
     int mcu_row; /* current row relative to first row of this row of MCUs */
+    int mcu_y; /* row of MCUs to decode next */
     unsigned char *out_ptr; /* pointer to current row to output */
     int cur_row; /* current row relative to top of image */
     int set_rows;
@@ -127,6 +144,12 @@ struct jpeg
     int subsample_x[3]; /* info per component */
     int subsample_y[3];
     bool resize;
+    bool progressive;
+    int scan_comps; /* components in the current scan */
+    int scan_ss, scan_se; /* spectral selection of the current scan */
+    int scan_ah, scan_al; /* successive approximation bit positions */
+    int eobrun; /* blocks left in the current end-of-band run */
+    struct coef_plane coef_planes[3];
     unsigned char buf[JPEG_READ_BUF_SIZE];
     struct img_part part;
 };
@@ -957,16 +980,21 @@ static int process_markers(struct jpeg* p_jpeg)
     int i, j, n;
     int ret = 0; /* returned flags */
 
-    while ((c = e_getc(p_jpeg, -1)))
+    while (p_jpeg->marker || (c = e_getc(p_jpeg, -1)))
     {
-        if (c != 0xFF) /* no marker? */
+        if (p_jpeg->marker)
+        {   /* already read at the end of the previous scan */
+            c = p_jpeg->marker;
+            p_jpeg->marker = 0;
+        }
+        else if (c != 0xFF) /* no marker? */
         {
             JDEBUGF("Non-marker data\n");
             jpeg_putc(p_jpeg);
             break; /* exit marker processing */
         }
-
-        c = e_getc(p_jpeg, -1);
+        else
+            c = e_getc(p_jpeg, -1);
         JDEBUGF("marker value %X\n",c);
         switch (c)
         {
@@ -976,10 +1004,12 @@ static int process_markers(struct jpeg* p_jpeg)
             jpeg_putc(p_jpeg);
             continue;
 
+        case 0xC2: /* SOF Huff  - Progressive DCT*/
         case 0xC0: /* SOF Huff  - Baseline DCT */
             {
                 JDEBUGF("SOF marker ");
-                ret |= SOF0;
+                p_jpeg->progressive = (c == 0xC2);
+                ret |= p_jpeg->progressive ? SOF2 : SOF0;
                 marker_size = e_getc(p_jpeg, -1) << 8; /* Highbyte */
                 marker_size |= e_getc(p_jpeg, -1); /* Lowbyte */
                 JDEBUGF("len: %d\n", marker_size);
@@ -1018,7 +1048,6 @@ static int process_markers(struct jpeg* p_jpeg)
             break;
 
         case 0xC1: /* SOF Huff  - Extended sequential DCT*/
-        case 0xC2: /* SOF Huff  - Progressive DCT*/
         case 0xC3: /* SOF Huff  - Spatial (sequential) lossless*/
         case 0xC5: /* SOF Huff  - Differential sequential DCT*/
         case 0xC6: /* SOF Huff  - Differential progressive DCT*/
@@ -1031,7 +1060,7 @@ static int process_markers(struct jpeg* p_jpeg)
         case 0xCE: /* SOF Arith - Differential progressive DCT*/
         case 0xCF: /* SOF Arith - Differential spatial*/
             {
-                return (-4); /* other DCT model than baseline not implemented */
+                return (-4); /* other DCT model not implemented */
             }
 
         case 0xC4: /* Define Huffman Table(s) */
@@ -1103,7 +1132,7 @@ static int process_markers(struct jpeg* p_jpeg)
             break;
         case 0xD9: /* End of Image */
             JDEBUGF("EOI\n");
-            break;
+            return (ret | EOI);
         case 0x01: /* for temp private use arith code */
             JDEBUGF("private\n");
             break; /* skip parameterless marker */
@@ -1117,11 +1146,13 @@ static int process_markers(struct jpeg* p_jpeg)
                 marker_size -= 2;
 
                 n = (marker_size-1-3)/2;
-                if (e_getc(p_jpeg, -1) != n || (n != 1 && n != 3))
+                if (e_getc(p_jpeg, -1) != n || (n != 1 && n != 3 &&
+                    !(p_jpeg->progressive && n == 2)))
                 {
                     return (-7); /* Unsupported SOS component specification */
                 }
                 marker_size--;
+                p_jpeg->scan_comps = n;
                 for (i=0; i<n; i++)
                 {
                     p_jpeg->scanheader[i].ID = e_getc(p_jpeg, -1);
@@ -1130,7 +1161,14 @@ static int process_markers(struct jpeg* p_jpeg)
                     p_jpeg->scanheader[i].AC_select = c & 0x0F;
                     marker_size -= 2;
                 }
-                /* skip spectral information */
+                /* spectral selection and successive approximation, only
+                   used in progressive mode */
+                p_jpeg->scan_ss = e_getc(p_jpeg, -1);
+                p_jpeg->scan_se = e_getc(p_jpeg, -1);
+                c = e_getc(p_jpeg, -1);
+                p_jpeg->scan_ah = c >> 4;
+                p_jpeg->scan_al = c & 0x0F;
+                marker_size -= 3;
                 e_skip_bytes(p_jpeg, marker_size);
             }
             break;
@@ -1567,12 +1605,15 @@ INLINE void fix_quant_tables(struct jpeg *p_jpeg)
 * is evaluated multiple times.
 */
 
-static void fill_bit_buffer(struct jpeg* p_jpeg)
+/* Fetch the next byte of entropy coded data. Any marker but RSTm ends the
+ * data: it is kept for process_markers() and zeroes are returned from then on.
+ */
+INLINE unsigned char get_entropy_byte(struct jpeg* p_jpeg, int ind)
 {
     unsigned char byte, marker;
 
-    if (p_jpeg->marker_val)
-        p_jpeg->marker_ind += 16;
+    if (UNLIKELY(p_jpeg->marker))
+        return 0;
     byte = d_getc(p_jpeg, 0);
     if (UNLIKELY(byte == 0xFF)) /* legal marker can be byte stuffing or RSTm */
     {   /* simplification: just skip the (one-byte) marker code */
@@ -1580,22 +1621,23 @@ static void fill_bit_buffer(struct jpeg* p_jpeg)
         if ((marker & ~7) == 0xD0)
         {
             p_jpeg->marker_val = marker;
-            p_jpeg->marker_ind = 8;
+            p_jpeg->marker_ind = ind;
         }
-    }
-    p_jpeg->bitbuf = (p_jpeg->bitbuf << 8) | byte;
-
-    byte = d_getc(p_jpeg, 0);
-    if (UNLIKELY(byte == 0xFF)) /* legal marker can be byte stuffing or RSTm */
-    {   /* simplification: just skip the (one-byte) marker code */
-        marker = d_getc(p_jpeg, 0);
-        if ((marker & ~7) == 0xD0)
+        else if (marker)
         {
-            p_jpeg->marker_val = marker;
-            p_jpeg->marker_ind = 0;
+            p_jpeg->marker = marker;
+            byte = 0;
         }
     }
-    p_jpeg->bitbuf = (p_jpeg->bitbuf << 8) | byte;
+    return byte;
+}
+
+static void fill_bit_buffer(struct jpeg* p_jpeg)
+{
+    if (p_jpeg->marker_val)
+        p_jpeg->marker_ind += 16;
+    p_jpeg->bitbuf = (p_jpeg->bitbuf << 8) | get_entropy_byte(p_jpeg, 8);
+    p_jpeg->bitbuf = (p_jpeg->bitbuf << 8) | get_entropy_byte(p_jpeg, 0);
     p_jpeg->bitbuf_bits += 16;
 #ifdef JPEG_BS_DEBUG
     DEBUGF("read in: %04X\n", p_jpeg->bitbuf & 0xFFFF);
@@ -1663,6 +1705,8 @@ static void search_restart(struct jpeg *p_jpeg)
     }
     unsigned char byte;
     p_jpeg->bitbuf_bits = 0;
+    if (p_jpeg->marker) /* no more entropy coded data */
+        return;
     while ((byte = d_getc(p_jpeg, 0xFF)))
     {
         if (byte == 0xff)
@@ -1672,12 +1716,32 @@ static void search_restart(struct jpeg *p_jpeg)
             {
                 return;
             }
+            else if (byte && byte != 0xFF)
+            {
+                p_jpeg->marker = byte;
+                return;
+            }
             else
                 jpeg_putc(p_jpeg);
         }
     }
 }
 
+/* progressive mode: skip whatever is left of the current scan, up to the
+   marker that follows it */
+static void skip_to_marker(struct jpeg *p_jpeg)
+{
+    unsigned char *c;
+    unsigned char last = 0;
+
+    while (!p_jpeg->marker && (c = jpeg_getc(p_jpeg)))
+    {
+        if (last == 0xFF && *c && *c != 0xFF && (*c & ~7) != 0xD0)
+            p_jpeg->marker = *c;
+        last = *c;
+    }
+}
+
 /* Figure F.12: extend sign bit. */
 #if CONFIG_CPU == SH7034
 /* SH1 lacks a variable-shift instruction */
@@ -1777,6 +1841,329 @@ static const int extend_offset[16] = /* entry n is (-1 << n) + 1 */
     } /* end slow decode */ \
 }
 
+/* Progressive mode decoding, Annex G.1.2: each scan adds a band of
+ * coefficients (scan_ss..scan_se) of one component, or the DC coefficients
+ * of several, at the bit position scan_al. Refinement scans (scan_ah != 0)
+ * then add one more bit to the coefficients already seen.
+ */
+#define NZ_BIT(k) ((uint64_t)1 << (k))
+
+INLINE void refine_coef(struct jpeg *p_jpeg, int16_t *coef, int ncoef, int k,
+                        int p1)
+{
+    check_bit_buffer(p_jpeg, 1);
+    if (get_bits(p_jpeg, 1) && k < ncoef && !(coef[k] & p1))
+        coef[k] += coef[k] >= 0 ? p1 : -p1;
+}
+
+static void decode_ac_first(struct jpeg *p_jpeg, struct derived_tbl *actbl,
+                            int16_t *coef, uint64_t *nonzero, int ncoef)
+{
+    int k, s, r;
+
+    if (p_jpeg->eobrun)
+    {
+        p_jpeg->eobrun--;
+        return;
+    }
+    for (k = p_jpeg->scan_ss; k <= p_jpeg->scan_se; k++)
+    {
+        huff_decode_ac(p_jpeg, actbl, s);
+        r = s >> 4;
+        s &= 15;
+        if (s)
+        {
+            k += r;
+            if (k > p_jpeg->scan_se) /* corrupt data */
+                break;
+            check_bit_buffer(p_jpeg, s);
+            r = get_bits(p_jpeg, s);
+            /* coefficients the IDCT doesn't use are only marked */
+            if (k < ncoef)
+                coef[k] = HUFF_EXTEND(r, s) << p_jpeg->scan_al;
+            *nonzero |= NZ_BIT(k);
+        }
+        else if (r == 15)
+            k += 15;
+        else
+        {   /* end of band for this and the next 2**r + bits - 1 blocks */
+            p_jpeg->eobrun = BIT_N(r) - 1;
+            if (r)
+            {
+                check_bit_buffer(p_jpeg, r);
+                p_jpeg->eobrun += get_bits(p_jpeg, r);
+            }
+            break;
+        }
+    }
+}
+
+static void decode_ac_refine(struct jpeg *p_jpeg, struct derived_tbl *actbl,
+                             int16_t *coef, uint64_t *nonzero, int ncoef)
+{
+    int p1 = BIT_N(p_jpeg->scan_al);
+    int k = p_jpeg->scan_ss;
+    int s, r;
+
+    if (!p_jpeg->eobrun)
+    {
+        for (; k <= p_jpeg->scan_se; k++)
+        {
+            huff_decode_ac(p_jpeg, actbl, s);
+            r = s >> 4;
+            s &= 15;
+            if (s)
+            {   /* newly nonzero coefficient, always of magnitude 1 */
+                check_bit_buffer(p_jpeg, 1);
+                s = get_bits(p_jpeg, 1) ? p1 : -p1;
+            }
+            else if (r != 15)
+            {   /* end of band, the rest is refined below */
+                p_jpeg->eobrun = BIT_N(r);
+                if (r)
+                {
+                    check_bit_buffer(p_jpeg, r);
+                    p_jpeg->eobrun += get_bits(p_jpeg, r);
+                }
+                break;
+            }
+            /* skip r zero coefficients, correcting nonzero ones on the way */
+            for (; k <= p_jpeg->scan_se; k++)
+            {
+                if (*nonzero & NZ_BIT(k))
+                    refine_coef(p_jpeg, coef, ncoef, k, p1);
+                else if (--r < 0)
+                    break;
+            }
+            if (s && k <= p_jpeg->scan_se)
+            {
+                if (k < ncoef)
+                    coef[k] = s;
+                *nonzero |= NZ_BIT(k);
+            }
+        }
+    }
+    if (p_jpeg->eobrun)
+    {
+        for (; k <= p_jpeg->scan_se; k++)
+        {
+            if (*nonzero & NZ_BIT(k))
+                refine_coef(p_jpeg, coef, ncoef, k, p1);
+        }
+        p_jpeg->eobrun--;
+    }
+}
+
+static void decode_prog_block(struct jpeg *p_jpeg, struct coef_plane *pl,
+                              int bx, int by, struct derived_tbl *dctbl,
+                              struct derived_tbl *actbl, int *dc_pred)
+{
+    int blk = by * pl->stride + bx;
+    int16_t *coef = pl->coef + blk * pl->ncoef;
+    int s, r;
+
+    if (p_jpeg->scan_ss == 0)
+    {
+        if (p_jpeg->scan_ah == 0)
+        {
+            huff_decode_dc(p_jpeg, dctbl, s, r);
+            s = HUFF_EXTEND(r, s);
+            *dc_pred += s;
+            if (pl->ncoef)
+                coef[0] = *dc_pred << p_jpeg->scan_al;
+        }
+        else
+        {
+            check_bit_buffer(p_jpeg, 1);
+            if (get_bits(p_jpeg, 1) && pl->ncoef)
+                coef[0] |= BIT_N(p_jpeg->scan_al);
+        }
+    }
+    else if (p_jpeg->scan_ah == 0)
+        decode_ac_first(p_jpeg, actbl, coef, pl->nonzero + blk, pl->ncoef);
+    else
+        decode_ac_refine(p_jpeg, actbl, coef, pl->nonzero + blk, pl->ncoef);
+}
+
+INLINE void prog_restart(struct jpeg *p_jpeg, int *dc_pred)
+{
+    if (p_jpeg->restart_interval && --p_jpeg->restart == 0)
+    {
+        p_jpeg->restart = p_jpeg->restart_interval;
+        search_restart(p_jpeg);
+        dc_pred[0] = dc_pred[1] = dc_pred[2] = 0;
+        p_jpeg->eobrun = 0;
+    }
+}
+
+static int decode_prog_scan(struct jpeg *p_jpeg)
+{
+    struct coef_plane *pl[3];
+    struct derived_tbl *dctbl[3], *actbl[3];
+    int dc_pred[3] = { 0, 0, 0 };
+    int comps = p_jpeg->blocks == 1 ? 1 : 3;
+    int n = p_jpeg->scan_comps;
+    bool needed = false;
+    int i, ci, x, y, bx, by;
+
+    if (p_jpeg->scan_ss > p_jpeg->scan_se || p_jpeg->scan_se > 63 ||
+        (p_jpeg->scan_ss == 0 && p_jpeg->scan_se != 0) ||
+        (p_jpeg->scan_ss != 0 && n != 1) || p_jpeg->scan_al > 13)
+        return -12; /* invalid progression parameters */
+
+    for (i = 0; i < n; i++)
+    {
+        for (ci = 0; ci < comps; ci++)
+            if (p_jpeg->frameheader[ci].ID == p_jpeg->scanheader[i].ID)
+                break;
+        if (ci == comps)
+            return -13; /* scan of unknown component */
+        if (p_jpeg->scanheader[i].DC_select > 1 ||
+            p_jpeg->scanheader[i].AC_select > 1)
+            return -5; /* Huffman table index out of range */
+        pl[i] = &p_jpeg->coef_planes[ci];
+        dctbl[i] = &p_jpeg->dc_derived_tbls[p_jpeg->scanheader[i].DC_select];
+        actbl[i] = &p_jpeg->ac_derived_tbls[p_jpeg->scanheader[i].AC_select];
+        /* AC bands of blocks that only need the DC coefficient, and all
+           of the components that aren't displayed, are never decoded */
+        if (pl[i]->ncoef > (p_jpeg->scan_ss ? 1 : 0))
+            needed = true;
+    }
+    JDEBUGF("scan: %d components, coefficients %d-%d, bits %d/%d%s\n", n,
+        p_jpeg->scan_ss, p_jpeg->scan_se, p_jpeg->scan_ah, p_jpeg->scan_al,
+        needed ? "" : ", skipped");
+
+    if (!needed)
+    {
+        skip_to_marker(p_jpeg);
+        return 0;
+    }
+
+    p_jpeg->bitbuf_bits = 0;
+    p_jpeg->marker_val = 0;
+    p_jpeg->marker_ind = 0;
+    p_jpeg->eobrun = 0;
+    p_jpeg->restart = p_jpeg->restart_interval;
+
+    if (n == 1)
+    {   /* non-interleaved, every block is an MCU of its own */
+        for (by = 0; by < pl[0]->h; by++)
+        {
+            for (bx = 0; bx < pl[0]->w; bx++)
+            {
+                decode_prog_block(p_jpeg, pl[0], bx, by, dctbl[0], actbl[0],
+                    dc_pred);
+                prog_restart(p_jpeg, dc_pred);
+            }
+            yield();
+        }
+    }
+    else
+    {
+        for (y = 0; y < p_jpeg->y_mbl; y++)
+        {
+            for (x = 0; x < p_jpeg->x_mbl; x++)
+            {
+                for (i = 0; i < n; i++)
+                {
+                    for (by = y * pl[i]->vs; by < (y + 1) * pl[i]->vs; by++)
+                        for (bx = x * pl[i]->hs; bx < (x + 1) * pl[i]->hs;
+                             bx++)
+                            decode_prog_block(p_jpeg, pl[i], bx, by, dctbl[i],
+                                actbl[i], &dc_pred[i]);
+                }
+                prog_restart(p_jpeg, dc_pred);
+            }
+            yield();
+        }
+    }
+
+    skip_to_marker(p_jpeg);
+    return 0;
+}
+
+/* Decode all scans of a progressive JPEG into the coefficient planes */
+static int decode_progressive(struct jpeg *p_jpeg)
+{
+    int status;
+
+    while (true)
+    {
+        status = decode_prog_scan(p_jpeg);
+        if (status < 0)
+            return status;
+        status = process_markers(p_jpeg);
+        /* a truncated file still gives a (blurred) picture */
+        if (status <= 0 || !(status & SOS))
+            return 0;
+        if (status & DHT)
+            fix_huff_tables(p_jpeg);
+    }
+}
+
+/* Set up the coefficient planes for progressive mode in the given buffer.
+ * Returns the space used, or -1 if it doesn't fit.
+ */
+static int init_coef_planes(struct jpeg *p_jpeg, char *buf, int size)
+{
+    int comps = p_jpeg->blocks == 1 ? 1 : 3;
+    int hmax = p_jpeg->frameheader[0].horizontal_sampling;
+    int vmax = p_jpeg->frameheader[0].vertical_sampling;
+    char *pos = buf;
+    int ci;
+
+    for (ci = 0; ci < comps; ci++)
+    {
+        struct coef_plane *pl = &p_jpeg->coef_planes[ci];
+        pl->hs = ci ? 1 : hmax;
+        pl->vs = ci ? 1 : vmax;
+        pl->stride = p_jpeg->x_mbl * pl->hs;
+        pl->w = ((p_jpeg->x_size * pl->hs + hmax - 1) / hmax + 7) / 8;
+        pl->h = ((p_jpeg->y_size * pl->vs + vmax - 1) / vmax + 7) / 8;
+#ifdef HAVE_LCD_COLOR
+        pl->ncoef = p_jpeg->k_need[!!ci] + 1;
+#else
+        pl->ncoef = ci ? 0 : p_jpeg->k_need[0] + 1;
+#endif
+        int blocks = pl->stride * p_jpeg->y_mbl * pl->vs;
+        if (pl->ncoef > 1)
+        {
+            pl->nonzero = (uint64_t *)pos;
+            pos += blocks * sizeof(uint64_t);
+        }
+        pl->coef = (int16_t *)pos;
+        pos += ALIGN_UP(blocks * pl->ncoef * sizeof(int16_t),
+            sizeof(uint64_t));
+        JDEBUGF("component %d: %d coefficients of %dx%d blocks\n", ci,
+            pl->ncoef, pl->w, pl->h);
+    }
+    if (pos - buf > size)
+        return -1;
+    memset(buf, 0, pos - buf);
+    return pos - buf;
+}
+
+/* Progressive mode: fetch a block for the IDCT from the coefficient planes */
+static void load_block(struct jpeg *p_jpeg, int16_t *block, int ci, int x,
+                       int blkn, const unsigned char *order)
+{
+    struct coef_plane *pl = &p_jpeg->coef_planes[ci];
+    /* the luma blocks come first in an MCU, in raster order */
+    int bx = x * pl->hs + (ci ? 0 : blkn & (pl->hs - 1));
+    int by = p_jpeg->mcu_y * pl->vs + (ci ? 0 : blkn >> (pl->hs - 1));
+    int16_t *coef = pl->coef + (by * pl->stride + bx) * pl->ncoef;
+    int16_t *quant = p_jpeg->quanttable[!!ci];
+    int k;
+
+    block[0] = MULTIPLY16(coef[0], quant[0]);
+    MEMSET(block+1, 0, p_jpeg->zero_need[!!ci] * sizeof(int));
+    for (k = 1; k < pl->ncoef; k++)
+    {
+        if (coef[k])
+            block[order[k]] = MULTIPLY16(coef[k], quant[k]);
+    }
+}
+
 static struct img_part *store_row_jpeg(void *jpeg_args)
 {
     struct jpeg *p_jpeg = (struct jpeg*) jpeg_args;
@@ -1823,6 +2210,20 @@ static struct img_part *store_row_jpeg(void *jpeg_args)
                 struct derived_tbl* dctbl = &p_jpeg->dc_derived_tbls[ti];
                 struct derived_tbl* actbl = &p_jpeg->ac_derived_tbls[ti];
 
+                if (p_jpeg->progressive)
+                {
+#ifndef HAVE_LCD_COLOR
+                    if (!ci)
+#endif
+#ifdef JPEG_IDCT_TRANSPOSE
+                        load_block(p_jpeg, block, ci, x, blkn,
+                            transpose ? zag : zag + 64);
+#else
+                        load_block(p_jpeg, block, ci, x, blkn, zag);
+#endif
+                    goto block_end;
+                }
+
                 /* Section F.2.2.1: decode the DC coefficient difference */
                 huff_decode_dc(p_jpeg, dctbl, s, r);
 
@@ -1854,7 +2255,7 @@ static struct img_part *store_row_jpeg(void *jpeg_args)
                         if (s)
                         {
                             check_bit_buffer(p_jpeg, s);
-                            if (k >= p_jpeg->k_need[!!ci])
+                            if (k > p_jpeg->k_need[!!ci])
                                 goto skip_rest;
                             r = get_bits(p_jpeg, s);
                             r = HUFF_EXTEND(r, s);
@@ -1937,6 +2338,8 @@ block_end:
             }
 #endif
             out += mcu_offset;
+            if (p_jpeg->progressive)
+                continue;
             if (p_jpeg->restart_interval && --p_jpeg->restart == 0)
             {   /* if a restart marker is due: */
                 p_jpeg->restart = p_jpeg->restart_interval; /* count again */
@@ -1949,6 +2352,7 @@ block_end:
 #endif
             }
         }
+        p_jpeg->mcu_y++;
     } /* if !p_jpeg->mcu_row */
     p_jpeg->mcu_row = (p_jpeg->mcu_row + 1) & (height - 1);
     p_jpeg->part.len = width;
@@ -2022,7 +2426,7 @@ int get_jpeg_dim_mem(unsigned char *data, unsigned long len,
     int status = process_markers(p_jpeg);
     if (status < 0)
         return status;
-    if ((status & (DQT | SOF0)) != (DQT | SOF0))
+    if (!(status & DQT) || !(status & (SOF0 | SOF2)))
         return -(status * 16);
     size->width = p_jpeg->x_size;
     size->height = p_jpeg->y_size;
@@ -2070,7 +2474,7 @@ int clip_jpeg_fd(int fd,
 #endif
     if (status < 0)
         return status;
-    if ((status & (DQT | SOF0)) != (DQT | SOF0))
+    if (!(status & DQT) || !(status & (SOF0 | SOF2)))
         return -(status * 16);
     if (!(status & DHT)) /* if no Huffman table present: */
         default_huff_tbl(p_jpeg); /* use default */
@@ -2175,6 +2579,18 @@ int clip_jpeg_fd(int fd,
     buf_start += decode_buf_size;
     maxsize = buf_end - buf_start;
     memset(p_jpeg->img_buf, 0, decode_buf_size);
+    if (p_jpeg->progressive)
+    {
+        ALIGN_BUFFER(buf_start, maxsize, sizeof(uint64_t));
+        int coef_size = init_coef_planes(p_jpeg, buf_start, maxsize);
+        if (coef_size < 0)
+            return -1;
+        buf_start += coef_size;
+        maxsize = buf_end - buf_start;
+        status = decode_progressive(p_jpeg);
+        if (status < 0)
+            return status;
+    }
     p_jpeg->mcu_row = 0;
     p_jpeg->restart = p_jpeg->restart_interval;
     rset.rowstart = 0;
@@ -78,6 +78,32 @@
 #define CHANNEL_BYTES (sizeof(uint32_t)/sizeof(uint32_t)) /* packed */
 #endif
 
+/* On targets with 128-bit vector registers the four channels of a
+   struct uint32_argb are scaled as one vector. All the scaler math is done
+   modulo 2^32 per channel, so this is bit-exact with the C code. Define
+   SCALER_NO_SIMD to build the C version instead.
+*/
+#if defined(HAVE_LCD_COLOR) && !defined(CPU_COLDFIRE) && \
+    !defined(SCALER_NO_SIMD) && (defined(__SSE2__) || defined(__ARM_NEON__)) \
+    && !defined(__clang__) && __GNUC__ >= 9
+#define SCALER_SIMD
+typedef uint32_t v4u32 __attribute__((vector_size(16)));
+/* struct uint32_argb and the row buffers are only 32-bit aligned */
+typedef uint32_t v4u32_u __attribute__((vector_size(16), aligned(4)));
+typedef uint8_t v4u8_u __attribute__((vector_size(4), aligned(1)));
+#define V4(p) (*(v4u32_u *)(p))
+/* widen a struct uint8_rgb, which leaves the channels in b, g, r, a order */
+#define V4_PX(px) __builtin_convertvector(*(const v4u8_u *)(px), v4u32)
+/* swap to the r, g, b, a order of struct uint32_argb */
+#define V4_RGBA(v) __builtin_shuffle(v, (v4u32){ 2, 1, 0, 3 })
+/* the vertical scalers step through their rows a pixel at a time */
+#define ROW_STEP 4
+#define ROW_V(p) V4(p)
+#else
+#define ROW_STEP 1
+#define ROW_V(p) (*(p))
+#endif
+
 /* calculate the maximum dimensions which will preserve the aspect ration of
    src while fitting in the constraints passed in dst, and store result in dst,
    returning 0 if rounding and 1 if not rounding.
@@ -178,7 +204,11 @@ static bool scale_h_area(void *out_line_ptr,
     const uint32_t h_i_val = ctx->h_i_val,
                    h_o_val = ctx->h_o_val;
 #endif
-#ifdef HAVE_LCD_COLOR
+#if defined(SCALER_SIMD)
+    v4u32 rgbvalacc = { 0, 0, 0, 0 },
+          rgbvaltmp = { 0, 0, 0, 0 };
+    struct uint32_argb *out_line = (struct uint32_argb *)out_line_ptr;
+#elif defined(HAVE_LCD_COLOR)
     struct uint32_argb rgbvalacc = { 0, 0, 0, 0 },
                        rgbvaltmp = { 0, 0, 0, 0 },
                       *out_line = (struct uint32_argb *)out_line_ptr;
@@ -198,7 +228,35 @@ static bool scale_h_area(void *out_line_ptr,
         /* end of current area has been reached */
         /* fill buffer if needed */
         FILL_BUF(part,ctx->store_part,ctx->args);
-#ifdef HAVE_LCD_COLOR
+#if defined(SCALER_SIMD)
+        if (oxe >= h_i_val)
+        {
+            /* "reset" error, which now represents partial coverage of next
+               pixel by the next area
+            */
+            oxe -= h_i_val;
+            /* add saved partial pixel from start of area */
+            rgbvalacc = rgbvalacc * h_o_val + rgbvaltmp * mul;
+
+            /* get new pixel , then add its partial coverage to this area */
+            rgbvaltmp = V4_PX(part->buf);
+            mul = h_o_val - oxe;
+            rgbvalacc += rgbvaltmp * mul;
+            /* round, divide, and either store or accumulate to output row */
+            rgbvalacc = V4_RGBA((rgbvalacc + (1 << 21)) >> 22);
+            if (accum)
+                rgbvalacc += V4(&out_line[ox]);
+            V4(&out_line[ox]) = rgbvalacc;
+            /* reset accumulator */
+            rgbvalacc = (v4u32){ 0, 0, 0, 0 };
+            mul = oxe;
+            ox += 1;
+        /* inside an area */
+        } else {
+            /* add pixel value to accumulator */
+            rgbvalacc += V4_PX(part->buf);
+        }
+#elif defined(HAVE_LCD_COLOR)
         if (oxe >= h_i_val)
         {
             /* "reset" error, which now represents partial coverage of next
@@ -376,8 +434,9 @@ static inline bool scale_v_area(struct rowset *rset, struct scaler_context *ctx)
             oye -= v_i_val;
             /* add stored partial row to accumulator */
             for(rowacc_px = rowacc, rowtmp_px = rowtmp; rowacc_px != rowtmp;
-                rowacc_px++, rowtmp_px++)
-                *rowacc_px = *rowacc_px * v_o_val + *rowtmp_px * mul;
+                rowacc_px += ROW_STEP, rowtmp_px += ROW_STEP)
+                ROW_V(rowacc_px) = ROW_V(rowacc_px) * v_o_val +
+                                   ROW_V(rowtmp_px) * mul;
             /* store new scaled row in temp row */
             if(!ctx->h_scaler(rowtmp, ctx, false))
                 return false;
@@ -386,8 +445,8 @@ static inline bool scale_v_area(struct rowset *rset, struct scaler_context *ctx)
             */
             mul = v_o_val - oye;
             for(rowacc_px = rowacc, rowtmp_px = rowtmp; rowacc_px != rowtmp;
-                rowacc_px++, rowtmp_px++)
-                *rowacc_px += mul * *rowtmp_px;
+                rowacc_px += ROW_STEP, rowtmp_px += ROW_STEP)
+                ROW_V(rowacc_px) += ROW_V(rowtmp_px) * mul;
             ctx->output_row(oy, (void*)rowacc, ctx);
             /* clear accumulator row, store partial coverage for next row */
             memset((void *)rowacc, 0, ctx->bm->width * sizeof(uint32_t) * CHANNEL_BYTES);
@@ -420,7 +479,10 @@ static bool scale_h_linear(void *out_line_ptr, struct scaler_context *ctx,
        values are conditionally initialized before use, but other values are
        set such that this will occur before these are used.
     */
-#ifdef HAVE_LCD_COLOR
+#if defined(SCALER_SIMD)
+    v4u32 rgbval=rgbval, rgbinc=rgbinc;
+    struct uint32_argb *out_line = (struct uint32_argb*)out_line_ptr;
+#elif defined(HAVE_LCD_COLOR)
     struct uint32_argb rgbval=rgbval, rgbinc=rgbinc,
                       *out_line = (struct uint32_argb*)out_line_ptr;
 #else
@@ -436,7 +498,39 @@ static bool scale_h_linear(void *out_line_ptr, struct scaler_context *ctx,
     yield();
     for (ox = 0; ox < (uint32_t)ctx->bm->width; ox++)
     {
-#ifdef HAVE_LCD_COLOR
+#if defined(SCALER_SIMD)
+        if (ixe >= h_o_val)
+        {
+            /* Store the new "current" pixel value in rgbval, and the color
+               step value in rgbinc.
+            */
+            ixe -= h_o_val;
+            rgbval = V4_RGBA(V4_PX(part->buf));
+            rgbinc = -rgbval;
+            rgbval *= h_o_val;
+            ix += 1;
+            /* If this wasn't the last pixel, add the next one to rgbinc. */
+            if (LIKELY(ix < (uint32_t)ctx->src->width)) {
+                part->buf++;
+                part->len--;
+                /* Fetch new pixels if needed */
+                FILL_BUF(part,ctx->store_part,ctx->args);
+                rgbinc += V4_RGBA(V4_PX(part->buf));
+                /* Add a partial step to rgbval, in this pixel isn't precisely
+                   aligned with the new source pixel
+                */
+                rgbval += rgbinc * ixe;
+            }
+            /* Now multiply the color increment to its proper value */
+            rgbinc *= h_i_val;
+        } else
+            rgbval += rgbinc;
+        /* round and scale values, and accumulate or store to output */
+        if (accum)
+            V4(&out_line[ox]) += (rgbval + (1 << 21)) >> 22;
+        else
+            V4(&out_line[ox]) = (rgbval + (1 << 21)) >> 22;
+#elif defined(HAVE_LCD_COLOR)
         if (ixe >= h_o_val)
         {
             /* Store the new "current" pixel value in rgbval, and the color
@@ -631,27 +725,29 @@ static inline bool scale_v_linear(struct rowset *rset,
             iye -= v_o_val;
             iy += 1;
             for(rowinc_px = rowinc, rowtmp_px = rowtmp, rowval_px = rowval;
-                rowinc_px < rowval; rowinc_px++, rowtmp_px++, rowval_px++)
+                rowinc_px < rowval; rowinc_px += ROW_STEP,
+                rowtmp_px += ROW_STEP, rowval_px += ROW_STEP)
             {
-                *rowinc_px = -*rowtmp_px;
-                *rowval_px = *rowtmp_px * v_o_val;
+                ROW_V(rowinc_px) = -ROW_V(rowtmp_px);
+                ROW_V(rowval_px) = ROW_V(rowtmp_px) * v_o_val;
             }
             if (iy < (uint32_t)ctx->src->height)
             {
                 if (!ctx->h_scaler((void*)rowtmp, ctx, false))
                     return false;
                 for(rowinc_px = rowinc, rowtmp_px = rowtmp, rowval_px = rowval;
-                    rowinc_px < rowval; rowinc_px++, rowtmp_px++, rowval_px++)
+                    rowinc_px < rowval; rowinc_px += ROW_STEP,
+                    rowtmp_px += ROW_STEP, rowval_px += ROW_STEP)
                 {
-                    *rowinc_px += *rowtmp_px;
-                    *rowval_px += *rowinc_px * iye;
-                    *rowinc_px *= v_i_val;
+                    ROW_V(rowinc_px) += ROW_V(rowtmp_px);
+                    ROW_V(rowval_px) += ROW_V(rowinc_px) * iye;
+                    ROW_V(rowinc_px) *= v_i_val;
                 }
             }
         } else
             for(rowinc_px = rowinc, rowval_px = rowval; rowinc_px < rowval;
-                rowinc_px++, rowval_px++)
-                *rowval_px += *rowinc_px;
+                rowinc_px += ROW_STEP, rowval_px += ROW_STEP)
+                ROW_V(rowval_px) += ROW_V(rowinc_px);
         ctx->output_row(oy, (void*)rowval, ctx);
         iye += v_i_val;
     }
@@ -659,6 +755,50 @@ static inline bool scale_v_linear(struct rowset *rset,
 }
 #endif /* HAVE_UPSCALER */
 
+#if defined(HAVE_LCD_COLOR) && LCD_DEPTH > 1
+/* dither offsets for one output row, they repeat every 16 columns */
+static inline void dither_row(uint8_t *delta, bool dither, uint8_t dy)
+{
+    int i;
+    for (i = 0; i < 16; i++)
+        delta[i] = dither ? DITHERXDY(i, dy) : 127;
+}
+
+/* round and scale the colour channels of an accumulated pixel */
+static inline void sc_out_rgb(const struct uint32_argb *qp,
+                              struct scaler_context *ctx,
+                              unsigned *r, unsigned *g, unsigned *b)
+{
+#ifdef SCALER_SIMD
+    v4u32 q = SC_OUT(V4(qp), ctx);
+    *r = q[0];
+    *g = q[1];
+    *b = q[2];
+#else
+    *r = SC_OUT(qp->r, ctx);
+    *g = SC_OUT(qp->g, ctx);
+    *b = SC_OUT(qp->b, ctx);
+#endif
+    (void)ctx;
+}
+
+#if LCD_DEPTH < 24
+/* dither and pack one pixel. R and B use the same math, so they are done
+   side by side in the two halves of one word, none of the intermediate
+   values come near 16 bits.
+*/
+static inline fb_data pack_lcd(unsigned r, unsigned g, unsigned b,
+                               unsigned delta)
+{
+    uint32_t rb = (r << 16) | b;
+    rb = (31 * rb + ((rb >> 3) & 0x001f001f) + delta * 0x00010001) >> 8;
+    return FB_RGBPACK_LCD(rb >> 16, PACKG(g, delta), rb & 0x1f);
+}
+#else
+#define pack_lcd(r, g, b, delta) ((void)(delta), FB_RGBPACK_LCD(r, g, b))
+#endif
+#endif /* HAVE_LCD_COLOR */
+
 #if defined(HAVE_LCD_COLOR) && (defined(HAVE_JPEG) || defined(PLUGIN))
 static void output_row_32_native_fromyuv(uint32_t row, void * row_in,
                                struct scaler_context *ctx)
@@ -672,28 +812,17 @@ static void output_row_32_native_fromyuv(uint32_t row, void * row_in,
 #endif
 
     int col;
-    uint8_t dy = DITHERY(row);
+    uint8_t delta[16];
     struct uint32_argb *qp = (struct uint32_argb *)row_in;
     SDEBUGF("output_row: y: %lu in: %p\n",row, row_in);
     fb_data *dest = (fb_data *)ctx->bm->data + Y_STEP * row;
-    int delta = 127;
     unsigned r, g, b, y, u, v;
-    
+
+    dither_row(delta, ctx->dither, DITHERY(row));
     for (col = 0; col < ctx->bm->width; col++) {
-        (void) delta;
-        if (ctx->dither)
-            delta = DITHERXDY(col,dy);
-        y = SC_OUT(qp->b, ctx);
-        u = SC_OUT(qp->g, ctx);
-        v = SC_OUT(qp->r, ctx);
-        qp++;
+        sc_out_rgb(qp++, ctx, &v, &u, &y);
         yuv_to_rgb(y, u, v, &r, &g, &b);
-#if LCD_DEPTH < 24
-        r = (31 * r + (r >> 3) + delta) >> 8;
-        g = (63 * g + (g >> 2) + delta) >> 8;
-        b = (31 * b + (b >> 3) + delta) >> 8;
-#endif
-        *dest = FB_RGBPACK_LCD(r, g, b);
+        *dest = pack_lcd(r, g, b, delta[col & 15]);
         dest += DEST_STEP;
     }
 }
@@ -772,39 +901,27 @@ static void output_row_32_native(uint32_t row, void * row_in,
                 (void)fb_width;
                 fb_data *dest = STRIDE_MAIN((fb_data *)ctx->bm->data + fb_width * row,
                                             (fb_data *)ctx->bm->data + row);
-                int delta = 127;
+                const int dest_step = STRIDE_MAIN(1, ctx->bm->height);
+                uint8_t delta[16];
                 unsigned r, g, b;
-                struct uint32_argb q0;
-                /* setup alpha channel buffer */
-                unsigned char *bm_alpha = NULL;
-                if (ctx->bm->alpha_offset > 0)
-                    bm_alpha = ctx->bm->data + ctx->bm->alpha_offset;
-                if (bm_alpha)
-                    bm_alpha += ALIGN_UP(ctx->bm->width, 2)*row/2;
 
+                dither_row(delta, ctx->dither, dy);
                 for (col = 0; col < ctx->bm->width; col++) {
-                    (void) delta;
-                    if (ctx->dither)
-                        delta = DITHERXDY(col,dy);
-                    q0 = *qp++;
-                    r = SC_OUT(q0.r, ctx);
-                    g = SC_OUT(q0.g, ctx);
-                    b = SC_OUT(q0.b, ctx);
-#if LCD_DEPTH < 24
-                    r = (31 * r + (r >> 3) + delta) >> 8;
-                    g = (63 * g + (g >> 2) + delta) >> 8;
-                    b = (31 * b + (b >> 3) + delta) >> 8;
-#endif
-                    *dest = FB_RGBPACK_LCD(r, g, b);
-                    dest += STRIDE_MAIN(1, ctx->bm->height);
-                    if (bm_alpha) {
-                        /* pack alpha channel for 2 pixels into 1 byte */
-                        unsigned alpha = SC_OUT(q0.a, ctx);
-                        if (col%2)
-                            *bm_alpha++ |= alpha&0xf0;
-                        else
-                            *bm_alpha = alpha>>4;
-                    }
+                    sc_out_rgb(&qp[col], ctx, &r, &g, &b);
+                    *dest = pack_lcd(r, g, b, delta[col & 15]);
+                    dest += dest_step;
+                }
+
+                /* pack alpha channel for 2 pixels into 1 byte */
+                if (ctx->bm->alpha_offset > 0) {
+                    unsigned char *bm_alpha = ctx->bm->data +
+                                              ctx->bm->alpha_offset +
+                                              ALIGN_UP(ctx->bm->width, 2)*row/2;
+                    for (col = 0; col < ctx->bm->width - 1; col += 2)
+                        *bm_alpha++ = (SC_OUT(qp[col].a, ctx) >> 4) |
+                                      (SC_OUT(qp[col + 1].a, ctx) & 0xf0);
+                    if (col < ctx->bm->width)
+                        *bm_alpha = SC_OUT(qp[col].a, ctx) >> 4;
                 }
 #endif /* LCD_DEPTH */
 }
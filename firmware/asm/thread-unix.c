@@ -60,12 +60,6 @@ static struct ctx * alloc_thread_buf(void)
     return &thread_bufs[bufidx];
 }
 
-static void free_thread_buf(struct ctx *threadbuf)
-{
-    unsigned int bufidx = threadbuf - thread_bufs;
-    threadbit_set_bit(&free_thread_bufs, bufidx);
-}
-
 /* The *_context functions are heavily based on Gnu pth
  * http://www.gnu.org/software/pth/
  *
@@ -247,7 +241,6 @@ void bootstrap_context(void)
      */
     thread_entry();
     DEBUGF("thread left\n");
-    free_thread_buf(t);
     thread_exit();
 }
 
@@ -294,7 +287,10 @@ static void init_main_thread(void *addr)
 static void setup_thread(struct regs *context)
 {
     void (*fn)(void) = context->start;
-    context->uc = alloc_thread_buf();
+    /* the context stays with the thread slot, as threads may exit without
+     * returning here */
+    if (context->uc == NULL)
+        context->uc = alloc_thread_buf();
     while (!make_context(context->uc, fn, (char*)context->stack, context->stack_size))
         DEBUGF("Thread creation failed. Retrying");
 }
@@ -319,11 +315,15 @@ static inline void store_context(void* addr)
 static inline void load_context(const void* addr)
 {
     struct regs *r = (struct regs*)addr;
+    /* take it now: a thread that is just starting doesn't return here, and
+     * an exiting thread that has nothing stored mustn't save itself over
+     * the context left behind */
+    struct ctx *old = target_context;
+    target_context = NULL;
     if (UNLIKELY(r->start))
     {
         setup_thread(r);
         r->start = NULL;
     }
-    swap_context(target_context, r->uc);
-    target_context = NULL;
+    swap_context(old, r->uc);
 }
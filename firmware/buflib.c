@@ -102,6 +102,113 @@ static union buflib_data* find_first_free(struct buflib_context *ctx);
 static union buflib_data* find_block_before(struct buflib_context *ctx,
                                             union buflib_data* block,
                                             bool is_free);
+
+/* Free blocks are kept in per size class lists so that allocation doesn't
+ * need to walk the whole buffer. A listed free block stores the offsets of
+ * its list neighbours after the length marker:
+ * |-L|next|prev|YYYYYYY|
+ * Smaller free blocks can't hold that; they are too small to be of use for
+ * an allocation anyway and wait for a merge or compaction. */
+#define FREE_LIST_MIN_LEN 3
+
+static inline int free_class(intptr_t len)
+{
+    int class = 0;
+    for (len >>= 3; len && class < BUFLIB_FREE_CLASSES - 1; len >>= 1)
+        class++;
+    return class;
+}
+
+static void free_list_add(struct buflib_context *ctx, union buflib_data *block)
+{
+    intptr_t len = -block->val;
+    if (!ctx->free_lists_valid || len < FREE_LIST_MIN_LEN)
+        return;
+
+    int class = free_class(len);
+    intptr_t offset = block - ctx->buf_start;
+    intptr_t head = ctx->free_list[class];
+
+    block[1].val = head;
+    block[2].val = -1;
+    if (head >= 0)
+        ctx->buf_start[head + 2].val = offset;
+    ctx->free_list[class] = offset;
+    ctx->free_classes |= 1u << class;
+}
+
+/* must be called before the block's length changes */
+static void free_list_remove(struct buflib_context *ctx,
+                             union buflib_data *block)
+{
+    intptr_t len = -block->val;
+    if (!ctx->free_lists_valid || len < FREE_LIST_MIN_LEN)
+        return;
+
+    int class = free_class(len);
+    intptr_t next = block[1].val, prev = block[2].val;
+
+    if (prev >= 0)
+        ctx->buf_start[prev + 1].val = next;
+    else
+        ctx->free_list[class] = next;
+    if (next >= 0)
+        ctx->buf_start[next + 2].val = prev;
+    if (ctx->free_list[class] < 0)
+        ctx->free_classes &= ~(1u << class);
+}
+
+static void free_lists_rebuild(struct buflib_context *ctx)
+{
+    union buflib_data *block;
+
+    for (int i = 0; i < BUFLIB_FREE_CLASSES; i++)
+        ctx->free_list[i] = -1;
+    ctx->free_classes = 0;
+    ctx->free_lists_valid = true;
+
+    for (block = ctx->buf_start; block < ctx->alloc_end;
+         block += abs(block->val))
+    {
+        if (block->val < 0)
+            free_list_add(ctx, block);
+    }
+}
+
+/* Find and unlink a free block of at least size units. Blocks of size's own
+ * class are tried first so the larger ones are left for larger allocations,
+ * otherwise any block of the smallest larger class fits. Returns NULL if only
+ * the space at alloc_end is left */
+static union buflib_data*
+find_free_block(struct buflib_context *ctx, size_t size)
+{
+    union buflib_data *block = NULL;
+    int class = free_class(size);
+    uint32_t larger;
+    intptr_t offset;
+
+    if (!ctx->free_lists_valid)
+        free_lists_rebuild(ctx);
+
+    for (offset = ctx->free_list[class]; offset >= 0;
+         offset = ctx->buf_start[offset + 1].val)
+    {
+        if ((size_t)-ctx->buf_start[offset].val >= size)
+        {
+            block = ctx->buf_start + offset;
+            break;
+        }
+    }
+
+    larger = ctx->free_classes & ~((2u << class) - 1);
+    if (!block && larger)
+        block = ctx->buf_start + ctx->free_list[find_first_set_bit(larger)];
+
+    if (block)
+        free_list_remove(ctx, block);
+    return block;
+}
+
 /* Initialize buffer manager */
 void
 buflib_init(struct buflib_context *ctx, void *buf, size_t size)
@@ -123,6 +230,7 @@ buflib_init(struct buflib_context *ctx, void *buf, size_t size)
      */
     ctx->alloc_end = bd_buf;
     ctx->compact = true;
+    free_lists_rebuild(ctx);
 }
 
 bool buflib_context_relocate(struct buflib_context *ctx, void *buf)
@@ -290,16 +398,28 @@ move_block(struct buflib_context* ctx, union buflib_data* block, int shift)
 
 /* Compact allocations and handle table, adjusting handle pointers as needed.
  * Return true if any space was freed or consolidated, false otherwise.
+ *
+ * max_move limits how many units of allocations are moved (0: no limit) and
+ * want stops the compaction early once a free block of that many units has
+ * been gathered (0: compact everything). An early stop leaves the gathered
+ * space as a free block in the middle of the buffer and sets *stopped.
+ * Allocations larger than max_move are left where they are, like unmovable
+ * ones, and the buffer isn't considered compact afterwards.
  */
 static bool
-buflib_compact(struct buflib_context *ctx)
+buflib_compact_bounded(struct buflib_context *ctx, size_t max_move,
+                       size_t want, bool *stopped)
 {
     BDEBUGF("%s(): Compacting!\n", __func__);
     union buflib_data *block,
                       *hole = NULL;
     int shift = 0, len;
+    size_t moved = 0;
+    bool skipped = false;
     /* Store the results of attempting to shrink the handle table */
     bool ret = handle_table_shrink(ctx);
+    /* blocks are about to move over the free list links */
+    ctx->free_lists_valid = false;
     /* compaction has basically two modes of operation:
      *  1) the buffer is nicely movable: In this mode, blocks can be simply
      * moved towards the beginning. Free blocks add to a shift value,
@@ -323,13 +443,30 @@ buflib_compact(struct buflib_context *ctx)
             len = -len;
             continue;
         }
+        /* stop early if there's enough room now or the budget is used up;
+         * the space gathered so far stays free in front of this block */
+        if ((want && (size_t)-shift >= want) ||
+            (max_move && (size_t)len <= max_move && moved + len > max_move))
+        {
+            if (shift)
+                block[shift].val = shift;
+            if (stopped)
+                *stopped = true;
+            return true;
+        }
+        if (max_move && (size_t)len > max_move)
+        {
+            movable = false;
+            skipped = true;
+        }
         /* attempt to fill any hole */
-        if (hole && -hole->val >= len)
+        if (movable && hole && -hole->val >= len)
         {
             intptr_t hlen = -hole->val;
             if ((movable = move_block(ctx, block, hole - block)))
             {
                 ret = true;
+                moved += len;
                 /* Move was successful. The memory at block is now free */
                 block->val = -len;
 
@@ -360,29 +497,52 @@ buflib_compact(struct buflib_context *ctx)
                 shift = 0;
             }
             else
+            {
                 ret = true;
+                moved += len;
+            }
         }
     }
     /* Move the end-of-allocation mark, and return true if any new space has
      * been freed.
      */
     ctx->alloc_end += shift;
-    ctx->compact = true;
+    ctx->compact = !skipped;
     return ret || shift;
 }
 
+static inline bool
+buflib_compact(struct buflib_context *ctx)
+{
+    return buflib_compact_bounded(ctx, 0, 0, NULL);
+}
+
+bool
+buflib_compact_step(struct buflib_context *ctx, size_t max_bytes)
+{
+    bool stopped = false;
+    if (!ctx->compact)
+        buflib_compact_bounded(ctx,
+                    MAX(max_bytes / sizeof(union buflib_data), 1), 0, &stopped);
+    return stopped;
+}
+
 /* Compact the buffer by trying both shrinking and moving.
  *
  * Try to move first. If unsuccesfull, try to shrink. If that was successful
  * try to move once more as there might be more room now.
+ *
+ * want is the size in units that is needed, moving stops as soon as there is
+ * a free block that large (0: compact everything)
  */
 static bool
-buflib_compact_and_shrink(struct buflib_context *ctx, unsigned shrink_hints)
+buflib_compact_and_shrink(struct buflib_context *ctx, unsigned shrink_hints,
+                          size_t want)
 {
     bool result = false;
     /* if something compacted before already there will be no further gain */
     if (!ctx->compact)
-        result = buflib_compact(ctx);
+        result = buflib_compact_bounded(ctx, 0, want, NULL);
     if (!result)
     {
         union buflib_data *this, *before;
@@ -535,16 +695,22 @@ handle_alloc:
         }
         /* buflib_compact_and_shrink() will compact and move last_block()
          * if possible */
-        if (buflib_compact_and_shrink(ctx, hints))
+        if (buflib_compact_and_shrink(ctx, hints, 0))
             goto handle_alloc;
         return -1;
     }
 
 buffer_alloc:
-    /* need to re-evaluate last before the loop because the last allocation
+    /* need to re-evaluate last before the search because the last allocation
      * possibly made room in its front to fit this, so last would be wrong */
     last = false;
-    for (block = find_first_free(ctx);;block += block_len)
+    /* The free blocks in the middle are tried first, any fragmentation this
+     * causes will be handled at compaction.
+     */
+    block = find_free_block(ctx, size);
+    if (block)
+        block_len = -block->val;
+    else
     {
         /* If the last used block extends all the way to the handle table, the
          * block "after" it doesn't have a header. Because of this, it's easier
@@ -552,31 +718,18 @@ buffer_alloc:
          * calculate the free space at the end by comparing it to the
          * last_handle pointer.
          */
-        if(block == ctx->alloc_end)
-        {
-            last = true;
-            block_len = ctx->last_handle - block;
-            if ((size_t)block_len < size)
-                block = NULL;
-            break;
-        }
-        block_len = block->val;
-        /* blocks with positive length are already allocated. */
-        if(block_len > 0)
-            continue;
-        block_len = -block_len;
-        /* The search is first-fit, any fragmentation this causes will be
-         * handled at compaction.
-         */
-        if ((size_t)block_len >= size)
-            break;
+        block = ctx->alloc_end;
+        last = true;
+        block_len = ctx->last_handle - block;
+        if ((size_t)block_len < size)
+            block = NULL;
     }
     if (!block)
     {
-        /* Try compacting if allocation failed */
+        /* Try compacting if allocation failed, but only as far as needed */
         unsigned hint = BUFLIB_SHRINK_POS_FRONT |
                     ((size*sizeof(union buflib_data))&BUFLIB_SHRINK_SIZE_MASK);
-        if (buflib_compact_and_shrink(ctx, hint))
+        if (buflib_compact_and_shrink(ctx, hint, size))
         {
             goto buffer_alloc;
         } else {
@@ -613,7 +766,10 @@ buffer_alloc:
         ctx->alloc_end = block;
     /* Only free blocks *before* alloc_end have tagged length. */
     else if ((size_t)block_len > size)
+    {
         block->val = size - block_len;
+        free_list_add(ctx, block);
+    }
     /* Return the handle index as a positive integer. */
     return ctx->handle_table - handle;
 }
@@ -672,6 +828,7 @@ buflib_free(struct buflib_context *ctx, int handle_num)
     block = find_block_before(ctx, freed_block, true);
     if (block)
     {
+        free_list_remove(ctx, block);
         block->val -= freed_block->val;
     }
     else
@@ -693,7 +850,11 @@ buflib_free(struct buflib_context *ctx, int handle_num)
     else {
         ctx->compact = false;
         if (next_block->val < 0)
+        {
+            free_list_remove(ctx, next_block);
             block->val += next_block->val;
+        }
+        free_list_add(ctx, block);
     }
     handle_free(ctx, handle);
     handle->alloc = NULL;
@@ -803,7 +964,7 @@ buflib_alloc_maximum(struct buflib_context* ctx, const char* name, size_t *size,
      * welcome to give up some or all of their memory */
     hints = BUFLIB_SHRINK_POS_BACK | BUFLIB_SHRINK_POS_FRONT | bufsize;
     /* compact until no space can be gained anymore */
-    while (buflib_compact_and_shrink(ctx, hints));
+    while (buflib_compact_and_shrink(ctx, hints, 0));
 
     *size = buflib_allocatable(ctx);
     if (*size <= 0) /* OOM */
@@ -843,6 +1004,9 @@ buflib_shrink(struct buflib_context* ctx, int handle, void* new_start, size_t ne
     if (new_next_block > old_next_block)
         return false;
 
+    /* free blocks are merged and created below */
+    ctx->free_lists_valid = false;
+
     metadata_size.val = aligned_oldstart - block;
     /* update val and the handle table entry */
     new_block = aligned_newstart - metadata_size.val;
@@ -4,6 +4,7 @@
 #include "system.h"
 #include "core_alloc.h"
 #include "buflib.h"
+#include "ata_idle_notify.h"
 
 /* not static so it can be discovered by core_get_data() */
 struct buflib_context core_ctx;
@@ -72,9 +73,34 @@ size_t core_allocatable(void)
     return buflib_allocatable(&core_ctx);
 }
 
+bool core_compact_step(size_t max_bytes)
+{
+    return buflib_compact_step(&core_ctx, max_bytes);
+}
+
+#if !defined(BOOTLOADER) && !defined(APPLICATION) && !defined(__PCTOOL__)
+/* How much is moved each time storage goes idle, at most. The callback
+ * mustn't yield, so this is what the other threads may have to wait for.
+ * Larger allocations are left for the compaction of a failing allocation */
+#define CORE_COMPACT_IDLE_BYTES (32*1024)
+
+/* Close up the holes left by core_free() while there's nothing else to do,
+ * so an allocation later finds the free space in one piece. Whatever is
+ * left is done once storage is idle again after the next core_free() */
+static void core_compact_idle(void)
+{
+    core_compact_step(CORE_COMPACT_IDLE_BYTES);
+}
+#endif
+
 int core_free(int handle)
 {
-    return buflib_free(&core_ctx, handle);
+    handle = buflib_free(&core_ctx, handle);
+#if !defined(BOOTLOADER) && !defined(APPLICATION) && !defined(__PCTOOL__)
+    if (!core_ctx.compact)
+        register_storage_idle_func(core_compact_idle);
+#endif
+    return handle;
 }
 
 int core_alloc_maximum(const char* name, size_t *size, struct buflib_callbacks *ops)
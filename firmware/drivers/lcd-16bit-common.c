@@ -515,20 +515,18 @@ void lcd_mono_bitmap(const unsigned char *src, int x, int y, int width, int heig
 #define BLEND_OUT(acc) do {} while (0)
 #endif
 
-/* Blend the given two colors */
-static inline unsigned blend_two_colors(unsigned c1, unsigned c2, unsigned a)
+/* Spread a pixel so that its three channels are scaled by one multiply,
+ * and join it again after the blend */
+static inline unsigned spread_color(unsigned c)
 {
-    a += a >> (ALPHA_COLOR_LOOKUP_SHIFT - 1);
 #if (LCD_PIXELFORMAT == RGB565SWAPPED)
-    c1 = swap16(c1);
-    c2 = swap16(c2);
+    c = swap16(c);
 #endif
-    unsigned c1l = (c1 | (c1 << 16)) & 0x07e0f81f;
-    unsigned c2l = (c2 | (c2 << 16)) & 0x07e0f81f;
-    unsigned p;
-    BLEND_START(p, c1l, a);
-    BLEND_CONT(p, c2l, ALPHA_COLOR_LOOKUP_SIZE + 1 - a);
-    BLEND_OUT(p);
+    return (c | (c << 16)) & 0x07e0f81f;
+}
+
+static inline unsigned join_color(unsigned p)
+{
     p = (p >> ALPHA_COLOR_LOOKUP_SHIFT) & 0x07e0f81f;
     p |= (p >> 16);
 #if (LCD_PIXELFORMAT == RGB565SWAPPED)
@@ -538,6 +536,91 @@ static inline unsigned blend_two_colors(unsigned c1, unsigned c2, unsigned a)
 #endif
 }
 
+/* Weight of the first color in a blend, 0..16 for alpha 0..15 */
+#define ALPHA_WEIGHT(a) ((a) + ((a) >> (ALPHA_COLOR_LOOKUP_SHIFT - 1)))
+
+/* Blend the given two colors */
+static inline unsigned blend_two_colors(unsigned c1, unsigned c2, unsigned a)
+{
+    a = ALPHA_WEIGHT(a);
+    unsigned c1l = spread_color(c1);
+    unsigned c2l = spread_color(c2);
+    unsigned p;
+    BLEND_START(p, c1l, a);
+    BLEND_CONT(p, c2l, ALPHA_COLOR_LOOKUP_SIZE + 1 - a);
+    BLEND_OUT(p);
+    return join_color(p);
+}
+
+/* Blend a color given its weight with the precomputed share of a color that
+ * is the same for every pixel. Gives the same result as blend_two_colors(). */
+static inline unsigned blend_with_share(unsigned c, unsigned weight,
+                                        unsigned share)
+{
+    return join_color(spread_color(c) * weight + share);
+}
+
+/* Where the rows are contiguous in memory and the target has 128 bit vectors
+ * the common modes unpack a row of alpha values and blend eight pixels at a
+ * time, one channel per operation. The channels are blended exactly like
+ * blend_two_colors() does. Define ALPHA_BLEND_NO_SIMD to build without. */
+#if COL_INC == 1 && !defined(ALPHA_BLEND_NO_SIMD) && \
+    (defined(__SSE2__) || defined(__ARM_NEON__))
+#define ALPHA_BLEND_SIMD
+typedef uint16_t v8u16 __attribute__((vector_size(16)));
+/* fb_data rows are only 16-bit aligned */
+typedef uint16_t v8u16_u __attribute__((vector_size(16), aligned(2)));
+#define V8(p) (*(v8u16_u *)(p))
+
+static inline v8u16 blend8(v8u16 c1, v8u16 c2, v8u16 w1)
+{
+    v8u16 w2 = ALPHA_COLOR_LOOKUP_SIZE + 1 - w1;
+    v8u16 r, g, b;
+#if (LCD_PIXELFORMAT == RGB565SWAPPED)
+    c1 = (c1 << 8) | (c1 >> 8);
+    c2 = (c2 << 8) | (c2 >> 8);
+#endif
+    r = ((c1 >> 11) * w1 + (c2 >> 11) * w2) >> ALPHA_COLOR_LOOKUP_SHIFT;
+    g = (((c1 >> 5) & 0x3f) * w1 + ((c2 >> 5) & 0x3f) * w2)
+            >> ALPHA_COLOR_LOOKUP_SHIFT;
+    b = ((c1 & 0x1f) * w1 + (c2 & 0x1f) * w2) >> ALPHA_COLOR_LOOKUP_SHIFT;
+    c1 = (r << 11) | (g << 5) | b;
+#if (LCD_PIXELFORMAT == RGB565SWAPPED)
+    c1 = (c1 << 8) | (c1 >> 8);
+#endif
+    return c1;
+}
+
+/* dst[i] = c1[i] blended with color, weights[i] being the weight of c1[i] */
+static void blend_row_color(fb_data *dst, const fb_data *c1, unsigned color,
+                            const uint16_t *weights, int count)
+{
+    v8u16 c2 = (v8u16){ 0 } + (uint16_t)color;
+    int i;
+
+    for (i = 0; i + 8 <= count; i += 8)
+        V8(&dst[i]) = blend8(V8(&c1[i]), c2, V8(&weights[i]));
+
+    for (; i < count; i++)
+        dst[i] = join_color(spread_color(c1[i]) * weights[i] +
+                 spread_color(color) * (ALPHA_COLOR_LOOKUP_SIZE + 1 - weights[i]));
+}
+
+/* dst[i] = c1[i] blended with c2[i] */
+static void blend_row_image(fb_data *dst, const fb_data *c1, const fb_data *c2,
+                            const uint16_t *weights, int count)
+{
+    int i;
+
+    for (i = 0; i + 8 <= count; i += 8)
+        V8(&dst[i]) = blend8(V8(&c1[i]), V8(&c2[i]), V8(&weights[i]));
+
+    for (; i < count; i++)
+        dst[i] = join_color(spread_color(c1[i]) * weights[i] +
+                 spread_color(c2[i]) * (ALPHA_COLOR_LOOKUP_SIZE + 1 - weights[i]));
+}
+#endif /* ALPHA_BLEND_SIMD */
+
 /* Blend an image with an alpha channel
  * if image is NULL, drawing will happen according to the drawmode
  * src is the alpha channel (4bit per pixel) */
@@ -665,13 +748,41 @@ static void ICODE_ATTR lcd_alpha_bitmap_part_mix(const fb_data* image,
      * Therefore NULL accesses are impossible and we can increment
      * unconditionally (applies for stride at the end of the loop as well) */
     image += skip_start_image;
+
+    /* Where one of the colors is the same for every pixel, so is its share
+     * of each of the 16 possible blends. For DRMODE_SOLID that's the whole
+     * blend. */
+    unsigned lut[ALPHA_COLOR_LOOKUP_SIZE + 1];
+    switch (drmode)
+    {
+        case DRMODE_SOLID:
+            for (unsigned a = 0; a <= ALPHA_COLOR_LOOKUP_SIZE; a++)
+                lut[a] = blend_two_colors(current_vp->bg_pattern,
+                                          current_vp->fg_pattern, a);
+            break;
+        case DRMODE_FG:
+        case DRMODE_SOLID|DRMODE_INT_BD:
+            for (unsigned a = 0; a <= ALPHA_COLOR_LOOKUP_SIZE; a++)
+                lut[a] = spread_color(current_vp->fg_pattern) *
+                         (ALPHA_COLOR_LOOKUP_SIZE + 1 - ALPHA_WEIGHT(a));
+            break;
+        case DRMODE_SOLID|DRMODE_INT_IMG:
+            for (unsigned a = 0; a <= ALPHA_COLOR_LOOKUP_SIZE; a++)
+                lut[a] = spread_color(current_vp->bg_pattern) * ALPHA_WEIGHT(a);
+            break;
+    }
+
+#ifdef ALPHA_BLEND_SIMD
+    uint16_t weights[LCD_WIDTH];
+#endif
+
     /* go through the rows and update each pixel */
     do
     {
-        /* saving current_vp->fg/bg_pattern and lcd_backdrop_offset into these
+        /* saving current_vp->bg_pattern and lcd_backdrop_offset into these
          * temp vars just before the loop helps gcc to opimize the loop better
          * (testing showed ~15% speedup) */
-        unsigned fg, bg;
+        unsigned bg;
         ptrdiff_t bo, img_offset;
         col = width;
         dst = dst_row;
@@ -701,6 +812,15 @@ static void ICODE_ATTR lcd_alpha_bitmap_part_mix(const fb_data* image,
                 data = *(++src) ^ dmask; \
         } while (0)
 #endif
+#ifdef ALPHA_BLEND_SIMD
+#define UNPACK_ALPHA_ROW    do { \
+            for (int i = 0; i < width; i++) \
+            { \
+                weights[i] = ALPHA_WEIGHT(data & ALPHA_COLOR_LOOKUP_SIZE); \
+                UPDATE_SRC_ALPHA; \
+            } \
+        } while (0)
+#endif
 
         switch (drmode)
         {
@@ -738,6 +858,11 @@ static void ICODE_ATTR lcd_alpha_bitmap_part_mix(const fb_data* image,
                 break;
             case DRMODE_FG|DRMODE_INT_IMG:
                 img_offset = image - dst;
+#ifdef ALPHA_BLEND_SIMD
+                UNPACK_ALPHA_ROW;
+                blend_row_image(dst, dst, dst + img_offset, weights, width);
+                break;
+#endif
                 do
                 {
                     *dst = blend_two_colors(*dst, *(dst + img_offset), data & ALPHA_COLOR_LOOKUP_SIZE );
@@ -747,10 +872,18 @@ static void ICODE_ATTR lcd_alpha_bitmap_part_mix(const fb_data* image,
                 while (--col);
                 break;
             case DRMODE_FG:
-                fg = current_vp->fg_pattern;
+#ifdef ALPHA_BLEND_SIMD
+                UNPACK_ALPHA_ROW;
+                blend_row_color(dst, dst, current_vp->fg_pattern,
+                                weights, width);
+                break;
+#endif
                 do
                 {
-                    *dst = blend_two_colors(*dst, fg, data & ALPHA_COLOR_LOOKUP_SIZE );
+                    unsigned a = data & ALPHA_COLOR_LOOKUP_SIZE;
+                    /* most of a glyph is transparent */
+                    if (a != ALPHA_COLOR_LOOKUP_SIZE)
+                        *dst = blend_with_share(*dst, ALPHA_WEIGHT(a), lut[a]);
                     dst += COL_INC;
                     UPDATE_SRC_ALPHA;
                 }
@@ -758,22 +891,30 @@ static void ICODE_ATTR lcd_alpha_bitmap_part_mix(const fb_data* image,
                 break;
             case DRMODE_SOLID|DRMODE_INT_BD:
                 bo = lcd_backdrop_offset;
-                fg = current_vp->fg_pattern;
+#ifdef ALPHA_BLEND_SIMD
+                UNPACK_ALPHA_ROW;
+                blend_row_color(dst, (fb_data *)((uintptr_t)dst + bo),
+                                current_vp->fg_pattern, weights, width);
+                break;
+#endif
                 do
                 {
                     fb_data *c = (fb_data *)((uintptr_t)dst +  bo);
-                    *dst = blend_two_colors(*c, fg, data & ALPHA_COLOR_LOOKUP_SIZE );
+                    unsigned a = data & ALPHA_COLOR_LOOKUP_SIZE;
+                    *dst = blend_with_share(*c, ALPHA_WEIGHT(a), lut[a]);
                     dst += COL_INC;
                     UPDATE_SRC_ALPHA;
                 }
                 while (--col);
                 break;
             case DRMODE_SOLID|DRMODE_INT_IMG:
-                bg = current_vp->bg_pattern;
                 img_offset = image - dst;
                 do
                 {
-                    *dst = blend_two_colors(bg, *(dst + img_offset), data & ALPHA_COLOR_LOOKUP_SIZE );
+                    unsigned a = data & ALPHA_COLOR_LOOKUP_SIZE;
+                    *dst = blend_with_share(*(dst + img_offset),
+                                ALPHA_COLOR_LOOKUP_SIZE + 1 - ALPHA_WEIGHT(a),
+                                lut[a]);
                     dst += COL_INC;
                     UPDATE_SRC_ALPHA;
                 }
@@ -782,6 +923,12 @@ static void ICODE_ATTR lcd_alpha_bitmap_part_mix(const fb_data* image,
             case DRMODE_SOLID|DRMODE_INT_BD|DRMODE_INT_IMG:
                 bo = lcd_backdrop_offset;
                 img_offset = image - dst;
+#ifdef ALPHA_BLEND_SIMD
+                UNPACK_ALPHA_ROW;
+                blend_row_image(dst, (fb_data *)((uintptr_t)dst + bo),
+                                dst + img_offset, weights, width);
+                break;
+#endif
                 do
                 {
                     fb_data *c = (fb_data *)((uintptr_t)dst +  bo);
@@ -792,11 +939,9 @@ static void ICODE_ATTR lcd_alpha_bitmap_part_mix(const fb_data* image,
                 while (--col);
                 break;
             case DRMODE_SOLID:
-                bg = current_vp->bg_pattern;
-                fg = current_vp->fg_pattern;
                 do
                 {
-                    *dst = blend_two_colors(bg, fg, data & ALPHA_COLOR_LOOKUP_SIZE );
+                    *dst = lut[data & ALPHA_COLOR_LOOKUP_SIZE];
                     dst += COL_INC;
                     UPDATE_SRC_ALPHA;
                 }
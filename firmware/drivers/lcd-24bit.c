@@ -669,6 +669,16 @@ static void ICODE_ATTR lcd_alpha_bitmap_part_mix(const fb_data* image,
      * Therefore NULL accesses are impossible and we can increment
      * unconditionally (applies for stride at the end of the loop as well) */
     image += skip_start_image;
+
+    /* with both colors fixed there are only 16 possible blends */
+    fb_data lut[ALPHA_COLOR_LOOKUP_SIZE + 1];
+    if (drmode == DRMODE_SOLID)
+    {
+        for (unsigned a = 0; a <= ALPHA_COLOR_LOOKUP_SIZE; a++)
+            lut[a] = blend_two_colors(current_vp->bg_pattern,
+                                      current_vp->fg_pattern, a);
+    }
+
     /* go through the rows and update each pixel */
     do
     {
@@ -759,8 +769,12 @@ static void ICODE_ATTR lcd_alpha_bitmap_part_mix(const fb_data* image,
                 fg = current_vp->fg_pattern;
                 do
                 {
-                    unsigned px = FB_UNPACK_SCALAR_LCD(*dst);
-                    *dst = blend_two_colors(px, fg, data & ALPHA_COLOR_LOOKUP_SIZE );
+                    /* most of a glyph is transparent */
+                    if ((data & ALPHA_COLOR_LOOKUP_SIZE) != ALPHA_COLOR_LOOKUP_SIZE)
+                    {
+                        unsigned px = FB_UNPACK_SCALAR_LCD(*dst);
+                        *dst = blend_two_colors(px, fg, data & ALPHA_COLOR_LOOKUP_SIZE );
+                    }
                     dst += COL_INC;
                     UPDATE_SRC_ALPHA;
                 }
@@ -804,11 +818,9 @@ static void ICODE_ATTR lcd_alpha_bitmap_part_mix(const fb_data* image,
                 while (--col);
                 break;
             case DRMODE_SOLID:
-                bg = current_vp->bg_pattern;
-                fg = current_vp->fg_pattern;
                 do
                 {
-                    *dst = blend_two_colors(bg, fg, data & ALPHA_COLOR_LOOKUP_SIZE );
+                    *dst = lut[data & ALPHA_COLOR_LOOKUP_SIZE];
                     dst += COL_INC;
                     UPDATE_SRC_ALPHA;
                 }
@@ -31,6 +31,7 @@
 #include <stdio.h>
 #include "string-extra.h"
 #include "diacritic.h"
+#include "text_cache.h"
 
 #ifndef LCDFN /* Not compiling for remote - define macros for main LCD. */
 #define LCDFN(fn) lcd_ ## fn
@@ -118,34 +119,33 @@ void LCDFN(update_viewport_rect)(int x, int y, int width, int height)
     LCDFN(update_rect)(current_vp->x + x, current_vp->y + y, width, height);
 }
 
-/* put a string at a given pixel position, skipping first ofs pixel columns */
-static void LCDFN(putsxyofs)(int x, int y, int ofs, const unsigned char *str)
+/* apply the alignment of the viewport to a string w pixels wide */
+static void LCDFN(align_x)(int *x, int *ofs, int w)
 {
-    unsigned short *ucs;
-    font_lock(current_vp->font, true);
-    struct font* pf = font_get(current_vp->font);
     int vp_flags = current_vp->flags;
-    int rtl_next_non_diac_width, last_non_diacritic_width;
 
-    if ((vp_flags & VP_FLAG_ALIGNMENT_MASK) != 0)
+    /* center takes precedence */
+    if (vp_flags & VP_FLAG_ALIGN_CENTER)
     {
-        int w;
-
-        LCDFN(getstringsize)(str, &w, NULL);
-        /* center takes precedence */
-        if (vp_flags & VP_FLAG_ALIGN_CENTER)
-        {
-            x = ((current_vp->width - w)/ 2) + x;
-            if (x < 0)
-                x = 0;
-        }
-        else
-        {
-            x = current_vp->width - w - x;
-            x += ofs;
-            ofs = 0;
-        }
+        *x = ((current_vp->width - w)/ 2) + *x;
+        if (*x < 0)
+            *x = 0;
+    }
+    else
+    {
+        *x = current_vp->width - w - *x;
+        *x += *ofs;
+        *ofs = 0;
     }
+}
+
+/* put a string glyph by glyph at a given pixel position, skipping first ofs
+ * pixel columns */
+static void LCDFN(putsxyofs_glyphs)(struct font *pf, int x, int y, int ofs,
+                                    const unsigned char *str)
+{
+    unsigned short *ucs;
+    int rtl_next_non_diac_width, last_non_diacritic_width;
 
     rtl_next_non_diac_width = 0;
     last_non_diacritic_width = 0;
@@ -255,7 +255,61 @@ static void LCDFN(putsxyofs)(int x, int y, int ofs, const unsigned char *str)
             }
         }
     }
-    font_lock(current_vp->font, false);
+}
+
+/* put a string at a given pixel position, skipping first ofs pixel columns */
+static void LCDFN(putsxyofs)(int x, int y, int ofs, const unsigned char *str)
+{
+#if defined(MAIN_LCD) && defined(TEXT_CACHE_CLOCK)
+    unsigned long start = TEXT_CACHE_CLOCK();
+#endif
+    int font = current_vp->font;
+    bool align = (current_vp->flags & VP_FLAG_ALIGNMENT_MASK) != 0;
+    font_lock(font, true);
+    struct font* pf = font_get(font);
+
+#ifdef HAVE_TEXT_CACHE
+#if defined(MAIN_LCD) && defined(HAVE_LCD_COLOR)
+    bool cachable = true;
+#else
+    bool cachable = pf->depth == 0; /* no anti-aliasing here */
+#endif
+    struct text_run run;
+
+    if (cachable && text_cache_get(font, str, &run))
+    {
+        /* the whole string in one go */
+        if (align)
+            LCDFN(align_x)(&x, &ofs, run.width);
+
+#if defined(MAIN_LCD) && defined(HAVE_LCD_COLOR)
+        if (run.depth)
+            lcd_alpha_bitmap_part(run.bits, ofs, 0, run.width, x, y,
+                                  run.width - ofs, run.height);
+        else
+#endif
+            LCDFN(mono_bitmap_part)(run.bits, ofs, 0, run.width, x, y,
+                                    run.width - ofs, run.height);
+
+        text_cache_release();
+    }
+    else
+#endif /* HAVE_TEXT_CACHE */
+    {
+        if (align)
+        {
+            int w;
+            LCDFN(getstringsize)(str, &w, NULL);
+            LCDFN(align_x)(&x, &ofs, w);
+        }
+
+        LCDFN(putsxyofs_glyphs)(pf, x, y, ofs, str);
+    }
+
+    font_lock(font, false);
+#if defined(MAIN_LCD) && defined(TEXT_CACHE_CLOCK)
+    text_cache_add_draw_time(TEXT_CACHE_CLOCK() - start);
+#endif
 }
 
 /*** pixel oriented text output ***/
@@ -841,6 +841,11 @@ Lyre prototype 1 */
 #define HAVE_PICTUREFLOW_INTEGRATION
 #endif
 
+/* Keep strings drawn on bitmap displays rendered for redrawing them */
+#if defined(HAVE_LCD_BITMAP) && !defined(BOOTLOADER) && !defined(__PCTOOL__)
+#define HAVE_TEXT_CACHE
+#endif
+
 /* Add one HAVE_ define for all mas35xx targets */
 #if (CONFIG_CODEC == MAS3587F) || (CONFIG_CODEC == MAS3507D) || (CONFIG_CODEC == MAS3539F)
 #define HAVE_MAS35XX
@@ -872,11 +877,28 @@ Lyre prototype 1 */
 #define HAVE_PRIORITY_SCHEDULING
 #endif
 
+/* Each kernel thread is a thread of the host */
+#if defined(HAVE_SDL_THREADS) || defined(HAVE_PTHREAD_THREADS)
+#define HAVE_HOST_THREADS
+#else
+/* The scheduler accounts the CPU time of each thread */
+#define HAVE_THREAD_CPU_TIME
+#endif
+
 #if (CONFIG_PLATFORM & PLATFORM_NATIVE)
 #define HAVE_PRIORITY_SCHEDULING
 #define HAVE_SCHEDULER_BOOSTCTRL
 #endif /* PLATFORM_NATIVE */
 
+/* The hosted kernels provide a microsecond timer for the hrtimer queue and
+ * can stretch their tick while the scheduler is idle */
+#if (CONFIG_PLATFORM & PLATFORM_HOSTED) && !defined(__PCTOOL__)
+#define HAVE_HRTIMER
+#ifndef HAVE_HOST_THREADS
+#define HAVE_TICKLESS_IDLE
+#endif
+#endif /* PLATFORM_HOSTED */
+
 
 #ifdef HAVE_USBSTACK
 #if CONFIG_USBOTG == USBOTG_ARC
@@ -901,7 +923,8 @@ Lyre prototype 1 */
     || (CONFIG_CPU == AS3525) || (CONFIG_CPU == AS3525v2) \
     || defined(CPU_S5L870X) || (CONFIG_CPU == S3C2440) \
     || defined(APPLICATION) || (CONFIG_CPU == PP5002) \
-    || (CONFIG_CPU == RK27XX) || (CONFIG_CPU == IMX233)
+    || (CONFIG_CPU == RK27XX) || (CONFIG_CPU == IMX233) \
+    || defined(HAVE_PTHREAD_THREADS)
 #define HAVE_SEMAPHORE_OBJECTS
 #endif
 
@@ -1066,6 +1089,28 @@ Lyre prototype 1 */
 
 #endif /* CPU_PP */
 
+#ifdef HAVE_PTHREAD_THREADS
+/* The threads of a core take turns as on a target while the cores run in
+ * parallel on the host, see firmware/kernel/pthread/thread.c */
+#define NUM_CORES 2
+/* Decoding and buffering get the COP to themselves, so they run alongside
+ * the UI, audio and all other threads, which stay on the CPU */
+#define CODEC_THREAD_CORE     COP
+#define BUFFERING_THREAD_CORE COP
+#define HAVE_CORELOCK_OBJECT
+#define CURRENT_CORE current_core()
+#define SHAREDBSS_ATTR
+#define SHAREDDATA_ATTR
+#define NOCACHEBSS_ATTR
+#define NOCACHEDATA_ATTR
+/* the host keeps the caches of its cores coherent */
+#define UNCACHED_ADDR(a)    (a)
+
+#define IF_COP(...)         __VA_ARGS__
+#define IF_COP_VOID(...)    __VA_ARGS__
+#define IF_COP_CORE(core)   core
+#endif /* HAVE_PTHREAD_THREADS */
+
 #if CONFIG_CPU == IMX31L || CONFIG_CPU == IMX233
 #define NOCACHEBSS_ATTR     __attribute__((section(".ncbss"),nocommon))
 #define NOCACHEDATA_ATTR    __attribute__((section(".ncdata"),nocommon))
@@ -1089,6 +1134,16 @@ Lyre prototype 1 */
 
 #endif /* NUM_CORES */
 
+#if NUM_CORES > 1
+/* The cores of the playback threads that do the work */
+#ifndef CODEC_THREAD_CORE
+#define CODEC_THREAD_CORE     CPU
+#endif
+#ifndef BUFFERING_THREAD_CORE
+#define BUFFERING_THREAD_CORE CPU
+#endif
+#endif /* NUM_CORES > 1 */
+
 #ifdef HAVE_HEADPHONE_DETECTION
 /* Timeout objects required if headphone detection is enabled */
 #define INCLUDE_TIMEOUT_API
@@ -608,6 +608,12 @@ extern void lcd_bitmap_transparent_part(const fb_data *src,
                                         int height);
 extern void lcd_bitmap_transparent(const fb_data *src, int x, int y,
                                    int width, int height);
+#ifdef HAVE_LCD_COLOR
+/* 4 bit alpha, as used by anti-aliased fonts */
+extern void lcd_alpha_bitmap_part(const unsigned char *src, int src_x,
+                                  int src_y, int stride, int x, int y,
+                                  int width, int height);
+#endif
 #else /* LCD_DEPTH == 1 */
 #define lcd_mono_bitmap lcd_bitmap
 #define lcd_mono_bitmap_part lcd_bitmap_part
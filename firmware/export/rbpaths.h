@@ -138,5 +138,6 @@ extern void paths_init(void);
 #define PLAYLIST_CONTROL_FILE   ROCKBOX_DIR "/.playlist_control"
 #define NVRAM_FILE              ROCKBOX_DIR "/nvram.bin"
 #define GLYPH_CACHE_FILE        ROCKBOX_DIR "/.glyphcache"
+#define SKIN_CACHE_DIR          ROCKBOX_DIR "/skincache"
 
 #endif /* __PATHS_H__ */
@@ -0,0 +1,109 @@
+/***************************************************************************
+ *             __________               __   ___.
+ *   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+ *   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+ *   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+ *   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+ *                     \/            \/     \/    \/            \/
+ * $Id$
+ *
+ * Static tracepoints recorded into per-thread ring buffers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ ****************************************************************************/
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "config.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include "gcc_extensions.h"
+
+/****************************************************************************
+ * Every thread records into a ring of its own and the interrupt handlers of
+ * each core into another one, so recording takes no locks. The rings keep
+ * the most recent events; stop the trace right after the glitch of interest
+ * and dump it, then turn the dump into Chrome trace / Perfetto JSON with
+ * tools/trace2json.py.
+ ****************************************************************************/
+
+/* Tracepoints - keep trace_point_names[] in trace.c in order */
+enum trace_point
+{
+    TP_SWITCH_THREAD = 0,   /* thread switched out */
+    TP_CODEC_DECODE,        /* codec decoding between two pcmbuf inserts */
+    TP_DSP_PROCESS,         /* dsp_process() - arg: input samples */
+    TP_PCMBUF_CALLBACK,     /* pcm callback - arg: bytes handed out (0 means
+                               the buffer ran dry) */
+    TP_BUFFER_HANDLE,       /* buffering reading a handle - arg: handle id */
+    TP_STORAGE_READ,        /* storage_read_sectors() - arg: sector count */
+    TP_NUM_POINTS
+};
+
+enum trace_phase
+{
+    TRACE_PH_BEGIN = 0,     /* start of a slice */
+    TRACE_PH_END,           /* end of the innermost slice */
+    TRACE_PH_INSTANT,       /* a point in time */
+};
+
+#define TRACE_ID(phase, tp) (((phase) << 8) | (tp))
+
+#ifdef ROCKBOX_HAS_TRACE
+
+extern bool trace_running;
+
+/* Record into the ring of the calling thread */
+void trace_event(unsigned int id, intptr_t arg);
+/* Record into the ring of the interrupt handlers of the current core */
+void trace_isr_event(unsigned int id, intptr_t arg);
+/* Record into the ring of the thread in 'slot' - for the scheduler */
+void trace_thread_event(unsigned int slot, unsigned int id, intptr_t arg);
+
+/* Empty the rings and start recording - until the first TRACE_TRIGGER() if
+   'stop_on_trigger' is set */
+void trace_start(bool stop_on_trigger);
+/* Stop recording, the rings keep their contents */
+void trace_stop(void);
+/* Stop recording if started to stop on a trigger */
+void trace_trigger(void);
+/* Write the rings to a file, returns < 0 on error */
+int trace_dump(const char *filename);
+
+#define TRACE_EVENT_(fn, phase, tp, arg) \
+    do { if (UNLIKELY(trace_running)) \
+             fn(TRACE_ID(phase, tp), (intptr_t)(arg)); } while (0)
+
+#define TRACE_BEGIN(tp, arg)        TRACE_EVENT_(trace_event, TRACE_PH_BEGIN, tp, arg)
+#define TRACE_END(tp, arg)          TRACE_EVENT_(trace_event, TRACE_PH_END, tp, arg)
+#define TRACE_INSTANT(tp, arg)      TRACE_EVENT_(trace_event, TRACE_PH_INSTANT, tp, arg)
+#define TRACE_ISR_BEGIN(tp, arg)    TRACE_EVENT_(trace_isr_event, TRACE_PH_BEGIN, tp, arg)
+#define TRACE_ISR_END(tp, arg)      TRACE_EVENT_(trace_isr_event, TRACE_PH_END, tp, arg)
+#define TRACE_ISR_INSTANT(tp, arg)  TRACE_EVENT_(trace_isr_event, TRACE_PH_INSTANT, tp, arg)
+#define TRACE_THREAD(slot, phase, tp) \
+    do { if (UNLIKELY(trace_running)) \
+             trace_thread_event((slot), TRACE_ID(phase, tp), 0); } while (0)
+#define TRACE_TRIGGER() \
+    do { if (UNLIKELY(trace_running)) trace_trigger(); } while (0)
+
+#else /* !ROCKBOX_HAS_TRACE */
+
+#define TRACE_BEGIN(tp, arg)        do { } while (0)
+#define TRACE_END(tp, arg)          do { } while (0)
+#define TRACE_INSTANT(tp, arg)      do { } while (0)
+#define TRACE_ISR_BEGIN(tp, arg)    do { } while (0)
+#define TRACE_ISR_END(tp, arg)      do { } while (0)
+#define TRACE_ISR_INSTANT(tp, arg)  do { } while (0)
+#define TRACE_THREAD(slot, phase, tp) do { } while (0)
+#define TRACE_TRIGGER()             do { } while (0)
+
+#endif /* ROCKBOX_HAS_TRACE */
+
+#endif /* TRACE_H */
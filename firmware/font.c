@@ -42,6 +42,7 @@
 #include "rbunicode.h"
 #include "diacritic.h"
 #include "rbpaths.h"
+#include "text_cache.h"
 
 #define MAX_FONTSIZE_FOR_16_BIT_OFFSETS 0xFFDB
 
@@ -170,6 +171,9 @@ void font_init(void)
     cache_fd = -1;
     while (i<MAXFONTS)
         buflib_allocations[i++] = -1;
+#ifdef HAVE_TEXT_CACHE
+    text_cache_init();
+#endif
 }
 
 /* Check if we have x bytes left in the file buffer */
@@ -577,6 +581,10 @@ int font_load_ex( const char *path, size_t buf_size, int glyphs )
     buflib_allocations[font_id] = handle;
     //printf("%s -> [%d] -> %d\n", path, font_id, *handle);
     lock_font_handle( handle, false );
+#ifdef HAVE_TEXT_CACHE
+    /* font ids may now resolve to another font */
+    text_cache_flush();
+#endif
     return font_id; /* success!*/
 }
 
@@ -606,6 +614,9 @@ void font_unload(int font_id)
         if (handle > 0)
             core_free(handle);
         buflib_allocations[font_id] = -1;
+#ifdef HAVE_TEXT_CACHE
+        text_cache_flush();
+#endif
 
     }
 }
@@ -43,6 +43,11 @@ union buflib_data
     uint32_t crc;
 };
 
+/* number of size classes free blocks are sorted into, class n > 0 holds
+ * blocks of 2^(n+2) to 2^(n+3)-1 buflib_data units, class 0 the smaller ones
+ * and the last class everything larger */
+#define BUFLIB_FREE_CLASSES 16
+
 struct buflib_context
 {
     union buflib_data *handle_table;
@@ -51,6 +56,12 @@ struct buflib_context
     union buflib_data *buf_start;
     union buflib_data *alloc_end;
     bool compact;
+    /* free blocks before alloc_end, linked per size class by their offset
+     * from buf_start (-1 ends a list). Rebuilt on demand after compaction
+     * and shrinking, which move free blocks around wholesale */
+    bool free_lists_valid;
+    uint32_t free_classes; /* bit n set if class n isn't empty */
+    intptr_t free_list[BUFLIB_FREE_CLASSES];
 };
 
 /**
@@ -283,6 +294,18 @@ bool buflib_shrink(struct buflib_context *ctx, int handle, void* newstart, size_
  */
 int buflib_free(struct buflib_context *context, int handle);
 
+/**
+ * Does part of the work of a compaction, moving at most max_bytes of
+ * allocations towards the start of the buffer. Allocations larger than
+ * max_bytes are never moved by this, that is left to the compaction of an
+ * allocation that doesn't fit otherwise. Intended to be called repeatedly
+ * when there is time to spare, so that allocations later don't have to wait
+ * for a full compaction.
+ *
+ * Returns: true if another step could move more
+ */
+bool buflib_compact_step(struct buflib_context *ctx, size_t max_bytes);
+
 /**
  * Moves the underlying buflib buffer up by size bytes (as much as
  * possible for size == 0) without moving the end. This effectively
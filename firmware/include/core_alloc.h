@@ -17,6 +17,7 @@ bool core_shrink(int handle, void* new_start, size_t new_size);
 int core_free(int handle);
 size_t core_available(void);
 size_t core_allocatable(void);
+bool core_compact_step(size_t max_bytes);
 const char* core_get_name(int handle);
 #ifdef DEBUG
 void core_check_valid(void);
@@ -0,0 +1,79 @@
+/***************************************************************************
+ *             __________               __   ___.
+ *   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+ *   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+ *   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+ *   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+ *                     \/            \/     \/    \/            \/
+ * $Id$
+ *
+ * Cache of strings rendered in one piece
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ ****************************************************************************/
+#ifndef _TEXT_CACHE_H_
+#define _TEXT_CACHE_H_
+
+#include <stdbool.h>
+#include "config.h"
+#include "kernel.h"
+
+#ifdef HAVE_TEXT_CACHE
+
+/* A string laid out (bidi, diacritics) and rendered into one bitmap in the
+ * glyph format of its font: packed vertically 8 pixels per byte for mono
+ * fonts, 4 bit alpha for anti-aliased ones. The stride is the width. The
+ * drawing mode and colours are applied when the run is drawn, so one run
+ * serves every style. */
+struct text_run
+{
+    const unsigned char *bits;
+    int width;
+    int height;
+    int depth;                  /* as struct font */
+};
+
+struct text_cache_stats
+{
+    unsigned long hits;         /* strings drawn from the cache */
+    unsigned long misses;       /* strings rendered into the cache */
+    unsigned long uncached;     /* strings drawn glyph by glyph */
+    unsigned long draws;        /* strings drawn on the main LCD ... */
+    unsigned long long draw_time; /* ... and the microseconds that took */
+    size_t size;                /* bytes for runs */
+    size_t used;                /* bytes taken by the cached runs */
+    int runs;                   /* number of cached runs */
+};
+
+/* Clock the draw time is taken with, if the target has a fine one */
+#if defined(HAVE_HRTIMER)
+#define TEXT_CACHE_CLOCK()  ((unsigned long)hrtimer_now())
+#elif defined(USEC_TIMER)
+#define TEXT_CACHE_CLOCK()  ((unsigned long)USEC_TIMER)
+#endif
+
+void text_cache_init(void);
+/* Finds or renders the run of 'str' in font 'font_id'. On success the run
+ * stays put until text_cache_release(). Fails if the string is too wide,
+ * the font can't be cached or another thread is rendering, in which case
+ * the string has to be drawn glyph by glyph. */
+bool text_cache_get(int font_id, const unsigned char *str,
+                    struct text_run *run);
+void text_cache_release(void);
+/* Drops all runs - whenever the fonts change */
+void text_cache_flush(void);
+
+void text_cache_add_draw_time(unsigned long usec);
+void text_cache_get_stats(struct text_cache_stats *stats);
+void text_cache_reset_stats(void);
+
+#endif /* HAVE_TEXT_CACHE */
+
+#endif /* _TEXT_CACHE_H_ */
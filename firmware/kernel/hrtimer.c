@@ -0,0 +1,135 @@
+/***************************************************************************
+ *             __________               __   ___.
+ *   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+ *   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+ *   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+ *   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+ *                     \/            \/     \/    \/            \/
+ * $Id$
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Microsecond timer queue. Pending timers are kept in a list sorted by
+ * expiry and the target timer is always programmed to the first of them.
+ ****************************************************************************/
+
+#include "config.h"
+#include "system.h" /* TIME_BEFORE */
+#include "hrtimer.h"
+
+/* Targets without interrupt emulation serialize with the handler by other
+   means */
+#ifndef hrtimer_lock
+#define hrtimer_lock()          disable_irq_save()
+#define hrtimer_unlock(level)   restore_irq(level)
+#endif
+
+/* pending timers, earliest first */
+static struct hrtimer *hrtimer_list;
+
+static void hrtimer_insert(struct hrtimer *t)
+{
+    struct hrtimer **p = &hrtimer_list;
+
+    /* timers expiring at the same time run in the order of registration */
+    while (*p != NULL && !TIME_BEFORE(t->expires, (*p)->expires))
+        p = &(*p)->next;
+
+    t->next = *p;
+    *p = t;
+    t->queued = true;
+}
+
+static void hrtimer_remove(struct hrtimer *t)
+{
+    struct hrtimer **p = &hrtimer_list;
+
+    while (*p != t)
+        p = &(*p)->next;
+
+    *p = t->next;
+    t->queued = false;
+}
+
+static void hrtimer_program(void)
+{
+    if (hrtimer_list != NULL)
+        hrtimer_target_set(hrtimer_list->expires);
+    else
+        hrtimer_target_clear();
+}
+
+void hrtimer_register(struct hrtimer *t, hrtimer_cb_type callback,
+                      long usecs, intptr_t data)
+{
+    if (t == NULL)
+        return;
+
+    int oldlevel = hrtimer_lock();
+    struct hrtimer *first = hrtimer_list;
+
+    if (t->queued)
+        hrtimer_remove(t);
+
+    t->callback = callback;
+    t->data = data;
+    t->expires = hrtimer_now() + usecs;
+    hrtimer_insert(t);
+
+    if (hrtimer_list != first || t == first)
+        hrtimer_program();
+
+    hrtimer_unlock(oldlevel);
+}
+
+void hrtimer_cancel(struct hrtimer *t)
+{
+    int oldlevel = hrtimer_lock();
+
+    if (t->queued)
+    {
+        bool first = t == hrtimer_list;
+        hrtimer_remove(t);
+        if (first)
+            hrtimer_program();
+    }
+
+    hrtimer_unlock(oldlevel);
+}
+
+void hrtimer_interrupt(void)
+{
+    int oldlevel = hrtimer_lock();
+    long now = hrtimer_now();
+
+    while (hrtimer_list != NULL && !TIME_BEFORE(now, hrtimer_list->expires))
+    {
+        struct hrtimer *t = hrtimer_list;
+        hrtimer_remove(t);
+
+        long usecs = t->callback(t);
+
+        /* reload, unless the callback registered it again itself */
+        if (usecs > 0 && !t->queued)
+        {
+            t->expires += usecs;
+            if (TIME_BEFORE(t->expires, now))
+                t->expires = now + usecs; /* fell behind - don't catch up */
+            hrtimer_insert(t);
+        }
+
+        now = hrtimer_now();
+    }
+
+    hrtimer_program();
+    hrtimer_unlock(oldlevel);
+}
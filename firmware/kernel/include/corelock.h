@@ -37,6 +37,21 @@
 #define corelock_unlock(cl) \
     do {} while (0)
 
+#elif defined(HAVE_PTHREAD_THREADS)
+
+#include <pthread.h>
+
+/* The cores are host threads */
+struct corelock
+{
+    pthread_mutex_t mutex;
+};
+
+extern void corelock_init(struct corelock *cl);
+extern void corelock_lock(struct corelock *cl);
+extern int  corelock_try_lock(struct corelock *cl);
+extern void corelock_unlock(struct corelock *cl);
+
 #else
 
 /* No reliable atomic instruction available - use Peterson's algorithm */
@@ -0,0 +1,70 @@
+/***************************************************************************
+ *             __________               __   ___.
+ *   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+ *   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+ *   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+ *   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+ *                     \/            \/     \/    \/            \/
+ * $Id$
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ ****************************************************************************/
+#ifndef HRTIMER_H
+#define HRTIMER_H
+
+#include "config.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/****************************************************************************
+ * Sub-tick one-shot/interval timers. Like the timeout API, but the times are
+ * in microseconds and the expiries are driven by a one-shot hardware timer
+ * that is programmed to the earliest pending one, so nothing waits for the
+ * next tick. Any number of timers may be registered.
+ ****************************************************************************/
+
+struct hrtimer;
+
+/* hrtimer callback - called in interrupt context
+ * t - pointer to struct hrtimer associated with event
+ * return next interval in microseconds or <= 0 to stop the timer
+ */
+typedef long (* hrtimer_cb_type)(struct hrtimer *t);
+
+struct hrtimer
+{
+    struct hrtimer  *next;     /* next timer to expire */
+    hrtimer_cb_type callback;  /* callback - returning <= 0 stops it */
+    intptr_t        data;      /* data passed to callback */
+    long            expires;   /* expiration time in microseconds */
+    bool            queued;    /* timer is pending */
+};
+
+/* Calls the callback 'usecs' microseconds from now - calling with a pending
+   timer restarts it - can be called from the ISR and from callbacks */
+void hrtimer_register(struct hrtimer *t, hrtimer_cb_type callback,
+                      long usecs, intptr_t data);
+/* Cancels a pending timer - can be called from the ISR */
+void hrtimer_cancel(struct hrtimer *t);
+
+/* implemented in target tree */
+
+/* Current time in microseconds; wraps around */
+long hrtimer_now(void);
+/* Program the timer to call hrtimer_interrupt() once 'expires' is reached,
+   replacing any earlier setting */
+void hrtimer_target_set(long expires);
+/* No timer is pending anymore */
+void hrtimer_target_clear(void);
+
+/* To be called by the target's timer interrupt handler */
+void hrtimer_interrupt(void);
+
+#endif /* HRTIMER_H */
@@ -33,6 +33,10 @@
 #include "timeout.h"
 #endif
 
+#ifdef HAVE_HRTIMER
+#include "hrtimer.h"
+#endif
+
 #ifdef HAVE_SEMAPHORE_OBJECTS
 #include "semaphore.h"
 #endif
@@ -112,6 +112,7 @@ struct event_queue
     struct queue_event events[QUEUE_LENGTH]; /* list of events */
     unsigned int volatile read;         /* head of queue */
     unsigned int volatile write;        /* tail of queue */
+    bool single_producer;               /* posts take no locks */
 #ifdef HAVE_EXTENDED_MESSAGING_AND_NAME
     struct queue_sender_list * volatile send; /* list of threads waiting for
                                            reply to an event */
@@ -128,7 +129,10 @@ extern void queue_delete(struct event_queue *q);
 extern void queue_wait(struct event_queue *q, struct queue_event *ev);
 extern void queue_wait_w_tmo(struct event_queue *q, struct queue_event *ev,
                              int ticks);
+extern int queue_wait_many(struct event_queue *q, struct queue_event *evs,
+                           int count, int ticks);
 extern void queue_post(struct event_queue *q, long id, intptr_t data);
+extern void queue_enable_single_producer(struct event_queue *q);
 #ifdef HAVE_EXTENDED_MESSAGING_AND_NAME
 extern void queue_enable_queue_send(struct event_queue *q,
                                     struct queue_sender_list *send,
@@ -93,11 +93,11 @@ struct thread_entry;
  *
  * simulator (possibly) doesn't simulate stack usage anyway but well ... */
 
-#if defined(HAVE_SDL_THREADS) || defined(__PCTOOL__)
+#if defined(HAVE_HOST_THREADS) || defined(__PCTOOL__)
 #define DEFAULT_STACK_SIZE 0x100 /* tiny, ignored anyway */
 #else
 #include "asm/thread.h"
-#endif /* HAVE_SDL_THREADS */
+#endif /* HAVE_HOST_THREADS */
 
 extern void yield(void);
 extern unsigned sleep(unsigned ticks);
@@ -192,7 +192,7 @@ int core_get_debug_info(unsigned int core, struct core_debug_info *infop);
 
 #endif /* NUM_CORES */
 
-#ifdef HAVE_SDL_THREADS
+#ifdef HAVE_HOST_THREADS
 #define IF_SDL(x...) x
 #define IFN_SDL(x...)
 #else
@@ -204,7 +204,7 @@ struct thread_debug_info
 {
     char         statusstr[4];
     char         name[32];
-#ifndef HAVE_SDL_THREADS
+#ifndef HAVE_HOST_THREADS
     unsigned int stack_usage;
 #endif
 #if NUM_CORES > 1
@@ -214,8 +214,22 @@ struct thread_debug_info
     int          base_priority;
     int          current_priority;
 #endif
+#ifdef HAVE_THREAD_CPU_TIME
+    bool          stack_warn;   /* stack got within an eighth of its end */
+    unsigned long cpu_time;     /* CPU time used in microseconds (wraps) */
+#ifdef HAVE_SCHEDULER_BOOSTCTRL
+    unsigned long boost_ticks;  /* ticks spent with a boost request held */
+    unsigned int  boost_count;  /* number of boost requests */
+#endif
+#endif /* HAVE_THREAD_CPU_TIME */
 };
 int thread_get_debug_info(unsigned int thread_id,
                           struct thread_debug_info *infop);
 
+#ifdef HAVE_THREAD_CPU_TIME
+/* Time a core spent idle in microseconds (wraps) - the CPU time of its
+   threads and this add up to the time passed */
+unsigned long core_idle_time(IF_COP_VOID(unsigned int core));
+#endif
+
 #endif /* THREAD_H */
@@ -64,4 +64,28 @@ extern void tick_start(unsigned int interval_in_ms) INIT_ATTR;
 extern int tick_add_task(void (*f)(void));
 extern int tick_remove_task(void (*f)(void));
 
+#ifdef HAVE_TICKLESS_IDLE
+/* Longest stretch of ticks that are skipped while the core is idle. The tick
+ * tasks run for each of them afterwards, so this bounds how late polling
+ * tick tasks (buttons...) may notice something; the pending timeouts bound
+ * it too. */
+#ifndef TICK_IDLE_MAX_TICKS
+#define TICK_IDLE_MAX_TICKS (HZ/10)
+#endif
+
+/* Called by the scheduler before the core goes to sleep with nothing to run
+ * (with interrupts disabled) and after it woke up again (with interrupts
+ * enabled, as the core sleep enables them). next_tick is the tick of the
+ * earliest thread timeout. */
+extern void tick_idle_enter(long next_tick);
+extern void tick_idle_exit(void);
+
+/* implemented in target tree: don't interrupt before 'ticks' ticks have
+ * passed (but do wake on any other interrupt) and then go back to the
+ * regular period. The tick handler has to call call_tick_tasks() once for
+ * each tick that passed, as usual. */
+extern void tick_target_idle(long ticks);
+extern void tick_target_resume(void);
+#endif /* HAVE_TICKLESS_IDLE */
+
 #endif /* TICK_H */
@@ -42,5 +42,7 @@ struct timeout
 void timeout_register(struct timeout *tmo, timeout_cb_type callback,
                       int ticks, intptr_t data);
 void timeout_cancel(struct timeout *tmo);
+/* Tick of the earliest expiry, a minute from now if none is pending */
+long timeout_next_expiry(void);
 
 #endif /* _KERNEL_H_ */
@@ -1,9 +1,30 @@
+/***************************************************************************
+ *             __________               __   ___.
+ *   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+ *   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+ *   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+ *   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+ *                     \/            \/     \/    \/            \/
+ * $Id$
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ ****************************************************************************/
 #include <pthread.h>
 #include "kernel.h"
 
+/* Core locks are host mutexes - locking and unlocking them orders the
+ * memory accesses of the cores like the barriers on a target would */
+
 void corelock_init(struct corelock *lk)
 {
-    lk->mutex = (pthread_mutex_t) PTHREAD_MUTEX_INITIALIZER;
+    pthread_mutex_init(&lk->mutex, NULL);
 }
 
 void corelock_lock(struct corelock *lk)
@@ -11,6 +32,10 @@ void corelock_lock(struct corelock *lk)
     pthread_mutex_lock(&lk->mutex);
 }
 
+int corelock_try_lock(struct corelock *lk)
+{
+    return pthread_mutex_trylock(&lk->mutex) == 0;
+}
 
 void corelock_unlock(struct corelock *lk)
 {
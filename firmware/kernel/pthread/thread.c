@@ -1,204 +1,479 @@
+/***************************************************************************
+ *             __________               __   ___.
+ *   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+ *   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+ *   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+ *   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+ *                     \/            \/     \/    \/            \/
+ * $Id$
+ *
+ * Kernel threads as host threads that really run in parallel
+ *
+ * Each kernel thread is a pthread. The threads of a core take turns by
+ * holding the core's run lock, so code running on one core sees the same
+ * cooperative scheduling as on a target, while the CPU and the COP run at
+ * the same time on different host processors - like a PortalPlayer target
+ * with both cores enabled. Kernel objects are guarded by their corelocks,
+ * which are host mutexes here.
+ *
+ * Only the codec and buffering threads are put on the COP (see config.h),
+ * so decoding and buffering run alongside everything else. The UI, audio,
+ * voice and all other threads share the CPU and still run one at a time,
+ * and there is no priority scheduling within a core - a thread runs until
+ * it blocks or yields. This is opt-in with configure --pthread-threads; the
+ * default simulator keeps one host thread running at a time.
+ *
+ * A blocked thread gives up its core and waits on its own condition
+ * variable, which the waking thread signals with the thread's slot lock
+ * held, so no wakeup gets lost between blocking on an object and waiting.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ ****************************************************************************/
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <errno.h>
+#include <time.h>
 #include <pthread.h>
-#include "/usr/include/semaphore.h"
-#include "thread-internal.h"
-#include "kernel.h"
+#include "system.h"
+#include "thread-sdl.h"
+#include "../kernel-internal.h"
 
-#define NSEC_PER_SEC 1000000000L
-static inline void timespec_add_ns(struct timespec *a, uint64_t ns)
+#define THREAD_PANICF(str...) \
+    ({ fprintf(stderr, str); exit(-1); })
+
+#define NSEC_PER_TICK   (1000000000L / HZ)
+
+#define THREADS_RUN                 0
+#define THREADS_EXIT                1
+#define THREADS_EXIT_COMMAND_DONE   2
+static volatile int threads_status = THREADS_RUN;
+
+__thread unsigned int sim_thread_core; /* CPU unless set by runthread() */
+
+/* The thread holding the run lock of a core is the one running on it. The
+ * lock is handed out in the order it was asked for, so a yield() lets every
+ * other runnable thread of the core have its turn first. */
+static struct run_lock
 {
-    lldiv_t q = lldiv(a->tv_nsec + ns, NSEC_PER_SEC);
-    a->tv_sec += q.quot;
-    a->tv_nsec = q.rem;
+    pthread_mutex_t mtx;
+    pthread_cond_t cond;
+    unsigned long next;     /* next ticket to hand out */
+    unsigned long serving;  /* ticket of the thread holding the core */
+} run_locks[NUM_CORES];
+
+/* host threads not yet exited, for the shutdown */
+static pthread_mutex_t exit_mtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t exit_cond = PTHREAD_COND_INITIALIZER;
+static int threads_alive;
+
+/* host time of tick 0, for the timeouts */
+static int64_t time_base;
+
+static void run_lock(unsigned int core)
+{
+    struct run_lock *rl = &run_locks[core];
+
+    pthread_mutex_lock(&rl->mtx);
+
+    unsigned long ticket = rl->next++;
+    while (ticket != rl->serving)
+        pthread_cond_wait(&rl->cond, &rl->mtx);
+
+    pthread_mutex_unlock(&rl->mtx);
 }
 
-static int threads_initialized;
+static void run_unlock(unsigned int core)
+{
+    struct run_lock *rl = &run_locks[core];
 
-struct thread_init_data {
-    void (*function)(void);
-    bool start_frozen;
-    sem_t init_sem;
-    struct thread_entry *entry;
-};
+    pthread_mutex_lock(&rl->mtx);
+    rl->serving++;
+    pthread_cond_broadcast(&rl->cond);
+    pthread_mutex_unlock(&rl->mtx);
+}
 
-__thread struct thread_entry *_current;
+static int64_t time_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
 
-unsigned int thread_self(void)
+static void set_timeout(struct thread_entry *thread, int64_t ns)
 {
-    return (unsigned) pthread_self();
+    thread->context.tmo.tv_sec = ns / 1000000000;
+    thread->context.tmo.tv_nsec = ns % 1000000000;
 }
 
-static struct thread_entry_item {
-    unsigned thread_id;
-    struct thread_entry *entry;
-} entry_lookup[32];
+/* Wait until the thread may run again. Must not hold its core. */
+static void wait_runnable(struct thread_entry *thread)
+{
+    struct regs *context = &thread->context;
 
+    corelock_lock(&thread->slot_cl);
 
+    while (thread->state != STATE_RUNNING && threads_status == THREADS_RUN)
+    {
+        if (thread->state < TIMEOUT_STATE_FIRST ||
+            thread->state == STATE_FROZEN)
+        {
+            pthread_cond_wait(&context->wake, &thread->slot_cl.mutex);
+        }
+        else if (pthread_cond_timedwait(&context->wake,
+                                        &thread->slot_cl.mutex,
+                                        &context->tmo) == ETIMEDOUT)
+        {
+            /* A timed out thread stays on the object's wait queue until
+               it takes itself off */
+            thread->state = STATE_RUNNING;
+        }
+    }
 
-static struct thread_entry_item *__find_thread_entry(unsigned thread_id)
+    corelock_unlock(&thread->slot_cl);
+}
+
+void sim_thread_shutdown(void)
 {
-    int i;
-    
-    for (i = 0; i < 32; i++)
+    /* Every thread exits when it next gets its core; wake those that wait
+       for something else */
+    threads_status = THREADS_EXIT;
+
+    for (unsigned int i = 0; i < MAXTHREADS; i++)
     {
-        if (entry_lookup[i].thread_id == thread_id)
-            return &entry_lookup[i];
+        struct thread_entry *thread = __thread_slot_entry(i);
+        corelock_lock(&thread->slot_cl);
+        pthread_cond_signal(&thread->context.wake);
+        corelock_unlock(&thread->slot_cl);
     }
-    return NULL;
+
+    pthread_mutex_lock(&exit_mtx);
+    while (threads_alive > 0)
+        pthread_cond_wait(&exit_cond, &exit_mtx);
+    pthread_mutex_unlock(&exit_mtx);
+
+    /* Signal completion of operation */
+    threads_status = THREADS_EXIT_COMMAND_DONE;
 }
 
-static struct thread_entry *find_thread_entry(unsigned thread_id)
+void sim_thread_exception_wait(void)
 {
-    return __find_thread_entry(thread_id)->entry;
+    while (1)
+    {
+        sleep(HZ/10);
+        if (threads_status != THREADS_RUN)
+            thread_exit();
+    }
 }
 
-static void *trampoline(void *arg)
+/* A way to yield and leave the threading system for extended periods */
+void sim_thread_lock(void *me)
 {
-    struct thread_init_data *data = arg;
+    run_lock(CURRENT_CORE);
+    __running_self_entry() = (struct thread_entry *)me;
+
+    if (threads_status != THREADS_RUN)
+        thread_exit();
+}
 
-    void (*thread_fn)(void) = data->function;
+void * sim_thread_unlock(void)
+{
+    struct thread_entry *current = __running_self_entry();
+    run_unlock(CURRENT_CORE);
+    return current;
+}
+
+void switch_thread(void)
+{
+    struct thread_entry *current = __running_self_entry();
+    const unsigned int core = CURRENT_CORE;
 
-    _current = data->entry;
+    enable_irq();
+
+    run_unlock(core);
+
+    /* Any other thread waiting for the core already gets it first */
+    if (current->state != STATE_RUNNING)
+        wait_runnable(current);
+
+    run_lock(core);
+
+    __running_self_entry() = current;
+
+    if (threads_status != THREADS_RUN)
+        thread_exit();
+}
 
-    if (data->start_frozen)
+void sleep_thread(int ticks)
+{
+    struct thread_entry *current = __running_self_entry();
+    int64_t since = time_now() - time_base;
+
+    corelock_lock(&current->slot_cl);
+    current->state = STATE_SLEEPING;
+    /* to the end of the current tick and as many more */
+    set_timeout(current, time_base +
+                (since / NSEC_PER_TICK + 1 + ticks) * NSEC_PER_TICK);
+    corelock_unlock(&current->slot_cl);
+}
+
+void block_thread_(struct thread_entry *current, int ticks)
+{
+    corelock_lock(&current->slot_cl);
+
+    if (ticks < 0)
+        current->state = STATE_BLOCKED;
+    else
     {
-        struct corelock thaw_lock;
-        corelock_init(&thaw_lock);
-        corelock_lock(&thaw_lock);
+        current->state = STATE_BLOCKED_W_TMO;
+        set_timeout(current, time_now() + (int64_t)ticks * NSEC_PER_TICK);
+    }
+
+    wait_queue_register(current);
+
+    corelock_unlock(&current->slot_cl);
+}
+
+unsigned int wakeup_thread_(struct thread_entry *thread)
+{
+    unsigned int result = THREAD_NONE;
 
-        _current->lock = &thaw_lock;
-        sem_post(&data->init_sem);
-        block_thread_switch(_current, _current->lock);
-        _current->lock = NULL;
+    corelock_lock(&thread->slot_cl);
 
-        corelock_unlock(&thaw_lock);
+    switch (thread->state)
+    {
+    case STATE_BLOCKED:
+    case STATE_BLOCKED_W_TMO:
+        wait_queue_remove(thread);
+        thread->state = STATE_RUNNING;
+        pthread_cond_signal(&thread->context.wake);
+        result = THREAD_OK;
+        break;
+
+    case STATE_RUNNING:
+        if (wait_queue_try_remove(thread))
+            result = THREAD_OK; /* timed out */
+        break;
     }
-    else
-        sem_post(&data->init_sem);
 
-    free(data);
-    thread_fn();
+    corelock_unlock(&thread->slot_cl);
 
-    return NULL;
+    return result;
 }
 
 void thread_thaw(unsigned int thread_id)
 {
-    struct thread_entry *e = find_thread_entry(thread_id);
-    if (e->lock)
+    struct thread_entry *thread = __thread_id_entry(thread_id);
+
+    corelock_lock(&thread->slot_cl);
+
+    if (thread->id == thread_id && thread->state == STATE_FROZEN)
     {
-        corelock_lock(e->lock);
-        wakeup_thread(e);
-        corelock_unlock(e->lock);
+        thread->state = STATE_RUNNING;
+        pthread_cond_signal(&thread->context.wake);
     }
-    /* else: no lock. must be running already */
+
+    corelock_unlock(&thread->slot_cl);
 }
 
-void init_threads(void)
+static void * runthread(void *data)
 {
-    struct thread_entry_item *item0 = &entry_lookup[0];
-    item0->entry = calloc(1, sizeof(struct thread_entry));
-    item0->thread_id = pthread_self();
+    struct thread_entry *current = data;
 
-    _current = item0->entry;
-    pthread_cond_init(&item0->entry->cond, NULL);
-    threads_initialized = 1;
-}
+    sim_thread_core = current->core;
+
+    /* frozen threads wait for thread_thaw() */
+    wait_runnable(current);
+
+    run_lock(current->core);
+    __running_self_entry() = current;
 
+    if (threads_status == THREADS_RUN)
+        current->context.start();
+
+    thread_exit();
+    return NULL;
+}
 
 unsigned int create_thread(void (*function)(void),
                            void* stack, size_t stack_size,
-                           unsigned flags, const char *name
-                           //~ IF_PRIO(, int priority)
-                           IF_COP(, unsigned int core))
+                           unsigned flags, const char *name,
+                           unsigned int core)
 {
-    pthread_t retval;
+    pthread_attr_t attr;
+    pthread_t t;
 
-    struct thread_init_data *data = calloc(1, sizeof(struct thread_init_data));
-    struct thread_entry *entry = calloc(1, sizeof(struct thread_entry));
-    struct thread_entry_item *item;
+    struct thread_entry *thread = thread_alloc();
+    if (thread == NULL)
+    {
+        DEBUGF("Failed to find thread slot\n");
+        return 0;
+    }
 
-    if (!threads_initialized)
-        abort();
+    thread->name = name;
+    thread->core = core;
+    thread->state = (flags & CREATE_THREAD_FROZEN) ?
+        STATE_FROZEN : STATE_RUNNING;
+    thread->context.start = function;
 
-    data->function = function;
-    data->start_frozen = flags & CREATE_THREAD_FROZEN;
-    data->entry = entry;
-    pthread_cond_init(&entry->cond, NULL);         
-    entry->runnable = true;
+    pthread_mutex_lock(&exit_mtx);
+    threads_alive++;
+    pthread_mutex_unlock(&exit_mtx);
 
-    sem_init(&data->init_sem, 0, 0);
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int rc = pthread_create(&t, &attr, runthread, thread);
+    pthread_attr_destroy(&attr);
 
-    if (pthread_create(&retval, NULL, trampoline, data) < 0)
-        return -1;
+    if (rc != 0)
+    {
+        DEBUGF("Failed to create host thread\n");
+        pthread_mutex_lock(&exit_mtx);
+        threads_alive--;
+        pthread_mutex_unlock(&exit_mtx);
+        thread->state = STATE_KILLED;
+        thread_free(thread);
+        return 0;
+    }
 
-    sem_wait(&data->init_sem);
+    return thread->id;
+    (void)stack; (void)stack_size;
+}
+
+void thread_exit(void)
+{
+    struct thread_entry *current = __running_self_entry();
+    const unsigned int core = CURRENT_CORE;
 
-    item = __find_thread_entry(0);
-    item->thread_id = retval;
-    item->entry = entry;
+    int oldlevel = disable_irq_save();
 
-    pthread_setname_np(retval, name);
-    
+    corelock_lock(&current->waiter_cl);
 
-    return retval;
+    new_thread_id(current);
+    current->state = STATE_KILLED;
+    wait_queue_wake(&current->queue);
+
+    corelock_unlock(&current->waiter_cl);
+
+    restore_irq(oldlevel);
+
+    bool main_thread = THREAD_ID_SLOT(current->id) == 0;
+
+    thread_free(current);
+    run_unlock(core);
+
+    if (main_thread)
+    {
+        /* Wait for the other threads to be gone before exiting for real */
+        while (threads_status < THREADS_EXIT_COMMAND_DONE)
+        {
+            struct timespec ts = { 0, 10000000 };
+            nanosleep(&ts, NULL);
+        }
+
+        sim_do_exit();
+    }
+
+    pthread_mutex_lock(&exit_mtx);
+    if (--threads_alive == 0)
+        pthread_cond_signal(&exit_cond);
+    pthread_mutex_unlock(&exit_mtx);
+
+    pthread_exit(NULL);
 }
 
-/* for block_thread(), _w_tmp() and wakeup_thread() t->lock must point
- * to a corelock instance, and this corelock must be held by the caller */
-void block_thread_switch(struct thread_entry *t, struct corelock *cl)
+void thread_wait(unsigned int thread_id)
 {
-    t->runnable = false;
-    if (wait_queue_ptr(t))
-        wait_queue_register(t);
-    while(!t->runnable)
-        pthread_cond_wait(&t->cond, &cl->mutex);
+    struct thread_entry *current = __running_self_entry();
+    struct thread_entry *thread = __thread_id_entry(thread_id);
+
+    int oldlevel = disable_irq_save();
+    corelock_lock(&thread->waiter_cl);
+
+    if (thread->id == thread_id && thread->state != STATE_KILLED)
+    {
+        block_thread(current, TIMEOUT_BLOCK, &thread->queue, NULL);
+        corelock_unlock(&thread->waiter_cl);
+        switch_thread();
+        return;
+    }
+
+    corelock_unlock(&thread->waiter_cl);
+    restore_irq(oldlevel);
 }
 
-void block_thread_switch_w_tmo(struct thread_entry *t, int timeout,
-                               struct corelock *cl)
+unsigned int switch_core(unsigned int new_core)
 {
-    int err = 0;
-    struct timespec ts;
+    struct thread_entry *current = __running_self_entry();
+    const unsigned int old_core = CURRENT_CORE;
 
-    clock_gettime(CLOCK_REALTIME, &ts);
-    timespec_add_ns(&ts, timeout * (NSEC_PER_SEC/HZ));
+    if (new_core == old_core)
+        return old_core;
 
-    t->runnable = false;
-    wait_queue_register(t->wqp, t);
-    while(!t->runnable && !err)
-        err = pthread_cond_timedwait(&t->cond, &cl->mutex, &ts);
+    corelock_lock(&current->slot_cl);
+    current->core = new_core;
+    corelock_unlock(&current->slot_cl);
 
-    if (err == ETIMEDOUT)
-    {   /* the thread timed out and was not explicitely woken up.
-         * we need to do this now to mark it runnable again */
-        t->runnable = true;
-        /* NOTE: objects do their own removal upon timer expiration */
-    }
+    run_unlock(old_core);
+    sim_thread_core = new_core;
+    run_lock(new_core);
+
+    __running_self_entry() = current;
+
+    return old_core;
 }
 
-unsigned int wakeup_thread(struct thread_entry *t)
+void core_idle(void)
 {
-    if (t->wqp)
-        wait_queue_remove(t);
-    t->runnable = true;
-    pthread_cond_signal(&t->cond);
-    return THREAD_OK;
+    /* the host does the idling */
+    yield();
 }
 
+void core_wake(unsigned int core)
+{
+    (void)core;
+}
 
-void yield(void) {}
-
-unsigned sleep(unsigned ticks)
+/* Initialize threading */
+void init_threads(void)
 {
-    struct timespec ts;
+    pthread_condattr_t attr;
+
+    /* the timeouts are on the clock the tick is counted with */
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+
+    for (unsigned int core = 0; core < NUM_CORES; core++)
+    {
+        pthread_mutex_init(&run_locks[core].mtx, NULL);
+        pthread_cond_init(&run_locks[core].cond, NULL);
+    }
+
+    thread_alloc_init();
+
+    for (unsigned int i = 0; i < MAXTHREADS; i++)
+        pthread_cond_init(&__thread_slot_entry(i)->context.wake, &attr);
+
+    pthread_condattr_destroy(&attr);
+
+    time_base = time_now();
 
-    ts.tv_sec = ticks/HZ;
-    ts.tv_nsec = (ticks % HZ) * (NSEC_PER_SEC/HZ);
+    struct thread_entry *thread = thread_alloc();
+    if (thread == NULL)
+        THREAD_PANICF("Main thread alloc failed\n");
 
-    nanosleep(&ts, NULL);
+    /* Slot 0 is the main thread, which is already running */
+    thread->name = __main_thread_name;
+    thread->state = STATE_RUNNING;
+    thread->core = CPU;
 
-    return 0;
+    run_lock(CPU);
+    __running_self_entry() = thread;
 }
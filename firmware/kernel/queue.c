@@ -32,6 +32,16 @@ static struct
 #endif
 } all_queues SHAREDBSS_ATTR;
 
+/* Orders the memory accesses of the lock-free single producer path against
+ * those of the receiver. The cores of the native targets keep the objects
+ * they share in uncached memory, so there it's enough to keep the compiler
+ * from reordering. */
+#ifdef HAVE_PTHREAD_THREADS
+#define queue_barrier() __sync_synchronize()
+#else
+#define queue_barrier() asm volatile ("" : : : "memory")
+#endif
+
 /****************************************************************************
  * Queue handling stuff
  ****************************************************************************/
@@ -114,6 +124,9 @@ void queue_enable_queue_send(struct event_queue *q,
     int oldlevel = disable_irq_save();
     corelock_lock(&q->cl);
 
+    KERNEL_ASSERT(!q->single_producer,
+                  "queue_enable_queue_send->single producer q=%08lX", (long)q);
+
     if(send != NULL && q->send == NULL)
     {
         memset(send, 0, sizeof(*send));
@@ -192,6 +205,22 @@ static inline void queue_wake_waiter(struct event_queue *q)
         queue_wake_waiter_inner(thread);
 }
 
+/* Receiver half of the single producer handshake: the producer publishes
+ * events without the lock and only then looks for a waiter, so after
+ * registering as one check once more that nothing was posted since the
+ * queue was found empty at 'wr' - or else nobody would wake us. */
+static inline void queue_wait_recheck(struct event_queue *q,
+                                      struct thread_entry *current,
+                                      unsigned int wr)
+{
+    if(q->single_producer)
+    {
+        queue_barrier();
+        if(q->write != wr)
+            wakeup_thread(current, WAKEUP_DEFAULT);
+    }
+}
+
 /* Queue must not be available for use during this call */
 void queue_init(struct event_queue *q, bool register_queue)
 {
@@ -207,6 +236,7 @@ void queue_init(struct event_queue *q, bool register_queue)
      * queue_count and queue_empty return sane values in the case of a
      * concurrent change without locking inside them. */
     q->read = q->write;
+    q->single_producer = false;
 #ifdef HAVE_EXTENDED_MESSAGING_AND_NAME
     q->send = NULL; /* No message sending by default */
     IF_PRIO( q->blocker_p = NULL; )
@@ -233,6 +263,33 @@ void queue_init(struct event_queue *q, bool register_queue)
     restore_irq(oldlevel);
 }
 
+/* Lets queue_post() skip the locks on a queue that only ever has one thread
+ * or interrupt handler posting to it and one thread receiving. The lock is
+ * then taken only when the receiver has to be woken. Such a queue can't be
+ * registered for broadcasts nor take queue_send(), and only the receiver may
+ * remove events from it. */
+void queue_enable_single_producer(struct event_queue *q)
+{
+    int oldlevel = disable_irq_save();
+    corelock_lock(&all_queues.cl);
+    corelock_lock(&q->cl);
+
+    KERNEL_ASSERT(*find_array_ptr((void **)all_queues.queues, q) == NULL,
+                  "queue_enable_single_producer->registered q=%08lX",
+                  (long)q);
+#ifdef HAVE_EXTENDED_MESSAGING_AND_NAME
+    KERNEL_ASSERT(q->send == NULL,
+                  "queue_enable_single_producer->queue_send q=%08lX",
+                  (long)q);
+#endif
+
+    q->single_producer = true;
+
+    corelock_unlock(&q->cl);
+    corelock_unlock(&all_queues.cl);
+    restore_irq(oldlevel);
+}
+
 /* Queue must not be available for use during this call */
 void queue_delete(struct event_queue *q)
 {
@@ -274,7 +331,7 @@ void queue_delete(struct event_queue *q)
 void queue_wait(struct event_queue *q, struct queue_event *ev)
 {
     int oldlevel;
-    unsigned int rd;
+    unsigned int rd, wr;
 
 #ifdef HAVE_PRIORITY_SCHEDULING
     KERNEL_ASSERT(QUEUE_GET_THREAD(q) == NULL ||
@@ -293,11 +350,13 @@ void queue_wait(struct event_queue *q, struct queue_event *ev)
     while(1)
     {
         rd = q->read;
-        if (rd != q->write) /* A waking message could disappear */
+        wr = q->write;
+        if (rd != wr) /* A waking message could disappear */
             break;
 
         struct thread_entry *current = __running_self_entry();
         block_thread(current, TIMEOUT_BLOCK, &q->queue, NULL);
+        queue_wait_recheck(q, current, wr);
 
         corelock_unlock(&q->cl);
         switch_thread();
@@ -306,6 +365,8 @@ void queue_wait(struct event_queue *q, struct queue_event *ev)
         corelock_lock(&q->cl);
     } 
 
+    queue_barrier(); /* the events were written before the index */
+
 #ifdef HAVE_EXTENDED_MESSAGING_AND_NAME
     if(ev)
 #endif
@@ -348,6 +409,7 @@ void queue_wait_w_tmo(struct event_queue *q, struct queue_event *ev, int ticks)
     {
         struct thread_entry *current = __running_self_entry();
         block_thread(current, ticks, &q->queue, NULL);
+        queue_wait_recheck(q, current, wr);
         corelock_unlock(&q->cl);    
 
         switch_thread();
@@ -361,6 +423,8 @@ void queue_wait_w_tmo(struct event_queue *q, struct queue_event *ev, int ticks)
         wait_queue_try_remove(current);
     }
 
+    queue_barrier(); /* the events were written before the index */
+
 #ifdef HAVE_EXTENDED_MESSAGING_AND_NAME
     if(ev)
 #endif
@@ -386,11 +450,123 @@ void queue_wait_w_tmo(struct event_queue *q, struct queue_event *ev, int ticks)
     restore_irq(oldlevel);
 }
 
+/* Takes up to 'count' events at once, waiting up to 'ticks' for the first
+ * one if the queue is empty (TIMEOUT_BLOCK waits forever). Returns the
+ * number of events taken, 0 on timeout. A receiver handling bursts of
+ * events saves a lock round trip and possibly a wakeup per event this way.
+ *
+ * An event sent with queue_send() ends the batch so that queue_reply()
+ * answers it; any other events taken along are auto-replied with 0 by the
+ * next wait, as a queue_wait() would. */
+int queue_wait_many(struct event_queue *q, struct queue_event *evs,
+                    int count, int ticks)
+{
+    int oldlevel;
+    unsigned int rd, wr;
+    int n = 0;
+
+#ifdef HAVE_EXTENDED_MESSAGING_AND_NAME
+    KERNEL_ASSERT(QUEUE_GET_THREAD(q) == NULL ||
+                  QUEUE_GET_THREAD(q) == __running_self_entry(),
+                  "queue_wait_many->wrong thread\n");
+#endif
+
+    oldlevel = disable_irq_save();
+    corelock_lock(&q->cl);
+
+#ifdef HAVE_EXTENDED_MESSAGING_AND_NAME
+    queue_do_auto_reply(q->send);
+#endif
+
+    rd = q->read;
+    wr = q->write;
+
+    while (rd == wr && ticks != 0)
+    {
+        struct thread_entry *current = __running_self_entry();
+        block_thread(current, ticks, &q->queue, NULL);
+        queue_wait_recheck(q, current, wr);
+        corelock_unlock(&q->cl);
+
+        switch_thread();
+
+        disable_irq();
+        corelock_lock(&q->cl);
+
+        rd = q->read;
+        wr = q->write;
+
+        wait_queue_try_remove(current);
+
+        if (ticks > 0)
+            break; /* timed out or not, the time is up */
+        /* else a waking message could disappear */
+    }
+
+    queue_barrier(); /* the events were written before the index */
+
+    while (rd != wr && n < count)
+    {
+        unsigned int i = rd++ & QUEUE_LENGTH_MASK;
+        evs[n++] = q->events[i];
+
+#ifdef HAVE_EXTENDED_MESSAGING_AND_NAME
+        if (q->send && q->send->senders[i])
+        {
+            queue_do_fetch_sender(q->send, i);
+            break;
+        }
+#endif
+    }
+
+    q->read = rd;
+
+    corelock_unlock(&q->cl);
+    restore_irq(oldlevel);
+
+    return n;
+}
+
+/* Only the producer changes q->write and only the receiver q->read, so the
+ * event is published without locks. The producer looks for a waiter after
+ * publishing and the receiver checks for events again after registering as
+ * one (queue_wait_recheck()), so one of them always sees the other. */
+static void queue_post_single_producer(struct event_queue *q,
+                                       long id, intptr_t data)
+{
+    unsigned int wr = q->write;
+
+    KERNEL_ASSERT((wr - q->read) < QUEUE_LENGTH,
+                  "queue_post ovf q=%08lX", (long)q);
+
+    q->events[wr & QUEUE_LENGTH_MASK].id   = id;
+    q->events[wr & QUEUE_LENGTH_MASK].data = data;
+
+    queue_barrier(); /* the event before the index */
+    q->write = wr + 1;
+    queue_barrier(); /* the index before looking for a waiter */
+
+    if(UNLIKELY(WQ_THREAD_FIRST(&q->queue) != NULL))
+    {
+        int oldlevel = disable_irq_save();
+        corelock_lock(&q->cl);
+        queue_wake_waiter(q);
+        corelock_unlock(&q->cl);
+        restore_irq(oldlevel);
+    }
+}
+
 void queue_post(struct event_queue *q, long id, intptr_t data)
 {
     int oldlevel;
     unsigned int wr;
 
+    if(q->single_producer)
+    {
+        queue_post_single_producer(q, id, data);
+        return;
+    }
+
     oldlevel = disable_irq_save();
     corelock_lock(&q->cl);
 
@@ -420,6 +596,9 @@ intptr_t queue_send(struct event_queue *q, long id, intptr_t data)
     int oldlevel;
     unsigned int wr;
 
+    KERNEL_ASSERT(!q->single_producer,
+                  "queue_send->single producer q=%08lX", (long)q);
+
     oldlevel = disable_irq_save();
     corelock_lock(&q->cl);
 
@@ -527,6 +706,8 @@ bool queue_peek_ex(struct event_queue *q, struct queue_event *ev,
     oldlevel = disable_irq_save();
     corelock_lock(&q->cl);
 
+    queue_barrier(); /* the events were written before the index */
+
     /* Starting at the head, find first match  */
     for(rd = q->read, wr = q->write; rd != wr; rd++)
     {
@@ -631,6 +812,7 @@ bool queue_peek(struct event_queue *q, struct queue_event *ev)
     rd = q->read;
     if(rd != q->write)
     {
+        queue_barrier(); /* the events were written before the index */
         *ev = q->events[rd & QUEUE_LENGTH_MASK];
         have_msg = true;
     }
@@ -20,6 +20,9 @@
  ****************************************************************************/
 #include "kernel-internal.h"
 #include "system.h"
+#ifdef HAVE_HRTIMER
+#include "hrtimer.h"
+#endif
 
 /* Unless otherwise defined, do nothing */
 #ifndef YIELD_KERNEL_HOOK
@@ -76,7 +79,12 @@ void thread_alloc_init(void)
     #else
         struct core_entry *c = &__cores[core];
     #endif
+    #ifdef HAVE_PRIORITY_SCHEDULING
+        for (unsigned int priority = 0; priority < NUM_PRIORITIES; priority++)
+            rtr_queue_init(&c->rtr[priority]);
+    #else
         rtr_queue_init(&c->rtr);
+    #endif
         corelock_init(&c->rtr_cl);
         tmo_queue_init(&c->tmo);
         c->next_tmo_check = current_tick; /* Something not in the past */
@@ -157,6 +165,34 @@ unsigned int wait_queue_wake(struct __wait_queue *wqp)
     return result;
 }
 
+#ifdef HAVE_HRTIMER
+/*---------------------------------------------------------------------------
+ * A sleeping thread that is woken by an hrtimer instead of at a tick
+ *---------------------------------------------------------------------------
+ */
+struct sleep_timer
+{
+    struct hrtimer hrt;
+    struct __wait_queue queue; /* the sleeping thread */
+    IF_COP( struct corelock cl; )
+};
+
+static long sleep_timer_cb(struct hrtimer *hrt)
+{
+    struct sleep_timer *st = (struct sleep_timer *)hrt->data;
+
+    corelock_lock(&st->cl);
+
+    struct thread_entry *thread = WQ_THREAD_FIRST(&st->queue);
+    if (thread)
+        wakeup_thread(thread, WAKEUP_DEFAULT);
+
+    corelock_unlock(&st->cl);
+
+    return 0; /* one-shot */
+}
+#endif /* HAVE_HRTIMER */
+
 
 /** Public functions **/
 
@@ -187,6 +223,8 @@ unsigned int thread_self(void)
  *                      n <= ticks suspended < n + 1
  *       n to n+1 is a lower bound. Other factors may affect the actual time
  *       a thread is suspended before it runs again.
+ *       With HAVE_HRTIMER, sleep(n) lasts n tick periods from the call
+ *       instead, as it isn't ended by the tick.
  *---------------------------------------------------------------------------
  */
 unsigned sleep(unsigned ticks)
@@ -196,6 +234,38 @@ unsigned sleep(unsigned ticks)
     if (SLEEP_KERNEL_HOOK(ticks))
         return 0; /* Handled */
 
+#ifdef HAVE_HRTIMER
+    if (ticks > 0)
+    {
+        struct thread_entry *current = __running_self_entry();
+        struct sleep_timer st;
+
+        st.hrt.queued = false;
+        wait_queue_init(&st.queue);
+        corelock_init(&st.cl);
+
+        /* The timeout only ends it should the timer fail to */
+        disable_irq();
+        corelock_lock(&st.cl);
+        block_thread(current, ticks + 1, &st.queue, NULL);
+        hrtimer_register(&st.hrt, sleep_timer_cb, ticks * (1000000 / HZ),
+                         (intptr_t)&st);
+        corelock_unlock(&st.cl);
+        switch_thread();
+
+        /* Nothing may refer to the stack once this returns */
+        hrtimer_cancel(&st.hrt);
+
+        int oldlevel = disable_irq_save();
+        corelock_lock(&st.cl);
+        wait_queue_try_remove(current);
+        corelock_unlock(&st.cl);
+        restore_irq(oldlevel);
+
+        return 0;
+    }
+#endif /* HAVE_HRTIMER */
+
     disable_irq();
     sleep_thread(ticks);
     switch_thread();
@@ -231,7 +301,7 @@ void format_thread_name(char *buf, size_t bufsize,
     snprintf(buf, bufsize, fmt, name, thread->id);
 }
 
-#ifndef HAVE_SDL_THREADS
+#ifndef HAVE_HOST_THREADS
 /*---------------------------------------------------------------------------
  * Returns the maximum percentage of the stack ever used during runtime.
  *---------------------------------------------------------------------------
@@ -252,17 +322,21 @@ static unsigned int stack_usage(uintptr_t *stackptr, size_t stack_size)
 
     return usage;
 }
-#endif /* HAVE_SDL_THREADS */
+#endif /* HAVE_HOST_THREADS */
 
 #if NUM_CORES > 1
 int core_get_debug_info(unsigned int core, struct core_debug_info *infop)
 {
-    extern uintptr_t * const idle_stacks[NUM_CORES];
-
     if (core >= NUM_CORES || !infop)
         return -1;
 
+#ifdef HAVE_HOST_THREADS
+    /* the host does the idling */
+    infop->idle_stack_usage = 0;
+#else
+    extern uintptr_t * const idle_stacks[NUM_CORES];
     infop->idle_stack_usage = stack_usage(idle_stacks[core], IDLE_STACK_SIZE);
+#endif
     return 1;
 }
 #endif /* NUM_CORES > 1 */
@@ -304,7 +378,7 @@ int thread_get_debug_info(unsigned int thread_id,
 #ifdef HAVE_SCHEDULER_BOOSTCTRL
         cpu_boost = thread->cpu_boost;
 #endif
-#ifndef HAVE_SDL_THREADS
+#ifndef HAVE_HOST_THREADS
         infop->stack_usage = stack_usage(thread->stack, thread->stack_size);
 #endif
 #if NUM_CORES > 1
@@ -314,6 +388,16 @@ int thread_get_debug_info(unsigned int thread_id,
         infop->base_priority = thread->base_priority;
         infop->current_priority = thread->priority;
 #endif
+#ifdef HAVE_THREAD_CPU_TIME
+        infop->stack_warn = thread->stack_warn;
+        infop->cpu_time = thread->cpu_time;
+#ifdef HAVE_SCHEDULER_BOOSTCTRL
+        infop->boost_ticks = thread->boost_ticks;
+        if (cpu_boost)
+            infop->boost_ticks += current_tick - thread->boost_tick;
+        infop->boost_count = thread->boost_count;
+#endif
+#endif /* HAVE_THREAD_CPU_TIME */
 
         snprintf(infop->statusstr, sizeof (infop->statusstr), "%c%c",
                  cpu_boost ? '+' : (state == STATE_RUNNING ? '*' : ' '),
@@ -41,6 +41,17 @@ struct regs
     void (*start)(void); /* Start function */
 };
 
+#define DEFAULT_STACK_SIZE 0x100 /* tiny, ignored anyway */
+#elif defined(HAVE_PTHREAD_THREADS)
+#include <pthread.h>
+#include <time.h>
+struct regs
+{
+    pthread_cond_t wake;     /* Signalled when the thread may run again */
+    struct timespec tmo;     /* Host time at which a timed wait ends */
+    void (*start)(void);     /* Start function */
+};
+
 #define DEFAULT_STACK_SIZE 0x100 /* tiny, ignored anyway */
 #else
 #include "asm/thread.h"
@@ -92,7 +103,7 @@ struct thread_entry
 {
     struct regs context;         /* Register context at switch -
                                     _must_ be first member */
-#ifndef HAVE_SDL_THREADS
+#ifndef HAVE_HOST_THREADS
     uintptr_t *stack;            /* Pointer to top of stack */
 #endif
     const char *name;            /* Thread name */
@@ -127,7 +138,7 @@ struct thread_entry
     unsigned char priority;      /* Scheduled priority (higher of base or
                                     all threads blocked by this one) */
 #endif
-#ifndef HAVE_SDL_THREADS
+#ifndef HAVE_HOST_THREADS
     unsigned short stack_size;   /* Size of stack in bytes */
 #endif
     unsigned char state;         /* Thread slot state (STATE_*) */
@@ -137,6 +148,15 @@ struct thread_entry
 #ifdef HAVE_IO_PRIORITY
     unsigned char io_priority;
 #endif
+#ifdef HAVE_THREAD_CPU_TIME
+    bool stack_warn;             /* Stack got within an eighth of its end */
+    unsigned long cpu_time;      /* CPU time used in microseconds (wraps) */
+#ifdef HAVE_SCHEDULER_BOOSTCTRL
+    long boost_tick;             /* Tick of the last boost request */
+    unsigned long boost_ticks;   /* Ticks spent boosted before that */
+    unsigned int boost_count;    /* Number of boost requests */
+#endif
+#endif /* HAVE_THREAD_CPU_TIME */
 };
 
 /* Thread ID, 32 bits = |VVVVVVVV|VVVVVVVV|VVVVVVVV|SSSSSSSS| */
@@ -155,16 +175,28 @@ struct core_entry
 {
     /* "Active" lists - core is constantly active on these and are never
        locked and interrupts do not access them */
+#ifdef HAVE_PRIORITY_SCHEDULING
+    struct __rtr_queue rtr[NUM_PRIORITIES]; /* Runnable threads, one FIFO
+                                       for each priority level */
+#else
     struct __rtr_queue rtr;          /* Threads that are runnable */
+#endif
     struct __tmo_queue tmo;          /* Threads on a bounded wait */
     struct thread_entry *running;    /* Currently running thread */
 #ifdef HAVE_PRIORITY_SCHEDULING
-    struct priority_distribution rtr_dist; /* Summary of runnables */
+    struct priority_distribution rtr_dist; /* Summary of runnables - the
+                                       mask has a bit for each level with
+                                       a non-empty FIFO */
 #endif
     long next_tmo_check;             /* Next due timeout check */
 #if NUM_CORES > 1
     struct corelock rtr_cl;          /* Lock for rtr list */
 #endif /* NUM_CORES */
+#ifdef HAVE_THREAD_CPU_TIME
+    unsigned long idle_time;         /* Time spent idle in microseconds */
+    unsigned long last_switch;       /* Accounting clock at the last switch */
+    bool idle;                       /* Core is sleeping in switch_thread */
+#endif
 };
 
 /* Hide a few scheduler details from itself to make allocation more flexible */
@@ -217,6 +249,15 @@ static FORCE_INLINE
 #define THREAD_FROM(p, member) \
     container_of(p, struct thread_entry, member)
 
+/* Run queue of the given priority level */
+#ifdef HAVE_PRIORITY_SCHEDULING
+#define RTR_QUEUE(corep, priority) \
+    ({ &(corep)->rtr[(priority)]; })
+#else
+#define RTR_QUEUE(corep, priority) \
+    ({ &(corep)->rtr; })
+#endif
+
 #define RTR_EMPTY(rtrp) \
     ({ (rtrp)->head == NULL; })
 
@@ -418,8 +459,8 @@ static inline void blocker_splay_init(struct blocker_splay *blsplay)
     blocker_init(&blsplay->blocker);
 #ifdef HAVE_PRIORITY_SCHEDULING
     threadbit_clear(&blsplay->mask);
-#endif
     corelock_init(&blsplay->cl);
+#endif
 }
 
 #endif /* THREAD_INTERNAL_H */
@@ -35,6 +35,7 @@
 #ifdef RB_PROFILE
 #include <profile.h>
 #endif
+#include "trace.h"
 #include "core_alloc.h"
 
 /* Define THREAD_EXTRA_CHECKS as 1 to enable additional state checks */
@@ -44,6 +45,16 @@
 #define THREAD_EXTRA_CHECKS 0
 #endif
 
+#ifdef HAVE_THREAD_CPU_TIME
+/* Clock for the CPU time accounting in microseconds. Without one, the tick
+ * charges a whole tick to whatever it interrupts instead. */
+#if defined(HAVE_HRTIMER)
+#define THREAD_CPU_CLOCK()  ((unsigned long)hrtimer_now())
+#elif defined(USEC_TIMER)
+#define THREAD_CPU_CLOCK()  ((unsigned long)USEC_TIMER)
+#endif
+#endif /* HAVE_THREAD_CPU_TIME */
+
 /****************************************************************************
  *                              ATTENTION!!                                 *
  *    See notes below on implementing processor-specific portions!          *
@@ -139,6 +150,22 @@
  *        \ else         : 0
  *
  *---------------------------------------------------------------------------
+ * Run queues:
+ *
+ * With priority scheduling, each core keeps a FIFO of runnable threads for
+ * every priority level and the core's priority distribution marks the
+ * levels that are not empty. The next thread is the first one of the
+ * highest occupied level, found with a single ffs, however many threads
+ * are runnable. The running thread stays at the front of its FIFO and
+ * goes to the back of it when it gives up the processor, so threads of
+ * equal priority get their turns round robin.
+ *
+ * Lower priority threads age so they don't starve: each time the first
+ * thread of a lower, non-realtime level is passed over, its skip count goes
+ * up and once it exceeds the square of the distance to the highest level
+ * it gets to run once. Only the first thread of each level ages, so the
+ * work is bounded by the number of occupied levels.
+ *---------------------------------------------------------------------------
  * Basic priority inheritance priotocol (PIP):
  *
  * Mn = mutex n, Tn = thread n
@@ -278,10 +305,8 @@ should_switch_tasks(struct thread_entry *thread)
     if (thread->core != core)
         return THREAD_OK;
 #endif
-    /* Just woke something therefore a thread is on the run queue */
-    struct thread_entry *current =
-        RTR_THREAD_FIRST(&__core_id_entry(core)->rtr);
-    if (LIKELY(thread->priority >= current->priority))
+    struct thread_entry *current = __core_id_entry(core)->running;
+    if (LIKELY(current == NULL || thread->priority >= current->priority))
         return THREAD_OK;
 
     /* There is a thread ready to run of higher priority on the same
@@ -372,6 +397,14 @@ static void new_thread_base_init(struct thread_entry *thread,
     /* Default to high (foreground) priority */
     thread->io_priority = IO_PRIORITY_IMMEDIATE;
 #endif
+#ifdef HAVE_THREAD_CPU_TIME
+    thread->stack_warn = false;
+    thread->cpu_time = 0;
+#ifdef HAVE_SCHEDULER_BOOSTCTRL
+    thread->boost_ticks = 0;
+    thread->boost_count = 0;
+#endif
+#endif /* HAVE_THREAD_CPU_TIME */
 }
 
 /*---------------------------------------------------------------------------
@@ -382,7 +415,7 @@ static inline void core_rtr_add(struct core_entry *corep,
                                 struct thread_entry *thread)
 {
     RTR_LOCK(corep);
-    rtr_queue_add(&corep->rtr, thread);
+    rtr_queue_add(RTR_QUEUE(corep, thread->priority), thread);
     rtr_add_entry(corep, thread->priority);
 #ifdef HAVE_PRIORITY_SCHEDULING
     thread->skip_count = thread->base_priority;
@@ -399,7 +432,7 @@ static inline void core_rtr_remove(struct core_entry *corep,
                                    struct thread_entry *thread)
 {
     RTR_LOCK(corep);
-    rtr_queue_remove(&corep->rtr, thread);
+    rtr_queue_remove(RTR_QUEUE(corep, thread->priority), thread);
     rtr_subtract_entry(corep, thread->priority);
     /* Does not demote state */
     RTR_UNLOCK(corep);
@@ -488,11 +521,52 @@ static inline void set_rtr_thread_priority(
     const unsigned int core = IF_COP_CORE(thread->core);
     struct core_entry *corep = __core_id_entry(core);
     RTR_LOCK(corep);
+    rtr_queue_remove(RTR_QUEUE(corep, thread->priority), thread);
     rtr_move_entry(corep, thread->priority, priority);
     thread->priority = priority;
+    rtr_queue_add(RTR_QUEUE(corep, priority), thread);
     RTR_UNLOCK(corep);
 }
 
+/*---------------------------------------------------------------------------
+ * Pick the next thread to run from the core's run queues. The queues must
+ * not all be empty.
+ *---------------------------------------------------------------------------
+ */
+static inline struct thread_entry * rtr_select_thread(struct core_entry *corep)
+{
+    int max = priobit_ffs(&corep->rtr_dist.mask);
+    struct thread_entry *thread = RTR_THREAD_FIRST(RTR_QUEUE(corep, max));
+
+    /* Age the first thread of each lower level. Priorities of REALTIME
+     * class are run strictly according to priority thus are not subject to
+     * switchout due to lower-priority processes aging; they must give up
+     * the processor by going off the run list. */
+    priobit_t lower = corep->rtr_dist.mask;
+    priobit_clear_bit(&lower, max);
+
+    int priority;
+    while ((priority = priobit_ffs(&lower)) < NUM_PRIORITIES)
+    {
+        priobit_clear_bit(&lower, priority);
+
+        if (priority <= PRIORITY_REALTIME)
+            continue;
+
+        struct thread_entry *t = RTR_THREAD_FIRST(RTR_QUEUE(corep, priority));
+        int diff = priority - max;
+
+        if (++t->skip_count > diff*diff)
+        {
+            thread = t;
+            break;
+        }
+    }
+
+    thread->skip_count = 0; /* Reset aging counter */
+    return thread;
+}
+
 /*---------------------------------------------------------------------------
  * Finds the highest priority thread in a list of threads. If the list is
  * empty, the PRIORITY_IDLE is returned.
@@ -1015,12 +1089,20 @@ void switch_thread(void)
     const unsigned int core = CURRENT_CORE;
     struct core_entry *corep = __core_id_entry(core);
     struct thread_entry *thread = corep->running;
+#ifdef THREAD_CPU_CLOCK
+    unsigned long now = THREAD_CPU_CLOCK();
+#endif
 
     if (thread)
     {
+#ifdef THREAD_CPU_CLOCK
+        thread->cpu_time += now - corep->last_switch;
+#endif
 #ifdef RB_PROFILE
         profile_thread_stopped(THREAD_ID_SLOT(thread->id));
 #endif
+        TRACE_THREAD(THREAD_ID_SLOT(thread->id), TRACE_PH_BEGIN,
+                     TP_SWITCH_THREAD);
 #ifdef DEBUG
         /* Check core_ctx buflib integrity */
         core_check_valid();
@@ -1030,6 +1112,12 @@ void switch_thread(void)
         /* Check if the current thread stack is overflown */
         if (UNLIKELY(thread->stack[0] != DEADBEEF) && thread->stack_size > 0)
             thread_stkov(thread);
+#ifdef HAVE_THREAD_CPU_TIME
+        /* ...or close to it */
+        if (UNLIKELY(thread->stack[thread->stack_size / (8*sizeof (uintptr_t))]
+                        != DEADBEEF) && thread->stack_size > 0)
+            thread->stack_warn = true;
+#endif
     }
 
     /* TODO: make a real idle task */
@@ -1042,68 +1130,73 @@ void switch_thread(void)
 
         RTR_LOCK(corep);
 
+#ifdef HAVE_PRIORITY_SCHEDULING
+        if (!priobit_is_clear(&corep->rtr_dist.mask))
+            break;
+#else
         if (!RTR_EMPTY(&corep->rtr))
             break;
+#endif
 
         thread = NULL;
-        
+
+#ifdef HAVE_TICKLESS_IDLE
+        /* Nothing happens until the next timeout unless an interrupt
+           says otherwise - let the tick sleep too */
+        tick_idle_enter(corep->next_tmo_check);
+#endif
+
         /* Enter sleep mode to reduce power usage */
         RTR_UNLOCK(corep);
+#ifdef HAVE_THREAD_CPU_TIME
+        corep->idle = true;
+        core_sleep(IF_COP(core));
+        corep->idle = false;
+#else
         core_sleep(IF_COP(core));
+#endif
 
         /* Awakened by interrupt or other CPU */
+#ifdef HAVE_TICKLESS_IDLE
+        tick_idle_exit();
+#endif
     }
 
-    thread = (thread && thread->state == STATE_RUNNING) ?
-        RTR_THREAD_NEXT(thread) : RTR_THREAD_FIRST(&corep->rtr);
-
 #ifdef HAVE_PRIORITY_SCHEDULING
-    /* Select the new task based on priorities and the last time a
-     * process got CPU time relative to the highest priority runnable
-     * task. If priority is not a feature, then FCFS is used (above). */
-    int max = priobit_ffs(&corep->rtr_dist.mask);
-
-    for (;;)
+    /* A thread that is still runnable goes to the back of its level */
+    if (thread && thread->state == STATE_RUNNING)
     {
-        int priority = thread->priority;
-        int diff;
-
-        /* This ridiculously simple method of aging seems to work
-         * suspiciously well. It does tend to reward CPU hogs (under
-         * yielding) but that's generally not desirable at all. On
-         * the plus side, it, relatively to other threads, penalizes
-         * excess yielding which is good if some high priority thread
-         * is performing no useful work such as polling for a device
-         * to be ready. Of course, aging is only employed when higher
-         * and lower priority threads are runnable. The highest
-         * priority runnable thread(s) are never skipped unless a
-         * lower-priority process has aged sufficiently. Priorities
-         * of REALTIME class are run strictly according to priority
-         * thus are not subject to switchout due to lower-priority
-         * processes aging; they must give up the processor by going
-         * off the run list. */
-        if (LIKELY(priority <= max) ||
-            (priority > PRIORITY_REALTIME &&
-             (diff = priority - max, ++thread->skip_count > diff*diff)))
-        {
-            break;
-        }
-
-        thread = RTR_THREAD_NEXT(thread);
+        struct __rtr_queue *rtrp = RTR_QUEUE(corep, thread->priority);
+        if (rtrp->head == &thread->rtr)
+            rtr_queue_make_first(rtrp, RTR_THREAD_NEXT(thread));
     }
 
-    thread->skip_count = 0; /* Reset aging counter */
-#endif /* HAVE_PRIORITY_SCHEDULING */
+    /* Select the new task based on priorities and the last time a
+     * process got CPU time relative to the highest priority runnable
+     * task. If priority is not a feature, then FCFS is used. */
+    thread = rtr_select_thread(corep);
+#else
+    thread = (thread && thread->state == STATE_RUNNING) ?
+        RTR_THREAD_NEXT(thread) : RTR_THREAD_FIRST(&corep->rtr);
 
     rtr_queue_make_first(&corep->rtr, thread);
+#endif /* HAVE_PRIORITY_SCHEDULING */
+
     corep->running = thread;
 
+#ifdef THREAD_CPU_CLOCK
+    /* Idling and scheduling count as idle time */
+    corep->last_switch = THREAD_CPU_CLOCK();
+    corep->idle_time += corep->last_switch - now;
+#endif
+
     RTR_UNLOCK(corep);
     enable_irq();
 
 #ifdef RB_PROFILE
     profile_thread_started(THREAD_ID_SLOT(thread->id));
 #endif
+    TRACE_THREAD(THREAD_ID_SLOT(thread->id), TRACE_PH_END, TP_SWITCH_THREAD);
 
     /* And finally, give control to the next thread. */
     thread_load_context(thread);
@@ -1177,6 +1270,33 @@ void core_idle(void)
     core_sleep(IF_COP(CURRENT_CORE));
 }
 
+#ifdef HAVE_THREAD_CPU_TIME
+#ifndef THREAD_CPU_CLOCK
+/*---------------------------------------------------------------------------
+ * Charge the tick to what it interrupted
+ *---------------------------------------------------------------------------
+ */
+static void thread_cpu_time_tick(void)
+{
+    struct core_entry *corep = __core_id_entry(CURRENT_CORE);
+
+    if (corep->idle)
+        corep->idle_time += 1000000 / HZ;
+    else if (corep->running)
+        corep->running->cpu_time += 1000000 / HZ;
+}
+#endif /* THREAD_CPU_CLOCK */
+
+/*---------------------------------------------------------------------------
+ * Return the time a core spent idle in microseconds - wraps around
+ *---------------------------------------------------------------------------
+ */
+unsigned long core_idle_time(IF_COP_VOID(unsigned int core))
+{
+    return __core_id_entry(IF_COP_CORE(core))->idle_time;
+}
+#endif /* HAVE_THREAD_CPU_TIME */
+
 /*---------------------------------------------------------------------------
  * Create a thread. If using a dual core architecture, specify which core to
  * start the thread on.
@@ -1515,6 +1635,17 @@ static inline void boost_thread(struct thread_entry *thread, bool boost)
     if ((thread->cpu_boost != 0) != boost)
     {
         thread->cpu_boost = boost;
+#ifdef HAVE_THREAD_CPU_TIME
+        if (boost)
+        {
+            thread->boost_tick = current_tick;
+            thread->boost_count++;
+        }
+        else
+        {
+            thread->boost_ticks += current_tick - thread->boost_tick;
+        }
+#endif
         cpu_boost(boost);
     }
 }
@@ -1563,6 +1694,10 @@ void INIT_ATTR init_threads(void)
         core_rtr_add(corep, thread);
         corep->running = thread;
 
+#if defined(HAVE_THREAD_CPU_TIME) && !defined(THREAD_CPU_CLOCK)
+        tick_add_task(thread_cpu_time_tick);
+#endif
+
 #ifdef INIT_MAIN_THREAD
         init_main_thread(&thread->context);
 #endif
@@ -23,6 +23,9 @@
 #include "tick.h"
 #include "general.h"
 #include "panic.h"
+#ifdef INCLUDE_TIMEOUT_API
+#include "timeout.h"
+#endif
 
 /****************************************************************************
  * Timer tick
@@ -68,6 +71,41 @@ int tick_remove_task(void (*f)(void))
     return rc;
 }
 
+#ifdef HAVE_TICKLESS_IDLE
+#if NUM_CORES > 1
+#error Tickless idle needs the tick to be owned by the only core
+#endif
+
+static bool tick_idle;
+
+void tick_idle_enter(long next_tick)
+{
+#ifdef INCLUDE_TIMEOUT_API
+    long next_timeout = timeout_next_expiry();
+    if (TIME_BEFORE(next_timeout, next_tick))
+        next_tick = next_timeout;
+#endif
+
+    long ticks = MIN(next_tick - current_tick, TICK_IDLE_MAX_TICKS);
+
+    /* nothing to gain from a tick or less */
+    if (ticks > 1)
+    {
+        tick_idle = true;
+        tick_target_idle(ticks);
+    }
+}
+
+void tick_idle_exit(void)
+{
+    if (tick_idle)
+    {
+        tick_idle = false;
+        tick_target_resume();
+    }
+}
+#endif /* HAVE_TICKLESS_IDLE */
+
 void init_tick(void)
 {
     tick_start(1000/HZ);
@@ -57,6 +57,21 @@ void timeout_cancel(struct timeout *tmo)
     restore_irq(oldlevel);
 }
 
+long timeout_next_expiry(void)
+{
+    int oldlevel = disable_irq_save();
+    long next = current_tick + 60*HZ;
+
+    for (struct timeout **p = tmo_list; *p != NULL; p++)
+    {
+        if (TIME_BEFORE((*p)->expires, next))
+            next = (*p)->expires;
+    }
+
+    restore_irq(oldlevel);
+    return next;
+}
+
 /* Adds a timeout callback - calling with an active timeout resets the
    interval - can be called from the ISR */
 void timeout_register(struct timeout *tmo, timeout_cb_type callback,
@@ -20,6 +20,7 @@
  ****************************************************************************/
 #include "storage.h"
 #include "kernel.h"
+#include "trace.h"
 
 #ifdef CONFIG_STORAGE_MULTI
 
@@ -86,10 +87,14 @@ static void storage_wait_turn(IF_MD_NONVOID(int drive))
 int storage_read_sectors(IF_MD(int drive,) unsigned long start, int count,
                          void* buf)
 {
+    int rc;
+
 #ifdef HAVE_IO_PRIORITY
     storage_wait_turn(IF_MD(drive));
 #endif
 
+    TRACE_BEGIN(TP_STORAGE_READ, count);
+
 #ifdef CONFIG_STORAGE_MULTI
     int driver=(storage_drivers[drive] & DRIVER_MASK)>>DRIVER_OFFSET;
     int ldrive=(storage_drivers[drive] & DRIVE_MASK)>>DRIVE_OFFSET;
@@ -98,35 +103,45 @@ int storage_read_sectors(IF_MD(int drive,) unsigned long start, int count,
     {
 #if (CONFIG_STORAGE & STORAGE_ATA)
     case STORAGE_ATA:
-        return ata_read_sectors(IF_MD(ldrive,) start,count,buf);
+        rc = ata_read_sectors(IF_MD(ldrive,) start,count,buf);
+        break;
 #endif
 
 #if (CONFIG_STORAGE & STORAGE_MMC)
     case STORAGE_MMC:
-        return mmc_read_sectors(IF_MD(ldrive,) start,count,buf);
+        rc = mmc_read_sectors(IF_MD(ldrive,) start,count,buf);
+        break;
 #endif
 
 #if (CONFIG_STORAGE & STORAGE_SD)
     case STORAGE_SD:
-        return sd_read_sectors(IF_MD(ldrive,) start,count,buf);
+        rc = sd_read_sectors(IF_MD(ldrive,) start,count,buf);
+        break;
 #endif
 
 #if (CONFIG_STORAGE & STORAGE_NAND)
     case STORAGE_NAND:
-        return nand_read_sectors(IF_MD(ldrive,) start,count,buf);
+        rc = nand_read_sectors(IF_MD(ldrive,) start,count,buf);
+        break;
 #endif
 
 #if (CONFIG_STORAGE & STORAGE_RAMDISK)
     case STORAGE_RAMDISK:
-        return ramdisk_read_sectors(IF_MD(ldrive,) start,count,buf);
+        rc = ramdisk_read_sectors(IF_MD(ldrive,) start,count,buf);
+        break;
 #endif
+
+    default:
+        rc = -1;
+        break;
     }
-    
-    return -1;
 #else /* CONFIG_STORAGE_MULTI */
-    return STORAGE_FUNCTION(read_sectors)(IF_MD(drive,)start,count,buf);
+    rc = STORAGE_FUNCTION(read_sectors)(IF_MD(drive,)start,count,buf);
 #endif /* CONFIG_STORAGE_MULTI */
 
+    TRACE_END(TP_STORAGE_READ, rc);
+
+    return rc;
 }
 
 int storage_write_sectors(IF_MD(int drive,) unsigned long start, int count,
@@ -26,6 +26,7 @@
 #include <errno.h>
 #include <unistd.h>
 #include <pthread.h>
+#include <semaphore.h>
 
 #include "config.h"
 #include "system.h"
@@ -36,14 +37,51 @@
 #include "timer.h"
 
 
-static pthread_cond_t wfi_cond = PTHREAD_COND_INITIALIZER;
-static pthread_mutex_t wfi_mtx = PTHREAD_MUTEX_INITIALIZER;
+static sem_t wfi_sem;
+
+static timer_t tick_timer_id;
+static struct timespec tick_base; /* time of tick 0 */
+static long tick_interval_ns;
+/* serializes catching up with the ticks */
+static pthread_mutex_t tick_mtx = PTHREAD_MUTEX_INITIALIZER;
+
+static inline long timespec_diff_ns(const struct timespec *a,
+                                    const struct timespec *b)
+{
+    return (a->tv_sec - b->tv_sec) * 1000000000L + (a->tv_nsec - b->tv_nsec);
+}
+
+/* time at which the given tick is due */
+static void tick_time(long tick, struct timespec *ts)
+{
+    long long ns = tick_base.tv_nsec + (long long)tick * tick_interval_ns;
+    ts->tv_sec = tick_base.tv_sec + ns / 1000000000;
+    ts->tv_nsec = ns % 1000000000;
+}
+
+/*
+ * call the tick tasks for each tick that is due */
+static void tick_catch_up(void)
+{
+    struct timespec now;
+
+    pthread_mutex_lock(&tick_mtx);
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long new_tick = timespec_diff_ns(&now, &tick_base) / tick_interval_ns;
+
+    while (TIME_BEFORE(current_tick, new_tick))
+        call_tick_tasks();
+
+    pthread_mutex_unlock(&tick_mtx);
+}
+
 /*
  * call tick tasks and wake the scheduler up */
 void timer_signal(union sigval arg)
 {
     (void)arg;
-    call_tick_tasks();
+    tick_catch_up();
     interrupt();
 }
 
@@ -53,16 +91,128 @@ void timer_signal(union sigval arg)
  * other mechanisms could use them as well */
 void wait_for_interrupt(void)
 {
-    pthread_cond_wait(&wfi_cond, &wfi_mtx);
+    while (sem_wait(&wfi_sem) < 0 && errno == EINTR);
+
+    /* one wakeup is enough for everything that happened meanwhile */
+    while (sem_trywait(&wfi_sem) == 0);
 }
 
 /*
- * Wakeup the kernel, if sleeping (shall not be called from a signal handler) */
+ * Wakeup the kernel, if sleeping. A wakeup that comes before the kernel
+ * sleeps isn't lost. */
 void interrupt(void)
 {
-    pthread_cond_signal(&wfi_cond);
+    sem_post(&wfi_sem);
+}
+
+#ifdef HAVE_TICKLESS_IDLE
+static void tick_arm(long tick)
+{
+    struct itimerspec ts;
+
+    tick_time(tick, &ts.it_value);
+    ts.it_interval.tv_sec = 0;
+    ts.it_interval.tv_nsec = tick_interval_ns;
+
+    timer_settime(tick_timer_id, TIMER_ABSTIME, &ts, NULL);
+}
+
+/*
+ * have the next tick signal come with the tick the kernel needs to wake up
+ * for; it continues at the regular rate from there */
+void tick_target_idle(long ticks)
+{
+    tick_arm(current_tick + ticks);
+}
+
+/*
+ * woken before that - back to the regular rate */
+void tick_target_resume(void)
+{
+    tick_catch_up();
+    tick_arm(current_tick + 1);
+}
+#endif /* HAVE_TICKLESS_IDLE */
+
+
+#ifdef HAVE_HRTIMER
+static timer_t hrtimer_tid;
+/* there is no interrupt emulation to keep hrtimer_interrupt() from running
+   while the list is changed, so it's done with a mutex */
+static pthread_mutex_t hrtimer_mtx;
+
+int hrtimer_lock(void)
+{
+    pthread_mutex_lock(&hrtimer_mtx);
+    return 0;
+}
+
+void hrtimer_unlock(int level)
+{
+    (void)level;
+    pthread_mutex_unlock(&hrtimer_mtx);
+}
+
+long hrtimer_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    /* let it wrap like a hardware counter would */
+    return (long)((unsigned long)ts.tv_sec * 1000000ul +
+                  (unsigned long)ts.tv_nsec / 1000ul);
+}
+
+void hrtimer_target_set(long expires)
+{
+    struct itimerspec ts;
+    long usecs = expires - hrtimer_now();
+
+    memset(&ts, 0, sizeof(ts));
+    if (usecs > 0)
+    {
+        ts.it_value.tv_sec = usecs / 1000000;
+        ts.it_value.tv_nsec = (usecs % 1000000) * 1000;
+    }
+    else
+    {
+        ts.it_value.tv_nsec = 1; /* already due; zero would disarm it */
+    }
+
+    timer_settime(hrtimer_tid, 0, &ts, NULL);
+}
+
+void hrtimer_target_clear(void)
+{
+    struct itimerspec ts;
+    memset(&ts, 0, sizeof(ts));
+    timer_settime(hrtimer_tid, 0, &ts, NULL);
 }
 
+static void hrtimer_signal(union sigval arg)
+{
+    (void)arg;
+    hrtimer_interrupt();
+    interrupt();
+}
+
+static int hrtimer_init(void)
+{
+    pthread_mutexattr_t attr;
+    sigevent_t sigev;
+
+    /* callbacks may register timers */
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&hrtimer_mtx, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    memset(&sigev, 0, sizeof(sigevent_t));
+    sigev.sigev_notify = SIGEV_THREAD,
+    sigev.sigev_notify_function = hrtimer_signal;
+
+    return timer_create(CLOCK_MONOTONIC, &sigev, &hrtimer_tid);
+}
+#endif /* HAVE_HRTIMER */
 
 /*
  * setup a hrtimer to send a signal to our process every tick
@@ -77,26 +227,29 @@ void interrupt(void)
 void tick_start(unsigned int interval_in_ms)
 {
     int ret = 0;
-    timer_t timerid;
     struct itimerspec ts;
     sigevent_t sigev;
 
+    ret |= sem_init(&wfi_sem, 0, 0);
+
     /* initializing in the declaration causes some weird warnings */
     memset(&sigev, 0, sizeof(sigevent_t));
     sigev.sigev_notify = SIGEV_THREAD,
     sigev.sigev_notify_function = timer_signal;
 
+    tick_interval_ns = interval_in_ms*1000*1000;
+    clock_gettime(CLOCK_MONOTONIC, &tick_base);
+
     ts.it_value.tv_sec = ts.it_interval.tv_sec = 0;
-    ts.it_value.tv_nsec = ts.it_interval.tv_nsec = interval_in_ms*1000*1000;
+    ts.it_value.tv_nsec = ts.it_interval.tv_nsec = tick_interval_ns;
 
-    /* add the timer */
-    ret |= timer_create(CLOCK_REALTIME, &sigev, &timerid);
-    ret |= timer_settime(timerid, 0, &ts, NULL);
+    /* add the timer, on the clock the ticks are counted with */
+    ret |= timer_create(CLOCK_MONOTONIC, &sigev, &tick_timer_id);
+    ret |= timer_settime(tick_timer_id, 0, &ts, NULL);
 
-    /* Grab the mutex already now and leave it to this thread. We don't
-     * care about race conditions when signaling the condition (because
-     * they are not critical), but a mutex is necessary due to the API */
-    pthread_mutex_lock(&wfi_mtx);
+#ifdef HAVE_HRTIMER
+    ret |= hrtimer_init();
+#endif
 
     if (ret != 0)
         panicf("%s(): %s\n", __func__, strerror(errno));
@@ -31,4 +31,10 @@
 void wait_for_interrupt(void);
 void interrupt(void);
 
+/* see kernel-unix.c */
+int hrtimer_lock(void);
+void hrtimer_unlock(int level);
+#define hrtimer_lock    hrtimer_lock
+#define hrtimer_unlock  hrtimer_unlock
+
 #endif /* __KERNEL_UNIX_H__ */
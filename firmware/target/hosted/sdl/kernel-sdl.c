@@ -32,9 +32,31 @@
 #include "debug.h"
 
 static SDL_TimerID tick_timer_id;
+static unsigned int tick_interval; /* ms */
 long start_tick;
 
-#ifndef HAVE_SDL_THREADS
+#ifdef HAVE_TICKLESS_IDLE
+/* SDL timers can't be rearmed from a thread that has "interrupts" disabled,
+   so the timer keeps running at the tick rate and the ticks are held back
+   from the sleeping core instead. This makes the kernel side behave as on a
+   target with a reprogrammable tick; it saves no host wakeups. */
+static SDL_mutex *tick_mtx;
+/* tick until which the core is idle, 0 = not idle */
+static volatile long tick_idle_until;
+#endif
+
+#ifdef HAVE_HRTIMER
+/* SDL only counts milliseconds, so the hrtimer expiries are handled by a
+   thread of their own that waits for the next one with that resolution */
+static SDL_Thread *hrtimer_thread;
+static SDL_mutex *hrtimer_mtx;
+static SDL_cond *hrtimer_cond;
+static long hrtimer_expires;
+static bool hrtimer_armed;
+static bool hrtimer_quit;
+#endif
+
+#ifndef HAVE_HOST_THREADS
 /* for the wait_for_interrupt function */
 static SDL_cond *wfi_cond;
 static SDL_mutex *wfi_mutex;
@@ -62,6 +84,18 @@ static int status_reg = 0;
  */
 int set_irq_level(int level)
 {
+#if NUM_CORES > 1
+    /* Only the CPU takes "interrupts"; the other cores just keep their
+     * level, which is only ever changed by the thread running there */
+    if (CURRENT_CORE != CPU)
+    {
+        static int core_levels[NUM_CORES];
+        int oldlevel = core_levels[CURRENT_CORE];
+        core_levels[CURRENT_CORE] = level;
+        return oldlevel;
+    }
+#endif
+
     SDL_LockMutex(sim_irq_mtx);
 
     int oldlevel = interrupt_level;
@@ -103,11 +137,71 @@ void sim_exit_irq_handler(void)
 
     status_reg = 0;
     SDL_UnlockMutex(sim_irq_mtx);
-#ifndef HAVE_SDL_THREADS
+#ifndef HAVE_HOST_THREADS
     SDL_CondSignal(wfi_cond);
 #endif
 }
 
+#ifdef HAVE_HRTIMER
+long hrtimer_now(void)
+{
+    /* let it wrap like a hardware counter would */
+    return (long)((unsigned long)(SDL_GetTicks() - start_tick) * 1000ul);
+}
+
+void hrtimer_target_set(long expires)
+{
+    SDL_LockMutex(hrtimer_mtx);
+    hrtimer_expires = expires;
+    hrtimer_armed = true;
+    SDL_CondSignal(hrtimer_cond);
+    SDL_UnlockMutex(hrtimer_mtx);
+}
+
+void hrtimer_target_clear(void)
+{
+    SDL_LockMutex(hrtimer_mtx);
+    hrtimer_armed = false;
+    SDL_UnlockMutex(hrtimer_mtx);
+}
+
+static int hrtimer_thread_func(void *param)
+{
+    (void)param;
+
+    SDL_LockMutex(hrtimer_mtx);
+
+    while (!hrtimer_quit)
+    {
+        if (!hrtimer_armed)
+        {
+            SDL_CondWait(hrtimer_cond, hrtimer_mtx);
+            continue;
+        }
+
+        long wait = hrtimer_expires - hrtimer_now();
+        if (wait > 0)
+        {
+            SDL_CondWaitTimeout(hrtimer_cond, hrtimer_mtx, (wait + 999) / 1000);
+            continue;
+        }
+
+        /* the handler programs the next expiry */
+        hrtimer_armed = false;
+        SDL_UnlockMutex(hrtimer_mtx);
+
+        sim_enter_irq_handler();
+        hrtimer_interrupt();
+        sim_exit_irq_handler();
+
+        SDL_LockMutex(hrtimer_mtx);
+    }
+
+    SDL_UnlockMutex(hrtimer_mtx);
+    return 0;
+}
+#endif /* HAVE_HRTIMER */
+
 static bool sim_kernel_init(void)
 {
     sim_irq_mtx = SDL_CreateMutex();
@@ -123,7 +217,7 @@ static bool sim_kernel_init(void)
         panicf("Cannot create sim_thread_cond\n");
         return false;
     }
-#ifndef HAVE_SDL_THREADS
+#ifndef HAVE_HOST_THREADS
     wfi_cond = SDL_CreateCond();
     if (wfi_cond == NULL)
     {
@@ -136,6 +230,30 @@ static bool sim_kernel_init(void)
         panicf("Cannot create wfi mutex\n");
         return false;
     }
+#endif
+#ifdef HAVE_TICKLESS_IDLE
+    tick_mtx = SDL_CreateMutex();
+    if (tick_mtx == NULL)
+    {
+        panicf("Cannot create tick mutex\n");
+        return false;
+    }
+#endif
+#ifdef HAVE_HRTIMER
+    hrtimer_mtx = SDL_CreateMutex();
+    hrtimer_cond = SDL_CreateCond();
+    if (hrtimer_mtx == NULL || hrtimer_cond == NULL)
+    {
+        panicf("Cannot create hrtimer mutex\n");
+        return false;
+    }
+
+    hrtimer_thread = SDL_CreateThread(hrtimer_thread_func, NULL);
+    if (hrtimer_thread == NULL)
+    {
+        panicf("Cannot create hrtimer thread\n");
+        return false;
+    }
 #endif
     return true;
 }
@@ -143,12 +261,21 @@ static bool sim_kernel_init(void)
 void sim_kernel_shutdown(void)
 {
     SDL_RemoveTimer(tick_timer_id);
-#ifndef HAVE_SDL_THREADS
+#ifndef HAVE_HOST_THREADS
     SDL_DestroyCond(wfi_cond);
     SDL_UnlockMutex(wfi_mutex);
     SDL_DestroyMutex(wfi_mutex);
 #endif
     enable_irq();
+#ifdef HAVE_HRTIMER
+    SDL_LockMutex(hrtimer_mtx);
+    hrtimer_quit = true;
+    SDL_CondSignal(hrtimer_cond);
+    SDL_UnlockMutex(hrtimer_mtx);
+    SDL_WaitThread(hrtimer_thread, NULL);
+    SDL_DestroyCond(hrtimer_cond);
+    SDL_DestroyMutex(hrtimer_mtx);
+#endif
     while(handlers_pending > 0)
         SDL_Delay(10);
 
@@ -160,11 +287,21 @@ Uint32 tick_timer(Uint32 interval, void *param)
 {
     long new_tick;
 
-    (void) interval;
     (void) param;
-    
+
+#ifdef HAVE_TICKLESS_IDLE
+    SDL_LockMutex(tick_mtx);
+#endif
+
     new_tick = (SDL_GetTicks() - start_tick) / (1000/HZ);
-        
+
+#ifdef HAVE_TICKLESS_IDLE
+    /* the idle core isn't interrupted before its next timeout */
+    long idle_until = tick_idle_until;
+    if (idle_until != 0 && TIME_BEFORE(new_tick, idle_until))
+        new_tick = current_tick;
+#endif
+
     while(new_tick != current_tick)
     {
         sim_enter_irq_handler();
@@ -175,10 +312,29 @@ Uint32 tick_timer(Uint32 interval, void *param)
 
         sim_exit_irq_handler();
     }
-    
+
+#ifdef HAVE_TICKLESS_IDLE
+    SDL_UnlockMutex(tick_mtx);
+#endif
+
     return interval;
 }
 
+#ifdef HAVE_TICKLESS_IDLE
+void tick_target_idle(long ticks)
+{
+    tick_idle_until = current_tick + ticks;
+}
+
+void tick_target_resume(void)
+{
+    tick_idle_until = 0;
+
+    /* catch up with the ticks the core slept through */
+    tick_timer(tick_interval, NULL);
+}
+#endif /* HAVE_TICKLESS_IDLE */
+
 void tick_start(unsigned int interval_in_ms)
 {
     if (!sim_kernel_init())
@@ -197,13 +353,14 @@ void tick_start(unsigned int interval_in_ms)
         start_tick = SDL_GetTicks();
     }
 
+    tick_interval = interval_in_ms;
     tick_timer_id = SDL_AddTimer(interval_in_ms, tick_timer, NULL);
-#ifndef HAVE_SDL_THREADS
+#ifndef HAVE_HOST_THREADS
     SDL_LockMutex(wfi_mutex);
 #endif
 }
 
-#ifndef HAVE_SDL_THREADS
+#ifndef HAVE_HOST_THREADS
 void wait_for_interrupt(void)
 {
     /* the exit may come at any time, during the CondWait or before,
@@ -71,18 +71,20 @@ static struct pcm_udata
 
 static SDL_AudioSpec obtained;
 static SDL_AudioCVT cvt;
-static int audio_locked = 0;
+/* Counted per core: the threads of a core take turns, but the cores may
+ * both want the lock at the same time */
+static int audio_locked[NUM_CORES];
 static SDL_mutex *audio_lock;
 
 void pcm_play_lock(void)
 {
-    if (++audio_locked == 1)
+    if (++audio_locked[CURRENT_CORE] == 1)
         SDL_LockMutex(audio_lock);
 }
 
 void pcm_play_unlock(void)
 {
-    if (--audio_locked == 0)
+    if (--audio_locked[CURRENT_CORE] == 0)
         SDL_UnlockMutex(audio_lock);
 }
 
@@ -193,7 +193,7 @@ static int sdl_event_thread(void * param)
 
     /* Order here is relevent to prevent deadlocks and use of destroyed
        sync primitives by kernel threads */
-#ifdef HAVE_SDL_THREADS
+#ifdef HAVE_HOST_THREADS
     sim_thread_shutdown(); /* not needed for native threads */
 #endif
     return 0;
@@ -214,7 +214,7 @@ void power_off(void)
     memset(&event, 0, sizeof(SDL_Event));
     event.type = SDL_USEREVENT;
     SDL_PushEvent(&event);
-#ifdef HAVE_SDL_THREADS
+#ifdef HAVE_HOST_THREADS
     /* since sim_thread_shutdown() grabs the mutex we need to let it free,
      * otherwise SDL_WaitThread will deadlock */
     struct thread_entry* t = sim_thread_unlock();
@@ -222,11 +222,12 @@ void power_off(void)
     /* wait for event thread to finish */
     SDL_WaitThread(evt_thread, NULL);
 
-#ifdef HAVE_SDL_THREADS
+#ifdef HAVE_HOST_THREADS
     /* lock again before entering the scheduler */
     sim_thread_lock(t);
-    /* sim_thread_shutdown() will cause sim_do_exit() to be called via longjmp,
-     * but only if we let the sdl thread scheduler exit the other threads */
+    /* sim_thread_shutdown() will cause sim_do_exit() to be called by the
+     * exiting main thread, but only if we let the host thread scheduler exit
+     * the other threads */
     while(1) yield();
 #else
     sim_do_exit();
@@ -272,7 +273,7 @@ void system_init(void)
 
 void system_reboot(void)
 {
-#ifdef HAVE_SDL_THREADS
+#ifdef HAVE_HOST_THREADS
     sim_thread_exception_wait();
 #else
     sim_do_exit();
@@ -41,7 +41,7 @@ int set_irq_level(int level);
 #define restore_irq(level) \
     ((void)set_irq_level(level))
 
-#ifndef HAVE_SDL_THREADS
+#ifndef HAVE_HOST_THREADS
 void wait_for_interrupt(void);
 #else
 #define wait_for_interrupt()
@@ -49,6 +49,15 @@ void wait_for_interrupt(void);
 
 #include "system-hosted.h"
 
+#ifdef HAVE_PTHREAD_THREADS
+/* Core the calling thread runs on, CPU for the host's own threads */
+extern __thread unsigned int sim_thread_core;
+static inline unsigned int current_core(void)
+{
+    return sim_thread_core;
+}
+#endif
+
 void sim_enter_irq_handler(void);
 void sim_exit_irq_handler(void);
 void sim_kernel_shutdown(void);
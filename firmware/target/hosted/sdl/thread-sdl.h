@@ -22,7 +22,7 @@
 #ifndef __THREADSDL_H__
 #define __THREADSDL_H__
 
-#ifdef HAVE_SDL_THREADS
+#ifdef HAVE_HOST_THREADS
 /* extra thread functions that only apply when running on hosting platforms */
 void sim_thread_lock(void *me);
 void * sim_thread_unlock(void);
@@ -36,9 +36,13 @@ Uint32 SDL_timer_callback(Uint32 interval, void *param){
     ((int)((1000*cycles)/TIMER_FREQ))
 
 bool timer_register(int reg_prio, void (*unregister_callback)(void),
-                    long cycles, void (*timer_callback)(void))
+                    long cycles, void (*timer_callback)(void)
+                    IF_COP(, int core))
 {
     (void)unregister_callback;
+#if NUM_CORES > 1
+    (void)core; /* the "interrupts" all come to the CPU */
+#endif
     if (reg_prio <= timer_prio || cycles == 0)
         return false;
     timer_prio=reg_prio;
@@ -0,0 +1,38 @@
+/* Just enough of system.h, panic.h and debug.h to build buflib.c on the
+ * host. Force-included, the real headers are shadowed by the empty ones in
+ * this directory */
+
+#ifndef _BUFLIB_STUB_H_
+#define _BUFLIB_STUB_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MIN(a, b) (((a)<(b))?(a):(b))
+#define MAX(a, b) (((a)>(b))?(a):(b))
+#define ARRAYLEN(a) (sizeof(a)/sizeof((a)[0]))
+
+#define ALIGN_DOWN(n, a)     ((typeof(n))((uintptr_t)(n)/(a)*(a)))
+#define ALIGN_UP(n, a)       ALIGN_DOWN((n)+((a)-1),a)
+
+#define ALIGN_BUFFER(ptr, size, align) \
+({                                           \
+    size_t    __sz = (size);                 \
+    size_t   __ali = (align);                \
+    uintptr_t __a1 = (uintptr_t)(ptr);       \
+    uintptr_t __a2 = __a1 + __sz;            \
+    __a1 = ALIGN_UP(__a1, __ali);            \
+    __a2 = ALIGN_DOWN(__a2, __ali);          \
+    (ptr)  = (typeof (ptr))__a1;             \
+    (size) = __a2 > __a1 ?  __a2 - __a1 : 0; \
+})
+
+static inline int find_first_set_bit(uint32_t val)
+    { return val ? __builtin_ctz(val) : 32; }
+
+#define DEBUGF(...) do { } while(0)
+#define panicf(...) do { fprintf(stderr, __VA_ARGS__); abort(); } while(0)
+
+#endif /* _BUFLIB_STUB_H_ */
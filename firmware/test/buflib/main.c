@@ -0,0 +1,312 @@
+/***************************************************************************
+ *             __________               __   ___.
+ *   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+ *   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+ *   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+ *   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+ *                     \/            \/     \/    \/            \/
+ * $Id$
+ *
+ * Random alloc/free workload for buflib. Allocation contents are checked
+ * when they are freed, so a bad move shows up, and the free lists are
+ * compared against a walk of the buffer every now and then. Reports the
+ * latency of buflib_alloc_ex() and of bounded compaction steps, and how
+ * fragmented the free space gets.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ ****************************************************************************/
+
+#include <stdbool.h>
+#include <time.h>
+
+#include "buflib.h"
+
+#define BUF_SIZE    (8 << 20)
+#define MAX_ALLOCS  4096
+#define OPS         200000
+#define STEP_BYTES  (32 << 10)
+
+static union buflib_data buffer[BUF_SIZE / sizeof(union buflib_data)];
+static struct buflib_context ctx;
+
+static struct alloc
+{
+    int handle;
+    size_t size;
+    unsigned char seed;
+} allocs[MAX_ALLOCS];
+static int num_allocs;
+
+static int errors;
+
+static uint32_t rand_state = 0x12345678;
+
+static uint32_t next_rand(void)
+{
+    rand_state = rand_state * 1664525 + 1013904223;
+    return rand_state >> 8;
+}
+
+static int move_callback(int handle, void *current, void *new)
+{
+    (void)handle; (void)current; (void)new;
+    return BUFLIB_CB_OK;
+}
+
+static struct buflib_callbacks movable_ops = { move_callback, NULL, NULL };
+static struct buflib_callbacks pinned_ops = { NULL, NULL, NULL };
+
+/* nanosecond samples of each operation */
+static long *alloc_ns, *step_ns;
+static int num_alloc_ns, num_step_ns;
+
+static long now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static void fill(struct alloc *a)
+{
+    unsigned char *p = buflib_get_data(&ctx, a->handle);
+    for (size_t i = 0; i < a->size; i++)
+        p[i] = a->seed + i * 31;
+}
+
+static void verify(struct alloc *a)
+{
+    unsigned char *p = buflib_get_data(&ctx, a->handle);
+    for (size_t i = 0; i < a->size; i++)
+    {
+        if (p[i] != (unsigned char)(a->seed + i * 31))
+        {
+            printf("handle %d: data corrupted at %zu\n", a->handle, i);
+            errors++;
+            return;
+        }
+    }
+}
+
+static size_t random_size(void)
+{
+    uint32_t r = next_rand() % 100;
+    if (r < 70)
+        return 16 + next_rand() % 1024;
+    else if (r < 98)
+        return 1024 + next_rand() % (32 << 10);
+    else
+        return (32 << 10) + next_rand() % (480 << 10);
+}
+
+static bool do_alloc(void)
+{
+    struct alloc *a = &allocs[num_allocs];
+    bool pinned = next_rand() % 10 == 0;
+    long start;
+
+    a->size = random_size();
+    a->seed = next_rand();
+
+    start = now_ns();
+    a->handle = buflib_alloc_ex(&ctx, a->size, "test",
+                                pinned ? &pinned_ops : &movable_ops);
+    alloc_ns[num_alloc_ns++] = now_ns() - start;
+
+    if (a->handle <= 0)
+        return false;
+
+    fill(a);
+    num_allocs++;
+    return true;
+}
+
+static void do_free(int index)
+{
+    verify(&allocs[index]);
+    buflib_free(&ctx, allocs[index].handle);
+    allocs[index] = allocs[--num_allocs];
+}
+
+/* same as in buflib.c */
+static int free_class(intptr_t len)
+{
+    int class = 0;
+    for (len >>= 3; len && class < BUFLIB_FREE_CLASSES - 1; len >>= 1)
+        class++;
+    return class;
+}
+
+static void check_free_lists(void)
+{
+    union buflib_data *block;
+    int walked = 0, listed = 0;
+
+    if (!ctx.free_lists_valid)
+        return;
+
+    for (block = ctx.buf_start; block < ctx.alloc_end; block += abs(block->val))
+    {
+        if (block->val <= -3)
+            walked++;
+    }
+
+    for (int class = 0; class < BUFLIB_FREE_CLASSES; class++)
+    {
+        intptr_t prev = -1;
+        bool empty = ctx.free_list[class] < 0;
+
+        if (empty != !(ctx.free_classes & (1u << class)))
+        {
+            printf("class %d: mask bit doesn't match the list\n", class);
+            errors++;
+        }
+
+        for (intptr_t offset = ctx.free_list[class]; offset >= 0;
+             offset = ctx.buf_start[offset + 1].val)
+        {
+            block = ctx.buf_start + offset;
+            if (block->val >= 0 || free_class(-block->val) != class ||
+                block[2].val != prev || block >= ctx.alloc_end)
+            {
+                printf("class %d: bad free block at %ld\n", class,
+                       (long)offset);
+                errors++;
+                return;
+            }
+            prev = offset;
+            listed++;
+        }
+    }
+
+    if (walked != listed)
+    {
+        printf("%d free blocks in the buffer, %d in the lists\n",
+               walked, listed);
+        errors++;
+    }
+}
+
+/* 1 - largest free block / all free space, 0 means not fragmented at all */
+static double fragmentation(void)
+{
+    union buflib_data *block;
+    size_t total = ctx.last_handle - ctx.alloc_end;
+    size_t largest = total;
+
+    for (block = ctx.buf_start; block < ctx.alloc_end; block += abs(block->val))
+    {
+        if (block->val < 0)
+        {
+            total += -block->val;
+            largest = MAX(largest, (size_t)-block->val);
+        }
+    }
+
+    return total ? 1.0 - (double)largest / total : 0.0;
+}
+
+static int cmp_long(const void *a, const void *b)
+{
+    long x = *(const long *)a, y = *(const long *)b;
+    return (x > y) - (x < y);
+}
+
+static void print_latency(const char *name, long *samples, int n)
+{
+    if (n == 0)
+        return;
+
+    qsort(samples, n, sizeof(long), cmp_long);
+    printf("%-8s %7d calls  p50 %6ld  p90 %6ld  p99 %7ld  p99.9 %8ld  "
+           "max %8ld ns\n", name, n, samples[n / 2], samples[n * 9 / 10],
+           samples[n * 99 / 100], samples[n * 999 / 1000], samples[n - 1]);
+}
+
+int main(void)
+{
+    int failed = 0, frag_samples = 0;
+    double frag_sum = 0, frag_max = 0;
+
+    alloc_ns = malloc(OPS * sizeof(long));
+    step_ns = malloc(OPS * sizeof(long));
+
+    buflib_init(&ctx, buffer, sizeof(buffer));
+
+    for (int op = 1; op <= OPS; op++)
+    {
+        /* allocate a bit more often than free, so the buffer fills up and
+         * the allocator has to deal with running out of space */
+        if (num_allocs < MAX_ALLOCS && (num_allocs == 0 ||
+                                        next_rand() % 100 < 55))
+        {
+            if (!do_alloc())
+            {
+                failed++;
+                /* make some room, as an out of memory caller would */
+                for (int i = 0; i < 8 && num_allocs > 0; i++)
+                    do_free(next_rand() % num_allocs);
+            }
+        }
+        else
+            do_free(next_rand() % num_allocs);
+
+        if (op % 64 == 0)
+        {
+            long start = now_ns();
+            buflib_compact_step(&ctx, STEP_BYTES);
+            step_ns[num_step_ns++] = now_ns() - start;
+        }
+
+        if (op % 1000 == 0)
+        {
+            double frag = fragmentation();
+            frag_sum += frag;
+            frag_max = MAX(frag_max, frag);
+            frag_samples++;
+            check_free_lists();
+        }
+    }
+
+    /* stepping must get the buffer compact eventually */
+    for (int i = 0; buflib_compact_step(&ctx, STEP_BYTES); i++)
+    {
+        if (i > 100000)
+        {
+            printf("compaction steps don't finish\n");
+            errors++;
+            break;
+        }
+    }
+    check_free_lists();
+
+    while (num_allocs > 0)
+        do_free(num_allocs - 1);
+
+    if (ctx.alloc_end != ctx.buf_start)
+    {
+        printf("buffer not empty after freeing everything\n");
+        errors++;
+    }
+
+    print_latency("alloc", alloc_ns, num_alloc_ns);
+    print_latency("compact", step_ns, num_step_ns);
+    printf("%d allocations failed, fragmentation mean %.3f max %.3f\n",
+           failed, frag_sum / frag_samples, frag_max);
+
+    if (errors)
+    {
+        printf("%d errors\n", errors);
+        return 1;
+    }
+
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,3 @@
+/* see buflib_stub.h */
+#include <stddef.h>
+size_t strlcpy(char *dst, const char *src, size_t siz);
@@ -0,0 +1 @@
+/* see buflib_stub.h */
@@ -0,0 +1,388 @@
+/***************************************************************************
+ *             __________               __   ___.
+ *   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+ *   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+ *   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+ *   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+ *                     \/            \/     \/    \/            \/
+ * $Id$
+ *
+ * Cache of strings rendered in one piece
+ *
+ * Lists and scrolling lines draw the same strings over and over. Decoding,
+ * bidi, diacritic placement and a blit per glyph are done once per string
+ * here and the result drawn with one blit afterwards.
+ *
+ * The runs live in a ring in one buflib allocation and the oldest ones make
+ * room for new ones. The table describing them is static, the runs are
+ * found by offset so the allocation may move whenever no run is in use.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ ****************************************************************************/
+#include <string.h>
+#include "config.h"
+#include "system.h"
+#include "font.h"
+#include "bidi.h"
+#include "diacritic.h"
+#include "core_alloc.h"
+#include "text_cache.h"
+
+/* Bytes for the runs */
+#ifndef TEXT_CACHE_SIZE
+#if MEMORYSIZE <= 2
+#define TEXT_CACHE_SIZE     (4 << 10)
+#elif LCD_DEPTH >= 16
+/* two screens full of anti-aliased text */
+#define TEXT_CACHE_SIZE     (LCD_WIDTH * LCD_HEIGHT)
+#else
+/* four screens full of mono text */
+#define TEXT_CACHE_SIZE     (LCD_WIDTH * LCD_HEIGHT / 2)
+#endif
+#endif
+
+#define TEXT_CACHE_RUNS     64
+/* no single run may push out more than a quarter of the others */
+#define TEXT_RUN_MAX_SIZE   (TEXT_CACHE_SIZE / 4)
+
+struct text_cache_run
+{
+    uint32_t hash;              /* of the string */
+    int font;                   /* font id, -1 if dropped */
+    unsigned short width;
+    unsigned short height;
+    unsigned char depth;
+    size_t offset;              /* into the ring: bitmap, then the string */
+    size_t size;
+};
+
+static struct
+{
+    int handle;
+    bool busy;                  /* a run is being rendered or drawn */
+    size_t head;                /* where the next run goes */
+    int first;                  /* oldest run in runs[] */
+    int count;
+    struct text_cache_run runs[TEXT_CACHE_RUNS];
+    struct text_cache_stats stats;
+} text_cache;
+
+static int move_callback(int handle, void *current, void *new)
+{
+    (void)handle; (void)current; (void)new;
+
+    /* a run being rendered or drawn is accessed by pointer */
+    if (text_cache.busy)
+        return BUFLIB_CB_CANNOT_MOVE;
+
+    return BUFLIB_CB_OK;
+}
+
+static struct buflib_callbacks text_cache_ops = { move_callback, NULL, NULL };
+
+void text_cache_init(void)
+{
+    text_cache.handle = core_alloc_ex("text cache", TEXT_CACHE_SIZE,
+                                      &text_cache_ops);
+    text_cache_flush();
+}
+
+void text_cache_flush(void)
+{
+    text_cache.head = 0;
+    text_cache.first = 0;
+    text_cache.count = 0;
+}
+
+static uint32_t text_hash(const unsigned char *str)
+{
+    uint32_t hash = 5381;
+
+    while (*str)
+        hash = hash * 33 + *str++;
+
+    return hash;
+}
+
+static inline struct text_cache_run *run_at(int n)
+{
+    return &text_cache.runs[(text_cache.first + n) % TEXT_CACHE_RUNS];
+}
+
+static void drop_oldest(void)
+{
+    text_cache.first = (text_cache.first + 1) % TEXT_CACHE_RUNS;
+    text_cache.count--;
+}
+
+/* Makes room for 'size' bytes at the head of the ring, dropping the oldest
+ * runs in the way, and returns a free table entry */
+static struct text_cache_run *make_room(size_t size)
+{
+    size_t start = text_cache.head;
+
+    if (start + size > TEXT_CACHE_SIZE)
+    {
+        /* wrap around - the runs between the head and the end of the ring
+           are the oldest ones, they go first */
+        while (text_cache.count > 0 && run_at(0)->offset >= start)
+            drop_oldest();
+        start = 0;
+    }
+
+    while (text_cache.count > 0)
+    {
+        struct text_cache_run *r = run_at(0);
+
+        if (text_cache.count < TEXT_CACHE_RUNS &&
+            (r->offset >= start + size || r->offset + r->size <= start))
+            break;
+
+        drop_oldest();
+    }
+
+    struct text_cache_run *r = run_at(text_cache.count++);
+    r->offset = start;
+    r->size = size;
+    text_cache.head = start + size;
+    return r;
+}
+
+/* Puts a glyph into a run at x, clipped to the run */
+static void put_glyph(unsigned char *dst, int run_width, int height,
+                      int depth, const unsigned char *src, int width, int x)
+{
+    int c0 = MAX(0, -x);
+    int c1 = MIN(width, run_width - x);
+
+    if (depth == 0)
+    {
+        /* mono - OR the bytes, diacritics may overlap their base */
+        for (int band = 0; band < (height + 7) / 8; band++)
+        {
+            const unsigned char *s = src + band * width;
+            unsigned char *d = dst + band * run_width + x;
+
+            for (int c = c0; c < c1; c++)
+                d[c] |= s[c];
+        }
+    }
+    else
+    {
+        /* 4 bit alpha, 0 is opaque - keep the more opaque pixel */
+        for (int row = 0; row < height; row++)
+        {
+            for (int c = c0; c < c1; c++)
+            {
+                int si = row * width + c;
+                int di = row * run_width + x + c;
+                unsigned a = (src[si >> 1] >> ((si & 1) * 4)) & 0xf;
+                unsigned b = (dst[di >> 1] >> ((di & 1) * 4)) & 0xf;
+
+                if (a < b)
+                {
+                    int shift = (di & 1) * 4;
+                    dst[di >> 1] = (dst[di >> 1] & ~(0xf << shift)) |
+                                   (a << shift);
+                }
+            }
+        }
+    }
+}
+
+/* Lays out and renders a string the way lcd_putsxyofs() draws it */
+static void render_run(struct font *pf, const unsigned short *ucs,
+                       unsigned char *bits, int run_width)
+{
+    int x = 0;
+    int rtl_next_non_diac_width = 0, last_non_diacritic_width = 0;
+
+    for (; *ucs; ucs++)
+    {
+        bool is_rtl, is_diac;
+        int width, base_width, base_ofs = 0;
+
+        is_diac = is_diacritic(*ucs, &is_rtl);
+        width = font_get_width(pf, *ucs);
+
+        if (is_rtl)
+        {
+            if (is_diac)
+            {
+                if (!rtl_next_non_diac_width)
+                {
+                    const unsigned short *u;
+
+                    for (u = &ucs[1]; *u && is_diacritic(*u, NULL); u++);
+
+                    rtl_next_non_diac_width = *u ? font_get_width(pf, *u) : 0;
+                }
+                base_width = rtl_next_non_diac_width;
+            }
+            else
+            {
+                rtl_next_non_diac_width = 0;
+                base_width = width;
+            }
+        }
+        else
+        {
+            if (!is_diac)
+                last_non_diacritic_width = width;
+
+            base_width = last_non_diacritic_width;
+        }
+
+        if (is_diac)
+            base_ofs = (base_width - width) / 2;
+
+        /* the glyph cache may evict the bits with the next lookup */
+        put_glyph(bits, run_width, pf->height, pf->depth,
+                  font_get_bits(pf, *ucs), width, x + base_ofs);
+
+        if (ucs[1])
+        {
+            bool next_is_rtl;
+            bool next_is_diacritic = is_diacritic(ucs[1], &next_is_rtl);
+
+            if ((is_rtl && !is_diac) ||
+                    (!is_rtl && (!next_is_diacritic || next_is_rtl)))
+                x += base_width;
+        }
+    }
+}
+
+static size_t run_bytes(int width, int height, int depth)
+{
+    if (depth == 0)
+        return width * ((height + 7) / 8);
+    else
+        return (width * height + 1) / 2;
+}
+
+bool text_cache_get(int font_id, const unsigned char *str,
+                    struct text_run *run)
+{
+    if (text_cache.handle <= 0 || text_cache.busy)
+        goto uncached;
+
+    uint32_t hash = text_hash(str);
+    size_t len = strlen(str) + 1;
+    unsigned char *ring = core_get_data(text_cache.handle);
+
+    for (int n = text_cache.count - 1; n >= 0; n--)
+    {
+        struct text_cache_run *r = run_at(n);
+
+        if (r->hash != hash || r->font != font_id)
+            continue;
+
+        size_t bytes = run_bytes(r->width, r->height, r->depth);
+        if (strcmp(ring + r->offset + bytes, str))
+            continue;
+
+        text_cache.busy = true;
+        text_cache.stats.hits++;
+
+        run->bits = ring + r->offset;
+        run->width = r->width;
+        run->height = r->height;
+        run->depth = r->depth;
+        return true;
+    }
+
+    /* bidi and measuring may yield on a glyph cache miss, as may rendering
+       - keep others out and the ring where it is until released */
+    text_cache.busy = true;
+
+    struct font *pf = font_get(font_id);
+    const unsigned short *ucs = bidi_l2v(str, 1);
+    int width = 0;
+
+    /* measure what bidi made of it, joined arabic glyphs differ in width */
+    for (const unsigned short *u = ucs; *u; u++)
+    {
+        if (!is_diacritic(*u, NULL))
+            width += font_get_width(pf, *u);
+    }
+
+    size_t bytes = run_bytes(width, pf->height, pf->depth);
+
+    if (width <= 0 || width > 0xffff || bytes + len > TEXT_RUN_MAX_SIZE)
+    {
+        text_cache.busy = false;
+        goto uncached;
+    }
+
+    text_cache.stats.misses++;
+
+    struct text_cache_run *r = make_room(ALIGN_UP(bytes + len, 4));
+    r->font = -1; /* not valid until rendered */
+
+    unsigned char *bits = ring + r->offset;
+    memset(bits, pf->depth ? 0xff : 0x00, bytes);
+    memcpy(bits + bytes, str, len);
+
+    font_lock(font_id, true);
+    render_run(pf, ucs, bits, width);
+    font_lock(font_id, false);
+
+    r->hash = hash;
+    r->font = font_id;
+    r->width = width;
+    r->height = pf->height;
+    r->depth = pf->depth;
+
+    run->bits = bits;
+    run->width = width;
+    run->height = pf->height;
+    run->depth = pf->depth;
+    return true;
+
+uncached:
+    text_cache.stats.uncached++;
+    return false;
+}
+
+void text_cache_release(void)
+{
+    text_cache.busy = false;
+}
+
+void text_cache_add_draw_time(unsigned long usec)
+{
+    text_cache.stats.draws++;
+    text_cache.stats.draw_time += usec;
+}
+
+void text_cache_get_stats(struct text_cache_stats *stats)
+{
+    *stats = text_cache.stats;
+
+    stats->size = text_cache.handle > 0 ? TEXT_CACHE_SIZE : 0;
+    stats->used = 0;
+    stats->runs = 0;
+
+    for (int n = 0; n < text_cache.count; n++)
+    {
+        struct text_cache_run *r = run_at(n);
+
+        if (r->font >= 0)
+        {
+            stats->used += r->size;
+            stats->runs++;
+        }
+    }
+}
+
+void text_cache_reset_stats(void)
+{
+    memset(&text_cache.stats, 0, sizeof (text_cache.stats));
+}
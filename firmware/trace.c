@@ -0,0 +1,198 @@
+/***************************************************************************
+ *             __________               __   ___.
+ *   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+ *   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+ *   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+ *   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+ *                     \/            \/     \/    \/            \/
+ * $Id$
+ *
+ * Static tracepoints recorded into per-thread ring buffers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ ****************************************************************************/
+#include "config.h"
+#include "system.h"
+#include "kernel.h"
+#include "file.h"
+#include "trace.h"
+#include "kernel/thread-internal.h" /* THREAD_ID_SLOT */
+
+/* Events kept per ring - a power of two */
+#ifndef TRACE_RING_SIZE
+#if MEMORYSIZE >= 32
+#define TRACE_RING_SIZE 1024
+#else
+#define TRACE_RING_SIZE 256
+#endif
+#endif
+
+struct trace_record
+{
+    uint32_t time;              /* trace_clock() */
+    uint32_t id;                /* TRACE_ID(phase, point) */
+    int32_t  arg;               /* tracepoint argument */
+};
+
+struct trace_ring
+{
+    unsigned long head;         /* number of events ever recorded */
+    struct trace_record rec[TRACE_RING_SIZE];
+};
+
+/* one ring per thread slot, then one per core for interrupt handlers */
+#define TRACE_ISR_RING(core)    (MAXTHREADS + (core))
+#define TRACE_NUM_RINGS         (MAXTHREADS + NUM_CORES)
+
+static struct trace_ring trace_rings[TRACE_NUM_RINGS] SHAREDBSS_ATTR;
+bool trace_running SHAREDBSS_ATTR;
+static bool trace_stop_on_trigger SHAREDBSS_ATTR;
+
+static const char * const trace_point_names[TP_NUM_POINTS] =
+{
+    [TP_SWITCH_THREAD]   = "switched out",
+    [TP_CODEC_DECODE]    = "codec decode",
+    [TP_DSP_PROCESS]     = "dsp_process",
+    [TP_PCMBUF_CALLBACK] = "pcmbuf callback",
+    [TP_BUFFER_HANDLE]   = "buffer_handle",
+    [TP_STORAGE_READ]    = "storage read",
+};
+
+/* Microseconds from the finest clock the target has; wraps around */
+static inline uint32_t trace_clock(void)
+{
+#if defined(HAVE_HRTIMER)
+    return hrtimer_now();
+#elif defined(USEC_TIMER)
+    return USEC_TIMER;
+#else
+    return current_tick * (1000000 / HZ);
+#endif
+}
+
+/* Only one context ever writes a ring, so no locking is needed */
+static inline void trace_record(struct trace_ring *ring, unsigned int id,
+                                intptr_t arg)
+{
+    unsigned long head = ring->head;
+    struct trace_record *rec = &ring->rec[head % TRACE_RING_SIZE];
+
+    rec->time = trace_clock();
+    rec->id = id;
+    rec->arg = arg;
+    ring->head = head + 1;
+}
+
+void trace_event(unsigned int id, intptr_t arg)
+{
+    trace_record(&trace_rings[THREAD_ID_SLOT(thread_self())], id, arg);
+}
+
+void trace_isr_event(unsigned int id, intptr_t arg)
+{
+    trace_record(&trace_rings[TRACE_ISR_RING(CURRENT_CORE)], id, arg);
+}
+
+void trace_thread_event(unsigned int slot, unsigned int id, intptr_t arg)
+{
+    trace_record(&trace_rings[slot], id, arg);
+}
+
+void trace_start(bool stop_on_trigger)
+{
+    trace_running = false;
+
+    for (int i = 0; i < TRACE_NUM_RINGS; i++)
+        trace_rings[i].head = 0;
+
+    trace_stop_on_trigger = stop_on_trigger;
+    trace_running = true;
+}
+
+void trace_stop(void)
+{
+    trace_running = false;
+}
+
+void trace_trigger(void)
+{
+    if (trace_stop_on_trigger)
+        trace_running = false;
+}
+
+/* The dump is text, one event per line, grouped by ring:
+ *
+ *   rbtrace 1
+ *   now <clock at the time of the dump>
+ *   point <number> <name>
+ *   ...
+ *   ring <thread|irq> <core> <name>
+ *   <time> <phase B|E|I> <point> <arg>
+ *   ...
+ *
+ * tools/trace2json.py turns it into Chrome trace / Perfetto JSON. Thread
+ * names are those of the slots at the time of the dump.
+ */
+int trace_dump(const char *filename)
+{
+    static const char phase_chars[] = "BEI";
+
+    trace_stop();
+
+    int fd = open(filename, O_WRONLY|O_CREAT|O_TRUNC, 0666);
+    if (fd < 0)
+        return -1;
+
+    fdprintf(fd, "rbtrace 1\n");
+    fdprintf(fd, "now %lu\n", (unsigned long)trace_clock());
+
+    for (int i = 0; i < TP_NUM_POINTS; i++)
+        fdprintf(fd, "point %d %s\n", i, trace_point_names[i]);
+
+    for (int i = 0; i < TRACE_NUM_RINGS; i++)
+    {
+        struct trace_ring *ring = &trace_rings[i];
+        unsigned long count = MIN(ring->head, TRACE_RING_SIZE);
+
+        if (count == 0)
+            continue;
+
+        if (i < MAXTHREADS)
+        {
+            struct thread_debug_info info;
+            unsigned int core = 0;
+
+            if (thread_get_debug_info(i, &info) <= 0)
+                snprintf(info.name, sizeof (info.name), "slot %d", i);
+#if NUM_CORES > 1
+            else
+                core = info.core;
+#endif
+            fdprintf(fd, "ring thread %u %s\n", core, info.name);
+        }
+        else
+        {
+            fdprintf(fd, "ring irq %d interrupts\n", i - MAXTHREADS);
+        }
+
+        for (unsigned long n = ring->head - count; n != ring->head; n++)
+        {
+            struct trace_record *rec = &ring->rec[n % TRACE_RING_SIZE];
+            unsigned int phase = rec->id >> 8;
+
+            fdprintf(fd, "%lu %c %u %ld\n", (unsigned long)rec->time,
+                     phase < sizeof (phase_chars) - 1 ? phase_chars[phase] : '?',
+                     rec->id & 0xff, (long)rec->arg);
+        }
+    }
+
+    close(fd);
+    return 0;
+}
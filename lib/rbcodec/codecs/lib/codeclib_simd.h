@@ -0,0 +1,216 @@
+/***************************************************************************
+ *             __________               __   ___.
+ *   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+ *   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+ *   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+ *   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+ *                     \/            \/     \/    \/            \/
+ * $Id$
+ *
+ * 4-way SIMD primitives for the fixed point fft/mdct (SSE2 and NEON)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ ****************************************************************************/
+
+#ifndef _CODECLIB_SIMD_H_
+#define _CODECLIB_SIMD_H_
+
+/* The vector cross products below must give exactly the same result as the
+   scalar XPROD31_R/XNPROD31_R used on the same target, so that decoders stay
+   bit-exact whichever path is compiled in.  Define CODECLIB_NO_SIMD to force
+   the scalar code (the test harness in lib/rbcodec/test/fft does this to get
+   its reference output). */
+
+#if !defined(CODECLIB_NO_SIMD) && defined(__SSE2__)
+#define CODECLIB_SIMD
+#ifdef __SSE4_1__
+#include <smmintrin.h>
+#else
+#include <emmintrin.h>
+#endif
+
+typedef __m128i v4i32;
+
+#define v4_add(a, b)    _mm_add_epi32(a, b)
+#define v4_sub(a, b)    _mm_sub_epi32(a, b)
+#define v4_neg(a)       _mm_sub_epi32(_mm_setzero_si128(), a)
+#define v4_set(a, b, c, d) _mm_setr_epi32(a, b, c, d)
+
+/* high 32 bits of the signed 64 bit products, i.e. MULT32() per lane */
+static inline v4i32 v4_mult32(v4i32 a, v4i32 b)
+{
+    v4i32 even, odd;
+#ifdef __SSE4_1__
+    even = _mm_mul_epi32(a, b);
+    odd  = _mm_mul_epi32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+#else
+    even = _mm_mul_epu32(a, b);
+    odd  = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+#endif
+    even = _mm_srli_epi64(even, 32);
+    odd  = _mm_and_si128(odd, _mm_setr_epi32(0, -1, 0, -1));
+    even = _mm_or_si128(even, odd);
+#ifndef __SSE4_1__
+    /* unsigned -> signed correction of the high word */
+    even = _mm_sub_epi32(even, _mm_and_si128(_mm_srai_epi32(a, 31), b));
+    even = _mm_sub_epi32(even, _mm_and_si128(_mm_srai_epi32(b, 31), a));
+#endif
+    return even;
+}
+
+/* a*t + b*v and a*t - b*v in s.31, matching the generic C macros */
+#define v4_mac31(a, t, b, v) \
+    _mm_slli_epi32(_mm_add_epi32(v4_mult32(a, t), v4_mult32(b, v)), 1)
+#define v4_msb31(a, t, b, v) \
+    _mm_slli_epi32(_mm_sub_epi32(v4_mult32(a, t), v4_mult32(b, v)), 1)
+
+/* load two complex values from p and two from q, split into real and
+   imaginary vectors */
+static inline void v4_load_cplx2(const int32_t *p, const int32_t *q,
+                                 v4i32 *re, v4i32 *im)
+{
+    __m128 lo = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)p));
+    __m128 hi = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)q));
+    *re = _mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+    *im = _mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)));
+}
+
+static inline void v4_store_cplx2(int32_t *p, int32_t *q, v4i32 re, v4i32 im)
+{
+    _mm_storeu_si128((__m128i *)p, _mm_unpacklo_epi32(re, im));
+    _mm_storeu_si128((__m128i *)q, _mm_unpackhi_epi32(re, im));
+}
+
+#define v4_reverse(a)   _mm_shuffle_epi32(a, _MM_SHUFFLE(0, 1, 2, 3))
+
+#elif !defined(CODECLIB_NO_SIMD) && defined(__ARM_NEON__)
+#define CODECLIB_SIMD
+#include <arm_neon.h>
+
+typedef int32x4_t v4i32;
+
+#define v4_add(a, b)    vaddq_s32(a, b)
+#define v4_sub(a, b)    vsubq_s32(a, b)
+#define v4_neg(a)       vnegq_s32(a)
+
+static inline v4i32 v4_set(int32_t a, int32_t b, int32_t c, int32_t d)
+{
+    int32_t s[4] = { a, b, c, d };
+    return vld1q_s32(s);
+}
+
+/* 64 bit products of the low and high lane pairs */
+#define V4_MULL(a, b, lo, hi) \
+    { lo = vmull_s32(vget_low_s32(a), vget_low_s32(b)); \
+      hi = vmull_s32(vget_high_s32(a), vget_high_s32(b)); }
+
+#define V4_HI32(lo, hi) \
+    vcombine_s32(vshrn_n_s64(lo, 32), vshrn_n_s64(hi, 32))
+
+#if defined(CPU_ARM) && ARM_ARCH < 6
+/* asm_arm.h accumulates in 64 bits (smull/smlal) before truncating */
+static inline v4i32 v4_mac31(v4i32 a, v4i32 t, v4i32 b, v4i32 v)
+{
+    int64x2_t lo, hi;
+    V4_MULL(a, t, lo, hi);
+    lo = vmlal_s32(lo, vget_low_s32(b), vget_low_s32(v));
+    hi = vmlal_s32(hi, vget_high_s32(b), vget_high_s32(v));
+    return vshlq_n_s32(V4_HI32(lo, hi), 1);
+}
+
+static inline v4i32 v4_msb31(v4i32 a, v4i32 t, v4i32 b, v4i32 v)
+{
+    int64x2_t lo, hi;
+    V4_MULL(a, t, lo, hi);
+    lo = vmlsl_s32(lo, vget_low_s32(b), vget_low_s32(v));
+    hi = vmlsl_s32(hi, vget_high_s32(b), vget_high_s32(v));
+    return vshlq_n_s32(V4_HI32(lo, hi), 1);
+}
+#else
+static inline v4i32 v4_mult32(v4i32 a, v4i32 b)
+{
+    int64x2_t lo, hi;
+    V4_MULL(a, b, lo, hi);
+    return V4_HI32(lo, hi);
+}
+
+static inline v4i32 v4_mac31(v4i32 a, v4i32 t, v4i32 b, v4i32 v)
+{
+    return vshlq_n_s32(vaddq_s32(v4_mult32(a, t), v4_mult32(b, v)), 1);
+}
+
+#if defined(CPU_ARM)
+/* smmls rounds the subtracted product towards +inf, i.e. it takes the
+   high word of the negated 64 bit product */
+static inline v4i32 v4_msb31(v4i32 a, v4i32 t, v4i32 b, v4i32 v)
+{
+    int64x2_t lo, hi;
+    const int64x2_t zero = vdupq_n_s64(0);
+    V4_MULL(b, v, lo, hi);
+    lo = vsubq_s64(zero, lo);
+    hi = vsubq_s64(zero, hi);
+    return vshlq_n_s32(vaddq_s32(v4_mult32(a, t), V4_HI32(lo, hi)), 1);
+}
+#else
+static inline v4i32 v4_msb31(v4i32 a, v4i32 t, v4i32 b, v4i32 v)
+{
+    return vshlq_n_s32(vsubq_s32(v4_mult32(a, t), v4_mult32(b, v)), 1);
+}
+#endif /* CPU_ARM */
+#endif /* ARM_ARCH */
+
+static inline void v4_load_cplx2(const int32_t *p, const int32_t *q,
+                                 v4i32 *re, v4i32 *im)
+{
+    int32x2x2_t lo = vld2_s32(p);
+    int32x2x2_t hi = vld2_s32(q);
+    *re = vcombine_s32(lo.val[0], hi.val[0]);
+    *im = vcombine_s32(lo.val[1], hi.val[1]);
+}
+
+static inline void v4_store_cplx2(int32_t *p, int32_t *q, v4i32 re, v4i32 im)
+{
+    int32x2x2_t x;
+    x.val[0] = vget_low_s32(re);
+    x.val[1] = vget_low_s32(im);
+    vst2_s32(p, x);
+    x.val[0] = vget_high_s32(re);
+    x.val[1] = vget_high_s32(im);
+    vst2_s32(q, x);
+}
+
+static inline v4i32 v4_reverse(v4i32 a)
+{
+    a = vrev64q_s32(a);
+    return vcombine_s32(vget_high_s32(a), vget_low_s32(a));
+}
+
+#endif /* __SSE2__ / __ARM_NEON__ */
+
+#ifdef CODECLIB_SIMD
+/* four consecutive complex values */
+#define v4_load_cplx(p, re, im)  v4_load_cplx2(p, (p) + 4, re, im)
+#define v4_store_cplx(p, re, im) v4_store_cplx2(p, (p) + 4, re, im)
+
+/* XPROD31_R / XNPROD31_R on four lanes */
+#define V4_XPROD31(_a, _b, _t, _v, _x, _y)\
+{\
+  _x = v4_mac31(_a, _t, _b, _v);\
+  _y = v4_msb31(_b, _t, _a, _v);\
+}
+
+#define V4_XNPROD31(_a, _b, _t, _v, _x, _y)\
+{\
+  _x = v4_msb31(_a, _t, _b, _v);\
+  _y = v4_mac31(_b, _t, _a, _v);\
+}
+#endif
+
+#endif /* _CODECLIB_SIMD_H_ */
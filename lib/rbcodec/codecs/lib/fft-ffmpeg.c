@@ -55,6 +55,7 @@
 /* asm-optimised functions and/or macros */
 #include "fft-ffmpeg_arm.h"
 #include "fft-ffmpeg_cf.h"
+#include "codeclib_simd.h"
 
 #ifndef ICODE_ATTR_TREMOR_MDCT
 #define ICODE_ATTR_TREMOR_MDCT ICODE_ATTR
@@ -275,6 +276,62 @@ static inline FFTComplex* TRANSFORM_ZERO(FFTComplex * z, unsigned int n)
 }
 #endif
 
+#ifdef CODECLIB_SIMD
+/* Four consecutive TRANSFORM_W10 (twiddles walking forwards) or
+   TRANSFORM_W01 (walking backwards) steps at once.  Same arithmetic as the
+   scalar versions, just one butterfly per lane. */
+static inline FFTComplex* TRANSFORM4(FFTComplex * z, unsigned int n,
+                                     v4i32 wre, v4i32 wim)
+{
+    v4i32 r0, i0, r1, i1, r2, i2, r3, i3;
+    v4i32 t1, t2, t5, t6, temp1, temp2;
+
+    v4_load_cplx(&z[n*2].re, &r2, &i2);
+    V4_XPROD31(r2, i2, wre, wim, t1, t2);
+    v4_load_cplx(&z[n*3].re, &r3, &i3);
+    V4_XNPROD31(r3, i3, wre, wim, t5, t6);
+
+    v4_load_cplx(&z[0].re, &r0, &i0);
+    v4_load_cplx(&z[n].re, &r1, &i1);
+
+    temp1 = v4_sub(t5, t1);
+    temp2 = v4_add(t5, t1);
+    r2 = v4_sub(r0, temp2);
+    r0 = v4_add(r0, temp2);
+    i3 = v4_sub(i1, temp1);
+    i1 = v4_add(i1, temp1);
+
+    temp1 = v4_sub(t2, t6);
+    temp2 = v4_add(t2, t6);
+    r3 = v4_sub(r1, temp1);
+    r1 = v4_add(r1, temp1);
+    i2 = v4_sub(i0, temp2);
+    i0 = v4_add(i0, temp2);
+
+    v4_store_cplx(&z[0].re, r0, i0);
+    v4_store_cplx(&z[n].re, r1, i1);
+    v4_store_cplx(&z[n*2].re, r2, i2);
+    v4_store_cplx(&z[n*3].re, r3, i3);
+    return z+4;
+}
+
+static inline FFTComplex* TRANSFORM4_W10(FFTComplex * z, unsigned int n,
+                                         const FFTSample * w, unsigned int STEP)
+{
+    const v4i32 wim = v4_set(w[0], w[STEP], w[STEP*2], w[STEP*3]);
+    const v4i32 wre = v4_set(w[1], w[STEP+1], w[STEP*2+1], w[STEP*3+1]);
+    return TRANSFORM4(z, n, wre, wim);
+}
+
+static inline FFTComplex* TRANSFORM4_W01(FFTComplex * z, unsigned int n,
+                                         const FFTSample * w, int STEP)
+{
+    const v4i32 wre = v4_set(w[0], w[-STEP], w[-STEP*2], w[-STEP*3]);
+    const v4i32 wim = v4_set(w[1], w[1-STEP], w[1-STEP*2], w[1-STEP*3]);
+    return TRANSFORM4(z, n, wre, wim);
+}
+#endif /* CODECLIB_SIMD */
+
 /* z[0...8n-1], w[1...2n-1] */
 static void pass(FFTComplex *z_arg, unsigned int STEP_arg, unsigned int n_arg) ICODE_ATTR_TREMOR_MDCT;
 static void pass(FFTComplex *z_arg, unsigned int STEP_arg, unsigned int n_arg)
@@ -291,6 +348,24 @@ static void pass(FFTComplex *z_arg, unsigned int STEP_arg, unsigned int n_arg)
     z = TRANSFORM_ZERO(z,n);
     z = TRANSFORM_W10(z,n,w);
     w += STEP;
+#ifdef CODECLIB_SIMD
+    /* n >= 8 here, so after two more scalar steps both halves are whole
+       multiples of four */
+    z = TRANSFORM_W10(z,n,w);
+    w += STEP;
+    z = TRANSFORM_W10(z,n,w);
+    w += STEP;
+    while(LIKELY(w < w_end)) {
+        z = TRANSFORM4_W10(z,n,w,STEP);
+        w += STEP*4;
+    }
+    w_end=sincos_lookup0;
+    while(LIKELY(w>w_end))
+    {
+        z = TRANSFORM4_W01(z,n,w,STEP);
+        w -= STEP*4;
+    }
+#else
     /* first pass forwards through sincos_lookup0*/
     do {
         z = TRANSFORM_W10(z,n,w);
@@ -308,6 +383,7 @@ static void pass(FFTComplex *z_arg, unsigned int STEP_arg, unsigned int n_arg)
         z = TRANSFORM_W01(z,n,w);
         w -= STEP;
     }
+#endif
 }
 
 /* what is STEP?
@@ -22,6 +22,7 @@
 #include "mdct.h"
 #include "codeclib_misc.h"
 #include "mdct_lookup.h"
+#include "codeclib_simd.h"
 
 #ifndef ICODE_ATTR_TREMOR_MDCT
 #define ICODE_ATTR_TREMOR_MDCT ICODE_ATTR
@@ -326,6 +327,23 @@ void ff_imdct_half(unsigned int nbits, fixed32 *output, const fixed32 *input)
             }
 #else
             fixed32 * z2 = (fixed32 *)(&z[n4-1]);
+#ifdef CODECLIB_SIMD
+            /* two values from each end per step.  Lanes are z1[0], z1[1],
+               z2[-1], z2[0], so the imaginary results that get swapped
+               between the ends are simply lane reversed */
+            while(z2 - z1 >= 6)
+            {
+                v4i32 re, im, t, v, x, y;
+                v4_load_cplx2(z1, z2 - 2, &re, &im);
+                t = v4_set(T[0], T[newstep*2], T[newstep*3+1], T[newstep+1]);
+                v = v4_set(T[1], T[newstep*2+1], T[newstep*3], T[newstep]);
+                V4_XNPROD31(im, re, t, v, x, y);
+                v4_store_cplx2(z1, z2 - 2, v4_neg(x), v4_neg(v4_reverse(y)));
+                T += newstep*4;
+                z1 += 4;
+                z2 -= 4;
+            }
+#endif
             while(z1<z2)
             {
                 fixed32 r0,i0,r1,i1;
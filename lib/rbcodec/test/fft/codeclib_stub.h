@@ -0,0 +1,44 @@
+/***************************************************************************
+ *             __________               __   ___.
+ *   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+ *   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+ *   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+ *   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+ *                     \/            \/     \/    \/            \/
+ * $Id$
+ *
+ * Minimal stand-in for codeclib.h so the transforms build on the host
+ * without the rest of the codec api.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ ****************************************************************************/
+
+#ifndef __CODECLIB_H__
+#define __CODECLIB_H__
+
+#include <stdint.h>
+#include <string.h>
+
+#define ICODE_ATTR
+#define ICONST_ATTR
+#define IBSS_ATTR
+#define LIKELY(x)   __builtin_expect(!!(x), 1)
+#define UNLIKELY(x) __builtin_expect(!!(x), 0)
+
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define ROCKBOX_BIG_ENDIAN
+#else
+#define ROCKBOX_LITTLE_ENDIAN
+#endif
+
+#include "mdct.h"
+#include "fft.h"
+
+#endif /* __CODECLIB_H__ */
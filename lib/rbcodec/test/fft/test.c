@@ -0,0 +1,177 @@
+/***************************************************************************
+ *             __________               __   ___.
+ *   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+ *   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+ *   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+ *   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+ *                     \/            \/     \/    \/            \/
+ * $Id$
+ *
+ * Checks the codeclib fft/imdct against the scalar build of the same code.
+ * Like test_codec, each transform's output is reduced to a checksum; the
+ * SIMD and scalar checksums must match exactly.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "codeclib_simd.h"
+
+void ref_fft_calc_c(int nbits, FFTComplex *z);
+void ref_imdct_half(unsigned int nbits, fixed32 *output, const fixed32 *input);
+void ref_imdct_calc(unsigned int nbits, fixed32 *output, const fixed32 *input);
+
+#define MAX_BITS 13
+#define MAX_N    (1 << MAX_BITS)
+#define RUNS     4
+
+static int32_t input[MAX_N];
+static int32_t out_ref[MAX_N];
+static int32_t out_test[MAX_N];
+
+static uint32_t rand_state;
+
+static int32_t next_rand(int bits)
+{
+    rand_state = rand_state * 1664525 + 1013904223;
+    return (int32_t)rand_state >> (32 - bits);
+}
+
+static void fill_input(int n, int bits)
+{
+    int i;
+    for (i = 0; i < n; i++)
+        input[i] = next_rand(bits);
+}
+
+/* adler32, as used for the test_codec checksums */
+static uint32_t checksum(const int32_t *buf, int n)
+{
+    const unsigned char *p = (const unsigned char *)buf;
+    uint32_t a = 1, b = 0;
+    int i;
+    for (i = 0; i < n * 4; i++) {
+        a = (a + p[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+}
+
+static int errors;
+
+static void compare(const char *name, int nbits, int n)
+{
+    uint32_t ref = checksum(out_ref, n);
+    uint32_t test = checksum(out_test, n);
+    int ok = (ref == test) && !memcmp(out_ref, out_test, n * sizeof(int32_t));
+
+    if (!ok) {
+        int i;
+        for (i = 0; i < n && out_ref[i] == out_test[i]; i++);
+        printf("%-11s nbits=%2d ref=%08x simd=%08x MISMATCH at %d (%d != %d)\n",
+               name, nbits, (unsigned)ref, (unsigned)test,
+               i, (int)out_ref[i], (int)out_test[i]);
+        errors++;
+    }
+}
+
+static double elapsed_us(clock_t start, int iterations)
+{
+    return (double)(clock() - start) * 1000000.0 / CLOCKS_PER_SEC / iterations;
+}
+
+static void test_fft(int nbits)
+{
+    const int n = 1 << nbits;
+    int run;
+
+    for (run = 0; run < RUNS; run++) {
+        fill_input(2*n, run & 1 ? 28 : 24);
+        memcpy(out_ref, input, 2*n * sizeof(int32_t));
+        memcpy(out_test, input, 2*n * sizeof(int32_t));
+        ref_fft_calc_c(nbits, (FFTComplex *)out_ref);
+        ff_fft_calc_c(nbits, (FFTComplex *)out_test);
+        compare("fft", nbits, 2*n);
+    }
+}
+
+static void test_imdct(int nbits)
+{
+    const int n = 1 << nbits;
+    int run;
+
+    for (run = 0; run < RUNS; run++) {
+        fill_input(n/2, run & 1 ? 28 : 24);
+        ref_imdct_half(nbits, out_ref, input);
+        ff_imdct_half(nbits, out_test, input);
+        compare("imdct_half", nbits, n/2);
+
+        ref_imdct_calc(nbits, out_ref, input);
+        ff_imdct_calc(nbits, out_test, input);
+        compare("imdct_calc", nbits, n);
+    }
+}
+
+static void bench_imdct(int nbits)
+{
+    const int n = 1 << nbits;
+    const int iterations = (1 << 24) >> nbits;
+    double t_ref, t_test;
+    clock_t start;
+    int i;
+
+    fill_input(n/2, 24);
+
+    start = clock();
+    for (i = 0; i < iterations; i++)
+        ref_imdct_half(nbits, out_ref, input);
+    t_ref = elapsed_us(start, iterations);
+
+    start = clock();
+    for (i = 0; i < iterations; i++)
+        ff_imdct_half(nbits, out_test, input);
+    t_test = elapsed_us(start, iterations);
+
+    printf("imdct_half nbits=%2d checksum=%08x  scalar %8.2f us  simd %8.2f us\n",
+           nbits, (unsigned)checksum(out_test, n/2), t_ref, t_test);
+}
+
+int main(void)
+{
+    int nbits;
+
+#ifdef CODECLIB_SIMD
+    printf("SIMD path enabled\n");
+#else
+    printf("no SIMD path for this host, comparing scalar against itself\n");
+#endif
+
+    rand_state = 0x12345678;
+
+    for (nbits = 2; nbits <= 12; nbits++)
+        test_fft(nbits);
+
+    for (nbits = 6; nbits <= MAX_BITS; nbits++)
+        test_imdct(nbits);
+
+    for (nbits = 7; nbits <= 12; nbits++)
+        bench_imdct(nbits);
+
+    if (errors) {
+        printf("%d mismatches\n", errors);
+        return 1;
+    }
+
+    printf("all transforms bit-exact\n");
+    return 0;
+}
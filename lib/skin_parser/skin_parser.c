@@ -491,36 +491,73 @@ static struct skin_element* skin_parse_sublines_optional(const char** document,
     return retval;
 }
 
+/* The most arguments a tag's parameter string allows, or -1 if a '*' lets
+ * it take any number of them */
+static int max_tag_args(const char* tag_args)
+{
+    int count = 0;
+
+    for (; *tag_args; tag_args++)
+    {
+        if (*tag_args == '*')
+            return -1;
+        if (*tag_args == '|')
+            continue;
+        if (*tag_args == '[')
+            tag_args = strchr(tag_args, ']');
+        count++;
+    }
+    return count;
+}
+
+/* Counts the arguments in the list at cursor, for tags that take any
+ * number of them */
+static int count_tag_args(const char* cursor)
+{
+    int num_args = 1;
+
+    while(*cursor != '\n' && *cursor != '\0' && *cursor != ARGLISTCLOSESYM)
+    {
+        /* Skipping over escaped characters */
+        if(*cursor == TAGSYM && *(cursor+1) != ARGLISTSEPARATESYM)
+        {
+            skip_tag(&cursor);
+        }
+        else if(*cursor == COMMENTSYM)
+        {
+            skip_comment(&cursor);
+        }
+        else if(*cursor == ARGLISTSEPARATESYM)
+        {
+            num_args++;
+            cursor++;
+        }
+        else
+        {
+            cursor++;
+        }
+    }
+    return num_args;
+}
+
 static int skin_parse_tag(struct skin_element* element, const char** document)
 {
     const char* cursor = *document + 1;
-    const char* bookmark;
     char *open_square_bracket = NULL;
 
-    char tag_name[MAX_TAG_LENGTH];
     char* tag_args;
     const struct tag_info *tag;
-    struct skin_tag_parameter* params = NULL;
+    struct skin_tag_parameter* args;
 
-    int num_args = 1;
+    int max_args;
     int i;
+    int last = 0;
     int qmark = 0; /* Flag for the all-or-none option */
 
     int optional = 0;
 
     /* Checking the tag name */
-    for (i=0; cursor[i] && i<MAX_TAG_LENGTH; i++)
-        tag_name[i] = cursor[i];
-
-    /* First we check the two characters after the '%', then a single char */
-    tag = NULL;
-    i = MAX_TAG_LENGTH;
-    while (!tag && i > 1)
-    {
-        tag_name[i-1] = '\0';
-        tag = find_tag(tag_name);
-        i--;
-    }
+    tag = find_tag_prefix(cursor, &i);
 
     if(!tag)
     {
@@ -574,41 +611,20 @@ static int skin_parse_tag(struct skin_element* element, const char** document)
         cursor++;
     }
 
-    bookmark = cursor;
-    while(*cursor != '\n' && *cursor != '\0' && *cursor != ARGLISTCLOSESYM)
-    {
-        /* Skipping over escaped characters */
-        if(*cursor == TAGSYM && *(cursor+1) != ARGLISTSEPARATESYM)
-        {
-            skip_tag(&cursor);
-        }
-        else if(*cursor == COMMENTSYM)
-        {
-            skip_comment(&cursor);
-        }
-        else if(*cursor == ARGLISTSEPARATESYM)
-        {
-            num_args++;
-            cursor++;
-        }
-        else
-        {
-            cursor++;
-        }
-    }
-
-    cursor = bookmark; /* Restoring the cursor */
-    element->params_count = num_args;
-    params = skin_alloc_params(num_args);
-    if (!params)
-        return 0;
+    /* The parameter string bounds the number of arguments, so they can be
+     * parsed as they come. Only a list that can repeat needs counting first.
+     * They go to the skin buffer once it is known how many there were */
+    max_args = max_tag_args(tag_args);
+    if (max_args < 0)
+        max_args = count_tag_args(cursor);
+    struct skin_tag_parameter params[max_args];
 
     /* Now we have to actually parse each argument */
-    for(i = 0; i < num_args; i++)
+    for(i = 0; !last; i++)
     {
         char type_code;
         /* Making sure we haven't run out of arguments */
-        if(*tag_args == '\0')
+        if(*tag_args == '\0' || i == max_args)
         {
             skin_error(TOO_MANY_ARGS, cursor);
             return 0;
@@ -785,24 +801,24 @@ static int skin_parse_tag(struct skin_element* element, const char** document)
 
         skip_whitespace(&cursor);
 
-        if(*cursor != ARGLISTSEPARATESYM && i < num_args - 1)
+        if(*cursor == ARGLISTCLOSESYM)
         {
-            skin_error(SEPARATOR_EXPECTED, cursor);
-            return 0;
+            last = 1;
         }
-        else if(*cursor != ARGLISTCLOSESYM && i == num_args - 1)
+        else if(*cursor != ARGLISTSEPARATESYM)
         {
-            skin_error(CLOSE_EXPECTED, cursor);
+            /* a separator if more arguments follow, the close otherwise */
+            if(count_tag_args(cursor) > 1)
+                skin_error(SEPARATOR_EXPECTED, cursor);
+            else
+                skin_error(CLOSE_EXPECTED, cursor);
             return 0;
         }
-        else
-        {
-            cursor++;
-        }
+        cursor++;
 
         if (*(tag_args + 1) == '*')
         {
-            if (i+1 == num_args)
+            if (last)
                 tag_args += 2;
             else if (open_square_bracket  && *tag_args == ']')
             {
@@ -820,7 +836,13 @@ static int skin_parse_tag(struct skin_element* element, const char** document)
             tag_args++;
         }
     }
-    element->params = skin_buffer_to_offset(params);
+    args = skin_alloc_params(i);
+    if (!args)
+        return 0;
+    memcpy(args, params, sizeof(*args) * i);
+
+    element->params_count = i;
+    element->params = skin_buffer_to_offset(args);
 
     /* Checking for a premature end */
     if(*tag_args != '\0' && !optional)
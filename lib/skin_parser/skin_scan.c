@@ -43,11 +43,8 @@ void skip_comment(const char** document)
 
 void skip_tag(const char** document)
 {
-    char tag_name[MAX_TAG_LENGTH];
-    int i;
+    int length;
     bool qmark;
-    const struct tag_info *tag;
-    const char *cursor;
 
     if(**document == TAGSYM)
         (*document)++;
@@ -61,26 +58,8 @@ void skip_tag(const char** document)
     }
     else
     {
-        cursor = *document;
-
-        /* Checking the tag name */
-        for (i=0; cursor[i] && i<MAX_TAG_LENGTH; i++)
-            tag_name[i] = cursor[i];
-
-        /* First we check the two characters after the '%', then a single char */
-        tag = NULL;
-        i = MAX_TAG_LENGTH;
-        while (!tag && i > 1)
-        {
-            tag_name[i-1] = '\0';
-            tag = find_tag(tag_name);
-            i--;
-        }
-
-        if (tag)
-        {
-            *document += strlen(tag->name);
-        }
+        if (find_tag_prefix(*document, &length))
+            *document += length;
     }
     if (**document == ARGLISTOPENSYM)
         skip_arglist(document);
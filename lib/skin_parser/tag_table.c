@@ -253,29 +253,86 @@ static const struct tag_info legal_tags[] =
 /* A table of legal escapable characters */
 static const char legal_escape_characters[] = "%(,);#<|>";
 
+#define TAG_COUNT (sizeof(legal_tags)/sizeof(*legal_tags) - 1)
+
 /*
- * Just does a straight search through the tag table to find one by
- * the given name
+ * The tags are chained by their first character, in table order, so a
+ * lookup only compares the handful of names sharing that character.
+ * Indexes are +1 so a zeroed table means an empty chain. The chains are
+ * built on the first lookup, so a host parsing skins on several threads
+ * has to make one lookup before starting them.
  */
-const struct tag_info* find_tag(const char* name)
+static unsigned short tag_chain_head[128];
+static unsigned short tag_chain_next[TAG_COUNT];
+static int tag_chains_built = 0;
+
+static void build_tag_chains(void)
 {
-    
-    const struct tag_info* current = legal_tags;
-    
-    /* 
-     * Continue searching so long as we have a non-empty name string
-     * and the name of the current element doesn't match the name
-     * we're searching for
-     */
-    
-    while(strcmp(current->name, name) && current->name[0] != '\0')
-        current++;
+    unsigned short *tail[128];
+    unsigned i;
+
+    for (i = 0; i < 128; i++)
+    {
+        tag_chain_head[i] = 0;
+        tail[i] = &tag_chain_head[i];
+    }
+
+    for (i = 0; i < TAG_COUNT; i++)
+    {
+        unsigned char c = legal_tags[i].name[0] & 0x7f;
+        tag_chain_next[i] = 0;
+        *tail[c] = i + 1;
+        tail[c] = &tag_chain_next[i];
+    }
 
-    if(current->name[0] == '\0')
+    tag_chains_built = 1;
+}
+
+const struct tag_info* find_tag_prefix(const char* text, int* length)
+{
+    const struct tag_info* found = NULL;
+    int found_len = 0;
+    unsigned char c = *text;
+    unsigned i;
+
+    if (c == '\0' || c >= 128)
         return NULL;
-    else
-        return current;
+    if (!tag_chains_built)
+        build_tag_chains();
+
+    for (i = tag_chain_head[c]; i; i = tag_chain_next[i-1])
+    {
+        const struct tag_info* current = &legal_tags[i-1];
+        const char* name = current->name + 1;
+        int len = 1;
 
+        while (*name && *name == text[len])
+        {
+            name++;
+            len++;
+        }
+
+        /* longest name wins, the earlier one of the same length */
+        if (*name == '\0' && len > found_len)
+        {
+            found = current;
+            found_len = len;
+        }
+    }
+
+    if (found && length)
+        *length = found_len;
+    return found;
+}
+
+const struct tag_info* find_tag(const char* name)
+{
+    int length;
+    const struct tag_info* tag = find_tag_prefix(name, &length);
+
+    if (tag && name[length] != '\0')
+        return NULL;
+    return tag;
 }
 
 /* Searches through the legal escape characters string */
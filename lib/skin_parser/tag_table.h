@@ -350,6 +350,12 @@ struct tag_info
  */
 const struct tag_info* find_tag(const char* name);
 
+/*
+ * Finds the longest tag name that text starts with, and stores its length
+ * in length. Returns NULL if text doesn't start with a tag
+ */
+const struct tag_info* find_tag_prefix(const char* text, int* length);
+
 /*
  * Determines whether a character is legal to escape or not.  If 
  * lookup is not found in the legal escape characters string, returns
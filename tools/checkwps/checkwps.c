@@ -22,6 +22,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include "config.h"
 #include "checkwps.h"
 #include "resize.h"
@@ -248,6 +249,109 @@ struct font* font_get(int font)
 /* This is no longer defined in ROCKBOX builds so just use a huge value */
 #define SKIN_BUFFER_SIZE (200*1024)
 
+/* how long each skin gets parsed over and over in benchmark mode */
+#define BENCHMARK_NS 250000000L
+
+static long now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static int count_tags(struct skin_element* element)
+{
+    int count = 0;
+    int i;
+
+    for (; element; element = SKINOFFSETTOPTR(skin_buffer, element->next))
+    {
+        struct skin_element **children =
+            SKINOFFSETTOPTR(skin_buffer, element->children);
+        struct skin_tag_parameter *params =
+            SKINOFFSETTOPTR(skin_buffer, element->params);
+
+        if (element->type == TAG || element->type == CONDITIONAL)
+            count++;
+
+        for (i = 0; children && i < element->children_count; i++)
+            count += count_tags(children[i]);
+
+        for (i = 0; params && i < element->params_count; i++)
+        {
+            if (params[i].type == CODE)
+                count += count_tags(SKINOFFSETTOPTR(skin_buffer,
+                                                    params[i].data.code));
+        }
+    }
+    return count;
+}
+
+/* Parse each skin over and over and report how many tags a second the
+ * parser gets through. Only the generic parser runs, without the skin
+ * engine's callback, so images, fonts and the target's screen size don't
+ * come into it */
+static int benchmark(char **files)
+{
+    long total_tags = 0, total_ns = 0;
+
+    for (; *files; files++)
+    {
+        const char* name = *files;
+        FILE* fp = fopen(name, "rb");
+        char* document;
+        long size, start, elapsed;
+        int tags = 0, runs = 0;
+
+        if (!fp)
+        {
+            printf("Can't open %s\n", name);
+            return 2;
+        }
+        fseek(fp, 0, SEEK_END);
+        size = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+        document = malloc(size + 1);
+        if (!document || fread(document, 1, size, fp) != (size_t)size)
+        {
+            printf("Can't read %s\n", name);
+            fclose(fp);
+            return 2;
+        }
+        fclose(fp);
+        document[size] = '\0';
+
+        start = now_ns();
+        do
+        {
+            struct skin_element* tree;
+
+            skin_buffer_init(skin_buffer, SKIN_BUFFER_SIZE);
+            tree = skin_parse(document, NULL, NULL);
+            if (!tree)
+            {
+                printf("%s: parsing failure\n", name);
+                skin_error_format_message();
+                free(document);
+                return 3;
+            }
+            if (runs++ == 0)
+                tags = count_tags(tree);
+            elapsed = now_ns() - start;
+        } while (elapsed < BENCHMARK_NS);
+
+        printf("%-40s %5d tags %9.0f tags/s\n", name, tags,
+               (double)tags * runs * 1000000000.0 / elapsed);
+        total_tags += (long)tags * runs;
+        total_ns += elapsed;
+        free(document);
+    }
+
+    if (total_ns)
+        printf("total %.0f tags/s\n", total_tags * 1000000000.0 / total_ns);
+    return 0;
+}
+
 int main(int argc, char **argv)
 {
     int res;
@@ -268,6 +372,7 @@ int main(int argc, char **argv)
         printf("\t-v\t\tverbose\n");
         printf("\t-vv\t\tmore verbose\n");
         printf("\t-vvv\t\tvery verbose\n");
+        printf("\t-b\t\tbenchmark the parser, reporting tags/s\n");
         printf("\t-h,\t--help\tshow this message\n");
         return 1;
     }
@@ -289,6 +394,9 @@ int main(int argc, char **argv)
 
     skin_buffer_init(skin_buffer, SKIN_BUFFER_SIZE);
 
+    if (!strcmp(argv[1], "-b"))
+        return benchmark(&argv[2]);
+
     /* Go through every skin that was thrown at us, error out at the first
      * flawed wps */
     while (argv[filearg]) {
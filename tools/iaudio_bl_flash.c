@@ -0,0 +1,134 @@
+const unsigned short iaudio_bl_flash[] = {
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0xf0f0, 0xf0f0, 0x1010, 0x1010, 0x1010, 0x0000, 0xf0f0, 0xf0f0, 0x0000, 0x0000,
+0x8080, 0x4040, 0x4040, 0x4040, 0xc0c0, 0x8080, 0x0000, 0x0000, 0x8080, 0xc0c0,
+0x4040, 0x4040, 0x8080, 0x0000, 0x0000, 0xf0f0, 0xf0f0, 0x4040, 0x4040, 0xc0c0,
+0x8080, 0x0000, 0x0000, 0xd0d0, 0xd0d0, 0x0000, 0x0000, 0xc0c0, 0xc0c0, 0x4040,
+0x4040, 0xc0c0, 0x8080, 0x0000, 0x0000, 0x8080, 0xc0c0, 0x4040, 0x4040, 0xc0c0,
+0xc0c0, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x1f1f, 0x1f1f, 0x0101, 0x0101, 0x0000, 0x0000, 0x1f1f, 0x1f1f, 0x0000, 0x0000,
+0x0e0e, 0x1f1f, 0x1111, 0x1111, 0x1f1f, 0x1f1f, 0x0000, 0x0000, 0x0909, 0x1313,
+0x1717, 0x1e1e, 0x0c0c, 0x0000, 0x0000, 0x1f1f, 0x1f1f, 0x0000, 0x0000, 0x1f1f,
+0x1f1f, 0x0000, 0x0000, 0x1f1f, 0x1f1f, 0x0000, 0x0000, 0x1f1f, 0x1f1f, 0x0000,
+0x0000, 0x1f1f, 0x1f1f, 0x0000, 0x0000, 0x4f4f, 0x5f5f, 0x5050, 0x5050, 0x7f7f,
+0x3f3f, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 
+0x0000, 0x0000, 0x0808, 0xfcfc, 0x0808, 0xe8e8, 0xe8e8, 0xe8e8, 0xe8e8, 0xe8e8,
+0xe8e8, 0xe8e8, 0xe8e8, 0xe0e0, 0xc0c0, 0xc0c0, 0xc0c0, 0x8080, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x8080, 0xc0c0, 0xc0c0, 0xe0e0, 0xe0e0, 0xe0e0,
+0xe0e0, 0xe8e8, 0xe8e8, 0xc8c8, 0xd0d0, 0x9090, 0x2020, 0xc0c0, 0x0000, 0x0000,
+0x0000, 0x0000, 0xc0c0, 0x2020, 0x9090, 0xd0d0, 0xc8c8, 0xe8e8, 0xe8e8, 0xe4e4,
+0xe4e4, 0xe8e8, 0xe8e8, 0xc8c8, 0xd0d0, 0x9090, 0x0808, 0xe8e8, 0xe8e8, 0xe8e8,
+0xe8e8, 0xe8e8, 0x0808, 0xfcfc, 0x0808, 0x0000, 0x0000, 0x0808, 0x8888, 0xe8e8,
+0xe8e8, 0xe8e8, 0xe8e8, 0xe8e8, 0x3838, 0x0c0c, 0x0808, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 
+0x0000, 0x0000, 0x0000, 0x0707, 0x0000, 0xffff, 0xffff, 0xffff, 0xffff, 0x2f2f,
+0x2f2f, 0x2f2f, 0x2f2f, 0xcfcf, 0x1f1f, 0xffff, 0xffff, 0xffff, 0xfefe, 0xf8f8,
+0x0000, 0xc0c0, 0xf8f8, 0xfefe, 0xffff, 0xffff, 0x7f7f, 0x1f1f, 0x0f0f, 0xe7e7,
+0x2727, 0x4f4f, 0x9f9f, 0x7f7f, 0xffff, 0xffff, 0xfefe, 0xf8f8, 0xc3c3, 0x1c1c,
+0x1c1c, 0xe3e3, 0xf8f8, 0xfefe, 0xffff, 0xffff, 0x7f7f, 0x1f1f, 0xcfcf, 0x2727,
+0x2727, 0x0707, 0x0f0f, 0x1f1f, 0x3f3f, 0xffff, 0x0000, 0xffff, 0xffff, 0xffff,
+0xffff, 0xffff, 0x0000, 0xffff, 0x0000, 0xe0e0, 0xf8f8, 0xfefe, 0xffff, 0xffff,
+0x7fff, 0x4fcf, 0x43c3, 0x40c0, 0x40c0, 0xc0c0, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 
+0x0707, 0x9999, 0xf2f2, 0x1c1c, 0x0000, 0xffff, 0xffff, 0xffff, 0xffff, 0xc0c0,
+0xc0c0, 0xf0f0, 0xd0d0, 0xcfcf, 0xe0e0, 0xffff, 0xffff, 0xffff, 0x7f7f, 0x0707,
+0xf8f8, 0xffff, 0xffff, 0xffff, 0xffff, 0x0707, 0x0000, 0x0000, 0x8080, 0xffff,
+0x8080, 0x8080, 0x8f8f, 0xf0f0, 0x8787, 0xffff, 0xffff, 0xffff, 0xffff, 0x8080,
+0xf8f8, 0xffff, 0xffff, 0xffff, 0xffff, 0x8787, 0xf0f0, 0x8f8f, 0x8080, 0x8080,
+0xe0e0, 0x8080, 0x8080, 0x0000, 0x0000, 0x0000, 0x0000, 0xffff, 0xffff, 0xffff,
+0xffff, 0xffff, 0xf0f0, 0xffff, 0xffff, 0xffff, 0xffff, 0x1f1f, 0x0303, 0xffff,
+0x00ff, 0x00ff, 0x00ff, 0x00ff, 0x00ff, 0x7fff, 0x20e0, 0x10f0, 0x10f0, 0x10f0,
+0x10f0, 0x10f0, 0x10f0, 0x20e0, 0x20e0, 0x40c0, 0x40c0, 0x8080, 0x0000, 0x0000,
+0x0000, 0x8080, 0x40c0, 0x40c0, 0x20e0, 0x20e0, 0x10f0, 0x10f0, 0x10f0, 0x10f0,
+0x10f0, 0x10f0, 0x10f0, 0x20e0, 0x20e0, 0x70f0, 0x10f0, 0x10f0, 0x10f0, 0x10f0,
+0x10f0, 0x30f0, 0xc0c0, 0x0000, 0xc0c0, 0x3030, 0xc0c0, 0x30f0, 0x10f0, 0x10f0,
+0x10f0, 0x10f0, 0x10f0, 0xd0f0, 0x3030, 0xd0d0, 0x2020, 0x1010, 
+0x7c7c, 0xc7c7, 0x1010, 0x1b1b, 0x0c0c, 0xf7f7, 0x7777, 0x8f8f, 0xffff, 0x1f1f,
+0xffff, 0x1f1f, 0x3f3f, 0xffff, 0xffff, 0xffff, 0xfbfb, 0xe1e1, 0x0000, 0x0000,
+0x1f1f, 0xffff, 0xffff, 0xffff, 0xffff, 0xe0e0, 0x0000, 0x0000, 0x0000, 0x0303,
+0x0000, 0x0000, 0xf0f0, 0x0f0f, 0xe0e0, 0xffff, 0xffff, 0xffff, 0xffff, 0x0000,
+0x1f1f, 0xffff, 0xffff, 0xffff, 0xffff, 0xe0e0, 0x0f0f, 0x7070, 0x8080, 0x0000,
+0xffff, 0x0000, 0x0000, 0x0000, 0x0000, 0x8080, 0x0000, 0xffff, 0xffff, 0xffff,
+0xffff, 0xffff, 0x7f7f, 0x8f8f, 0x3f3f, 0xffff, 0xffff, 0xffff, 0xfcfc, 0xffff,
+0x00ff, 0x00ff, 0x00ff, 0x00ff, 0x00ff, 0xe0ff, 0x101f, 0x080f, 0x0407, 0x0407,
+0x1417, 0x1417, 0x2427, 0xc8cf, 0x101f, 0xe0ff, 0x00ff, 0x00ff, 0x01ff, 0x07ff,
+0x01ff, 0x00ff, 0x00ff, 0x00ff, 0xe0ff, 0x101f, 0x080f, 0x0407, 0x0407, 0x1417,
+0x1417, 0x2427, 0xc8cf, 0x101f, 0xe0ff, 0x00ff, 0x00ff, 0x00ff, 0x00ff, 0x00ff,
+0xe0ff, 0xc0ff, 0x00ff, 0x01ff, 0x02fe, 0x01ff, 0x00ff, 0x00ff, 0xc0ff, 0x303f,
+0xc8cf, 0x3637, 0x0909, 0x0606, 0x0101, 0x0000, 0x0000, 0x0000, 
+0x0000, 0x0101, 0x0101, 0x0101, 0x8383, 0x7c7c, 0x6363, 0x1f1f, 0xffff, 0x0000,
+0xffff, 0x0000, 0x0000, 0x0101, 0x0707, 0x3f3f, 0xffff, 0xffff, 0xffff, 0xfcfc,
+0xe0e0, 0x8181, 0x1f1f, 0x7f7f, 0xffff, 0xffff, 0xffff, 0xf8f8, 0xf0f0, 0xe7e7,
+0xe4e4, 0xf3f3, 0xf8f8, 0xffff, 0xffff, 0xffff, 0x7f7f, 0x1f1f, 0x0101, 0x0000,
+0x0000, 0x0303, 0x1f1f, 0x7f7f, 0xffff, 0xffff, 0xffff, 0xfcfc, 0xf9f9, 0xf2f2,
+0xffff, 0xf0f0, 0xf8f8, 0xfcfc, 0xfefe, 0xffff, 0x0000, 0xffff, 0xffff, 0xffff,
+0xffff, 0xffff, 0x0000, 0x0303, 0x1c1c, 0x6161, 0x8f8f, 0x3f3f, 0xffff, 0xffff,
+0x00ff, 0x00ff, 0x00ff, 0x00ff, 0x00ff, 0x01ff, 0x02fe, 0x04fc, 0x08f8, 0x08f8,
+0x0efe, 0x0afa, 0x09f9, 0x04fc, 0x02fe, 0x01ff, 0x00ff, 0x80ff, 0x407f, 0x303f,
+0x407f, 0x80ff, 0x00ff, 0x00ff, 0x01ff, 0x02fe, 0x04fc, 0x08f8, 0x08f8, 0x0efe,
+0x0afa, 0x09f9, 0x04fc, 0x02fe, 0x01ff, 0x00ff, 0x00ff, 0x00ff, 0x00ff, 0x00ff,
+0x01ff, 0x00ff, 0x80ff, 0x407f, 0xa0bf, 0x407f, 0x80ff, 0x00ff, 0x00ff, 0x03ff,
+0x04fc, 0x1bfb, 0x24e4, 0xd8d8, 0x2020, 0xc0c0, 0x0000, 0x0000, 
+0x0000, 0x0000, 0x0000, 0x0000, 0x0101, 0x0606, 0x0606, 0x0707, 0x0707, 0x0404,
+0x0f0f, 0x0404, 0x0000, 0x0000, 0x0000, 0x0000, 0x0101, 0x0707, 0x0707, 0x0707,
+0x0707, 0x0707, 0x0e0e, 0x0404, 0x0000, 0x0101, 0x0303, 0x0303, 0x0707, 0x0707,
+0x0707, 0x0707, 0x0303, 0x0303, 0x0101, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0404, 0x0404, 0x0404, 0x0404, 0x0404, 0x0505, 0x0707, 0x0707, 0x0707, 0x0707,
+0x0707, 0x0707, 0x0303, 0x0303, 0x0101, 0x0000, 0x0000, 0x0707, 0x0707, 0x0707,
+0x0707, 0x0707, 0x0000, 0x0000, 0x0000, 0x0404, 0x0707, 0x0c0c, 0x0505, 0x0707,
+0x0407, 0x0407, 0x0407, 0x0407, 0x0407, 0x0707, 0x0203, 0x0203, 0x0407, 0x0407,
+0x0407, 0x0407, 0x0407, 0x0203, 0x0203, 0x0101, 0x0101, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0101, 0x0101, 0x0203, 0x0203, 0x0407, 0x0407, 0x0407, 0x0407,
+0x0407, 0x0407, 0x0407, 0x0203, 0x0203, 0x0707, 0x0407, 0x0407, 0x0407, 0x0407,
+0x0407, 0x0607, 0x0101, 0x0606, 0x0101, 0x0000, 0x0101, 0x0607, 0x0407, 0x0407,
+0x0407, 0x0407, 0x0407, 0x0407, 0x0507, 0x0606, 0x0101, 0x0606, 
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0xfefe, 0xfefe, 0x2222, 0x2222, 0xfefe, 0xdcdc, 0x0000, 0x0000, 0xf0f0, 0xf8f8,
+0x0808, 0x0808, 0xf8f8, 0xf0f0, 0x0000, 0x0000, 0xf0f0, 0xf8f8, 0x0808, 0x0808,
+0xf8f8, 0xf0f0, 0x0000, 0x0808, 0xfefe, 0xfefe, 0x0808, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0xfefe, 0xfefe, 0x0000, 0x0000, 0xf0f0, 0xf8f8, 0x0808, 0x0808,
+0xf8f8, 0xf0f0, 0x0000, 0x0000, 0xd0d0, 0xe8e8, 0x2828, 0x2828, 0xf8f8, 0xf0f0,
+0x0000, 0x0000, 0xf0f0, 0xf8f8, 0x0808, 0x0808, 0xfefe, 0xfefe, 0x0000, 0x0000,
+0xf0f0, 0xf8f8, 0x4848, 0x4848, 0x7878, 0x7070, 0x0000, 0x0000, 0xf8f8, 0xf8f8,
+0x1010, 0x0808, 0x0808, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0303, 0x0303, 0x0202, 0x0202, 0x0303, 0x0101, 0x0000, 0x0000, 0x0101, 0x0303,
+0x0202, 0x0202, 0x0303, 0x0101, 0x0000, 0x0000, 0x0101, 0x0303, 0x0202, 0x0202,
+0x0303, 0x0101, 0x0000, 0x0000, 0x0101, 0x0303, 0x0202, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0303, 0x0303, 0x0000, 0x0000, 0x0101, 0x0303, 0x0202, 0x0202,
+0x0303, 0x0101, 0x0000, 0x0000, 0x0101, 0x0303, 0x0202, 0x0202, 0x0303, 0x0303,
+0x0000, 0x0000, 0x0101, 0x0303, 0x0202, 0x0202, 0x0303, 0x0303, 0x0000, 0x0000,
+0x0101, 0x0303, 0x0202, 0x0202, 0x0202, 0x0101, 0x0000, 0x0000, 0x0303, 0x0303,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 
+
+};
+
@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+#             __________               __   ___.
+#   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+#   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+#   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+#   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+#                     \/            \/     \/    \/            \/
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+# KIND, either express or implied.
+#
+# Converts a trace dumped by a build with event tracing (see
+# firmware/export/trace.h) to the Chrome trace event JSON format, which
+# chrome://tracing and https://ui.perfetto.dev open.
+#
+# Usage: trace2json.py trace.out [trace.json]
+
+import json
+import sys
+
+CORE_NAMES = ["CPU", "COP"]
+
+
+def parse(f):
+    """Returns the dump time, the tracepoint names and the rings as
+    (kind, core, name, [(time, phase, point, arg)])"""
+    now = 0
+    points = {}
+    rings = []
+
+    for lineno, line in enumerate(f, 1):
+        line = line.rstrip("\n")
+        if not line:
+            continue
+
+        fields = line.split(" ", 3)
+        try:
+            if fields[0] == "rbtrace":
+                if fields[1] != "1":
+                    sys.exit("unsupported trace version %s" % fields[1])
+            elif fields[0] == "now":
+                now = int(fields[1])
+            elif fields[0] == "point":
+                rest = line.split(" ", 2)
+                points[int(rest[1])] = rest[2]
+            elif fields[0] == "ring":
+                rings.append((fields[1], int(fields[2]), fields[3], []))
+            else:
+                rings[-1][3].append((int(fields[0]), fields[1],
+                                     int(fields[2]), int(fields[3])))
+        except (IndexError, ValueError):
+            sys.exit("line %d: can't parse '%s'" % (lineno, line))
+
+    return now, points, rings
+
+
+def convert(now, points, rings):
+    events = []
+    pids = set()
+
+    # The clock wraps around; take every time as the latest one before the
+    # dump, which holds for traces shorter than the wrap period
+    def age(t):
+        return (now - t) & 0xffffffff
+
+    oldest = max([age(ev[0]) for ring in rings for ev in ring[3]] or [0])
+
+    def ts(t):
+        return oldest - age(t)
+
+    for tid, (kind, core, name, ring) in enumerate(rings):
+        pids.add(core)
+        events.append({"ph": "M", "name": "thread_name", "pid": core,
+                       "tid": tid, "args": {"name": name}})
+        # interrupts first, then the threads in slot order
+        events.append({"ph": "M", "name": "thread_sort_index", "pid": core,
+                       "tid": tid,
+                       "args": {"sort_index": -1 if kind == "irq" else tid}})
+
+        open_slices = []
+        for time, phase, point, arg in ring:
+            ev = {"name": points.get(point, "point %d" % point),
+                  "pid": core, "tid": tid, "ts": ts(time),
+                  "args": {"arg": arg}}
+            if phase == "B":
+                open_slices.append(ev["name"])
+                ev["ph"] = "B"
+            elif phase == "E":
+                # the ring may have dropped the beginning
+                if not open_slices:
+                    continue
+                ev["name"] = open_slices.pop()
+                ev["ph"] = "E"
+            else:
+                ev["ph"] = "i"
+                ev["s"] = "t"
+            events.append(ev)
+
+        # slices still open ran until the dump
+        while open_slices:
+            events.append({"name": open_slices.pop(), "ph": "E", "pid": core,
+                           "tid": tid, "ts": oldest})
+
+    for pid in pids:
+        name = CORE_NAMES[pid] if pid < len(CORE_NAMES) else "core %d" % pid
+        events.append({"ph": "M", "name": "process_name", "pid": pid,
+                       "args": {"name": name}})
+
+    return {"traceEvents": events, "displayTimeUnit": "ms"}
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        sys.exit("Usage: %s trace.out [trace.json]" % sys.argv[0])
+
+    with open(sys.argv[1]) as f:
+        trace = convert(*parse(f))
+
+    if len(sys.argv) == 3:
+        with open(sys.argv[2], "w") as f:
+            json.dump(trace, f)
+    else:
+        json.dump(trace, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
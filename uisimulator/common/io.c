@@ -50,7 +50,7 @@
 #endif
 
 #include <fcntl.h>
-#ifdef HAVE_SDL_THREADS
+#ifdef HAVE_HOST_THREADS
 #include "thread-sdl.h"
 #else
 #define sim_thread_unlock() NULL
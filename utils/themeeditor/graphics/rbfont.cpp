@@ -184,10 +184,10 @@ RBText* RBFont::renderText(QString text, QColor color, int viewWidth,
                            QGraphicsItem *parent)
 {
 
-    /* Checking for a cache hit first */
-    QImage* image = RBTextCache::lookup(header.value("filename").toString()
-                                        + text);
-    if(image)
+    /* Checking for a cache hit first. The colour is part of the image */
+    QString key = header.value("filename").toString() + color.name() + text;
+    QImage image = RBTextCache::lookup(key);
+    if(!image.isNull())
         return new RBText(image, viewWidth, parent);
 
     int firstChar = header.value("firstchar").toInt();
@@ -211,10 +211,10 @@ RBText* RBFont::renderText(QString text, QColor color, int viewWidth,
     for(int i = 0; i < widths.count(); i++)
         totalWidth += widths[i];
 
-    image = new QImage(totalWidth, height, QImage::Format_Indexed8);
+    image = QImage(totalWidth, height, QImage::Format_Indexed8);
 
-    image->setColor(0, qRgba(0,0,0,0));
-    image->setColor(1, color.rgb());
+    image.setColor(0, qRgba(0,0,0,0));
+    image.setColor(1, color.rgb());
 
     /* Drawing the text */
     int startX = 0;
@@ -248,9 +248,9 @@ RBText* RBFont::renderText(QString text, QColor color, int viewWidth,
             for(int bit = 0; bit < 8; bit++)
             {
                 if(mask & data)
-                    image->setPixel(x, y, 1);
+                    image.setPixel(x, y, 1);
                 else
-                    image->setPixel(x, y, 0);
+                    image.setPixel(x, y, 0);
 
                 y++;
                 mask <<= 1;
@@ -264,7 +264,7 @@ RBText* RBFont::renderText(QString text, QColor color, int viewWidth,
         startX += widths[i];
     }
 
-    RBTextCache::insert(header.value("filename").toString() + text, image);
+    RBTextCache::insert(key, image);
     return new RBText(image, viewWidth, parent);
 
 }
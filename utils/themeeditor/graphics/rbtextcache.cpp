@@ -21,15 +21,15 @@
 
 #include "rbtextcache.h"
 
-QHash<QString, QImage*> RBTextCache::cache;
+const int RBTextCache::maxEntries = 4096;
+QHash<QString, QImage> RBTextCache::cache;
 
-void RBTextCache::clearCache()
+void RBTextCache::insert(QString key, QImage im)
 {
-    QHash<QString, QImage*>::iterator i;
-    for(i = cache.begin(); i != cache.end(); i++)
-    {
-        delete (*i);
-    }
+    /* Typing leaves every intermediate string behind, so start over once
+     * there are too many of them */
+    if(cache.count() >= maxEntries)
+        cache.clear();
 
-    cache.clear();
+    cache.insert(key, im);
 }
@@ -25,15 +25,18 @@
 #include <QHash>
 #include <QImage>
 
+/* Rendered text, kept across renders. The images are implicitly shared
+ * with the RBText items showing them, so entries can be dropped at any time */
 class RBTextCache
 {
 public:
-    static QImage* lookup(QString key){ return cache.value(key, 0); }
-    static void insert(QString key, QImage* im){ cache.insert(key, im); }
-    static void clearCache();
+    static QImage lookup(QString key){ return cache.value(key); }
+    static void insert(QString key, QImage im);
+    static void clearCache(){ cache.clear(); }
 
 private:
-    static QHash<QString, QImage*> cache;
+    static const int maxEntries;
+    static QHash<QString, QImage> cache;
 };
 
 #endif // RBTEXTCACHE_H
@@ -24,6 +24,7 @@
 
 #include "tag_table.h"
 #include "skin_parser.h"
+#include "parsetreemodel.h"
 
 #include "quazipfile.h"
 
@@ -204,7 +205,9 @@ void ProjectExporter::checkWPS(ProjectModel* project, QString file)
     fin.close();
 
     skin_element* root;
+    ParseTreeModel::parserLock().lock();
     root = skin_parse(contents.toAscii());
+    ParseTreeModel::parserLock().unlock();
     if(!root)
     {
         addWarning(tr("Couldn't parse ") + file.split("/").last());
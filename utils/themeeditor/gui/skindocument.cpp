@@ -26,18 +26,20 @@
 #include <QColor>
 #include <QMessageBox>
 #include <QFileDialog>
+#include <QtConcurrentRun>
 
 #include <iostream>
 
 #include <QDebug>
 
-const int SkinDocument::updateInterval = 500;
+const int SkinDocument::parseDelay = 250;
 
 SkinDocument::SkinDocument(QLabel* statusLabel, ProjectModel* project,
                            DeviceState* device, QWidget *parent)
                                :TabContent(parent), statusLabel(statusLabel),
                                project(project), device(device),
-                               treeInSync(true)
+                               revision(0), parsedRevision(0),
+                               parsing(false), treeInSync(true)
 {
     setupUI();
 
@@ -54,7 +56,8 @@ SkinDocument::SkinDocument(QLabel* statusLabel, QString file,
                            QWidget *parent)
                                :TabContent(parent), fileName(file),
                                statusLabel(statusLabel), project(project),
-                               device(device), treeInSync(true)
+                               device(device), revision(0), parsedRevision(0),
+                               parsing(false), treeInSync(true)
 {
     setupUI();
     blockUpdate = false;
@@ -88,12 +91,17 @@ SkinDocument::SkinDocument(QLabel* statusLabel, QString file,
     {
         device->setData("cs", "FM Radio Screen");
     }
-
-    lastUpdate = QTime::currentTime();
 }
 
 SkinDocument::~SkinDocument()
 {
+    /* Nobody will take the tree of a parse still running */
+    if(parsing)
+    {
+        parseWatcher.waitForFinished();
+        skin_free_tree(parseWatcher.result().tree);
+    }
+
     highlighter->deleteLater();
     model->deleteLater();
 }
@@ -185,10 +193,13 @@ void SkinDocument::setupUI()
 
     settingsChanged();
 
-    /* Setting up a timer to check for updates */
-    checkUpdate.setInterval(500);
-    QObject::connect(&checkUpdate, SIGNAL(timeout()),
-                     this, SLOT(codeChanged()));
+    /* Parsing once typing pauses, and taking up the results */
+    parseTimer.setInterval(parseDelay);
+    parseTimer.setSingleShot(true);
+    QObject::connect(&parseTimer, SIGNAL(timeout()),
+                     this, SLOT(startParse()));
+    QObject::connect(&parseWatcher, SIGNAL(finished()),
+                     this, SLOT(parseFinished()));
 }
 
 void SkinDocument::settingsChanged()
@@ -227,13 +238,15 @@ void SkinDocument::cursorChanged()
         QTextCursor line = editor->textCursor();
         line.movePosition(QTextCursor::StartOfLine);
         line.movePosition(QTextCursor::EndOfLine, QTextCursor::KeepAnchor);
-        skin_parse(line.selectedText().toAscii());
+        ParseTreeModel::parserLock().lock();
+        skin_free_tree(skin_parse(line.selectedText().toAscii()));
         if(skin_error_line() > 0)
             parseStatus = tr("Error on line ") +
                           QString::number(line.blockNumber() + 1)
                           + tr(", column ") + QString::number(skin_error_col())
                           + tr(": ") +
                           skin_error_message();
+        ParseTreeModel::parserLock().unlock();
         statusLabel->setText(parseStatus);
     }
     else if(editor->hasErrors())
@@ -251,6 +264,23 @@ void SkinDocument::cursorChanged()
 
 void SkinDocument::codeChanged()
 {
+    if(blockUpdate)
+        return;
+
+    if(editor->document()->toPlainText() != saved)
+        emit titleChanged(titleText + QChar('*'));
+    else
+        emit titleChanged(titleText);
+
+    /* Waiting for the typing to pause before parsing */
+    revision++;
+    parseTimer.start();
+}
+
+void SkinDocument::startParse()
+{
+    parseTimer.stop();
+
     if(blockUpdate)
         return;
 
@@ -261,64 +291,46 @@ void SkinDocument::codeChanged()
         return;
     }
 
-    editor->clearErrors();
-    parseStatus = model->changeTree(editor->document()->
-                                    toPlainText().toAscii());
-
-    treeInSync = true;
-    emit antiSync(false);
-
-    if(skin_error_line() > 0)
-        parseStatus = tr("Errors in document");
-    statusLabel->setText(parseStatus);
-
-    /* Highlighting if an error was found */
-    if(skin_error_line() > 0)
-    {
-        editor->addError(skin_error_line());
+    /* With a parse still running, parseFinished() starts over */
+    if(parsing)
+        return;
 
-        /* Now we're going to attempt parsing again at each line, until we find
-           one that won't error out*/
-        QTextDocument doc(editor->document()->toPlainText());
-        int base = 0;
-        while(skin_error_line() > 0 && !doc.isEmpty())
-        {
-            QTextCursor rest(&doc);
+    QByteArray document = editor->document()->toPlainText().toAscii();
 
-            for(int i = 0; i < skin_error_line(); i++)
-                rest.movePosition(QTextCursor::NextBlock,
-                                  QTextCursor::KeepAnchor);
-            if(skin_error_line() == doc.blockCount())
-                rest.movePosition(QTextCursor::End, QTextCursor::KeepAnchor);
+    parsing = true;
+    parsedRevision = revision;
+    parseWatcher.setFuture(QtConcurrent::run(ParseTreeModel::parse, document));
+}
 
-            rest.removeSelectedText();
-            base += skin_error_line();
+void SkinDocument::parseFinished()
+{
+    SkinParseResult result = parseWatcher.result();
+    parsing = false;
 
-            skin_parse(doc.toPlainText().toAscii());
+    /* The document changed while it was being parsed */
+    if(parsedRevision != revision)
+    {
+        skin_free_tree(result.tree);
+        if(!parseTimer.isActive())
+            startParse();
+        return;
+    }
 
-            if(skin_error_line() > 0)
-                editor->addError(base + skin_error_line());
+    editor->clearErrors();
+    parseStatus = model->changeTree(result);
 
-        }
-    }
+    treeInSync = true;
+    emit antiSync(false);
 
-    if(editor->document()->toPlainText() != saved)
-        emit titleChanged(titleText + QChar('*'));
-    else
-        emit titleChanged(titleText);
+    /* Highlighting if an error was found */
+    if(!result.errorLines.isEmpty())
+        parseStatus = tr("Errors in document");
+    for(int i = 0; i < result.errorLines.count(); i++)
+        editor->addError(result.errorLines[i]);
+    statusLabel->setText(parseStatus);
 
-    if(lastUpdate.msecsTo(QTime::currentTime()) >= updateInterval)
-    {
-        model->render(project, device, this, &fileName);
-        checkUpdate.stop();
-        lastUpdate = QTime::currentTime();
-    }
-    else
-    {
-        checkUpdate.start();
-    }
+    model->renderChanged(project, device, this, &fileName);
     cursorChanged();
-
 }
 
 void SkinDocument::modelChanged()
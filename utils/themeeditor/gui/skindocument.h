@@ -26,8 +26,8 @@
 #include <QLabel>
 #include <QHBoxLayout>
 #include <QGraphicsScene>
-#include <QTime>
 #include <QTimer>
+#include <QFutureWatcher>
 
 #include "findreplacedialog.h"
 
@@ -92,11 +92,13 @@ signals:
 public slots:
     void settingsChanged();
     void cursorChanged();
-    void parseCode(){ codeChanged(); }
+    void parseCode(){ startParse(); }
     void genCode(){ editor->document()->setPlainText(model->genCode()); }
 
 private slots:
     void codeChanged();
+    void startParse();
+    void parseFinished();
     void modelChanged();
     void deviceChanged(){ scene(); }
 
@@ -125,9 +127,14 @@ private:
 
     FindReplaceDialog* findReplace;
 
-    QTime lastUpdate;
-    static const int updateInterval;
-    QTimer checkUpdate;
+    /* Parsing waits for a pause in typing, and then runs in the background.
+     * The revisions tell whether a finished parse is still up to date */
+    static const int parseDelay;
+    QTimer parseTimer;
+    QFutureWatcher<SkinParseResult> parseWatcher;
+    int revision;
+    int parsedRevision;
+    bool parsing;
 
     bool treeInSync;
 };
@@ -20,6 +20,7 @@
  ****************************************************************************/
 
 #include "editorwindow.h"
+#include "tag_table.h"
 
 #include <QtGui/QApplication>
 
@@ -31,6 +32,11 @@ int main(int argc, char* argv[])
     QCoreApplication::setApplicationVersion("Pre-Alpha");
     QCoreApplication::setOrganizationName("rockbox.org");
 
+    /* The skin parser indexes its tag table on the first lookup. Get that
+     * done before documents start being parsed in the background, as the
+     * syntax highlighter looks up tags without taking the parser lock */
+    find_tag("V");
+
     EditorWindow mainWindow;
     mainWindow.show();
 
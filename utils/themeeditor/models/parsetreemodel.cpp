@@ -26,18 +26,23 @@
 #include "rbrenderinfo.h"
 
 #include <cstdlib>
+#include <cstring>
 
 #include <QObject>
 #include <QPixmap>
 #include <QMap>
 #include <QDir>
+#include <QMutexLocker>
 
 #include <iostream>
 
 ParseTreeModel::ParseTreeModel(const char* document, QObject* parent):
-        QAbstractItemModel(parent), sbsModel(0)
+        QAbstractItemModel(parent), sbsModel(0), renderScreen(0),
+        renderValid(false)
 {
+    parserLock().lock();
     this->tree = skin_parse(document);
+    parserLock().unlock();
 
     if(tree)
         this->root = new ParseTreeNode(tree, this);
@@ -66,20 +71,112 @@ QString ParseTreeModel::genCode()
         return "";
 }
 
+QMutex& ParseTreeModel::parserLock()
+{
+    static QMutex lock;
+    return lock;
+}
+
+SkinParseResult ParseTreeModel::parse(QByteArray document)
+{
+    QMutexLocker locker(&parserLock());
+    SkinParseResult result;
+
+    result.tree = skin_parse(document.constData());
+    if(result.tree)
+    {
+        result.status = tr("Document Parses Successfully");
+        return result;
+    }
+
+    result.status = tr("Error on line ") +
+                    QString::number(skin_error_line())
+                    + tr(", column ") + QString::number(skin_error_col())
+                    + tr(": ") + QString(skin_error_message());
+
+    /* Now we're going to attempt parsing again after each error line, until
+       the rest of the document doesn't error out */
+    const char* rest = document.constData();
+    int base = 0;
+    while(skin_error_line() > 0)
+    {
+        result.errorLines.append(base + skin_error_line());
+
+        for(int i = 0; i < skin_error_line() && rest; i++)
+        {
+            rest = strchr(rest, '\n');
+            if(rest)
+                rest++;
+        }
+        if(!rest || !*rest)
+            break;
+        base += skin_error_line();
+
+        skin_free_tree(skin_parse(rest));
+    }
+
+    return result;
+}
+
 QString ParseTreeModel::changeTree(const char *document)
 {
-    struct skin_element* test = skin_parse(document);
+    SkinParseResult result = parse(document);
+
+    if(!result.tree)
+        return result.status;
+
+    return changeTree(result);
+}
 
-    if(!test)
+QString ParseTreeModel::changeTree(const SkinParseResult& result)
+{
+    if(!result.tree)
+        return result.status;
+
+    ParseTreeNode* temp = new ParseTreeNode(result.tree, this);
+    bool incremental = renderValid && root
+                       && root->numChildren() == temp->numChildren();
+
+    /* Finding the viewports that changed. If one of them sets something up
+     * for the other viewports, like an image or a font, the whole screen
+     * has to be rendered again */
+    dirtyViewports.clear();
+    for(int i = 0; incremental && i < temp->numChildren(); i++)
     {
-        QString error = tr("Error on line ") +
-                        QString::number(skin_error_line())
-                        + tr(", column ") + QString::number(skin_error_col())
-                        + tr(": ") + QString(skin_error_message());
-        return error;
+        ParseTreeNode* old = root->child(i);
+        ParseTreeNode* fresh = temp->child(i);
+
+        if(old->genCode() == fresh->genCode())
+            continue;
+
+        if(old->affectsScreen() || fresh->affectsScreen())
+            incremental = false;
+        else
+            dirtyViewports.append(i);
     }
 
-    ParseTreeNode* temp = new ParseTreeNode(test, this);
+    if(incremental)
+    {
+        /* The unchanged viewports keep their nodes, as their rendered items
+         * point to them, and the changed ones get taken off the scene */
+        for(int i = 0; i < temp->numChildren(); i++)
+        {
+            if(dirtyViewports.contains(i))
+            {
+                root->child(i)->clearRendered();
+            }
+            else
+            {
+                ParseTreeNode* old = root->child(i);
+                old->copyLines(temp->child(i));
+                root->replaceChild(i, temp->replaceChild(i, old));
+            }
+        }
+    }
+    else
+    {
+        renderValid = false;
+    }
 
     if(root)
     {
@@ -281,8 +378,9 @@ RBScene* ParseTreeModel::render(ProjectModel* project,
     /* Setting the background */
     scene->setBackgroundBrush(QBrush(QPixmap(":/render/scenebg.png")));
 
-    /* Preparing settings */
-    QMap<QString, QString> settings;
+    /* Preparing settings. The screen keeps a pointer to them */
+    QMap<QString, QString>& settings = renderSettings;
+    settings.clear();
     if(project)
         settings = project->getSettings();
 
@@ -368,6 +466,43 @@ RBScene* ParseTreeModel::render(ProjectModel* project,
     if(root)
         root->render(info);
 
+    renderScreen = screen;
+    renderValid = true;
+    dirtyViewports.clear();
+
+    return scene;
+}
+
+RBScene* ParseTreeModel::renderChanged(ProjectModel* project,
+                                       DeviceState* device,
+                                       SkinDocument* doc, const QString* file)
+{
+    if(!renderValid)
+        return render(project, device, doc, file);
+
+    RBRenderInfo info(this, project, doc, &renderSettings, device,
+                      renderScreen);
+
+    for(int i = 0; i < dirtyViewports.count(); i++)
+    {
+        int row = dirtyViewports[i];
+        ParseTreeNode* viewport = root->child(row);
+
+        viewport->render(info);
+
+        /* Keeping the viewports stacked in document order */
+        for(int next = row + 1; next < root->numChildren(); next++)
+        {
+            QGraphicsItem* above = root->child(next)->getRendered();
+            if(above)
+            {
+                viewport->getRendered()->stackBefore(above);
+                break;
+            }
+        }
+    }
+    dirtyViewports.clear();
+
     return scene;
 }
 
@@ -29,11 +29,21 @@
 
 #include <QAbstractItemModel>
 #include <QList>
+#include <QMap>
+#include <QMutex>
 
 #include "parsetreenode.h"
 #include "devicestate.h"
 #include "rbscene.h"
 
+/* The outcome of ParseTreeModel::parse() */
+struct SkinParseResult
+{
+    struct skin_element* tree;
+    QString status;
+    QList<int> errorLines;
+};
+
 class ParseTreeModel : public QAbstractItemModel
 {
 
@@ -53,6 +63,17 @@ public:
     QString genCode();
     /* Changes the parse tree to a new document */
     QString changeTree(const char* document);
+    /* Changes the parse tree to one returned by parse(), keeping the nodes
+     * and rendered items of the viewports that haven't changed */
+    QString changeTree(const SkinParseResult& result);
+
+    /* Parses a document and finds the lines with errors. This may run off
+     * the GUI thread */
+    static SkinParseResult parse(QByteArray document);
+
+    /* The skin parser isn't reentrant, everything calling it has to hold
+     * this lock */
+    static QMutex& parserLock();
 
     /* Model implementation stuff */
     QModelIndex index(int row, int column, const QModelIndex& parent) const;
@@ -66,6 +87,10 @@ public:
 
     RBScene* render(ProjectModel* project, DeviceState* device,
                     SkinDocument* doc, const QString* file = 0);
+    /* Renders just the viewports that changed since the last render, or
+     * everything if that can't be done */
+    RBScene* renderChanged(ProjectModel* project, DeviceState* device,
+                           SkinDocument* doc, const QString* file = 0);
 
     static QString safeSetting(ProjectModel* project, QString key,
                                QString fallback)
@@ -86,6 +111,12 @@ private:
     ParseTreeModel* sbsModel;
     struct skin_element* tree;
     RBScene* scene;
+
+    /* What the last render used, for renderChanged() */
+    QMap<QString, QString> renderSettings;
+    RBScreen* renderScreen;
+    bool renderValid;
+    QList<int> dirtyViewports;
 };
 
 
@@ -31,6 +31,7 @@
 
 #include <iostream>
 #include <cmath>
+#include <cstring>
 #include <cassert>
 
 #include <QDebug>
@@ -40,7 +41,7 @@ bool ParseTreeNode::breakFlag = false;
 
 /* Root element constructor */
 ParseTreeNode::ParseTreeNode(struct skin_element* data, ParseTreeModel* model)
-    : parent(0), element(0), param(0), children(), model(model)
+    : parent(0), element(0), param(0), children(), rendered(0), model(model)
 {
     while(data)
     {
@@ -53,7 +54,7 @@ ParseTreeNode::ParseTreeNode(struct skin_element* data, ParseTreeModel* model)
 ParseTreeNode::ParseTreeNode(struct skin_element* data, ParseTreeNode* parent,
                              ParseTreeModel* model)
                                  : parent(parent), element(data), param(0),
-                                 children(), model(model)
+                                 children(), rendered(0), model(model)
 {
     switch(element->type)
     {
@@ -109,7 +110,7 @@ case VIEWPORT:
 ParseTreeNode::ParseTreeNode(skin_tag_parameter *data, ParseTreeNode *parent,
                              ParseTreeModel *model)
                                  : parent(parent), element(0), param(data),
-                                 children(), model(model)
+                                 children(), rendered(0), model(model)
 {
 
 }
@@ -509,6 +510,67 @@ ParseTreeNode* ParseTreeNode::getParent() const
     return parent;
 }
 
+/* Puts node in place of the child at row, and returns the old child */
+ParseTreeNode* ParseTreeNode::replaceChild(int row, ParseTreeNode* node)
+{
+    ParseTreeNode* old = children[row];
+    children[row] = node;
+    node->parent = this;
+    return old;
+}
+
+/* Takes the viewport this node rendered off the scene */
+void ParseTreeNode::clearRendered()
+{
+    if(rendered)
+        delete rendered;
+    rendered = 0;
+}
+
+/* Checks whether rendering this node leaves anything behind on the screen
+ * that other viewports use, like images, fonts or viewport visibility.
+ * A viewport without any of these can be rendered again on its own */
+bool ParseTreeNode::affectsScreen() const
+{
+    static const char* screenTags[] =
+    {
+        "x", "xl", "X", "Fl", "Cl", "Cd", "Vd", "VI", "wd", "ax", 0
+    };
+
+    if(element)
+    {
+        /* The default viewport and %Vl/%Vi viewports register themselves
+         * with the screen */
+        if(element->type == VIEWPORT
+           && (!element->tag || element->tag->name[1] != '\0'))
+            return true;
+
+        if((element->type == TAG || element->type == CONDITIONAL)
+           && element->tag)
+        {
+            for(int i = 0; screenTags[i]; i++)
+                if(!strcmp(element->tag->name, screenTags[i]))
+                    return true;
+        }
+    }
+
+    for(int i = 0; i < children.count(); i++)
+        if(children[i]->affectsScreen())
+            return true;
+
+    return false;
+}
+
+/* Takes over the line numbers of an identical tree */
+void ParseTreeNode::copyLines(const ParseTreeNode* other)
+{
+    if(element && other->element)
+        element->line = other->element->line;
+
+    for(int i = 0; i < children.count() && i < other->children.count(); i++)
+        children[i]->copyLines(other->children[i]);
+}
+
 /* This version is called for the root node and for viewports */
 void ParseTreeNode::render(const RBRenderInfo& info)
 {
@@ -60,6 +60,12 @@ public:
         else
             return 0;
     }
+    ParseTreeNode* replaceChild(int row, ParseTreeNode* node);
+
+    QGraphicsItem* getRendered() const{ return rendered; }
+    void clearRendered();
+    bool affectsScreen() const;
+    void copyLines(const ParseTreeNode* other);
 
     void render(const RBRenderInfo& info);
     void render(const RBRenderInfo &info, RBViewport* viewport,